@@ -70,6 +70,13 @@ constexpr const char * brdfFrag   = "resources/Shaders/PBR/brdf.frag.glsl";
 constexpr const char * pbrVertex = "resources/Shaders/PBR/pbr.vert.glsl";
 constexpr const char * pbrFrag = "resources/Shaders/PBR/pbr.frag.glsl";
 
+constexpr const char * fullscreenTriangleVertex = "resources/Shaders/PBR/fullscreen_triangle.vert.glsl";
+constexpr const char * deferredLightingFrag     = "resources/Shaders/PBR/deferred_lighting.frag.glsl";
+
+constexpr const char * sssDownsampleFrag = "resources/Shaders/PBR/sss_downsample.frag.glsl";
+constexpr const char * sssBlurFrag       = "resources/Shaders/PBR/sss_blur.frag.glsl";
+constexpr const char * sssUpsampleFrag   = "resources/Shaders/PBR/sss_upsample.frag.glsl";
+
 constexpr const char * debugShadowMappingVertex = "resources/Shaders/debug_quad_depth.vert.glsl";
 constexpr const char * debugShadowMappingFrag   = "resources/Shaders/debug_quad_depth.frag.glsl";
 
@@ -80,6 +87,16 @@ constexpr const char * pointShadowMappingVertex   = "resources/Shaders/point_sha
 constexpr const char * pointShadowMappingFrag     = "resources/Shaders/point_shadow_mapping_depth.frag.glsl";
 constexpr const char * pointShadowMappingGeometry = "resources/Shaders/point_shadow_mapping_depth.geometry.glsl";
 
+// GPU culling (compute)
+constexpr const char * depthPyramidCompute = "resources/Shaders/depth_pyramid.comp.glsl";
+constexpr const char * cullCompute         = "resources/Shaders/cull.comp.glsl";
+constexpr const char * cullCompactCompute  = "resources/Shaders/cull_compact.comp.glsl";
+
+// Program binaries, rebuilt when sources or driver change
+constexpr const char * shaderCache = "shader_cache/";
+// Rasterized glyphs, rebuilt when font file or size change
+constexpr const char * fontCache = "font_cache/";
+
 // Planets
 constexpr const char * star = "resources/Textures/Star.bmp";
 // Snow
@@ -165,12 +182,67 @@ namespace Names
 constexpr const char * cameraProps = "CameraProps";
 constexpr const char * lights      = "Lights";
 constexpr const char * projection  = "Projection";
+constexpr const char * sphericalHarmonics = "SphericalHarmonics";
+constexpr const char * entityAttributes = "EntityAttributes";
 }; // !Constants::UBO::Names
 namespace Ids
 {
 constexpr const GLuint cameraProps = 0;
 constexpr const GLuint lights = 1;
 constexpr const GLuint projection = 2;
+constexpr const GLuint sphericalHarmonics = 3;
+constexpr const GLuint entityAttributes = 4;
 };
 }; // !Constants::UBO
+
+namespace SSBO // Shader Storage Buffer Objects
+{
+namespace Names
+{
+constexpr const char * instanceData = "InstanceData";
+}; // !Constants::SSBO::Names
+namespace Ids
+{
+constexpr const GLuint instanceData = 0;
+// GPU culling (GpuCuller)
+constexpr const GLuint cullInstances = 1;
+constexpr const GLuint cullCommands  = 2;
+constexpr const GLuint cullModels    = 3;
+constexpr const GLuint cullDraws     = 4;
+// Clustered shading (LightClusters)
+constexpr const GLuint lightGrid    = 5;
+constexpr const GLuint lightIndices = 6;
+};
+}; // !Constants::SSBO
+
+namespace TextureUnits // Set once per program when linked
+{
+// Per draw, material textures
+constexpr const GLuint texture         = 0; // _texture
+constexpr const GLuint diffuseTexture  = 0;
+constexpr const GLuint specularTexture = 1;
+constexpr const GLuint albedoMap    = 0;
+constexpr const GLuint normalMap    = 1;
+constexpr const GLuint metallicMap  = 2;
+constexpr const GLuint roughnessMap = 3;
+constexpr const GLuint aoMap        = 4;
+// Bound once per frame, out of the way of per draw & editing bindings
+constexpr const GLuint irradianceMap = 16;
+constexpr const GLuint prefilterMap  = 17;
+constexpr const GLuint brdfLUT       = 18;
+constexpr const GLuint shadowMaps    = 19;
+constexpr const GLuint pointShadowMaps = 20;
+// G-buffer, read by the deferred lighting pass (DeferredRendering)
+constexpr const GLuint gAlbedo   = 21;
+constexpr const GLuint gNormal   = 22;
+constexpr const GLuint gMaterial = 23;
+constexpr const GLuint gLight    = 24;
+constexpr const GLuint gDepth    = 25;
+// Separable SSS post-process (SubsurfaceScattering)
+constexpr const GLuint sssSceneColor   = 26;
+constexpr const GLuint sssSceneDepth   = 27;
+constexpr const GLuint sssSceneStencil = 28;
+constexpr const GLuint sssColor        = 29;
+constexpr const GLuint sssDepth        = 30;
+}; // !Constants::TextureUnits
 }; // !Constants
\ No newline at end of file
@@ -10,6 +10,7 @@
 // Project includes
 #include "OGL_Implementation\DebugInfo\Log.hpp"
 #include "Constants.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
 
 // GLM includes
 #include <glm\gtx\vector_angle.hpp>
@@ -44,15 +45,15 @@ Camera::Camera(int windowWidth, int windowHeight,
     glGenBuffers(1, &__uboProjection);
 
 
-    glBindBuffer(GL_UNIFORM_BUFFER, __uboCameraProps);
+    OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, __uboCameraProps);
     constexpr const size_t uboCameraPropsSize = sizeof(glm::vec4) + sizeof(glm::mat4) * 3;
     glBufferData(GL_UNIFORM_BUFFER, uboCameraPropsSize, NULL, GL_DYNAMIC_DRAW);
-    glBindBufferRange(GL_UNIFORM_BUFFER, Constants::UBO::Ids::cameraProps, __uboCameraProps, 0, uboCameraPropsSize);
+    OpenGL_State::BindBufferRange(GL_UNIFORM_BUFFER, Constants::UBO::Ids::cameraProps, __uboCameraProps, 0, uboCameraPropsSize);
 
-    glBindBuffer(GL_UNIFORM_BUFFER, __uboProjection);
+    OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, __uboProjection);
     constexpr const size_t uboProjectionSize = sizeof(glm::mat4);
     glBufferData(GL_UNIFORM_BUFFER, uboProjectionSize, NULL, GL_DYNAMIC_DRAW);
-    glBindBufferRange(GL_UNIFORM_BUFFER, Constants::UBO::Ids::projection, __uboProjection, 0, uboProjectionSize);
+    OpenGL_State::BindBufferRange(GL_UNIFORM_BUFFER, Constants::UBO::Ids::projection, __uboProjection, 0, uboProjectionSize);
 }
 
 Camera::Camera(int windowWidth, int windowHeight, glm::vec3 position, glm::vec3 up, GLfloat yaw, GLfloat pitch)
@@ -62,8 +63,8 @@ Camera::Camera(int windowWidth, int windowHeight, glm::vec3 position, glm::vec3
 
 Camera::~Camera()
 {
-    glDeleteBuffers(1, &__uboCameraProps);
-    glDeleteBuffers(1, &__uboProjection);
+    OpenGL_State::DeleteBuffers(1, &__uboCameraProps);
+    OpenGL_State::DeleteBuffers(1, &__uboProjection);
 
     if (mainCamera == this) mainCamera = nullptr;
 }
@@ -87,7 +88,7 @@ GLuint Camera::GetProjViewMatrixUbo()
             __view = glm::lookAt(this->Position, this->Position + this->Front, this->Up);
             __hasMoved = false;
             // Reassign position
-            glBindBuffer(GL_UNIFORM_BUFFER, __uboCameraProps);
+            OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, __uboCameraProps);
             glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::vec4), glm::value_ptr(Position));
         }
         if (__hasReshaped)
@@ -102,18 +103,18 @@ GLuint Camera::GetProjViewMatrixUbo()
             __hasReshaped = false;
 
             // Reassign projection matrix
-            glBindBuffer(GL_UNIFORM_BUFFER, __uboProjection);
+            OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, __uboProjection);
             glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(projection2D));
         }
         // Reassign view & proj matrix
-        glBindBuffer(GL_UNIFORM_BUFFER, __uboCameraProps);
+        OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, __uboCameraProps);
         glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::vec4) + 1 * sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(__view));
         glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::vec4) + 2 * sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(__projection));
 
         // Reassign viewProj matrix
         const glm::mat4 viewProj = __projection * __view;
         glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::vec4), sizeof(glm::mat4), glm::value_ptr(viewProj));
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, 0);
     }
     return __uboCameraProps;
 }
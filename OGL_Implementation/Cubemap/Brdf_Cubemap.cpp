@@ -10,6 +10,7 @@
 // Project includes
 #include "Constants.hpp"
 #include "OGL_Implementation\Window.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
 
 // GLM includes
 #include <glm\glm.hpp>
@@ -20,13 +21,19 @@
 
 Brdf_Cubemap * s_cubemap = nullptr;
 
-Brdf_Cubemap::Brdf_Cubemap(const std::string & hdrTexturePath, const Shader & backgroundShader_)
-    : shader{ backgroundShader_ }
+Brdf_Cubemap::Brdf_Cubemap(const std::string & hdrTexturePath, const Shader & backgroundShader_, IrradianceMode irradianceMode_)
+    : cubemapTexture{ 0 }
+    , irradianceMap{ 0 }
+    , prefilterMap{ 0 }
+    , brdfLUTTexture{ 0 }
+    , shader{ backgroundShader_ }
+    , irradianceMode{ irradianceMode_ }
+    , __uboSphericalHarmonics{ 0 }
 {
-    if (!GenerateHDRTexture(hdrTexturePath, texture))
+    // Spherical harmonics are projected from the equirectangular pixels, keeping them CPU side
+    if (!GenerateHDRTexture(hdrTexturePath, texture, UsesSphericalHarmonics()))
         throw std::runtime_error("Can't load BRDF Cubemap");
 
-    Shader irradianceShader               = GenerateShader(Constants::Paths::cubemapVertex, Constants::Paths::irradianceFrag);
     Shader prefilterShader                = GenerateShader(Constants::Paths::cubemapVertex, Constants::Paths::prefilterFrag);
     Shader equirectangularToCubemapShader = GenerateShader(Constants::Paths::cubemapVertex, Constants::Paths::equiToCubemapFrag);
     Shader brdfShader                     = GenerateShader(Constants::Paths::brdfVertex,    Constants::Paths::brdfFrag);
@@ -38,7 +45,7 @@ Brdf_Cubemap::Brdf_Cubemap(const std::string & hdrTexturePath, const Shader & ba
     glGenFramebuffers(1, &captureFBO);
     glGenRenderbuffers(1, &captureRBO);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 1024, 1024);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
@@ -46,7 +53,7 @@ Brdf_Cubemap::Brdf_Cubemap(const std::string & hdrTexturePath, const Shader & ba
     // pbr: setup cubemap to render to and attach to framebuffer
     // ---------------------------------------------------------
     glGenTextures(1, &cubemapTexture);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+    OpenGL_State::BindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
     for (unsigned int i = 0; i < 6; ++i)
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 1024, 1024, 0, GL_RGB, GL_FLOAT, nullptr);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -73,11 +80,10 @@ Brdf_Cubemap::Brdf_Cubemap(const std::string & hdrTexturePath, const Shader & ba
     equirectangularToCubemapShader.Use();
     equirectangularToCubemapShader.SetUniformInt("equirectangularMap", 0);
     equirectangularToCubemapShader.SetUniformMatrix4f("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture.GetTexture());
+    OpenGL_State::BindTextureUnit(0, texture.GetTexture());
 
-    glViewport(0, 0, 1024, 1024); // don't forget to configure the viewport to the capture dimensions.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    OpenGL_State::Viewport(0, 0, 1024, 1024); // don't forget to configure the viewport to the capture dimensions.
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     for (unsigned int i = 0; i < 6; ++i)
     {
         equirectangularToCubemapShader.SetUniformMatrix4f("view", captureViews[i]);
@@ -86,54 +92,64 @@ Brdf_Cubemap::Brdf_Cubemap(const std::string & hdrTexturePath, const Shader & ba
 
         RenderCube();
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // then let OpenGL generate mipmaps from first mip face (combatting visible dots artifact)
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+    OpenGL_State::BindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
-    // pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
-    // --------------------------------------------------------------------------------
-    glGenTextures(1, &irradianceMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-    for (unsigned int i = 0; i < 6; ++i)
+    if (UsesSphericalHarmonics())
     {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
+        // pbr: project the environment on spherical harmonics (CPU side) instead of convoluting an irradiance cubemap.
+        // ------------------------------------------------------------------------------------------------------------
+        UpdateSphericalHarmonics();
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
-
-    // pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
-    // -----------------------------------------------------------------------------
-    irradianceShader.Use();
-    irradianceShader.SetUniformInt("environmentMap", 0);
-    irradianceShader.SetUniformMatrix4f("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-
-    glViewport(0, 0, 32, 32); // don't forget to configure the viewport to the capture dimensions.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    for (unsigned int i = 0; i < 6; ++i)
+    else
     {
-        irradianceShader.SetUniformMatrix4f("view", captureViews[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        Shader irradianceShader = GenerateShader(Constants::Paths::cubemapVertex, Constants::Paths::irradianceFrag);
 
-        RenderCube();
+        // pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
+        // --------------------------------------------------------------------------------
+        glGenTextures(1, &irradianceMap);
+        OpenGL_State::BindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
+
+        // pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
+        // -----------------------------------------------------------------------------
+        irradianceShader.Use();
+        irradianceShader.SetUniformInt("environmentMap", 0);
+        irradianceShader.SetUniformMatrix4f("projection", captureProjection);
+        OpenGL_State::BindTextureUnit(0, cubemapTexture);
+
+        OpenGL_State::Viewport(0, 0, 32, 32); // don't forget to configure the viewport to the capture dimensions.
+        OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            irradianceShader.SetUniformMatrix4f("view", captureViews[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            RenderCube();
+        }
+        OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, 0);
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // pbr: create a pre-filter cubemap, and re-scale capture FBO to pre-filter scale.
     // --------------------------------------------------------------------------------
     glGenTextures(1, &prefilterMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
+    OpenGL_State::BindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
     for (unsigned int i = 0; i < 6; ++i)
     {
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
@@ -151,10 +167,9 @@ Brdf_Cubemap::Brdf_Cubemap(const std::string & hdrTexturePath, const Shader & ba
     prefilterShader.Use();
     prefilterShader.SetUniformInt("environmentMap", 0);
     prefilterShader.SetUniformMatrix4f("projection", captureProjection);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+    OpenGL_State::BindTextureUnit(0, cubemapTexture);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     unsigned int maxMipLevels = 5;
     for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
     {
@@ -163,7 +178,7 @@ Brdf_Cubemap::Brdf_Cubemap(const std::string & hdrTexturePath, const Shader & ba
         unsigned int mipHeight = static_cast<unsigned int>(128 * std::pow(0.5, mip));
         glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
         glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
-        glViewport(0, 0, mipWidth, mipHeight);
+        OpenGL_State::Viewport(0, 0, mipWidth, mipHeight);
 
         float roughness = (float)mip / (float)(maxMipLevels - 1);
         prefilterShader.SetUniformFloat("roughness", roughness);
@@ -176,14 +191,14 @@ Brdf_Cubemap::Brdf_Cubemap(const std::string & hdrTexturePath, const Shader & ba
             RenderCube();
         }
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // pbr: generate a 2D LUT from the BRDF equations used.
     // ----------------------------------------------------
     glGenTextures(1, &brdfLUTTexture);
 
     // pre-allocate enough memory for the LUT texture.
-    glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
+    OpenGL_State::BindTexture(GL_TEXTURE_2D, brdfLUTTexture);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 1024, 1024, 0, GL_RG, GL_FLOAT, 0);
     // be sure to set wrapping mode to GL_CLAMP_TO_EDGE
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -192,37 +207,67 @@ Brdf_Cubemap::Brdf_Cubemap(const std::string & hdrTexturePath, const Shader & ba
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     // then re-configure capture framebuffer object and render screen-space quad with BRDF shader.
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 1024, 1024);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture, 0);
 
-    glViewport(0, 0, 1024, 1024);
+    OpenGL_State::Viewport(0, 0, 1024, 1024);
     brdfShader.Use();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glDisable(GL_BLEND);
+    OpenGL_State::SetCapability(GL_BLEND, false);
     RenderQuad();
-    glEnable(GL_BLEND);
+    OpenGL_State::SetCapability(GL_BLEND, true);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, 0);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
-    glDeleteFramebuffers(1, &captureFBO);
+    OpenGL_State::DeleteFramebuffers(1, &captureFBO);
     glDeleteRenderbuffers(1, &captureRBO);
 
     // then before rendering, configure the viewport to the original framebuffer's screen dimensions
-    glViewport(0, 0, Window::Get()->windowWidth(), Window::Get()->windowHeight());
+    OpenGL_State::Viewport(0, 0, Window::Get()->windowWidth(), Window::Get()->windowHeight());
 
     if (!s_cubemap) s_cubemap = this;
 }
 
 Brdf_Cubemap::~Brdf_Cubemap()
 {
-    glDeleteTextures(4, &cubemapTexture);
+    OpenGL_State::DeleteTextures(4, &cubemapTexture);
+    OpenGL_State::DeleteBuffers(1, &__uboSphericalHarmonics);
 
     s_cubemap = nullptr;
 }
 
+void Brdf_Cubemap::UpdateSphericalHarmonics()
+{
+    if (!UsesSphericalHarmonics())
+        throw std::runtime_error("Brdf_Cubemap: spherical harmonics are not used by this cubemap.");
+
+    sphericalHarmonics.Project(texture.GetPixels().data(), texture.GetWidth(), texture.GetHeight(), texture.GetChannels());
+    const SphericalHarmonics_Shader shaderInfo = sphericalHarmonics.GetShaderInfo();
+
+    if (__uboSphericalHarmonics == 0)
+    {
+        glGenBuffers(1, &__uboSphericalHarmonics);
+        OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, __uboSphericalHarmonics);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(SphericalHarmonics_Shader), &shaderInfo, GL_DYNAMIC_DRAW);
+    }
+    else
+    {
+        OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, __uboSphericalHarmonics);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SphericalHarmonics_Shader), &shaderInfo);
+    }
+    OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    OpenGL_State::BindBufferRange(GL_UNIFORM_BUFFER, Constants::UBO::Ids::sphericalHarmonics, __uboSphericalHarmonics, 0, sizeof(SphericalHarmonics_Shader));
+}
+
+bool Brdf_Cubemap::UsesSphericalHarmonics() const
+{
+    return irradianceMode == IrradianceMode::SphericalHarmonics;
+}
+
 static unsigned int cubeVAO = 0;
 static unsigned int cubeVBO = 0;
 void Brdf_Cubemap::RenderCube()
@@ -277,23 +322,23 @@ void Brdf_Cubemap::RenderCube()
         glGenVertexArrays(1, &cubeVAO);
         glGenBuffers(1, &cubeVBO);
         // fill buffer
-        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+        OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, cubeVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         // link vertex attributes
-        glBindVertexArray(cubeVAO);
+        OpenGL_State::BindVertexArray(cubeVAO);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
         glEnableVertexAttribArray(2);
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, 0);
+        OpenGL_State::BindVertexArray(0);
     }
     // render Cube
-    glBindVertexArray(cubeVAO);
+    OpenGL_State::BindVertexArray(cubeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    OpenGL_State::BindVertexArray(0);
 }
 
 static unsigned int quadVAO = 0;
@@ -312,15 +357,15 @@ void Brdf_Cubemap::RenderQuad()
         // setup plane VAO
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        OpenGL_State::BindVertexArray(quadVAO);
+        OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)0);
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)(3 * sizeof(float)));
     }
-    glBindVertexArray(quadVAO);
+    OpenGL_State::BindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    OpenGL_State::BindVertexArray(0);
 }
\ No newline at end of file
@@ -11,13 +11,43 @@
 #include "OGL_Implementation\Shader\Shader.hpp"
 #include "OGL_Implementation\Texture\HDRTexture.hpp"
 #include "OGL_Implementation\EntityAttribute\EntityAttribute.hpp"
+#include "SphericalHarmonics.hpp"
 
 class Brdf_Cubemap
 {
 public:
-    Brdf_Cubemap(const std::string & hdrTexturePath, const Shader & backgroundShader_);
+    /**
+     * @brief Way the diffuse irradiance is computed
+    */
+    enum class IrradianceMode
+    {
+        /**
+         * @brief Irradiance cubemap convoluted by a shader on every texel of the 6 faces
+        */
+        Convolution,
+        /**
+         * @brief 9 coefficients projected on CPU worker threads and evaluated in shaders
+        */
+        SphericalHarmonics
+    };
+
+public:
+    Brdf_Cubemap(const std::string & hdrTexturePath, const Shader & backgroundShader_, IrradianceMode irradianceMode_ = IrradianceMode::SphericalHarmonics);
     ~Brdf_Cubemap();
 
+    /**
+     * @brief Projects the HDR texture on spherical harmonics and uploads
+     * the coefficients to the SphericalHarmonics UBO.
+     * Only available with IrradianceMode::SphericalHarmonics.
+    */
+    void UpdateSphericalHarmonics();
+
+    /**
+     * @brief Returns true if shaders should evaluate spherical harmonics instead of sampling irradianceMap
+     * @return true if using spherical harmonics
+    */
+    bool UsesSphericalHarmonics() const;
+
 private:
     void RenderCube();
     void RenderQuad();
@@ -29,6 +59,12 @@ public:
     GLuint brdfLUTTexture;
     HDRTexture texture;
     Shader shader;
+
+    const IrradianceMode irradianceMode;
+    SphericalHarmonics sphericalHarmonics;
+
+private:
+    GLuint __uboSphericalHarmonics;
 };
 
 extern Brdf_Cubemap * s_cubemap;
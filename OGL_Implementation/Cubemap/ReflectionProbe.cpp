@@ -0,0 +1,334 @@
+/*****************************************************************//**
+ * \file   ReflectionProbe.cpp
+ * \brief  ReflectionProbe source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 04 2022
+ *********************************************************************/
+#include "ReflectionProbe.hpp"
+
+// Project includes
+#include "Constants.hpp"
+#include "OGL_Implementation\Camera.hpp"
+#include "OGL_Implementation\Window.hpp"
+#include "OGL_Implementation\Rendering\Rendering.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
+
+// GLM includes
+#include <glm\gtc\matrix_transform.hpp>
+#include <glm\gtc\type_ptr.hpp>
+
+// C++ includes
+#include <algorithm>
+#include <memory>
+
+ReflectionProbe::Settings ReflectionProbe::settings;
+
+static std::vector<ReflectionProbe *> probes;
+static std::unique_ptr<Shader> s_prefilterShader;
+
+// CameraProps layout (see Camera): vec4 viewPos, mat4 viewProj, mat4 view, mat4 projection
+static constexpr const size_t cameraPropsSize = sizeof(glm::vec4) + sizeof(glm::mat4) * 3;
+static constexpr const int captureStepsCount = 6;
+static constexpr const int totalStepsCount = captureStepsCount + 6 * ReflectionProbe::prefilterMipsCount;
+
+// GPU timing of the previous frames, read back without stalling
+static constexpr const size_t timersCount = 3;
+static std::unique_ptr<std::array<OpenGL_Timer, timersCount>> timers;
+static std::array<int, timersCount> timersSteps = { 0, 0, 0 };
+static size_t currentTimer = 0;
+static float estimatedStepMs = 0.25f;
+static float budgetCreditMs = 0.0f;
+static int lastFrameSteps = 0;
+static size_t nextProbe = 0;
+
+static const glm::mat4 captureViews[] =
+{
+    glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+    glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+    glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
+    glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
+    glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+    glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
+};
+
+static GLuint AllocateCubemap(int resolution, bool mipmaps)
+{
+    GLuint cubemap;
+    glGenTextures(1, &cubemap);
+    OpenGL_State::BindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+    for (unsigned int i = 0; i < 6; ++i)
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, resolution, resolution, 0, GL_RGB, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (mipmaps) glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    return cubemap;
+}
+
+ReflectionProbe::ReflectionProbe(const glm::vec3 & position_, float radius_, int captureResolution_, int prefilterResolution_)
+    : position{ position_ }
+    , radius{ radius_ }
+    , captureFar{ 100.0f }
+    , continuous{ true }
+    , __captureResolution{ captureResolution_ }
+    , __prefilterResolution{ prefilterResolution_ }
+    , __environmentMap{ 0 }
+    , __prefilterMaps{ 0, 0 }
+    , __frontPrefilter{ 0 }
+    , __captureFbo{ 0 }
+    , __captureRbo{ 0 }
+    , __uboCaptureProps{ 0 }
+    , __step{ 0 }
+    , __ready{ false }
+    , __frozen{ false }
+{
+    if (!s_prefilterShader)
+    {
+        s_prefilterShader = std::make_unique<Shader>(GenerateShader(Constants::Paths::cubemapVertex, Constants::Paths::prefilterFrag));
+        s_prefilterShader->SetUniformInt("environmentMap", 0);
+    }
+
+    // Environment is sampled with mips by the prefilter shader
+    __environmentMap = AllocateCubemap(__captureResolution, true);
+    __prefilterMaps[0] = AllocateCubemap(__prefilterResolution, true);
+    __prefilterMaps[1] = AllocateCubemap(__prefilterResolution, true);
+
+    glGenFramebuffers(1, &__captureFbo);
+    glGenRenderbuffers(1, &__captureRbo);
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, __captureFbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, __captureRbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, __captureResolution, __captureResolution);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, __captureRbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Own CameraProps block, bound in place of the camera's one while capturing
+    glGenBuffers(1, &__uboCaptureProps);
+    OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, __uboCaptureProps);
+    glBufferData(GL_UNIFORM_BUFFER, cameraPropsSize, NULL, GL_DYNAMIC_DRAW);
+    OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    probes.push_back(this);
+}
+
+ReflectionProbe::~ReflectionProbe()
+{
+    probes.erase(std::remove(probes.begin(), probes.end(), this), probes.end());
+    if (nextProbe >= probes.size()) nextProbe = 0;
+
+    OpenGL_State::DeleteTextures(1, &__environmentMap);
+    OpenGL_State::DeleteTextures(2, __prefilterMaps.data());
+    OpenGL_State::DeleteFramebuffers(1, &__captureFbo);
+    glDeleteRenderbuffers(1, &__captureRbo);
+    OpenGL_State::DeleteBuffers(1, &__uboCaptureProps);
+}
+
+GLuint ReflectionProbe::GetPrefilterMap() const
+{
+    return __prefilterMaps[__frontPrefilter];
+}
+
+bool ReflectionProbe::IsReady() const
+{
+    return __ready;
+}
+
+void ReflectionProbe::Invalidate()
+{
+    __step = 0;
+    __frozen = false;
+}
+
+const ReflectionProbe * ReflectionProbe::FindClosest(const glm::vec3 & worldPosition)
+{
+    const ReflectionProbe * closest = nullptr;
+    float closestDistance2 = 0.0f;
+    for (const ReflectionProbe * probe : probes)
+    {
+        if (!probe->__ready) continue;
+
+        const glm::vec3 delta = probe->position - worldPosition;
+        const float distance2 = glm::dot(delta, delta);
+        if (distance2 > probe->radius * probe->radius) continue;
+        if (!closest || distance2 < closestDistance2)
+        {
+            closest = probe;
+            closestDistance2 = distance2;
+        }
+    }
+    return closest;
+}
+
+void ReflectionProbe::UpdateProbes()
+{
+    lastFrameSteps = 0;
+    if (!timers) timers = std::make_unique<std::array<OpenGL_Timer, timersCount>>();
+
+    // Reading back finished measures to refine the cost of a step
+    for (size_t i = 0; i < timersCount; ++i)
+    {
+        if (timersSteps[i] == 0 || !(*timers)[i].IsResultAvailable()) continue;
+
+        const float stepMs = static_cast<float>((*timers)[i].GetResult()) / 1e6f / timersSteps[i];
+        estimatedStepMs = estimatedStepMs * 0.8f + stepMs * 0.2f;
+        timersSteps[i] = 0;
+    }
+
+    if (!settings.enabled || probes.empty()) return;
+
+    // Unused budget is carried over (up to one step) so that steps more expensive than
+    // the budget still happen, just not every frame.
+    budgetCreditMs = std::min(budgetCreditMs + settings.budgetMs, std::max(settings.budgetMs, estimatedStepMs));
+
+    int steps = 0;
+    while (steps < settings.maxStepsPerFrame && budgetCreditMs >= estimatedStepMs)
+    {
+        // Probes never captured first, then round robin
+        ReflectionProbe * probe = nullptr;
+        for (ReflectionProbe * p : probes)
+        {
+            if (!p->__ready && !p->__frozen) { probe = p; break; }
+        }
+        for (size_t i = 0; !probe && i < probes.size(); ++i)
+        {
+            ReflectionProbe * p = probes[(nextProbe + i) % probes.size()];
+            if (!p->__frozen) probe = p;
+        }
+        if (!probe) break;
+
+        // Measuring the whole frame slice at once, timer is only started if there's work
+        if (steps == 0)
+        {
+            if (timersSteps[currentTimer] != 0) break; // previous measure on this timer still pending
+            (*timers)[currentTimer].Start();
+        }
+
+        probe->Step();
+        budgetCreditMs -= estimatedStepMs;
+        ++steps;
+
+        // Moving to the next probe once this one finished a cycle
+        if (probe->__step == 0)
+            nextProbe = (std::find(probes.begin(), probes.end(), probe) - probes.begin() + 1) % probes.size();
+    }
+
+    if (steps > 0)
+    {
+        (*timers)[currentTimer].Stop();
+        timersSteps[currentTimer] = steps;
+        currentTimer = (currentTimer + 1) % timersCount;
+
+        // Restoring main camera & default framebuffer
+        OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (mainCamera)
+            OpenGL_State::BindBufferRange(GL_UNIFORM_BUFFER, Constants::UBO::Ids::cameraProps, mainCamera->GetProjViewMatrixUbo(), 0, cameraPropsSize);
+        LightClusters::Bind(true);
+        OpenGL_State::Viewport(0, 0, Window::Get()->windowWidth(), Window::Get()->windowHeight());
+    }
+    lastFrameSteps = steps;
+}
+
+void ReflectionProbe::ReleaseResources()
+{
+    // Pending measures are dropped with their queries
+    timers.reset();
+    timersSteps.fill(0);
+    currentTimer = 0;
+    s_prefilterShader.reset();
+}
+
+float ReflectionProbe::GetEstimatedStepMs()
+{
+    return estimatedStepMs;
+}
+
+int ReflectionProbe::GetLastFrameSteps()
+{
+    return lastFrameSteps;
+}
+
+const std::vector<ReflectionProbe *> & ReflectionProbe::GetAllProbes()
+{
+    return probes;
+}
+
+void ReflectionProbe::Step()
+{
+    if (__step < captureStepsCount)
+    {
+        CaptureFace(__step);
+    }
+    else
+    {
+        const int prefilterStep = __step - captureStepsCount;
+        PrefilterFace(prefilterStep / 6, prefilterStep % 6);
+    }
+
+    if (++__step == totalStepsCount)
+    {
+        // Full cycle done, showing the new prefiltered map
+        __frontPrefilter = 1 - __frontPrefilter;
+        __ready = true;
+        __step = 0;
+        __frozen = !continuous;
+    }
+}
+
+void ReflectionProbe::CaptureFace(int face)
+{
+    const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, captureFar);
+    const glm::mat4 view = captureViews[face] * glm::translate(glm::mat4(1.0f), -position);
+    const glm::mat4 viewProj = projection * view;
+    const glm::vec4 viewPos(position, 1.0f);
+
+    OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, __uboCaptureProps);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::vec4), glm::value_ptr(viewPos));
+    glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::vec4), sizeof(glm::mat4), glm::value_ptr(viewProj));
+    glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::vec4) + sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(view));
+    glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::vec4) + 2 * sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(projection));
+    OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, 0);
+    OpenGL_State::BindBufferRange(GL_UNIFORM_BUFFER, Constants::UBO::Ids::cameraProps, __uboCaptureProps, 0, cameraPropsSize);
+    // Clusters belong to the main camera
+    LightClusters::Bind(false);
+
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, __captureFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, __environmentMap, 0);
+    OpenGL_State::Viewport(0, 0, __captureResolution, __captureResolution);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    if (s_cubemap) Rendering::DrawBrdfCubemap(*s_cubemap);
+    for (Entity * entity : Entity::GetAllEntities())
+        Rendering::DrawFaces(*entity);
+
+    // Prefiltering samples the environment with mips
+    if (face == captureStepsCount - 1)
+    {
+        OpenGL_State::BindTexture(GL_TEXTURE_CUBE_MAP, __environmentMap);
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    }
+}
+
+void ReflectionProbe::PrefilterFace(int mip, int face)
+{
+    static const glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+    const int mipResolution = std::max(1, __prefilterResolution >> mip);
+    const GLuint backPrefilter = __prefilterMaps[1 - __frontPrefilter];
+
+    Shader & shader = *s_prefilterShader;
+    shader.Use();
+    shader.SetUniformMatrix4f("projection", captureProjection);
+    shader.SetUniformMatrix4f("view", captureViews[face]);
+    shader.SetUniformFloat("roughness", static_cast<float>(mip) / static_cast<float>(prefilterMipsCount - 1));
+    shader.SetUniformFloat("environmentResolution", static_cast<float>(__captureResolution));
+    OpenGL_State::BindTextureUnit(0, __environmentMap);
+
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, __captureFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, backPrefilter, mip);
+    OpenGL_State::Viewport(0, 0, mipResolution, mipResolution);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    Rendering::RenderCube();
+}
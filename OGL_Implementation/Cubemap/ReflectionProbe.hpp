@@ -0,0 +1,147 @@
+/*****************************************************************//**
+ * \file   ReflectionProbe.hpp
+ * \brief  Local reflection probes, re-captured incrementally
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 04 2022
+ *********************************************************************/
+#pragma once
+
+// Project includes
+#include "OGL_Implementation\OpenGL_Timer.hpp"
+
+// GLM includes
+#include <glm\glm.hpp>
+
+// C++ includes
+#include <array>
+#include <vector>
+
+/**
+ * @brief Local specular environment captured from a position of the scene.
+ * Instead of capturing 6 faces + prefiltering 5 mips at once, the work is split in small
+ * steps (1 face capture or 1 face of 1 prefilter mip) spread over frames by UpdateProbes.
+ * Prefiltered maps are double buffered so entities never sample a half updated probe.
+*/
+class ReflectionProbe
+{
+public:
+    /**
+     * @brief Per frame update settings
+    */
+    struct Settings
+    {
+        /**
+         * @brief Enables probes updates
+        */
+        bool enabled = true;
+        /**
+         * @brief Maximum steps (face captures or prefilter faces) per frame
+        */
+        int maxStepsPerFrame = 4;
+        /**
+         * @brief GPU time budget per frame in milliseconds
+        */
+        float budgetMs = 0.5f;
+    };
+
+    /**
+     * @brief Number of prefiltered mips (same as MAX_REFLECTION_LOD + 1 in pbr.frag.glsl)
+    */
+    static constexpr const int prefilterMipsCount = 5;
+
+public:
+    /**
+     * @brief Creates probe, first capture is done progressively by UpdateProbes
+     * @param position_ capture position
+     * @param radius_ influence radius, entities further than that use the global cubemap
+     * @param captureResolution_ resolution of the captured environment faces
+     * @param prefilterResolution_ resolution of the prefiltered mip 0
+    */
+    ReflectionProbe(const glm::vec3 & position_, float radius_ = 10.0f, int captureResolution_ = 128, int prefilterResolution_ = 64);
+    ~ReflectionProbe();
+
+    /**
+     * @brief Returns prefiltered map entities should sample
+     * @return cubemap id
+    */
+    GLuint GetPrefilterMap() const;
+
+    /**
+     * @brief Returns true if a full capture has been done at least once
+     * @return ready
+    */
+    bool IsReady() const;
+
+    /**
+     * @brief Restarts capture from the first face
+    */
+    void Invalidate();
+
+    /**
+     * @brief Returns closest ready probe whose radius contains the position
+     * @param worldPosition
+     * @return probe or nullptr
+    */
+    static const ReflectionProbe * FindClosest(const glm::vec3 & worldPosition);
+
+    /**
+     * @brief Advances probes captures according to settings, to call once per frame
+     * after lights have been refreshed.
+    */
+    static void UpdateProbes();
+
+    /**
+     * @brief Releases the OpenGL objects shared by probes (prefilter shader & timers),
+     * to call before the window & its context are destroyed.
+    */
+    static void ReleaseResources();
+
+    /**
+     * @brief Returns estimated GPU cost of one step in ms
+     * @return ms
+    */
+    static float GetEstimatedStepMs();
+
+    /**
+     * @brief Returns steps done last frame
+     * @return steps
+    */
+    static int GetLastFrameSteps();
+
+    static const std::vector<ReflectionProbe *> & GetAllProbes();
+
+private:
+    /**
+     * @brief Does the next step of the probe
+    */
+    void Step();
+    void CaptureFace(int face);
+    void PrefilterFace(int mip, int face);
+
+public:
+    glm::vec3 position;
+    float radius;
+    float captureFar;
+    /**
+     * @brief If false, stops updating after the first full capture until Invalidate is called
+    */
+    bool continuous;
+
+    static Settings settings;
+
+private:
+    const int __captureResolution;
+    const int __prefilterResolution;
+    GLuint __environmentMap;
+    std::array<GLuint, 2> __prefilterMaps;
+    int __frontPrefilter;
+    GLuint __captureFbo, __captureRbo;
+    GLuint __uboCaptureProps;
+    /**
+     * @brief [0, 6[ = captures, [6, 6 + 6 * prefilterMipsCount[ = prefilter faces
+    */
+    int __step;
+    bool __ready;
+    bool __frozen;
+};
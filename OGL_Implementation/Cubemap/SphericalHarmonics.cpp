@@ -0,0 +1,175 @@
+/*****************************************************************//**
+ * \file   SphericalHarmonics.cpp
+ * \brief  SphericalHarmonics source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 02 2022
+ *********************************************************************/
+#include "SphericalHarmonics.hpp"
+
+// Project includes
+#include "OGL_Implementation\Tools\ThreadPool.hpp"
+
+// C++ includes
+#include <vector>
+#include <cmath>
+
+// SIMD includes
+#if defined(_M_X64) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define SH_USE_SSE 1
+#endif
+
+static constexpr const double pi = 3.14159265358979323846;
+
+// Basis normalization constants, Y_i = K_i * polynomial_i(x, y, z)
+static constexpr const float shBasisConstants[SphericalHarmonics::coefficientsCount] = {
+    0.282095f,                      // 1
+    0.488603f, 0.488603f, 0.488603f,// y, z, x
+    1.092548f, 1.092548f,           // xy, yz
+    0.315392f,                      // 3z^2 - 1
+    1.092548f,                      // xz
+    0.546274f                       // x^2 - y^2
+};
+
+// Cosine lobe convolution per band (A0 = PI, A1 = 2PI/3, A2 = PI/4), divided by PI
+static constexpr const float shBandConvolution[SphericalHarmonics::coefficientsCount] = {
+    1.0f,
+    2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f
+};
+
+// 9 coefficients * 3 channels
+using ShAccumulator = std::array<double, SphericalHarmonics::coefficientsCount * 3>;
+
+SphericalHarmonics::SphericalHarmonics()
+    : __coefficients{}
+{
+}
+
+static inline void AccumulatePixel(float * sums, float x, float y, float z, const float * pixel)
+{
+    const float basis[SphericalHarmonics::coefficientsCount] = {
+        1.0f, y, z, x, x * y, y * z, 3.0f * z * z - 1.0f, x * z, x * x - y * y
+    };
+    for (int i = 0; i < SphericalHarmonics::coefficientsCount; ++i)
+    {
+        sums[i * 3 + 0] += basis[i] * pixel[0];
+        sums[i * 3 + 1] += basis[i] * pixel[1];
+        sums[i * 3 + 2] += basis[i] * pixel[2];
+    }
+}
+
+void SphericalHarmonics::Project(const float * pixels, int width, int height, int channels)
+{
+    if (!pixels || width <= 0 || height <= 0 || channels < 3) return;
+
+    // phi only depends on the column, computing it once for all rows
+    std::vector<float> cosPhi(width), sinPhi(width);
+    for (int x = 0; x < width; ++x)
+    {
+        const double phi = ((x + 0.5) / width - 0.5) * 2.0 * pi;
+        cosPhi[x] = static_cast<float>(std::cos(phi));
+        sinPhi[x] = static_cast<float>(std::sin(phi));
+    }
+
+    const double dPhi = 2.0 * pi / width;
+    const double dTheta = pi / height;
+
+    ThreadPool & pool = ThreadPool::Get();
+    std::vector<ShAccumulator> partialSums(pool.GetMaxChunkCount(), ShAccumulator{});
+
+    pool.ParallelFor(height, [&](size_t begin, size_t end, size_t chunkId)
+    {
+        ShAccumulator & chunkSums = partialSums[chunkId];
+        for (size_t row = begin; row < end; ++row)
+        {
+            const double latitude = ((row + 0.5) / height - 0.5) * pi;
+            const float cosLat = static_cast<float>(std::cos(latitude));
+            const float y = static_cast<float>(std::sin(latitude));
+            const float * rowPixels = pixels + row * width * channels;
+
+            // Row sums are kept in float (short sums), chunk sums in double
+            float rowSums[coefficientsCount * 3] = {};
+            int x = 0;
+#ifdef SH_USE_SSE
+            __m128 acc[coefficientsCount * 3];
+            for (auto & a : acc) a = _mm_setzero_ps();
+
+            const __m128 vY = _mm_set1_ps(y);
+            const __m128 vCosLat = _mm_set1_ps(cosLat);
+            const __m128 vOne = _mm_set1_ps(1.0f);
+            const __m128 vThree = _mm_set1_ps(3.0f);
+            const __m128 vYY = _mm_mul_ps(vY, vY);
+            for (; x + 4 <= width; x += 4)
+            {
+                const float * p = rowPixels + x * channels;
+                const __m128 r = _mm_setr_ps(p[0], p[channels], p[2 * channels], p[3 * channels]);
+                const __m128 g = _mm_setr_ps(p[1], p[channels + 1], p[2 * channels + 1], p[3 * channels + 1]);
+                const __m128 b = _mm_setr_ps(p[2], p[channels + 2], p[2 * channels + 2], p[3 * channels + 2]);
+
+                const __m128 vX = _mm_mul_ps(vCosLat, _mm_loadu_ps(&cosPhi[x]));
+                const __m128 vZ = _mm_mul_ps(vCosLat, _mm_loadu_ps(&sinPhi[x]));
+
+                const __m128 basis[coefficientsCount] = {
+                    vOne,
+                    vY,
+                    vZ,
+                    vX,
+                    _mm_mul_ps(vX, vY),
+                    _mm_mul_ps(vY, vZ),
+                    _mm_sub_ps(_mm_mul_ps(vThree, _mm_mul_ps(vZ, vZ)), vOne),
+                    _mm_mul_ps(vX, vZ),
+                    _mm_sub_ps(_mm_mul_ps(vX, vX), vYY)
+                };
+                for (int i = 0; i < coefficientsCount; ++i)
+                {
+                    acc[i * 3 + 0] = _mm_add_ps(acc[i * 3 + 0], _mm_mul_ps(basis[i], r));
+                    acc[i * 3 + 1] = _mm_add_ps(acc[i * 3 + 1], _mm_mul_ps(basis[i], g));
+                    acc[i * 3 + 2] = _mm_add_ps(acc[i * 3 + 2], _mm_mul_ps(basis[i], b));
+                }
+            }
+            for (int i = 0; i < coefficientsCount * 3; ++i)
+            {
+                alignas(16) float lanes[4];
+                _mm_store_ps(lanes, acc[i]);
+                rowSums[i] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+            }
+#endif
+            // Remaining pixels (or every pixel without SSE)
+            for (; x < width; ++x)
+                AccumulatePixel(rowSums, cosLat * cosPhi[x], y, cosLat * sinPhi[x], rowPixels + x * channels);
+
+            // Solid angle of a texel of this row
+            const double dOmega = dPhi * dTheta * cosLat;
+            for (int i = 0; i < coefficientsCount * 3; ++i)
+                chunkSums[i] += rowSums[i] * dOmega;
+        }
+    }, 8);
+
+    ShAccumulator total{};
+    for (const auto & sums : partialSums)
+        for (int i = 0; i < coefficientsCount * 3; ++i)
+            total[i] += sums[i];
+
+    for (int i = 0; i < coefficientsCount; ++i)
+    {
+        __coefficients[i] = glm::vec3(
+            static_cast<float>(total[i * 3 + 0]),
+            static_cast<float>(total[i * 3 + 1]),
+            static_cast<float>(total[i * 3 + 2])) * shBasisConstants[i];
+    }
+}
+
+const std::array<glm::vec3, SphericalHarmonics::coefficientsCount> & SphericalHarmonics::GetCoefficients() const
+{
+    return __coefficients;
+}
+
+SphericalHarmonics_Shader SphericalHarmonics::GetShaderInfo() const
+{
+    SphericalHarmonics_Shader info;
+    for (int i = 0; i < coefficientsCount; ++i)
+        info.coefficients[i] = glm::vec4(__coefficients[i] * shBandConvolution[i] * shBasisConstants[i], 0.0f);
+    return info;
+}
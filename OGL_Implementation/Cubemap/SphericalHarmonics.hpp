@@ -0,0 +1,65 @@
+/*****************************************************************//**
+ * \file   SphericalHarmonics.hpp
+ * \brief  Spherical Harmonics projection of environment maps
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 02 2022
+ *********************************************************************/
+#pragma once
+
+// GLM includes
+#include <glm\glm.hpp>
+
+// C++ includes
+#include <array>
+
+/**
+ * @brief Irradiance coefficients given to shaders (std140 layout),
+ * xyz = rgb coefficient, w = padding
+*/
+struct SphericalHarmonics_Shader
+{
+    glm::vec4 coefficients[9];
+};
+
+/**
+ * @brief 3 bands (9 coefficients) spherical harmonics of an equirectangular environment map.
+ * Diffuse irradiance is directly evaluated from these coefficients in shaders
+ * instead of sampling a convoluted cubemap.
+*/
+class SphericalHarmonics
+{
+public:
+    static constexpr const int coefficientsCount = 9;
+
+public:
+    SphericalHarmonics();
+
+    /**
+     * @brief Projects an equirectangular environment map (same mapping as
+     * equirectangular_to_cubemap.frag.glsl, rows flipped like stbi does on load)
+     * onto the SH basis, work is split by rows between ThreadPool workers.
+     * @param pixels float pixels, row major
+     * @param width
+     * @param height
+     * @param channels number of floats per pixel (>= 3)
+    */
+    void Project(const float * pixels, int width, int height, int channels);
+
+    /**
+     * @brief Returns radiance coefficients (L_lm) of the last projection
+     * @return coefficients
+    */
+    const std::array<glm::vec3, coefficientsCount> & GetCoefficients() const;
+
+    /**
+     * @brief Returns coefficients ready to be uploaded, already convolved with the
+     * cosine lobe, divided by PI (to match the irradiance cubemap convention) and
+     * multiplied by the basis normalization constants.
+     * @return shader info
+    */
+    SphericalHarmonics_Shader GetShaderInfo() const;
+
+private:
+    std::array<glm::vec3, coefficientsCount> __coefficients;
+};
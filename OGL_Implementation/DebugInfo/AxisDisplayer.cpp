@@ -9,6 +9,7 @@
 
 // Project includes
 #include "OGL_Implementation\Window.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
 
 AxisDisplayer::AxisDisplayer(const Shader & shader_, const GLfloat axisSize)
     : pos{ 0.07f, 0.1f }
@@ -22,9 +23,9 @@ AxisDisplayer::AxisDisplayer(const Shader & shader_, const GLfloat axisSize)
             0.0f, 0.0f, 0.0f,
             axisSize, 0.0f, 0.0f
         };
-        glBindVertexArray(__xVAO);
+        OpenGL_State::BindVertexArray(__xVAO);
         // Fill mesh buffer
-        glBindBuffer(GL_ARRAY_BUFFER, __xVBO);
+        OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __xVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         // Set mesh attributes
         glEnableVertexAttribArray(0);
@@ -35,9 +36,9 @@ AxisDisplayer::AxisDisplayer(const Shader & shader_, const GLfloat axisSize)
             0.0f, 0.0f, 0.0f,
             0.0f, axisSize, 0.0f
         };
-        glBindVertexArray(__yVAO);
+        OpenGL_State::BindVertexArray(__yVAO);
         // Fill mesh buffer
-        glBindBuffer(GL_ARRAY_BUFFER, __yVBO);
+        OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __yVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         // Set mesh attributes
         glEnableVertexAttribArray(0);
@@ -48,9 +49,9 @@ AxisDisplayer::AxisDisplayer(const Shader & shader_, const GLfloat axisSize)
             0.0f, 0.0f, 0.0f,
             0.0f, 0.0f, axisSize
         };
-        glBindVertexArray(__zVAO);
+        OpenGL_State::BindVertexArray(__zVAO);
         // Fill mesh buffer
-        glBindBuffer(GL_ARRAY_BUFFER, __zVBO);
+        OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __zVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         // Set mesh attributes
         glEnableVertexAttribArray(0);
@@ -60,8 +61,8 @@ AxisDisplayer::AxisDisplayer(const Shader & shader_, const GLfloat axisSize)
 
 AxisDisplayer::~AxisDisplayer()
 {
-    glDeleteVertexArrays(3, &__xVAO);
-    glDeleteBuffers(3, &__xVBO);
+    OpenGL_State::DeleteVertexArrays(3, &__xVAO);
+    OpenGL_State::DeleteBuffers(3, &__xVBO);
 }
 
 void AxisDisplayer::Draw()
@@ -82,13 +83,13 @@ void AxisDisplayer::Draw()
 
     glLineWidth(3.0f);
 
-    glBindVertexArray(__xVAO);
+    OpenGL_State::BindVertexArray(__xVAO);
     glDrawArrays(GL_LINES, 0, 2);
-    glBindVertexArray(__yVAO);
+    OpenGL_State::BindVertexArray(__yVAO);
     glDrawArrays(GL_LINES, 0, 2);
-    glBindVertexArray(__zVAO);
+    OpenGL_State::BindVertexArray(__zVAO);
     glDrawArrays(GL_LINES, 0, 2);
-    glBindVertexArray(0);
+    OpenGL_State::BindVertexArray(0);
 
     glLineWidth(1.0f);
 }
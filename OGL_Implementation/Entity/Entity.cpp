@@ -8,6 +8,7 @@
 #include "Entity.hpp"
 
 // C++ includes
+#include <algorithm>
 #include <limits>
 
 static std::unique_ptr<Shader> defaultPointShader(nullptr);
@@ -33,6 +34,11 @@ Entity::Entity(const Mesh & mesh,
     , scale{ defaultScale }
     , quat{ defaultEulerAngles }
     , name{ std::format("Entity{0}", nameGiver++)}
+    , shaderFeatures{ ShadowFeature }
+    , transparent{ false }
+    , castsShadows{ true }
+    , __boundsMesh{ nullptr }
+    , __boundsVersion{ 0 }
 {
     entities.emplace_back(this);
 }
@@ -126,6 +132,46 @@ glm::mat4 Entity::GetModelMatrix(bool ignoreRotation, bool ignoreScale) const
     return mat;
 }
 
+const BoundingBox & Entity::GetWorldBoundingBox() const
+{
+    UpdateWorldBounds();
+    return __worldBox;
+}
+
+const BoundingSphere & Entity::GetWorldBoundingSphere() const
+{
+    UpdateWorldBounds();
+    return __worldSphere;
+}
+
+void Entity::UpdateWorldBounds() const
+{
+    const Mesh_Base * mesh = *__mesh;
+    // Parents transforms aren't tracked, children are recomputed every time
+    if (mesh == __boundsMesh && mesh->GetBoundsVersion() == __boundsVersion && !HasParent()
+        && pos == __boundsPos && scale == __boundsScale && quat == __boundsQuat)
+        return;
+
+    __boundsMesh = mesh;
+    __boundsVersion = mesh->GetBoundsVersion();
+    __boundsPos = pos;
+    __boundsScale = scale;
+    __boundsQuat = quat;
+
+    if (!mesh->GetBoundingBox().IsValid())
+    {
+        __worldBox = BoundingBox::Infinite();
+        __worldSphere = { glm::vec3(0.0f), std::numeric_limits<float>::max() };
+        return;
+    }
+
+    const glm::mat4 model = GetModelMatrix();
+    __worldBox = mesh->GetBoundingBox().Transform(model);
+    const BoundingSphere & sphere = mesh->GetBoundingSphere();
+    const float maxScale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+    __worldSphere = { glm::vec3(model * glm::vec4(sphere.center, 1.0f)), sphere.radius * maxScale };
+}
+
 glm::vec3 Entity::GetLocalPosition() const
 {
     return pos;
@@ -27,6 +27,7 @@
 
 // C++ includes
 #include <memory>
+#include <optional>
 
 /**
  * @brief Representation of an entity with a mesh,
@@ -86,6 +87,14 @@ public:
      * @return Model Matrix
     */
     virtual glm::mat4 GetModelMatrix(bool ignoreRotation = false, bool ignoreScale = false) const;
+    /**
+     * @brief World space bounds of the mesh, recomputed only when the transform
+     * or the mesh bounds changed since the last call.
+     * Meshes without bounds give an infinite box (never culled).
+     * @return world bounding box
+    */
+    const BoundingBox & GetWorldBoundingBox() const;
+    const BoundingSphere & GetWorldBoundingSphere() const;
 
     // AEntity abstract
     virtual glm::vec3 GetLocalPosition() const;
@@ -109,6 +118,25 @@ public:
      * @brief Name
     */
     std::string name;
+    /**
+     * @brief Shader features (ShaderFeature bitmask) compiled in the face shader variant,
+     * attributes features are added to them.
+    */
+    ShaderFeatures shaderFeatures;
+    /**
+     * @brief Blended entity, drawn after opaque ones from back to front (see RenderQueue)
+    */
+    bool transparent;
+    /**
+     * @brief Drawn in shadow maps of lights (see LightRendering)
+    */
+    bool castsShadows;
+    /**
+     * @brief Mesh rasterized in the software depth buffer of the OcclusionCuller,
+     * hiding entities behind it. A low poly mesh fully inside the entity
+     * (e.g. from Mesh::Simplify) keeps it cheap & conservative.
+    */
+    std::optional<Mesh> occluder;
 
 private:
     /**
@@ -120,6 +148,17 @@ private:
     */
     Shader __shaderPoint, __shaderWireframe, __shaderFace;
     Texture __texture;
+
+    void UpdateWorldBounds() const;
+    /**
+     * @brief World bounds & the state they were computed from
+    */
+    mutable BoundingBox __worldBox;
+    mutable BoundingSphere __worldSphere;
+    mutable glm::vec3 __boundsPos, __boundsScale;
+    mutable glm::quat __boundsQuat;
+    mutable const Mesh_Base * __boundsMesh;
+    mutable uint32_t __boundsVersion;
 };
 
 void SetDefaultPointShader(const Shader & shader);
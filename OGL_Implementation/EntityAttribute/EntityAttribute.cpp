@@ -14,3 +14,8 @@ EntityAttribute::EntityAttribute()
 EntityAttribute::~EntityAttribute()
 {
 }
+
+ShaderFeatures EntityAttribute::GetShaderFeatures() const
+{
+    return NoShaderFeature;
+}
@@ -25,4 +25,11 @@ public:
      * manipulation.
     */
     virtual void Render(Shader & shader) = 0;
+
+    /**
+     * @brief Returns shader features this attribute needs, the entity is then
+     * drawn with the variant compiled with them.
+     * @return features
+    */
+    virtual ShaderFeatures GetShaderFeatures() const;
 };
@@ -7,7 +7,8 @@
  *********************************************************************/
 #include "Material.hpp"
 
-#include "OGL_Implementation\Rendering\LightRendering.hpp"
+#include "Constants.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
 
 Material::Material(const glm::vec3 & diffuse_, const glm::vec3 & specular_, const float shininess_)
     : EntityAttribute()
@@ -26,35 +27,29 @@ Material::~Material()
 
 void Material::Render(Shader & shader)
 {
-    int textureID = 0;
-    auto checker = [&](const MaterialMapType mapType, const glm::vec3 & color, const Texture texture,
-                       const char * useColorName, const char * colorName, const char * textureName) {
+    // Samplers are set when programs are linked, shadow maps are bound once per frame
+    auto checker = [&](const MaterialMapType mapType, const glm::vec3 & color, const Texture & texture,
+                       const UniformName colorName, const GLuint textureUnit) {
         switch (mapType)
         {
             case MaterialMapType::Color:
-                shader.SetUniformInt(useColorName, 1);
                 shader.SetUniformFloat(colorName, color);
                 break;
             case MaterialMapType::Texture:
-                shader.SetUniformInt(useColorName, 0);
-                shader.SetUniformInt(textureName, textureID);
-                glActiveTexture(GL_TEXTURE0 + textureID++);
-                glBindTexture(GL_TEXTURE_2D, texture.GetTexture());
+                OpenGL_State::BindTextureUnit(textureUnit, texture.GetTexture());
                 break;
         }
     };
-    checker(diffuseMapType, diffuseColor, diffuseTexture, "material.diffuseUseColor", "material.diffuseColor", "material.diffuseTexture");
-    checker(specularMapType, specularColor, specularTexture, "material.specularUseColor", "material.specularColor", "material.specularTexture");
-
-    const auto shadowMaps = LightRendering::Get().shadowMaps;
-    std::vector<int> values(128, textureID);
-    for (int i = 0; i < PointLight::GetPointLightsCount(); ++i)
-    {
-        values[i] = textureID + i;
-        glActiveTexture(GL_TEXTURE0 + values[i]);
-        glBindTexture(GL_TEXTURE_2D, shadowMaps[i]);
-    }
-    shader.SetUniformInt("shadowMapsPerPointLight", values);
+    checker(diffuseMapType, diffuseColor, diffuseTexture, "material.diffuseColor", Constants::TextureUnits::diffuseTexture);
+    checker(specularMapType, specularColor, specularTexture, "material.specularColor", Constants::TextureUnits::specularTexture);
 
     shader.SetUniformFloat("material.shininess", shininess);
 }
+
+ShaderFeatures Material::GetShaderFeatures() const
+{
+    ShaderFeatures features = NoShaderFeature;
+    if (diffuseMapType == MaterialMapType::Color) features |= DiffuseColorFeature;
+    if (specularMapType == MaterialMapType::Color) features |= SpecularColorFeature;
+    return features;
+}
@@ -24,6 +24,7 @@ public:
     ~Material();
 
     void Render(Shader & shader) override;
+    ShaderFeatures GetShaderFeatures() const override;
 
 public:
     enum class MaterialMapType : unsigned char
@@ -8,7 +8,8 @@
 #include "Pbr_Material.hpp"
 
 #include "OGL_Implementation\Cubemap\Brdf_Cubemap.hpp"
-#include "OGL_Implementation\Rendering\LightRendering.hpp"
+#include "Constants.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
 
 Pbr_Material::Pbr_Material(const char * albedoMap, const char * normalMap, const char * metallicMap, const char * roughnessMap, const char * aoMap)
 {
@@ -24,43 +25,16 @@ Pbr_Material::~Pbr_Material()
 
 void Pbr_Material::Render(Shader & shader)
 {
-    if (s_cubemap)
-    {
-        shader.SetUniformInt("irradianceMap", 0);
-        shader.SetUniformInt("prefilterMap", 1);
-        shader.SetUniformInt("brdfLUT", 2);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, s_cubemap->irradianceMap);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, s_cubemap->prefilterMap);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, s_cubemap->brdfLUTTexture);
-    }
-
-    shader.SetUniformInt("albedoMap", 3);
-    shader.SetUniformInt("normalMap", 4);
-    shader.SetUniformInt("metallicMap", 5);
-    shader.SetUniformInt("roughnessMap", 6);
-    shader.SetUniformInt("aoMap", 7);
-
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, albedo.GetTexture());
-    glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_2D, normal.GetTexture());
-    glActiveTexture(GL_TEXTURE5);
-    glBindTexture(GL_TEXTURE_2D, metallic.GetTexture());
-    glActiveTexture(GL_TEXTURE6);
-    glBindTexture(GL_TEXTURE_2D, roughness.GetTexture());
-    glActiveTexture(GL_TEXTURE7);
-    glBindTexture(GL_TEXTURE_2D, ao.GetTexture());
+    // Samplers are set when programs are linked, IBL & shadow maps are bound once per frame
+    // (see Rendering::BindFrameTextures), only the material's own textures are left
+    OpenGL_State::BindTextureUnit(Constants::TextureUnits::albedoMap, albedo.GetTexture());
+    OpenGL_State::BindTextureUnit(Constants::TextureUnits::normalMap, normal.GetTexture());
+    OpenGL_State::BindTextureUnit(Constants::TextureUnits::metallicMap, metallic.GetTexture());
+    OpenGL_State::BindTextureUnit(Constants::TextureUnits::roughnessMap, roughness.GetTexture());
+    OpenGL_State::BindTextureUnit(Constants::TextureUnits::aoMap, ao.GetTexture());
+}
 
-    const auto shadowMaps = LightRendering::Get().shadowMaps;
-    std::vector<int> values(128, 31);
-    for (int i = 0; i < PointLight::GetPointLightsCount(); ++i)
-    {
-        values[i] = 8 + i;
-        glActiveTexture(GL_TEXTURE0 + values[i]);
-        glBindTexture(GL_TEXTURE_2D, shadowMaps[i]);
-    }
-    shader.SetUniformInt("shadowMapsPerPointLight", values);
+ShaderFeatures Pbr_Material::GetShaderFeatures() const
+{
+    return (s_cubemap && s_cubemap->UsesSphericalHarmonics()) ? IrradianceSHFeature : NoShaderFeature;
 }
@@ -23,6 +23,7 @@ public:
     ~Pbr_Material();
 
     void Render(Shader & shader) override;
+    ShaderFeatures GetShaderFeatures() const override;
 
     Texture albedo, normal, metallic, roughness, ao;
 };
@@ -1,40 +1,48 @@
 #include "ShaderAttribute.hpp"
 
-ShaderAttribute::ShaderAttribute(const int val)
-    : __data{new int(val)}
+// C++ includes
+#include <cstring>
+
+ShaderAttribute::ShaderAttribute(const std::string & name_, const int val)
+    : name{ name_ }
+    , uniformName{ name_ }
     , __dataType{ ShaderAttributeType::Int }
 {
+    memcpy(__data, &val, sizeof(val));
 }
 
-ShaderAttribute::ShaderAttribute(const float val)
-    : __data{new float(val)}
+ShaderAttribute::ShaderAttribute(const std::string & name_, const float val)
+    : name{ name_ }
+    , uniformName{ name_ }
     , __dataType{ ShaderAttributeType::Float }
 {
+    memcpy(__data, &val, sizeof(val));
 }
 
-ShaderAttribute::ShaderAttribute(const glm::mat4 & val)
-    : __data{ new glm::mat4(val) }
+ShaderAttribute::ShaderAttribute(const std::string & name_, const glm::mat4 & val)
+    : name{ name_ }
+    , uniformName{ name_ }
     , __dataType{ ShaderAttributeType::Matrix }
 {
+    memcpy(__data, &val, sizeof(val));
 }
 
 ShaderAttribute::~ShaderAttribute()
 {
-    if (__data) delete __data;
 }
 
-void ShaderAttribute::Render(const std::string & name, Shader & shader)
+void ShaderAttribute::Render(Shader & shader) const
 {
     switch (__dataType)
     {
         case ShaderAttributeType::Int:
-            shader.SetUniformInt(name.c_str(), *(int *)__data);
+            shader.SetUniformInt(uniformName, *(const int *)__data);
             break;
         case ShaderAttributeType::Float:
-            shader.SetUniformFloat(name.c_str(), *(float *)__data);
+            shader.SetUniformFloat(uniformName, *(const float *)__data);
             break;
         case ShaderAttributeType::Matrix:
-            shader.SetUniformMatrix4f(name.c_str(), *(glm::mat4 *)__data);
+            shader.SetUniformMatrix4f(uniformName, *(const glm::mat4 *)__data);
             break;
     }
 }
@@ -48,3 +56,14 @@ const void * ShaderAttribute::GetData() const
 {
     return __data;
 }
+
+size_t ShaderAttribute::GetSize() const
+{
+    switch (__dataType)
+    {
+        case ShaderAttributeType::Int:    return sizeof(int);
+        case ShaderAttributeType::Float:  return sizeof(float);
+        case ShaderAttributeType::Matrix: return sizeof(glm::mat4);
+    }
+    return 0;
+}
@@ -15,21 +15,41 @@
 
 // C++ includes
 #include <string>
+#include <cstddef>
 
 /**
- * @brief Shader Attribute, can be assigned any possible type used in GLSL
+ * @brief Shader Attribute, can be assigned any possible type used in GLSL.
+ * The value is stored inline (no allocation), with the std140 size of its type.
 */
 class ShaderAttribute
 {
 public:
-    ShaderAttribute(const int val);
-    ShaderAttribute(const float val);
-    ShaderAttribute(const glm::mat4 & val);
+    /**
+     * @brief Constructs attribute, its uniform name is hashed once here
+     * @param name_ uniform name
+     * @param val
+    */
+    ShaderAttribute(const std::string & name_, const int val);
+    ShaderAttribute(const std::string & name_, const float val);
+    ShaderAttribute(const std::string & name_, const glm::mat4 & val);
     ~ShaderAttribute();
 
-    void Render(const std::string & name, Shader & shader);
+    /**
+     * @brief Sets the value as a plain uniform (shaders without EntityAttributes block)
+     * @param shader
+    */
+    void Render(Shader & shader) const;
     void * GetData();
     const void * GetData() const;
+    /**
+     * @brief Returns size of the value in a std140 block
+     * @return size in bytes
+    */
+    size_t GetSize() const;
+
+public:
+    std::string name;
+    UniformName uniformName;
 
 private:
     enum class ShaderAttributeType : unsigned char
@@ -39,5 +59,5 @@ private:
         Matrix = 2
     };
     ShaderAttributeType __dataType;
-    void * __data;
+    alignas(16) std::byte __data[sizeof(glm::mat4)];
 };
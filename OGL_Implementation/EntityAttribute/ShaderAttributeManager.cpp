@@ -7,10 +7,140 @@
  *********************************************************************/
 #include "ShaderAttributeManager.hpp"
 
+// Project includes
+#include "Constants.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
+
+// C++ includes
+#include <algorithm>
+#include <cstring>
+
+/**
+ * @brief Bytes reserved per entity in the shared UBO, bigger blocks fall back to plain uniforms
+*/
+static constexpr const GLsizeiptr blockRangeSize = 256;
+
+static GLuint s_ubo = 0;
+/**
+ * @brief Capacity of s_ubo in ranges
+*/
+static GLsizeiptr s_uboCapacity = 0;
+static GLsizeiptr s_rangesCount = 0;
+static std::vector<GLintptr> s_freeRanges;
+
+static GLsizeiptr RangeStride()
+{
+    static GLint alignment = 0;
+    if (!alignment) glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    return ((blockRangeSize + alignment - 1) / alignment) * alignment;
+}
+
+static GLintptr AllocateRange()
+{
+    if (!s_freeRanges.empty())
+    {
+        const GLintptr range = s_freeRanges.back();
+        s_freeRanges.pop_back();
+        return range;
+    }
+
+    const GLsizeiptr stride = RangeStride();
+    if (s_rangesCount == s_uboCapacity)
+    {
+        // Grows the buffer, allocated ranges keep their offsets
+        const GLsizeiptr capacity = std::max<GLsizeiptr>(64, s_uboCapacity * 2);
+        GLuint ubo;
+        glGenBuffers(1, &ubo);
+        OpenGL_State::BindBuffer(GL_COPY_WRITE_BUFFER, ubo);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity * stride, NULL, GL_DYNAMIC_DRAW);
+        if (s_ubo)
+        {
+            OpenGL_State::BindBuffer(GL_COPY_READ_BUFFER, s_ubo);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, s_uboCapacity * stride);
+            OpenGL_State::DeleteBuffers(1, &s_ubo);
+        }
+        s_ubo = ubo;
+        s_uboCapacity = capacity;
+    }
+    return (s_rangesCount++) * stride;
+}
+
 ShaderAttributeManager::ShaderAttributeManager()
+    : __blockProgram{ 0 }
+    , __blockRange{ -1 }
+    , __dirty{ true }
 {
 }
 
 ShaderAttributeManager::~ShaderAttributeManager()
 {
+    if (__blockRange >= 0) s_freeRanges.push_back(__blockRange);
+}
+
+ShaderAttribute * ShaderAttributeManager::FindShaderAttribute(const std::string & name)
+{
+    for (auto & attribute : shaderAttributes)
+        if (attribute.name == name) return &attribute;
+    return nullptr;
+}
+
+const ShaderAttribute * ShaderAttributeManager::FindShaderAttribute(const std::string & name) const
+{
+    for (const auto & attribute : shaderAttributes)
+        if (attribute.name == name) return &attribute;
+    return nullptr;
+}
+
+void ShaderAttributeManager::UploadShaderAttributes(Shader & shader)
+{
+    if (shaderAttributes.empty()) return;
+
+    const GLint blockSize = shader.GetEntityAttributesSize();
+    if (blockSize <= 0 || blockSize > blockRangeSize)
+    {
+        for (const auto & attribute : shaderAttributes)
+            attribute.Render(shader);
+        return;
+    }
+
+    // Layout of the shader block, rebuilt when the program or the attributes change
+    if (__blockProgram != shader.Program())
+    {
+        __blockProgram = shader.Program();
+        __block.assign(blockSize, std::byte{ 0 });
+        __offsets.resize(shaderAttributes.size());
+        for (size_t i = 0; i < shaderAttributes.size(); ++i)
+        {
+            const GLint offset = shader.GetEntityAttributeOffset(shaderAttributes[i].uniformName);
+            __offsets[i] = (offset >= 0 && offset + shaderAttributes[i].GetSize() <= __block.size()) ? offset : -1;
+        }
+        __dirty = true;
+    }
+
+    for (size_t i = 0; i < shaderAttributes.size(); ++i)
+    {
+        const ShaderAttribute & attribute = shaderAttributes[i];
+        // Not a member of the block
+        if (__offsets[i] < 0)
+        {
+            attribute.Render(shader);
+            continue;
+        }
+
+        std::byte * value = __block.data() + __offsets[i];
+        if (memcmp(value, attribute.GetData(), attribute.GetSize()) != 0)
+        {
+            memcpy(value, attribute.GetData(), attribute.GetSize());
+            __dirty = true;
+        }
+    }
+
+    if (__blockRange < 0) __blockRange = AllocateRange();
+    if (__dirty)
+    {
+        OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, s_ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, __blockRange, __block.size(), __block.data());
+        __dirty = false;
+    }
+    OpenGL_State::BindBufferRange(GL_UNIFORM_BUFFER, Constants::UBO::Ids::entityAttributes, s_ubo, __blockRange, __block.size());
 }
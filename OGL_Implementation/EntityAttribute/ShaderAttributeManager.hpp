@@ -10,6 +10,9 @@
 // Project includes
 #include "ShaderAttribute.hpp"
 
+// C++ includes
+#include <vector>
+
 template<class T>
 /// @brief Concept checking if the type is a primitive appopriate for shader attributes
 concept ShaderAttributeTypable =
@@ -28,13 +31,29 @@ template<class T>
 concept ShaderAttributeTypableAny = ShaderAttributeTypable<T> || ShaderAttributeTypableClass<T>;
 
 /**
- * @brief Manages shader attributes for Entities
+ * @brief Manages shader attributes for Entities.
+ * Attributes are stored contiguously, then written in the std140 layout of the
+ * EntityAttributes block of the shader, into a range of a UBO shared by every entity.
+ * The range is re-uploaded only when a value changed, so that unchanged entities
+ * only cost a glBindBufferRange per draw.
 */
 class ShaderAttributeManager
 {
 public:
     ShaderAttributeManager();
     ~ShaderAttributeManager();
+    /**
+     * @brief Owns a range of the shared UBO
+    */
+    ShaderAttributeManager(const ShaderAttributeManager &) = delete;
+    ShaderAttributeManager & operator=(const ShaderAttributeManager &) = delete;
+
+    /**
+     * @brief Binds attributes to the shader: through the EntityAttributes block if
+     * the shader declares it, as plain uniforms otherwise.
+     * @param shader (in use)
+    */
+    void UploadShaderAttributes(Shader & shader);
 
     template<ShaderAttributeTypable T>
     void SetShaderAttribute(const std::string & name, const T val);
@@ -46,7 +65,34 @@ public:
     template<ShaderAttributeTypableAny T>
     const T * GetShaderAttribute(const std::string & name) const;
 
-    std::unordered_map<std::string, std::unique_ptr<ShaderAttribute>> shaderAttributes;
+    /**
+     * @brief Returns attribute
+     * @param name
+     * @return attribute or nullptr
+    */
+    ShaderAttribute * FindShaderAttribute(const std::string & name);
+    const ShaderAttribute * FindShaderAttribute(const std::string & name) const;
+
+    std::vector<ShaderAttribute> shaderAttributes;
+
+private:
+    /**
+     * @brief std140 image of the block, as last uploaded
+    */
+    std::vector<std::byte> __block;
+    /**
+     * @brief Offset of each attribute in the block (-1 if not a member)
+    */
+    std::vector<GLint> __offsets;
+    /**
+     * @brief Program __block & __offsets are laid out for, 0 if the layout has to be rebuilt
+    */
+    GLuint __blockProgram;
+    /**
+     * @brief Range in the shared UBO, -1 if not allocated yet
+    */
+    GLintptr __blockRange;
+    bool __dirty;
 };
 
 #include "ShaderAttributeManager.inl"
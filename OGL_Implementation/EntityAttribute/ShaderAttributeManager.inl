@@ -10,31 +10,43 @@
 template<ShaderAttributeTypable T>
 inline void ShaderAttributeManager::SetShaderAttribute(const std::string & name, const T val)
 {
-    shaderAttributes[name] = std::make_unique<ShaderAttribute>(val);
+    if (ShaderAttribute * attribute = FindShaderAttribute(name))
+        *attribute = ShaderAttribute(name, val);
+    else
+        shaderAttributes.emplace_back(name, val);
+    // Type (and size) may have changed
+    __blockProgram = 0;
 }
 
 template<ShaderAttributeTypableClass T>
 inline void ShaderAttributeManager::SetShaderAttribute(const std::string & name, const T & val)
 {
-    shaderAttributes[name] = std::make_unique<ShaderAttribute>(val);
+    if (ShaderAttribute * attribute = FindShaderAttribute(name))
+        *attribute = ShaderAttribute(name, val);
+    else
+        shaderAttributes.emplace_back(name, val);
+    // Type (and size) may have changed
+    __blockProgram = 0;
 }
 
 template<ShaderAttributeTypableAny T>
 inline T * ShaderAttributeManager::GetShaderAttribute(const std::string & name)
 {
-    if (!shaderAttributes.contains(name))
+    ShaderAttribute * attribute = FindShaderAttribute(name);
+    if (!attribute)
     {
         return nullptr;
     }
-    return (T *)shaderAttributes[name].get()->GetData();
+    return (T *)attribute->GetData();
 }
 
 template<ShaderAttributeTypableAny T>
 inline const T * ShaderAttributeManager::GetShaderAttribute(const std::string & name) const
 {
-    if (!shaderAttributes.contains(name))
+    const ShaderAttribute * attribute = FindShaderAttribute(name);
+    if (!attribute)
     {
         return nullptr;
     }
-    return (const T *)shaderAttributes[name].get()->GetData();
+    return (const T *)attribute->GetData();
 }
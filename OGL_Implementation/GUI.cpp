@@ -7,6 +7,9 @@
  *********************************************************************/
 #include "GUI.hpp"
 
+// Project includes
+#include "OGL_Implementation\OpenGL_State.hpp"
+
 #include "imgui_internal.h"
 
 GUI::GUI(GLFWwindow * window)
@@ -63,6 +66,8 @@ bool GUI::DrawGUI()
     ImGui::EndFrame();
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    // ImGui changes the state behind the cache's back
+    OpenGL_State::Invalidate();
     return true;
 }
 
@@ -85,10 +90,8 @@ void GUI::EditEntity(Entity & entity)
             entity.quat.SetRotation(eulerAngles);
         }
         ImGui::DragFloat3("Scale", glm::value_ptr(entity.scale), 0.02f);
-        if (entity.GetShaderAttribute<int>("useShadow"))
-        {
-            ImGui::Checkbox("Shadow Rendering", (bool *)entity.GetShaderAttribute<int>("useShadow"));
-        }
+        ImGui::CheckboxFlags("Shadow Rendering", &entity.shaderFeatures, ShadowFeature);
+        ImGui::Checkbox("Transparent", &entity.transparent);
         if (ImGui::TreeNodeEx("Mesh Properties", ImGuiTreeNodeFlags_::ImGuiTreeNodeFlags_DefaultOpen))
         {
             bool isMeshOpeFinished = entity.GetMesh().IsMeshOperationFinished();
@@ -97,9 +100,9 @@ void GUI::EditEntity(Entity & entity)
                 ImGui::PushStyleVar(ImGuiStyleVar_::ImGuiStyleVar_Alpha, 0.25f);
                 ImGui::PushItemFlag(ImGuiItemFlags_::ImGuiItemFlags_Disabled, true);
             }
-            if (entity.GetShaderAttribute<int>("isNormalFlat") && ImGui::Checkbox("Flat Mesh", (bool *)entity.GetShaderAttribute<int>("isNormalFlat")))
+            if (ImGui::CheckboxFlags("Flat Mesh", &entity.shaderFeatures, NormalFlatFeature))
             {
-                if (*entity.GetShaderAttribute<int>("isNormalFlat")) (*entity.GetMesh())->GenerateNormals(true);
+                if (entity.shaderFeatures & NormalFlatFeature) (*entity.GetMesh())->GenerateNormals(true);
                 else (*entity.GetMesh())->GenerateNormals(false);
             }
             if (ImGui::Button("Simplify"))
@@ -11,6 +11,11 @@ static std::unique_ptr<Shader> defaultLightShader(nullptr);
 static std::array<PointLight *, PointLight::maxPointLightsCount> pointLights = { nullptr };
 static size_t maxPos = 0;
 
+// Shadow map projection
+static constexpr const float nearPlane = 0.1f;
+static constexpr const float farPlane = 10.0f;
+static constexpr const float dimensions = 10.0f;
+
 PointLight::PointLight(const Mesh & mesh, const Shader & pointShader, const Shader & wireframeShader, const Shader & lightShader, const glm::vec3 & defaultPosition, const glm::vec3 & defaultEulerAngles, const glm::vec3 & defaultScale,
     const float constant, const float linear, const float quadratic, const glm::vec3 & ambient, const glm::vec3 & diffuse, const glm::vec3 & specular)
     : Entity(mesh, pointShader, wireframeShader, lightShader, defaultPosition, defaultEulerAngles, defaultScale)
@@ -21,7 +26,10 @@ PointLight::PointLight(const Mesh & mesh, const Shader & pointShader, const Shad
     , __diffuse{ diffuse }
     , __specular{ specular }
     , focus{ nullptr }
+    , shadowImportance{ 1.0f }
+    , omnidirectionalShadows{ false }
 {
+    castsShadows = false;
     InsertPointLight();
 }
 
@@ -60,12 +68,13 @@ glm::mat4 PointLight::GetModelMatrix(bool ignoreRotation, bool ignoreScale) cons
 
 PointLight_Shader PointLight::GetShaderInfo() const
 {
-    constexpr const float nearPlane = 0.1f;
-    constexpr const float farPlane = 10.0f;
-    constexpr const float dimensions = 10.0f;
-    const glm::mat4 lightProjection = glm::ortho(-dimensions, dimensions, -dimensions, dimensions, nearPlane, farPlane);
-    const glm::mat4 lightView = glm::lookAt(pos, focus->GetWorldPosition(), glm::vec3(0.0, 1.0, 0.0));
-    const glm::mat4 spaceMatrix = lightProjection * lightView;
+    glm::mat4 spaceMatrix(1.0f);
+    if (focus && !omnidirectionalShadows)
+    {
+        const glm::mat4 lightProjection = glm::ortho(-dimensions, dimensions, -dimensions, dimensions, nearPlane, farPlane);
+        const glm::mat4 lightView = glm::lookAt(pos, focus->GetWorldPosition(), glm::vec3(0.0, 1.0, 0.0));
+        spaceMatrix = lightProjection * lightView;
+    }
     PointLight_Shader shaderInfo{
         pos,
         __constant,
@@ -74,12 +83,44 @@ PointLight_Shader PointLight::GetShaderInfo() const
         __diffuse,
         __quadratic,
         __specular,
-        farPlane,
-        spaceMatrix
+        omnidirectionalShadows ? cubeShadowFarPlane : farPlane,
+        spaceMatrix,
+        glm::vec4(0.0f),
+        glm::vec4(0.0f, 0.0f, 0.0f, -1.0f)
     };
     return shaderInfo;
 }
 
+BoundingSphere PointLight::GetShadowBounds() const
+{
+    if (omnidirectionalShadows || !focus) return { pos, cubeShadowFarPlane };
+
+    // Orthographic box from the near to the far plane, towards the focus
+    const glm::vec3 direction = glm::normalize(focus->GetWorldPosition() - pos);
+    return { pos + direction * (nearPlane + farPlane) * 0.5f,
+        glm::length(glm::vec3(dimensions, dimensions, (farPlane - nearPlane) * 0.5f)) };
+}
+
+std::array<glm::mat4, 6> PointLight::GetCubeShadowMatrices() const
+{
+    // 90 degrees per face, up vectors of the cube map faces conventions
+    const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, nearPlane, cubeShadowFarPlane);
+    return {
+        projection * glm::lookAt(pos, pos + glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+        projection * glm::lookAt(pos, pos + glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+        projection * glm::lookAt(pos, pos + glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
+        projection * glm::lookAt(pos, pos + glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
+        projection * glm::lookAt(pos, pos + glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
+        projection * glm::lookAt(pos, pos + glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
+    };
+}
+
+float PointLight::GetRange(float cutoff) const
+{
+    const float intensity = std::max({ __diffuse.r, __diffuse.g, __diffuse.b, __specular.r, __specular.g, __specular.b });
+    return std::sqrt(std::max(intensity, 0.0f) / cutoff);
+}
+
 void PointLight::ChangeBrightnessSettings(const float constant, const float linear, const float quadratic)
 {
     __constant = constant;
@@ -29,6 +29,9 @@ struct PointLight_Shader
     float farPlane; // 60
 
     glm::mat4 pointLightViewMatrix; // 64
+
+    glm::vec4 shadowRect; // 128, UV offset (xy) & scale (zw) in the shadow atlas, set by LightRendering
+    glm::vec4 cubeShadow; // 144, position the cube shadow map was rendered from (xyz) & its layer (w, -1 without)
 };
 
 /**
@@ -105,6 +108,29 @@ public:
     virtual glm::mat4 GetModelMatrix(bool ignoreRotation = false, bool ignoreScale = false) const override;
 
     PointLight_Shader GetShaderInfo() const;
+    /**
+     * @brief Sphere around the region covered by the shadow map of the light
+     * @return bounds
+    */
+    BoundingSphere GetShadowBounds() const;
+    /**
+     * @brief View projections of the faces of the cube shadow map,
+     * in GL_TEXTURE_CUBE_MAP_POSITIVE_X + face order
+     * @return matrices
+    */
+    std::array<glm::mat4, 6> GetCubeShadowMatrices() const;
+    /**
+     * @brief Distance past which the inverse square attenuation of the PBR shader
+     * brings the brightest channel of the light under a fraction of its intensity
+     * @param cutoff fraction
+     * @return range
+    */
+    float GetRange(float cutoff) const;
+
+    /**
+     * @brief Range of omnidirectional shadows, depths of cube shadow maps are distances divided by it
+    */
+    static constexpr const float cubeShadowFarPlane = 25.0f;
 
     void ChangeBrightnessSettings(const float constant, const float linear, const float quadratic);
     void ChangeAmbient(const glm::vec3 & ambient);
@@ -127,7 +153,18 @@ public:
     glm::vec3 __ambient;
     glm::vec3 __diffuse;
     glm::vec3 __specular;
+    /**
+     * @brief Entity the shadow map of the light looks at (shadow atlas), unused by omnidirectional shadows
+    */
     Entity * focus;
+    /**
+     * @brief Scales the resolution of the shadow map (tile of the shadow atlas)
+    */
+    float shadowImportance;
+    /**
+     * @brief Shadows in every direction from a cube shadow map instead of towards the focus
+    */
+    bool omnidirectionalShadows;
 };
 
 void SetDefaultLightShader(const Shader & shader);
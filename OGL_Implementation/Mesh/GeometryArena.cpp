@@ -0,0 +1,145 @@
+/*****************************************************************//**
+ * \file   GeometryArena.cpp
+ * \brief  GeometryArena source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 09 2022
+ *********************************************************************/
+#include "GeometryArena.hpp"
+
+// Project includes
+#include "OGL_Implementation\OpenGL_State.hpp"
+
+// C++ includes
+#include <algorithm>
+#include <numeric>
+
+static constexpr const uint32_t initialVertexCapacity = 1 << 18;
+static constexpr const uint32_t initialIndexCapacity = 1 << 20;
+
+bool GeometryArena::Allocation::IsValid() const
+{
+    return baseVertex != TlsfAllocator::invalidOffset;
+}
+
+GeometryArena::GeometryArena()
+    : __vao{ 0 }
+    , __vbo{ 0 }
+    , __ebo{ 0 }
+    , __vertices{ initialVertexCapacity }
+    , __indices{ initialIndexCapacity }
+{
+    glCreateBuffers(1, &__vbo);
+    glNamedBufferData(__vbo, static_cast<GLsizeiptr>(initialVertexCapacity) * sizeof(VertexNormalTexture), NULL, GL_DYNAMIC_DRAW);
+    glCreateBuffers(1, &__ebo);
+    glNamedBufferData(__ebo, static_cast<GLsizeiptr>(initialIndexCapacity) * sizeof(GLuint), NULL, GL_STATIC_DRAW);
+
+    // VertexNormalTexture: position, normal, texture coordinates
+    glCreateVertexArrays(1, &__vao);
+    glEnableVertexArrayAttrib(__vao, 0);
+    glVertexArrayAttribFormat(__vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(__vao, 0, 0);
+    glEnableVertexArrayAttrib(__vao, 1);
+    glVertexArrayAttribFormat(__vao, 1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat));
+    glVertexArrayAttribBinding(__vao, 1, 0);
+    glEnableVertexArrayAttrib(__vao, 2);
+    glVertexArrayAttribFormat(__vao, 2, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat));
+    glVertexArrayAttribBinding(__vao, 2, 0);
+    glVertexArrayVertexBuffer(__vao, 0, __vbo, 0, sizeof(VertexNormalTexture));
+    glVertexArrayElementBuffer(__vao, __ebo);
+}
+
+GeometryArena & GeometryArena::Get()
+{
+    static GeometryArena * arena = new GeometryArena();
+    return *arena;
+}
+
+GeometryArena::Allocation GeometryArena::Allocate(const std::vector<VertexNormalTexture> & vertices, const std::vector<GLuint> & indices)
+{
+    GeometryArena & arena = Get();
+
+    std::vector<GLuint> sequentialIndices;
+    if (indices.empty())
+    {
+        sequentialIndices.resize(vertices.size());
+        std::iota(sequentialIndices.begin(), sequentialIndices.end(), 0);
+    }
+    const std::vector<GLuint> & meshIndices = indices.empty() ? sequentialIndices : indices;
+
+    Allocation allocation;
+    if (vertices.empty() || meshIndices.empty()) return allocation;
+    allocation.vertexCount = static_cast<uint32_t>(vertices.size());
+    allocation.indexCount = static_cast<uint32_t>(meshIndices.size());
+
+    allocation.baseVertex = arena.__vertices.Allocate(allocation.vertexCount);
+    if (allocation.baseVertex == TlsfAllocator::invalidOffset)
+    {
+        const uint32_t capacity = arena.__vertices.GetCapacity();
+        const uint32_t newCapacity = std::max(capacity * 2, capacity + allocation.vertexCount);
+        GrowBuffer(arena.__vbo, static_cast<GLsizeiptr>(capacity) * sizeof(VertexNormalTexture), static_cast<GLsizeiptr>(newCapacity) * sizeof(VertexNormalTexture));
+        glVertexArrayVertexBuffer(arena.__vao, 0, arena.__vbo, 0, sizeof(VertexNormalTexture));
+        arena.__vertices.Grow(newCapacity);
+        allocation.baseVertex = arena.__vertices.Allocate(allocation.vertexCount);
+    }
+
+    allocation.firstIndex = arena.__indices.Allocate(allocation.indexCount);
+    if (allocation.firstIndex == TlsfAllocator::invalidOffset)
+    {
+        const uint32_t capacity = arena.__indices.GetCapacity();
+        const uint32_t newCapacity = std::max(capacity * 2, capacity + allocation.indexCount);
+        GrowBuffer(arena.__ebo, static_cast<GLsizeiptr>(capacity) * sizeof(GLuint), static_cast<GLsizeiptr>(newCapacity) * sizeof(GLuint));
+        glVertexArrayElementBuffer(arena.__vao, arena.__ebo);
+        arena.__indices.Grow(newCapacity);
+        allocation.firstIndex = arena.__indices.Allocate(allocation.indexCount);
+    }
+
+    glNamedBufferSubData(arena.__vbo, static_cast<GLintptr>(allocation.baseVertex) * sizeof(VertexNormalTexture),
+        vertices.size() * sizeof(VertexNormalTexture), vertices.data());
+    glNamedBufferSubData(arena.__ebo, static_cast<GLintptr>(allocation.firstIndex) * sizeof(GLuint),
+        meshIndices.size() * sizeof(GLuint), meshIndices.data());
+    return allocation;
+}
+
+void GeometryArena::UpdateVertices(const Allocation & allocation, const std::vector<VertexNormalTexture> & vertices)
+{
+    glNamedBufferSubData(Get().__vbo, static_cast<GLintptr>(allocation.baseVertex) * sizeof(VertexNormalTexture),
+        std::min<size_t>(vertices.size(), allocation.vertexCount) * sizeof(VertexNormalTexture), vertices.data());
+}
+
+void GeometryArena::Free(Allocation & allocation)
+{
+    if (!allocation.IsValid()) return;
+
+    GeometryArena & arena = Get();
+    arena.__vertices.Free(allocation.baseVertex);
+    arena.__indices.Free(allocation.firstIndex);
+    allocation = Allocation();
+}
+
+GLuint GeometryArena::GetVAO()
+{
+    return Get().__vao;
+}
+
+GeometryArena::Stats GeometryArena::GetStats()
+{
+    const GeometryArena & arena = Get();
+    Stats stats;
+    stats.vertexCapacity = arena.__vertices.GetCapacity();
+    stats.verticesUsed = arena.__vertices.GetUsed();
+    stats.indexCapacity = arena.__indices.GetCapacity();
+    stats.indicesUsed = arena.__indices.GetUsed();
+    stats.allocations = arena.__vertices.GetAllocationsCount();
+    return stats;
+}
+
+void GeometryArena::GrowBuffer(GLuint & buffer, GLsizeiptr oldSize, GLsizeiptr newSize)
+{
+    GLuint newBuffer;
+    glCreateBuffers(1, &newBuffer);
+    glNamedBufferData(newBuffer, newSize, NULL, GL_DYNAMIC_DRAW);
+    glCopyNamedBufferSubData(buffer, newBuffer, 0, 0, oldSize);
+    OpenGL_State::DeleteBuffers(1, &buffer);
+    buffer = newBuffer;
+}
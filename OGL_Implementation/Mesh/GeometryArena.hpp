@@ -0,0 +1,89 @@
+/*****************************************************************//**
+ * \file   GeometryArena.hpp
+ * \brief  Shared vertex & index buffers of the meshes
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 09 2022
+ *********************************************************************/
+#pragma once
+
+// Project includes
+#include "Mesh_Geometry.hpp"
+#include "TlsfAllocator.hpp"
+
+// GLAD includes
+#include <GLAD\glad.h>
+
+// C++ includes
+#include <vector>
+
+/**
+ * @brief Vertices (VertexNormalTexture) & indices of every mesh, sub-allocated
+ * in one vertex buffer & one index buffer described by a single VAO.
+ * Meshes sharing the format are then drawn without VAO changes, and batches of them
+ * with one glMultiDrawElementsIndirect (see Rendering::DrawFacesBatch).
+ * Buffers grow (copied on the GPU) when full, allocations keep their offsets.
+*/
+class GeometryArena
+{
+public:
+    /**
+     * @brief Range of a mesh, indices are relative to baseVertex
+    */
+    struct Allocation
+    {
+        uint32_t baseVertex = TlsfAllocator::invalidOffset;
+        uint32_t vertexCount = 0;
+        uint32_t firstIndex = TlsfAllocator::invalidOffset;
+        uint32_t indexCount = 0;
+
+        bool IsValid() const;
+    };
+
+    struct Stats
+    {
+        uint32_t vertexCapacity = 0, verticesUsed = 0;
+        uint32_t indexCapacity = 0, indicesUsed = 0;
+        uint32_t allocations = 0;
+    };
+
+public:
+    /**
+     * @brief Uploads vertices & indices in the arena
+     * @param vertices
+     * @param indices if empty, vertices are drawn in order
+     * @return allocation, to be given back to Free
+    */
+    static Allocation Allocate(const std::vector<VertexNormalTexture> & vertices, const std::vector<GLuint> & indices = {});
+    /**
+     * @brief Overwrites vertices of an allocation
+     * @param allocation
+     * @param vertices as many as allocated
+    */
+    static void UpdateVertices(const Allocation & allocation, const std::vector<VertexNormalTexture> & vertices);
+    /**
+     * @brief Frees an allocation & invalidates it
+     * @param allocation
+    */
+    static void Free(Allocation & allocation);
+
+    static GLuint GetVAO();
+    static Stats GetStats();
+
+private:
+    GeometryArena();
+
+    /**
+     * @brief Created on first use & never destroyed: meshes of the static mesh
+     * database may free their allocations during static destruction
+    */
+    static GeometryArena & Get();
+    /**
+     * @brief Reallocates a buffer with a bigger capacity, keeping its content
+    */
+    static void GrowBuffer(GLuint & buffer, GLsizeiptr oldSize, GLsizeiptr newSize);
+
+private:
+    GLuint __vao, __vbo, __ebo;
+    TlsfAllocator __vertices, __indices;
+};
@@ -9,39 +9,49 @@
 
 // Project includes
 #include "OGL_Implementation\DebugInfo\Log.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
 
 // C++ includes
+#include <algorithm>
 #include <stdexcept>
 #include <functional>
 
 Mesh_Base::Mesh_Base()
-	: __hasTextureCoordinates{ true }
+	: __facesVAO{ 0 }
+	, __facesVBO{ 0 }
+	, __hasTextureCoordinates{ true }
 	, __hasNormals{ true }
+	, __boundsVersion{ 0 }
 {
 	LOG_PRINT(Log::LogMainFileName, "Constructed\n");
 
-	glGenVertexArrays(2, &__verticesVAO);
-	glGenBuffers(2, &__verticesVBO);
+	// Faces are drawn from the GeometryArena, only meshes drawn on their own allocate faces buffers
+	glGenVertexArrays(1, &__verticesVAO);
+	glGenBuffers(1, &__verticesVBO);
 }
 
 Mesh_Base::Mesh_Base(const std::vector<Face> & faces, const std::vector<VertexPos> & v, const std::vector<VertexNormal> & vN, const std::vector<VertexTextureCoordinates> & vT)
-	: __hasTextureCoordinates{ !vT.empty() }
+	: __facesVAO{ 0 }
+	, __facesVBO{ 0 }
+	, __hasTextureCoordinates{ !vT.empty() }
 	, __hasNormals{ !vN.empty() }
 	, __faces{ faces }
 	, __v{ v }
 	, __vN{ vN }
 	, __vT{ vT }
+	, __boundsVersion{ 0 }
 {
-	glGenVertexArrays(2, &__verticesVAO);
-	glGenBuffers(2, &__verticesVBO);
+	glGenVertexArrays(1, &__verticesVAO);
+	glGenBuffers(1, &__verticesVBO);
 }
 
 Mesh_Base::~Mesh_Base()
 {
 	LOG_PRINT(Log::LogMainFileName, "Destroyed\n");
 
-	glDeleteVertexArrays(2, &__verticesVAO);
-	glDeleteBuffers(2, &__verticesVBO);
+	OpenGL_State::DeleteVertexArrays(1, &__verticesVAO);
+	OpenGL_State::DeleteBuffers(1, &__verticesVBO);
+	GeometryArena::Free(__arenaAllocation);
 }
 
 GLuint Mesh_Base::GetVerticesVAO() const
@@ -51,7 +61,7 @@ GLuint Mesh_Base::GetVerticesVAO() const
 
 GLuint Mesh_Base::GetFacesVAO() const
 {
-	return __facesVAO;
+	return IsInArena() ? GeometryArena::GetVAO() : __facesVAO;
 }
 
 GLuint Mesh_Base::GetVerticesVBO() const
@@ -104,6 +114,47 @@ bool Mesh_Base::HasNormals() const
 	return __hasNormals;
 }
 
+const BoundingBox & Mesh_Base::GetBoundingBox() const
+{
+	return __boundingBox;
+}
+
+const BoundingSphere & Mesh_Base::GetBoundingSphere() const
+{
+	return __boundingSphere;
+}
+
+uint32_t Mesh_Base::GetBoundsVersion() const
+{
+	return __boundsVersion;
+}
+
+bool Mesh_Base::IsInArena() const
+{
+	return __arenaAllocation.IsValid();
+}
+
+const GeometryArena::Allocation & Mesh_Base::GetArenaAllocation() const
+{
+	return __arenaAllocation;
+}
+
+void Mesh_Base::DrawFaces(GLenum primitiveMode, GLsizei instanceCount, GLuint baseInstance) const
+{
+	if (IsInArena())
+	{
+		OpenGL_State::BindVertexArray(GeometryArena::GetVAO());
+		glDrawElementsInstancedBaseVertexBaseInstance(primitiveMode, __arenaAllocation.indexCount, GL_UNSIGNED_INT,
+			(const GLvoid *)(__arenaAllocation.firstIndex * sizeof(GLuint)), instanceCount, __arenaAllocation.baseVertex, baseInstance);
+		return;
+	}
+
+	// Faces not loaded yet, only meshes owning their faces buffers (images) are drawn in order
+	if (__facesVAO == 0) return;
+	OpenGL_State::BindVertexArray(__facesVAO);
+	glDrawArraysInstancedBaseInstance(primitiveMode, 0, __facesNVert, instanceCount, baseInstance);
+}
+
 void Mesh_Base::GenerateNormals(bool smooth, bool loading)
 {
 	__vN.clear();
@@ -144,56 +195,71 @@ void Mesh_Base::SetGeometry(const std::vector<Face> & faces, const std::vector<V
 
 void Mesh_Base::UpdateVerticesToApi()
 {
-	glBindVertexArray(__verticesVAO);
+	OpenGL_State::BindVertexArray(__verticesVAO);
 	// Fill mesh buffer
-	glBindBuffer(GL_ARRAY_BUFFER, __verticesVBO);
+	OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __verticesVBO);
 	glBufferData(GL_ARRAY_BUFFER, __v.size() * sizeof(VertexPos), __v.data(), GL_DYNAMIC_DRAW);
 	// Set mesh attributes
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, 0);
+	OpenGL_State::BindVertexArray(0);
 
 	__verticesNVert = __v.size();
 }
 
 void Mesh_Base::LoadVertices(const std::vector<VertexPos> & vertices)
 {
-	glBindVertexArray(__verticesVAO);
+	OpenGL_State::BindVertexArray(__verticesVAO);
 	// Fill mesh buffer
-	glBindBuffer(GL_ARRAY_BUFFER, __verticesVBO);
+	OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __verticesVBO);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VertexPos), vertices.data(), GL_DYNAMIC_DRAW);
 	// Set mesh attributes
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, 0);
+	OpenGL_State::BindVertexArray(0);
 
 	__verticesNVert = vertices.size();
 }
 
-void Mesh_Base::LoadFaces(const std::vector<VertexNormalTexture> & vertices)
+void Mesh_Base::LoadFaces(const std::vector<VertexNormalTexture> & vertices, const std::vector<GLuint> & indices)
 {
-	glBindVertexArray(__facesVAO);
-	// Fill mesh buffer
-	glBindBuffer(GL_ARRAY_BUFFER, __facesVBO);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VertexNormalTexture), vertices.data(), GL_DYNAMIC_DRAW);
-	// Set mesh attributes
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), 0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid *)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid *)(6 * sizeof(GLfloat)));
+	ComputeBounds(vertices);
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	// Vertices edited in place (e.g. Mesh_Custom::ModifyVertex, normals regenerated)
+	if (IsInArena() && indices.empty() && __arenaAllocation.vertexCount == vertices.size() && __arenaAllocation.indexCount == vertices.size())
+	{
+		GeometryArena::UpdateVertices(__arenaAllocation, vertices);
+		return;
+	}
 
-	__facesNVert = vertices.size();
+	GeometryArena::Free(__arenaAllocation);
+	__arenaAllocation = GeometryArena::Allocate(vertices, indices);
+	__facesNVert = __arenaAllocation.indexCount;
 }
 
+void Mesh_Base::ComputeBounds(const std::vector<VertexNormalTexture> & vertices)
+{
+	__boundingBox = BoundingBox();
+	for (const auto & vertex : vertices)
+		__boundingBox.Extend(vertex.xyz);
+
+	// Centered on the box, not minimal but tight enough for culling
+	__boundingSphere = BoundingSphere();
+	if (__boundingBox.IsValid())
+	{
+		__boundingSphere.center = __boundingBox.Center();
+		float radius2 = 0.0f;
+		for (const auto & vertex : vertices)
+			radius2 = std::max(radius2, glm::dot(vertex.xyz - __boundingSphere.center, vertex.xyz - __boundingSphere.center));
+		__boundingSphere.radius = std::sqrt(radius2);
+	}
+	++__boundsVersion;
+}
+
 std::vector<VertexNormalTexture> Mesh_Base::GenerateAssembledVertices(bool isNormal, bool isTexture) const
 {
 	std::vector<VertexNormalTexture> res;
@@ -9,6 +9,7 @@
 
 // Project includes
 #include "Mesh_Geometry.hpp"
+#include "GeometryArena.hpp"
 
 // GLAD includes
 #include <GLAD\glad.h>
@@ -37,6 +38,10 @@ public:
     virtual ~Mesh_Base();
 
     GLuint GetVerticesVAO() const;
+    /**
+     * @brief Returns the VAO drawing faces, the one of the GeometryArena if faces are in it
+     * @return vao
+    */
     GLuint GetFacesVAO() const;
     GLuint GetVerticesVBO() const;
     GLuint GetFacesVBO() const;
@@ -67,14 +72,40 @@ public:
     bool HasTextureCoordinates() const;
     bool HasNormals() const;
 
+    /**
+     * @brief Bounds of the faces, computed when they are loaded (invalid until then)
+    */
+    const BoundingBox & GetBoundingBox() const;
+    const BoundingSphere & GetBoundingSphere() const;
+    /**
+     * @brief Incremented when bounds change, so that data derived from them can be cached
+    */
+    uint32_t GetBoundsVersion() const;
+
+    bool IsInArena() const;
+    const GeometryArena::Allocation & GetArenaAllocation() const;
+    /**
+     * @brief Binds the faces VAO & draws faces, nothing is drawn until faces are loaded
+     * @param primitiveMode
+     * @param instanceCount
+     * @param baseInstance first instance (gl_BaseInstance)
+    */
+    void DrawFaces(GLenum primitiveMode, GLsizei instanceCount = 1, GLuint baseInstance = 0) const;
+
     void GenerateNormals(bool smooth, bool loading = true);
     void SetGeometry(const std::vector<Face> & faces, const std::vector<VertexPos> & v, const std::vector<VertexNormal> & vN = {}, const std::vector<VertexTextureCoordinates> & vT = {});
     void UpdateVerticesToApi();
 
 protected:
     void LoadVertices(const std::vector<VertexPos> & vertices);
-    void LoadFaces(const std::vector<VertexNormalTexture> & vertices);
+    /**
+     * @brief Uploads faces in the GeometryArena, in place if the count didn't change
+     * @param vertices
+     * @param indices if empty, vertices are drawn in order
+    */
+    void LoadFaces(const std::vector<VertexNormalTexture> & vertices, const std::vector<GLuint> & indices = {});
     std::vector<VertexNormalTexture> GenerateAssembledVertices(bool isNormal, bool isTexture) const;
+    void ComputeBounds(const std::vector<VertexNormalTexture> & vertices);
 
 protected:
     union
@@ -93,6 +124,10 @@ protected:
     GLuint __verticesVBO, __facesVBO;
     GLuint __verticesNVert, __facesNVert;
     bool __hasTextureCoordinates, __hasNormals;
+    GeometryArena::Allocation __arenaAllocation;
+    BoundingBox __boundingBox;
+    BoundingSphere __boundingSphere;
+    uint32_t __boundsVersion;
 };
 
 #include "Mesh_Base.inl"
\ No newline at end of file
@@ -6,6 +6,9 @@
  * \date   May, 01 2022
  *********************************************************************/
 #include "Mesh_Custom.hpp"
+
+// Project includes
+#include "OGL_Implementation\OpenGL_State.hpp"
 
 // C++ includes
 #include <stdexcept>
@@ -119,13 +122,11 @@ const std::vector<Face> * Mesh_Custom::GetFaces() const
 
 inline void Mesh_Custom::ReassignVertex()
 {
-    glBindVertexArray(__verticesVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, __verticesVAO);
+    OpenGL_State::BindVertexArray(__verticesVAO);
+    OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __verticesVAO);
     glBufferSubData(GL_ARRAY_BUFFER, 0, __vertices.size() * sizeof(VertexNormalTexture), __vertices.data());
 
-    glBindVertexArray(__facesVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, __facesVBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, __vertices.size() * sizeof(VertexNormalTexture), __vertices.data());
+    OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, 0);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    LoadFaces(__vertices);
 }
@@ -8,6 +8,7 @@
 #include "Mesh_Geometry.hpp"
 
 // C++ includes
+#include <limits>
 #include <unordered_map>
 #include <utility>
 
@@ -25,6 +26,63 @@ VertexNormalTexture::VertexNormalTexture(GLfloat x_, GLfloat y_, GLfloat z_, GLf
 {
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// 
+///  BOUNDS
+/// 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BoundingBox::BoundingBox()
+	: min(std::numeric_limits<float>::max())
+	, max(-std::numeric_limits<float>::max())
+{
+}
+
+BoundingBox::BoundingBox(const glm::vec3 & min_, const glm::vec3 & max_)
+	: min(min_)
+	, max(max_)
+{
+}
+
+BoundingBox BoundingBox::Infinite()
+{
+	// Finite, so that sizes & plane distances don't overflow into infinities (0 * inf is NaN)
+	constexpr const float limit = std::numeric_limits<float>::max() * 0.25f;
+	return BoundingBox(glm::vec3(-limit), glm::vec3(limit));
+}
+
+bool BoundingBox::IsValid() const
+{
+	return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+}
+
+void BoundingBox::Extend(const glm::vec3 & point)
+{
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+glm::vec3 BoundingBox::Center() const
+{
+	return (min + max) * 0.5f;
+}
+
+glm::vec3 BoundingBox::Extents() const
+{
+	return (max - min) * 0.5f;
+}
+
+BoundingBox BoundingBox::Transform(const glm::mat4 & matrix) const
+{
+	// Center is transformed, extents are projected on each axis with the absolute matrix
+	const glm::vec3 center = glm::vec3(matrix * glm::vec4(Center(), 1.0f));
+	const glm::vec3 extents = Extents();
+	glm::vec3 newExtents(0.0f);
+	for (int i = 0; i < 3; ++i)
+		newExtents += glm::abs(glm::vec3(matrix[i])) * extents[i];
+	return BoundingBox(center - newExtents, center + newExtents);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// 
 ///  HALF EDGE
@@ -69,6 +69,45 @@ struct VertexNormalTexture
 	};
 };
 
+/**
+ * @brief Axis aligned bounding box, empty (min > max) by default
+*/
+struct BoundingBox
+{
+	BoundingBox();
+	BoundingBox(const glm::vec3 & min_, const glm::vec3 & max_);
+
+	/**
+	 * @brief Box containing everything, for geometry without bounds (never culled)
+	*/
+	static BoundingBox Infinite();
+
+	bool IsValid() const;
+	void Extend(const glm::vec3 & point);
+	glm::vec3 Center() const;
+	/**
+	 * @brief Half sizes
+	*/
+	glm::vec3 Extents() const;
+	/**
+	 * @brief Box containing the transformed box (Arvo's method)
+	 * @param matrix affine transformation
+	 * @return transformed box
+	*/
+	BoundingBox Transform(const glm::mat4 & matrix) const;
+
+	glm::vec3 min, max;
+};
+
+/**
+ * @brief Bounding sphere, negative radius if empty
+*/
+struct BoundingSphere
+{
+	glm::vec3 center = glm::vec3(0.0f);
+	float radius = -1.0f;
+};
+
 /**
  * @brief Half Edge structure, used mainly by the Mesh Modules
 */
@@ -7,6 +7,9 @@
  *********************************************************************/
 #include "Mesh_Image.hpp"
 
+// Project includes
+#include "OGL_Implementation\OpenGL_State.hpp"
+
 // C++ includes
 #include <memory>
 
@@ -18,24 +21,26 @@ Mesh_Image::Mesh_Image()
             { 0.0, 1000.0,   0.0, 1.0 },
             { 1000.0, 1000.0,   1.0, 1.0 }
     };
-    glBindVertexArray(__facesVAO);
+    glGenVertexArrays(1, &__facesVAO);
+    glGenBuffers(1, &__facesVBO);
+    OpenGL_State::BindVertexArray(__facesVAO);
     // Fill mesh buffer
-    glBindBuffer(GL_ARRAY_BUFFER, __facesVBO);
+    OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __facesVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
     // Set mesh attributes
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
 
-    glBindVertexArray(__verticesVAO);
+    OpenGL_State::BindVertexArray(__verticesVAO);
     // Fill mesh buffer
-    glBindBuffer(GL_ARRAY_BUFFER, __verticesVBO);
+    OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __verticesVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
     // Set mesh attributes
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, 0);
+    OpenGL_State::BindVertexArray(0);
 
     __facesNVert = 4;
     __verticesNVert = 4;
@@ -43,7 +48,8 @@ Mesh_Image::Mesh_Image()
 
 Mesh_Image::~Mesh_Image()
 {
-    
+    OpenGL_State::DeleteVertexArrays(1, &__facesVAO);
+    OpenGL_State::DeleteBuffers(1, &__facesVBO);
 }
 
 GLuint Mesh_Image::GetFacesEBO() const
@@ -9,6 +9,7 @@
 
 // Project includes
 #include "OGL_Implementation\DebugInfo\Log.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
 
 Mesh_Obj::Mesh_Obj(const Obj & obj)
 	: Mesh_Base({}, obj.verticesPos, obj.verticesNormals, obj.verticesTextureCoordinates)
@@ -43,22 +44,15 @@ Mesh_Base::DrawMode Mesh_Obj::GetDrawMode() const
 
 void Mesh_Obj::bindFaces(const Obj & obj)
 {
-	// bind VAO
-	glBindVertexArray(__facesVAO);
-
-	// bind VBO, buffer data to it
-	glBindBuffer(GL_ARRAY_BUFFER, __facesVBO);
-
-	std::vector<GLfloat> data;
 	bool hasTextCoords = __hasTextureCoordinates = !obj.faces[0].vt.empty();
 	bool hasNormals = __hasNormals = !obj.faces[0].vn.empty();
 
 	for (const auto & face : obj.faces)
 	{
 		if (face.v.size() == 3)
-			MakeTriangle(data, obj, face);
+			MakeTriangle(obj, face);
 		else if (face.v.size() == 4)
-			MakeQuad(data, obj, face, hasNormals, hasTextCoords);
+			MakeQuad(obj, face, hasNormals, hasTextCoords);
 	}
 
 	if (!hasNormals)
@@ -66,54 +60,16 @@ void Mesh_Obj::bindFaces(const Obj & obj)
 		GenerateNormals(true, false);
 	}
 
-	for (const auto & face : __faces)
-	{
-		for (int i = 0; i < 3; i++)
-		{
-			int vid = face.v[i];
-			data.emplace_back(__v[vid].x);
-			data.emplace_back(__v[vid].y);
-			data.emplace_back(__v[vid].z);
-			int vnid = face.vn[i];
-			data.emplace_back(__vN[vnid].x);
-			data.emplace_back(__vN[vnid].y);
-			data.emplace_back(__vN[vnid].z);
-			if (hasTextCoords)
-			{
-				int vtid = face.vt[i];
-				data.emplace_back(__vT[vtid].x);
-				data.emplace_back(__vT[vtid].y);
-			}
-		}
-	}
-
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * data.size(), &data.front(), GL_STATIC_DRAW);
-
-	// set vertex attribute pointers
-	size_t totalSize = (6 + (hasTextCoords ? 2 : 0)) * sizeof(GLfloat);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, totalSize, (GLvoid *)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, totalSize, (GLvoid *)(3 * sizeof(GLfloat)));
-	if (hasTextCoords)
-	{
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, totalSize, (GLvoid *)(6 * sizeof(GLfloat)));
-	}
-
-	// unbind VBO & VAO
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
-
-	__facesNVert = GLsizei(data.size() / (6 + (hasTextCoords ? 2 : 0)));
+	// Faces go in the geometry arena, unindexed
+	LoadFaces(GenerateAssembledVertices(true, hasTextCoords));
 }
 
-void Mesh_Obj::MakeTriangle(std::vector<GLfloat> & data, const Obj & obj, const Face & face)
+void Mesh_Obj::MakeTriangle(const Obj & obj, const Face & face)
 {
 	__faces.push_back(face);
 }
 
-void Mesh_Obj::MakeQuad(std::vector<GLfloat> & data, const Obj & obj, const Face & face, const bool hasNormals, const bool hasTextCoords)
+void Mesh_Obj::MakeQuad(const Obj & obj, const Face & face, const bool hasNormals, const bool hasTextCoords)
 {
 	Face face1(
 		{ face.v[0], face.v[1], face.v[2] },
@@ -135,17 +91,17 @@ void Mesh_Obj::MakeQuad(std::vector<GLfloat> & data, const Obj & obj, const Face
 		face1.vt = { face.vt[0], face.vt[1], face.vt[2] };
 		face2.vt = { face.vt[2], face.vt[3], face.vt[0] };
 	}
-	MakeTriangle(data, obj, face1);
-	MakeTriangle(data, obj, face2);
+	MakeTriangle(obj, face1);
+	MakeTriangle(obj, face2);
 }
 
 void Mesh_Obj::bindVertices(const Obj & obj)
 {
 	// bind VAO
-	glBindVertexArray(__verticesVAO);
+	OpenGL_State::BindVertexArray(__verticesVAO);
 
 	// bind VBO, buffer data to it
-	glBindBuffer(GL_ARRAY_BUFFER, __verticesVBO);
+	OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __verticesVBO);
 
 	glBufferData(GL_ARRAY_BUFFER, sizeof(VertexPos) * obj.numVertices(), &obj.verticesPos.front(), GL_STATIC_DRAW);
 
@@ -155,8 +111,8 @@ void Mesh_Obj::bindVertices(const Obj & obj)
 	glEnableVertexAttribArray(0);
 
 	// unbind VBO & VAO
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, 0);
+	OpenGL_State::BindVertexArray(0);
 
 	__verticesNVert = GLsizei(obj.numVertices());
 }
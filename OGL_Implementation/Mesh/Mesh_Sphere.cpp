@@ -9,6 +9,7 @@
 
 // Project includes
 #include "OGL_Implementation\DebugInfo\Log.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
 
 // GLM includes
 #include <glm/gtx/normal.hpp>
@@ -21,12 +22,9 @@ Mesh_Sphere::Mesh_Sphere(float radius, int sectors, int stacks, bool smooth)
     , __sectors{ sectors }
     , __stacks{ stacks }
     , __smooth{ smooth }
-    , __facesEBO{ 0 }
 {
     LOG_PRINT(Log::LogMainFileName, "Constructed\n");
 
-    glGenBuffers(1, &__facesEBO);
-
     if (__smooth)
         buildVerticesSmooth();
     else
@@ -36,13 +34,12 @@ Mesh_Sphere::Mesh_Sphere(float radius, int sectors, int stacks, bool smooth)
 Mesh_Sphere::~Mesh_Sphere()
 {
     LOG_PRINT(Log::LogMainFileName, "Destroyed\n");
-
-    glDeleteBuffers(1, &__facesEBO);
 }
 
 GLuint Mesh_Sphere::GetFacesEBO() const
 {
-    return __facesEBO;
+    // Indices live in the geometry arena
+    return 0;
 }
 
 bool Mesh_Sphere::IsUsingEBO() const
@@ -101,42 +98,24 @@ void Mesh_Sphere::buildVertices(std::vector<VertexPos> & vertices, std::vector<V
 void Mesh_Sphere::bind3SizedVertices(const std::vector<VertexPos> & vertices)
 {
     // Binding vertices
-    glBindVertexArray(__verticesVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, __verticesVBO);
+    OpenGL_State::BindVertexArray(__verticesVAO);
+    OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __verticesVBO);
 
     glBufferData(GL_ARRAY_BUFFER, sizeof(VertexPos) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
 
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexPos), (GLvoid *)0);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, 0);
+    OpenGL_State::BindVertexArray(0);
 
     __verticesNVert = vertices.size();
 }
 
 void Mesh_Sphere::bindVnts(const std::vector<VertexNormalTexture> & vnts, const std::vector<GLuint> & indices)
 {
-    // Binding vertices with normal & texture coordinates
-    glBindVertexArray(__facesVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, __facesVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(VertexNormalTexture) * vnts.size(), vnts.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, __facesEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid *)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid *)(3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid *)(6 * sizeof(GLfloat)));
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    __facesNVert = indices.size();
+    // Vertices with normal & texture coordinates, indexed, in the geometry arena
+    LoadFaces(vnts, indices);
 }
 
 void Mesh_Sphere::buildVerticesSmooth()
@@ -47,6 +47,4 @@ private:
     float __radius;
     int __sectors, __stacks;
     bool __smooth;
-
-    GLuint __facesEBO;
 };
@@ -0,0 +1,237 @@
+/*****************************************************************//**
+ * \file   TlsfAllocator.cpp
+ * \brief  TlsfAllocator source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 09 2022
+ *********************************************************************/
+#include "TlsfAllocator.hpp"
+
+// C++ includes
+#include <bit>
+#include <stdexcept>
+
+TlsfAllocator::TlsfAllocator(uint32_t capacity)
+    : __firstLevelBitmap{ 0 }
+    , __secondLevelBitmaps{ 0 }
+    , __lastBlock{ invalidNode }
+    , __capacity{ 0 }
+    , __used{ 0 }
+{
+    for (auto & lists : __freeLists)
+        lists.fill(invalidNode);
+    if (capacity) Grow(capacity);
+}
+
+TlsfAllocator::~TlsfAllocator()
+{
+}
+
+uint32_t TlsfAllocator::Allocate(uint32_t size)
+{
+    if (size == 0) return invalidOffset;
+
+    const uint32_t node = FindFreeBlock(size);
+    if (node == invalidNode) return invalidOffset;
+    RemoveFree(node);
+
+    // Splits the remainder back into the free lists
+    if (__blocks[node].size > size)
+    {
+        const uint32_t remainder = NewBlock();
+        Block & block = __blocks[node];
+        Block & rest = __blocks[remainder];
+        rest.offset = block.offset + size;
+        rest.size = block.size - size;
+        rest.previous = node;
+        rest.next = block.next;
+        if (block.next != invalidNode) __blocks[block.next].previous = remainder;
+        else __lastBlock = remainder;
+        block.next = remainder;
+        block.size = size;
+        InsertFree(remainder);
+    }
+
+    Block & block = __blocks[node];
+    block.free = false;
+    __allocated.emplace(block.offset, node);
+    __used += size;
+    return block.offset;
+}
+
+void TlsfAllocator::Free(uint32_t offset)
+{
+    const auto it = __allocated.find(offset);
+    if (it == __allocated.end()) throw std::runtime_error("TlsfAllocator: freeing an offset that is not allocated");
+    uint32_t node = it->second;
+    __allocated.erase(it);
+    __used -= __blocks[node].size;
+
+    // Merges with free neighbours
+    const uint32_t next = __blocks[node].next;
+    if (next != invalidNode && __blocks[next].free)
+    {
+        RemoveFree(next);
+        __blocks[node].size += __blocks[next].size;
+        __blocks[node].next = __blocks[next].next;
+        if (__blocks[node].next != invalidNode) __blocks[__blocks[node].next].previous = node;
+        else __lastBlock = node;
+        ReleaseBlock(next);
+    }
+    const uint32_t previous = __blocks[node].previous;
+    if (previous != invalidNode && __blocks[previous].free)
+    {
+        RemoveFree(previous);
+        __blocks[previous].size += __blocks[node].size;
+        __blocks[previous].next = __blocks[node].next;
+        if (__blocks[previous].next != invalidNode) __blocks[__blocks[previous].next].previous = previous;
+        else __lastBlock = previous;
+        ReleaseBlock(node);
+        node = previous;
+    }
+    InsertFree(node);
+}
+
+void TlsfAllocator::Grow(uint32_t capacity)
+{
+    if (capacity <= __capacity) return;
+    const uint32_t added = capacity - __capacity;
+
+    if (__lastBlock != invalidNode && __blocks[__lastBlock].free)
+    {
+        RemoveFree(__lastBlock);
+        __blocks[__lastBlock].size += added;
+        InsertFree(__lastBlock);
+    }
+    else
+    {
+        const uint32_t node = NewBlock();
+        Block & block = __blocks[node];
+        block.offset = __capacity;
+        block.size = added;
+        block.previous = __lastBlock;
+        block.next = invalidNode;
+        if (__lastBlock != invalidNode) __blocks[__lastBlock].next = node;
+        __lastBlock = node;
+        InsertFree(node);
+    }
+    __capacity = capacity;
+}
+
+uint32_t TlsfAllocator::GetCapacity() const
+{
+    return __capacity;
+}
+
+uint32_t TlsfAllocator::GetUsed() const
+{
+    return __used;
+}
+
+uint32_t TlsfAllocator::GetAllocationsCount() const
+{
+    return static_cast<uint32_t>(__allocated.size());
+}
+
+void TlsfAllocator::Mapping(uint32_t size, uint32_t & firstLevel, uint32_t & secondLevel)
+{
+    if (size < secondLevelCount)
+    {
+        firstLevel = 0;
+        secondLevel = size;
+        return;
+    }
+    const uint32_t msb = std::bit_width(size) - 1;
+    firstLevel = msb - secondLevelBits + 1;
+    secondLevel = (size >> (msb - secondLevelBits)) - secondLevelCount;
+}
+
+uint32_t TlsfAllocator::FindFreeBlock(uint32_t size) const
+{
+    // Rounds up to the next size class, so that any block of the class found fits
+    uint64_t rounded = size;
+    if (size >= secondLevelCount)
+        rounded += (1ull << (std::bit_width(size) - 1 - secondLevelBits)) - 1;
+    if (rounded > UINT32_MAX) return invalidNode;
+
+    uint32_t firstLevel, secondLevel;
+    Mapping(static_cast<uint32_t>(rounded), firstLevel, secondLevel);
+
+    uint32_t secondLevelMap = __secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+    if (!secondLevelMap)
+    {
+        const uint32_t firstLevelMap = (firstLevel + 1 < firstLevelCount) ? __firstLevelBitmap & (~0u << (firstLevel + 1)) : 0;
+        if (firstLevelMap)
+        {
+            firstLevel = std::countr_zero(firstLevelMap);
+            secondLevelMap = __secondLevelBitmaps[firstLevel];
+        }
+    }
+    if (secondLevelMap)
+    {
+        secondLevel = std::countr_zero(secondLevelMap);
+        return __freeLists[firstLevel][secondLevel];
+    }
+
+    // Nothing in bigger classes, a block of the class of the size itself may still fit
+    Mapping(size, firstLevel, secondLevel);
+    for (uint32_t node = __freeLists[firstLevel][secondLevel]; node != invalidNode; node = __blocks[node].nextFree)
+        if (__blocks[node].size >= size) return node;
+    return invalidNode;
+}
+
+void TlsfAllocator::InsertFree(uint32_t node)
+{
+    uint32_t firstLevel, secondLevel;
+    Mapping(__blocks[node].size, firstLevel, secondLevel);
+
+    Block & block = __blocks[node];
+    block.free = true;
+    block.previousFree = invalidNode;
+    block.nextFree = __freeLists[firstLevel][secondLevel];
+    if (block.nextFree != invalidNode) __blocks[block.nextFree].previousFree = node;
+    __freeLists[firstLevel][secondLevel] = node;
+
+    __firstLevelBitmap |= 1u << firstLevel;
+    __secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+void TlsfAllocator::RemoveFree(uint32_t node)
+{
+    uint32_t firstLevel, secondLevel;
+    Mapping(__blocks[node].size, firstLevel, secondLevel);
+
+    Block & block = __blocks[node];
+    block.free = false;
+    if (block.previousFree != invalidNode) __blocks[block.previousFree].nextFree = block.nextFree;
+    else __freeLists[firstLevel][secondLevel] = block.nextFree;
+    if (block.nextFree != invalidNode) __blocks[block.nextFree].previousFree = block.previousFree;
+
+    if (__freeLists[firstLevel][secondLevel] == invalidNode)
+    {
+        __secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+        if (!__secondLevelBitmaps[firstLevel]) __firstLevelBitmap &= ~(1u << firstLevel);
+    }
+}
+
+uint32_t TlsfAllocator::NewBlock()
+{
+    uint32_t node;
+    if (!__unusedBlocks.empty())
+    {
+        node = __unusedBlocks.back();
+        __unusedBlocks.pop_back();
+    }
+    else
+    {
+        node = static_cast<uint32_t>(__blocks.size());
+        __blocks.emplace_back();
+    }
+    __blocks[node] = { 0, 0, invalidNode, invalidNode, invalidNode, invalidNode, false };
+    return node;
+}
+
+void TlsfAllocator::ReleaseBlock(uint32_t node)
+{
+    __unusedBlocks.push_back(node);
+}
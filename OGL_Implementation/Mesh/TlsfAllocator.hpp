@@ -0,0 +1,95 @@
+/*****************************************************************//**
+ * \file   TlsfAllocator.hpp
+ * \brief  Two-Level Segregated Fit range allocator
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 09 2022
+ *********************************************************************/
+#pragma once
+
+// C++ includes
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Allocates ranges of [0, capacity) in O(1) with the TLSF scheme:
+ * free blocks are kept in lists segregated by size, a first level per power of 2
+ * and 16 linear second level subdivisions, found through two bitmaps.
+ * Freed blocks are merged with their free neighbours.
+ * Only offsets are handed out, the memory itself lives elsewhere (e.g. in a GPU buffer).
+*/
+class TlsfAllocator
+{
+public:
+    static constexpr uint32_t invalidOffset = UINT32_MAX;
+
+public:
+    TlsfAllocator(uint32_t capacity = 0);
+    ~TlsfAllocator();
+
+    /**
+     * @brief Allocates a range
+     * @param size in units, greater than 0
+     * @return offset of the range or invalidOffset if no free block is big enough
+    */
+    uint32_t Allocate(uint32_t size);
+    /**
+     * @brief Frees a range returned by Allocate
+     * @param offset
+    */
+    void Free(uint32_t offset);
+    /**
+     * @brief Extends the managed range, allocated offsets stay valid
+     * @param capacity new capacity, greater than the current one
+    */
+    void Grow(uint32_t capacity);
+
+    uint32_t GetCapacity() const;
+    uint32_t GetUsed() const;
+    uint32_t GetAllocationsCount() const;
+
+private:
+    static constexpr uint32_t secondLevelBits = 4;
+    static constexpr uint32_t secondLevelCount = 1 << secondLevelBits;
+    static constexpr uint32_t firstLevelCount = 32;
+    static constexpr uint32_t invalidNode = UINT32_MAX;
+
+    struct Block
+    {
+        uint32_t offset, size;
+        /**
+         * @brief Neighbours in memory
+        */
+        uint32_t previous, next;
+        /**
+         * @brief Neighbours in the free list of the size class
+        */
+        uint32_t previousFree, nextFree;
+        bool free;
+    };
+
+    /**
+     * @brief Size class containing the size (rounded down)
+    */
+    static void Mapping(uint32_t size, uint32_t & firstLevel, uint32_t & secondLevel);
+    uint32_t FindFreeBlock(uint32_t size) const;
+    void InsertFree(uint32_t node);
+    void RemoveFree(uint32_t node);
+    uint32_t NewBlock();
+    void ReleaseBlock(uint32_t node);
+
+private:
+    std::vector<Block> __blocks;
+    /**
+     * @brief Recycled entries of __blocks
+    */
+    std::vector<uint32_t> __unusedBlocks;
+    uint32_t __firstLevelBitmap;
+    std::array<uint32_t, firstLevelCount> __secondLevelBitmaps;
+    std::array<std::array<uint32_t, secondLevelCount>, firstLevelCount> __freeLists;
+    std::unordered_map<uint32_t, uint32_t> __allocated;
+    uint32_t __lastBlock;
+    uint32_t __capacity, __used;
+};
@@ -0,0 +1,326 @@
+/*****************************************************************//**
+ * \file   OpenGL_State.cpp
+ * \brief  Source code of OpenGL_State
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 07 2022
+ *********************************************************************/
+#include "OpenGL_State.hpp"
+
+// C++ includes
+#include <array>
+#include <iterator>
+
+static constexpr const GLuint unknown = static_cast<GLuint>(-1);
+static constexpr const size_t maxTextureUnits = 192;
+static constexpr const size_t maxIndexedBindings = 16;
+
+/**
+ * @brief Targets whose binding is filtered (GL_ELEMENT_ARRAY_BUFFER is VAO state)
+*/
+static constexpr const GLenum bufferTargets[] = {
+    GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_DRAW_INDIRECT_BUFFER,
+    GL_DISPATCH_INDIRECT_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_PIXEL_PACK_BUFFER,
+    GL_PIXEL_UNPACK_BUFFER, GL_TEXTURE_BUFFER, GL_ATOMIC_COUNTER_BUFFER, GL_QUERY_BUFFER
+};
+static constexpr const GLenum indexedTargets[] = { GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER };
+static constexpr const GLenum filteredCapabilities[] = {
+    GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST, GL_MULTISAMPLE,
+    GL_PROGRAM_POINT_SIZE, GL_TEXTURE_CUBE_MAP_SEAMLESS, GL_POLYGON_OFFSET_FILL, GL_FRAMEBUFFER_SRGB
+};
+
+struct IndexedBinding
+{
+    GLuint buffer;
+    GLintptr offset;
+    GLsizeiptr size;
+};
+
+/**
+ * @brief Shadow copy of the context state, unknown values are never equal to a real one
+*/
+struct State
+{
+    GLuint program = unknown;
+    GLuint vao = unknown;
+    std::array<GLuint, std::size(bufferTargets)> buffers;
+    std::array<std::array<IndexedBinding, maxIndexedBindings>, std::size(indexedTargets)> indexedBuffers;
+    GLuint activeUnit = unknown;
+    std::array<GLuint, maxTextureUnits> textures;
+    std::array<GLuint, maxTextureUnits> samplers;
+    GLuint drawFramebuffer = unknown;
+    GLuint readFramebuffer = unknown;
+    /**
+     * @brief -1 = unknown, 0 = disabled, 1 = enabled
+    */
+    std::array<int, std::size(filteredCapabilities)> capabilities;
+    GLenum blendSrc = unknown, blendDst = unknown;
+    int depthMask = -1;
+    GLenum depthFunc = unknown;
+    GLenum polygonMode = unknown;
+    GLint viewport[4] = { -1, -1, -1, -1 };
+
+    State()
+    {
+        buffers.fill(unknown);
+        for (auto & bindings : indexedBuffers)
+            bindings.fill({ unknown, -1, -1 });
+        textures.fill(unknown);
+        samplers.fill(unknown);
+        capabilities.fill(-1);
+    }
+};
+
+static State s_state;
+static OpenGL_State::Stats s_frameStats;
+static OpenGL_State::Stats s_lastFrameStats;
+
+template<size_t N>
+static int IndexOf(const GLenum (&values)[N], GLenum value)
+{
+    for (size_t i = 0; i < N; ++i)
+        if (values[i] == value) return static_cast<int>(i);
+    return -1;
+}
+
+/**
+ * @brief Updates cached value & counters
+ * @return true if the call has to be issued
+*/
+template<class T>
+static bool Changed(T & cached, const T value)
+{
+    if (cached == value)
+    {
+        ++s_frameStats.elided;
+        return false;
+    }
+    cached = value;
+    ++s_frameStats.issued;
+    return true;
+}
+
+void OpenGL_State::UseProgram(GLuint program)
+{
+    if (Changed(s_state.program, program)) glUseProgram(program);
+}
+
+void OpenGL_State::BindVertexArray(GLuint vao)
+{
+    if (Changed(s_state.vao, vao)) glBindVertexArray(vao);
+}
+
+void OpenGL_State::BindBuffer(GLenum target, GLuint buffer)
+{
+    const int index = IndexOf(bufferTargets, target);
+    if (index < 0)
+    {
+        ++s_frameStats.issued;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (Changed(s_state.buffers[index], buffer)) glBindBuffer(target, buffer);
+}
+
+void OpenGL_State::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    const int targetIndex = IndexOf(indexedTargets, target);
+    if (targetIndex >= 0 && index < maxIndexedBindings)
+    {
+        IndexedBinding & binding = s_state.indexedBuffers[targetIndex][index];
+        if (binding.buffer == buffer && binding.offset == offset && binding.size == size)
+        {
+            ++s_frameStats.elided;
+            return;
+        }
+        binding = { buffer, offset, size };
+    }
+    // Also binds the generic binding point
+    const int genericIndex = IndexOf(bufferTargets, target);
+    if (genericIndex >= 0) s_state.buffers[genericIndex] = buffer;
+
+    ++s_frameStats.issued;
+    glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void OpenGL_State::BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    const int targetIndex = IndexOf(indexedTargets, target);
+    if (targetIndex >= 0 && index < maxIndexedBindings)
+    {
+        IndexedBinding & binding = s_state.indexedBuffers[targetIndex][index];
+        // Whole buffer
+        if (binding.buffer == buffer && binding.offset == 0 && binding.size == -1)
+        {
+            ++s_frameStats.elided;
+            return;
+        }
+        binding = { buffer, 0, -1 };
+    }
+    const int genericIndex = IndexOf(bufferTargets, target);
+    if (genericIndex >= 0) s_state.buffers[genericIndex] = buffer;
+
+    ++s_frameStats.issued;
+    glBindBufferBase(target, index, buffer);
+}
+
+void OpenGL_State::ActiveTexture(GLuint unit)
+{
+    if (Changed(s_state.activeUnit, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void OpenGL_State::BindTexture(GLenum target, GLuint texture)
+{
+    // Binding on an unknown unit would leave a stale copy of that unit
+    if (s_state.activeUnit >= maxTextureUnits) ActiveTexture(0);
+    const GLuint unit = s_state.activeUnit;
+    if (unit < maxTextureUnits && !Changed(s_state.textures[unit], texture)) return;
+    if (unit >= maxTextureUnits) ++s_frameStats.issued;
+    glBindTexture(target, texture);
+}
+
+void OpenGL_State::BindTextureUnit(GLuint unit, GLuint texture)
+{
+    if (unit < maxTextureUnits && !Changed(s_state.textures[unit], texture)) return;
+    if (unit >= maxTextureUnits) ++s_frameStats.issued;
+    glBindTextureUnit(unit, texture);
+}
+
+void OpenGL_State::BindSampler(GLuint unit, GLuint sampler)
+{
+    if (unit < maxTextureUnits && !Changed(s_state.samplers[unit], sampler)) return;
+    if (unit >= maxTextureUnits) ++s_frameStats.issued;
+    glBindSampler(unit, sampler);
+}
+
+void OpenGL_State::BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    const bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    const bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+    if ((!draw || s_state.drawFramebuffer == framebuffer) && (!read || s_state.readFramebuffer == framebuffer))
+    {
+        ++s_frameStats.elided;
+        return;
+    }
+    if (draw) s_state.drawFramebuffer = framebuffer;
+    if (read) s_state.readFramebuffer = framebuffer;
+    ++s_frameStats.issued;
+    glBindFramebuffer(target, framebuffer);
+}
+
+void OpenGL_State::SetCapability(GLenum capability, bool enabled)
+{
+    const int index = IndexOf(filteredCapabilities, capability);
+    if (index >= 0 && !Changed(s_state.capabilities[index], static_cast<int>(enabled))) return;
+    if (index < 0) ++s_frameStats.issued;
+    if (enabled) glEnable(capability);
+    else glDisable(capability);
+}
+
+void OpenGL_State::BlendFunc(GLenum sfactor, GLenum dfactor)
+{
+    if (s_state.blendSrc == sfactor && s_state.blendDst == dfactor)
+    {
+        ++s_frameStats.elided;
+        return;
+    }
+    s_state.blendSrc = sfactor;
+    s_state.blendDst = dfactor;
+    ++s_frameStats.issued;
+    glBlendFunc(sfactor, dfactor);
+}
+
+void OpenGL_State::DepthMask(bool enabled)
+{
+    if (Changed(s_state.depthMask, static_cast<int>(enabled))) glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void OpenGL_State::DepthFunc(GLenum func)
+{
+    if (Changed(s_state.depthFunc, func)) glDepthFunc(func);
+}
+
+void OpenGL_State::PolygonMode(GLenum mode)
+{
+    if (Changed(s_state.polygonMode, mode)) glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void OpenGL_State::Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    GLint * viewport = s_state.viewport;
+    if (viewport[0] == x && viewport[1] == y && viewport[2] == width && viewport[3] == height)
+    {
+        ++s_frameStats.elided;
+        return;
+    }
+    viewport[0] = x; viewport[1] = y; viewport[2] = width; viewport[3] = height;
+    ++s_frameStats.issued;
+    glViewport(x, y, width, height);
+}
+
+// Deleted objects are unbound by OpenGL
+void OpenGL_State::DeleteTextures(GLsizei n, const GLuint * textures)
+{
+    for (GLsizei i = 0; i < n; ++i)
+        for (GLuint & texture : s_state.textures)
+            if (texture == textures[i]) texture = 0;
+    ++s_frameStats.issued;
+    glDeleteTextures(n, textures);
+}
+
+void OpenGL_State::DeleteBuffers(GLsizei n, const GLuint * buffers)
+{
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        for (GLuint & buffer : s_state.buffers)
+            if (buffer == buffers[i]) buffer = 0;
+        for (auto & bindings : s_state.indexedBuffers)
+            for (IndexedBinding & binding : bindings)
+                if (binding.buffer == buffers[i]) binding = { 0, 0, -1 };
+    }
+    ++s_frameStats.issued;
+    glDeleteBuffers(n, buffers);
+}
+
+void OpenGL_State::DeleteVertexArrays(GLsizei n, const GLuint * vaos)
+{
+    for (GLsizei i = 0; i < n; ++i)
+        if (s_state.vao == vaos[i]) s_state.vao = 0;
+    ++s_frameStats.issued;
+    glDeleteVertexArrays(n, vaos);
+}
+
+void OpenGL_State::DeleteFramebuffers(GLsizei n, const GLuint * framebuffers)
+{
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        if (s_state.drawFramebuffer == framebuffers[i]) s_state.drawFramebuffer = 0;
+        if (s_state.readFramebuffer == framebuffers[i]) s_state.readFramebuffer = 0;
+    }
+    ++s_frameStats.issued;
+    glDeleteFramebuffers(n, framebuffers);
+}
+
+void OpenGL_State::DeleteProgram(GLuint program)
+{
+    // A program in use is only flagged for deletion but its name can already be reused
+    if (s_state.program == program) s_state.program = unknown;
+    ++s_frameStats.issued;
+    glDeleteProgram(program);
+}
+
+void OpenGL_State::Invalidate()
+{
+    s_state = State();
+}
+
+void OpenGL_State::NewFrame()
+{
+    s_lastFrameStats = s_frameStats;
+    s_frameStats = Stats();
+}
+
+const OpenGL_State::Stats & OpenGL_State::GetLastFrameStats()
+{
+    return s_lastFrameStats;
+}
@@ -0,0 +1,112 @@
+/*****************************************************************//**
+ * \file   OpenGL_State.hpp
+ * \brief  Shadow copy of the OpenGL state, filtering redundant calls
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 07 2022
+ *********************************************************************/
+#pragma once
+
+// OpenGL includes
+#include <GLAD\glad.h>
+
+/**
+ * @brief Keeps a copy of the OpenGL state (program, VAO, buffers per target & per
+ * indexed binding, textures & samplers per unit, framebuffers, capabilities, blending,
+ * depth, polygon mode & viewport), calls are only issued when the value changes.
+ * Every rendering code has to go through it, code changing the state behind its
+ * back (e.g. ImGui) has to be followed by Invalidate().
+ * GL_ELEMENT_ARRAY_BUFFER is part of the VAO state, so its bindings are never filtered.
+*/
+class OpenGL_State
+{
+public:
+    /**
+     * @brief Calls counted since the beginning of the frame
+    */
+    struct Stats
+    {
+        /**
+         * @brief Calls sent to the driver
+        */
+        int issued = 0;
+        /**
+         * @brief Calls filtered because the state already had the value
+        */
+        int elided = 0;
+    };
+
+public:
+    static void UseProgram(GLuint program);
+    static void BindVertexArray(GLuint vao);
+    static void BindBuffer(GLenum target, GLuint buffer);
+    /**
+     * @brief Binds a buffer range to an indexed binding point (also binds the generic target)
+     * @param target GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, ...
+     * @param index binding point
+     * @param buffer
+     * @param offset
+     * @param size
+    */
+    static void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    static void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    /**
+     * @brief Selects the active texture unit (used by BindTexture)
+     * @param unit index of the unit (not GL_TEXTURE0 + index)
+    */
+    static void ActiveTexture(GLuint unit);
+    /**
+     * @brief Binds a texture to the active unit, mostly to create or edit textures
+     * @param target
+     * @param texture
+    */
+    static void BindTexture(GLenum target, GLuint texture);
+    /**
+     * @brief Binds a texture to a unit without changing the active unit (glBindTextureUnit)
+     * @param unit index of the unit
+     * @param texture
+    */
+    static void BindTextureUnit(GLuint unit, GLuint texture);
+    static void BindSampler(GLuint unit, GLuint sampler);
+    static void BindFramebuffer(GLenum target, GLuint framebuffer);
+    /**
+     * @brief glEnable/glDisable
+     * @param capability
+     * @param enabled
+    */
+    static void SetCapability(GLenum capability, bool enabled);
+    static void BlendFunc(GLenum sfactor, GLenum dfactor);
+    static void DepthMask(bool enabled);
+    static void DepthFunc(GLenum func);
+    /**
+     * @brief Polygon mode of both faces
+     * @param mode
+    */
+    static void PolygonMode(GLenum mode);
+    static void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    /**
+     * @brief Deletes objects & forgets their bindings, as their names can be reused
+    */
+    static void DeleteTextures(GLsizei n, const GLuint * textures);
+    static void DeleteBuffers(GLsizei n, const GLuint * buffers);
+    static void DeleteVertexArrays(GLsizei n, const GLuint * vaos);
+    static void DeleteFramebuffers(GLsizei n, const GLuint * framebuffers);
+    static void DeleteProgram(GLuint program);
+
+    /**
+     * @brief Forgets the whole state, next calls will all be issued
+    */
+    static void Invalidate();
+
+    /**
+     * @brief Saves counters of the frame that ended & resets them, to call once per frame
+    */
+    static void NewFrame();
+
+    /**
+     * @brief Returns counters of the last complete frame
+     * @return stats
+    */
+    static const Stats & GetLastFrameStats();
+};
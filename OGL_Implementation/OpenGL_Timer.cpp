@@ -9,12 +9,20 @@
 
 OpenGL_Timer::OpenGL_Timer()
     : query{ 0 }
+    , endQuery{ 0 }
 {
 }
 
+OpenGL_Timer::~OpenGL_Timer()
+{
+    if (query != 0) glDeleteQueries(1, &query);
+    if (endQuery != 0) glDeleteQueries(1, &endQuery);
+}
+
 void OpenGL_Timer::Start()
 {
-    glGenQueries(1, &query);
+    // Query object is reused between measures
+    if (query == 0) glGenQueries(1, &query);
     glBeginQuery(GL_TIME_ELAPSED, query);
 }
 
@@ -35,3 +43,42 @@ GLuint64 OpenGL_Timer::End()
     glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedTime);
     return elapsedTime;
 }
+
+void OpenGL_Timer::Stop()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+}
+
+void OpenGL_Timer::StartTimestamp()
+{
+    if (query == 0) glGenQueries(1, &query);
+    if (endQuery == 0) glGenQueries(1, &endQuery);
+    glQueryCounter(query, GL_TIMESTAMP);
+}
+
+void OpenGL_Timer::StopTimestamp()
+{
+    glQueryCounter(endQuery, GL_TIMESTAMP);
+}
+
+bool OpenGL_Timer::IsResultAvailable() const
+{
+    if (query == 0) return false;
+    // Queries complete in order, the last one is enough
+    GLint available = 0;
+    glGetQueryObjectiv(endQuery != 0 ? endQuery : query, GL_QUERY_RESULT_AVAILABLE, &available);
+    return available != 0;
+}
+
+GLuint64 OpenGL_Timer::GetResult() const
+{
+    GLuint64 elapsedTime = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsedTime);
+    if (endQuery != 0)
+    {
+        GLuint64 endTime = 0;
+        glGetQueryObjectui64v(endQuery, GL_QUERY_RESULT, &endTime);
+        elapsedTime = endTime - elapsedTime;
+    }
+    return elapsedTime;
+}
@@ -20,6 +20,7 @@ public:
      * @brief Timer Constructor
     */
     OpenGL_Timer();
+    ~OpenGL_Timer();
 
     /**
      * @brief Starts Timer
@@ -32,6 +33,38 @@ public:
     */
     GLuint64 End();
 
+    /**
+     * @brief Ends timer without waiting for the GPU,
+     * result can be read later with GetResult
+    */
+    void Stop();
+
+    /**
+     * @brief Starts timer with a timestamp query, unlike Start it can be nested
+     * in or overlap other timers (only one GL_TIME_ELAPSED query can be active)
+    */
+    void StartTimestamp();
+    /**
+     * @brief Ends a timer started with StartTimestamp without waiting for the GPU
+    */
+    void StopTimestamp();
+
+    /**
+     * @brief Returns true if the result of the last Stop() can be read without stalling
+     * @return true if available
+    */
+    bool IsResultAvailable() const;
+
+    /**
+     * @brief Returns nanoseconds passed between Start and Stop (waits for the GPU if needed)
+     * @return time in ns
+    */
+    GLuint64 GetResult() const;
+
 public:
     GLuint query;
+    /**
+     * @brief Second timestamp of StartTimestamp/StopTimestamp, 0 when measured with Start/Stop
+    */
+    GLuint endQuery;
 };
@@ -0,0 +1,136 @@
+/*****************************************************************//**
+ * \file   DeferredRendering.cpp
+ * \brief  DeferredRendering source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 14 2022
+ *********************************************************************/
+#include "DeferredRendering.hpp"
+
+// Project includes
+#include "Constants.hpp"
+#include "OGL_Implementation\Window.hpp"
+#include "OGL_Implementation\Camera.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
+
+static std::unique_ptr<DeferredRendering> s_deferredRendering;
+
+DeferredRendering::Settings DeferredRendering::settings;
+
+/**
+ * @brief Internal format & texture unit of every color target
+*/
+static constexpr const GLenum targetsFormats[DeferredRendering::TargetsCount] = { GL_RGBA8, GL_RGBA16F, GL_RGBA8, GL_RGBA16F };
+static constexpr const GLuint targetsUnits[DeferredRendering::TargetsCount] = {
+    Constants::TextureUnits::gAlbedo,
+    Constants::TextureUnits::gNormal,
+    Constants::TextureUnits::gMaterial,
+    Constants::TextureUnits::gLight
+};
+
+DeferredRendering::DeferredRendering()
+    : __lightingShader{ GenerateShader(Constants::Paths::fullscreenTriangleVertex, Constants::Paths::deferredLightingFrag) }
+    , __framebuffer{ 0 }
+    , __targets{ 0 }
+    , __depth{ 0 }
+    , __emptyVAO{ 0 }
+    , __size{ 0 }
+{
+    __lightingShader.AddGlobalUbo(Constants::UBO::Ids::cameraProps, Constants::UBO::Names::cameraProps);
+    __lightingShader.AddGlobalUbo(Constants::UBO::Ids::lights, Constants::UBO::Names::lights);
+
+    glCreateFramebuffers(1, &__framebuffer);
+    constexpr const GLenum drawBuffers[TargetsCount] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+    glNamedFramebufferDrawBuffers(__framebuffer, TargetsCount, drawBuffers);
+    glCreateVertexArrays(1, &__emptyVAO);
+}
+
+DeferredRendering::~DeferredRendering()
+{
+    OpenGL_State::DeleteFramebuffers(1, &__framebuffer);
+    OpenGL_State::DeleteTextures(TargetsCount, __targets.data());
+    OpenGL_State::DeleteTextures(1, &__depth);
+    OpenGL_State::DeleteVertexArrays(1, &__emptyVAO);
+}
+
+void DeferredRendering::Init()
+{
+    s_deferredRendering.reset(new DeferredRendering());
+}
+
+bool DeferredRendering::Accepts(Entity & entity)
+{
+    // Forward until the lighting pass is compiled
+    return settings.enabled && s_deferredRendering->__lightingShader.IsReady()
+        && !entity.transparent && entity.GetPbrMaterial() && !(entity.shaderFeatures & SsssFeature);
+}
+
+void DeferredRendering::Resize(int width, int height)
+{
+    OpenGL_State::DeleteTextures(TargetsCount, __targets.data());
+    OpenGL_State::DeleteTextures(1, &__depth);
+    __size = glm::ivec2(width, height);
+
+    for (int i = 0; i < TargetsCount; ++i)
+    {
+        glCreateTextures(GL_TEXTURE_2D, 1, &__targets[i]);
+        glTextureStorage2D(__targets[i], 1, targetsFormats[i], width, height);
+        glNamedFramebufferTexture(__framebuffer, GL_COLOR_ATTACHMENT0 + i, __targets[i], 0);
+    }
+    glCreateTextures(GL_TEXTURE_2D, 1, &__depth);
+    glTextureStorage2D(__depth, 1, GL_DEPTH_COMPONENT32F, width, height);
+    glNamedFramebufferTexture(__framebuffer, GL_DEPTH_ATTACHMENT, __depth, 0);
+
+    // Only read with texelFetch
+    for (GLuint texture : __targets)
+    {
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glTextureParameteri(__depth, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(__depth, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void DeferredRendering::BeginGeometry()
+{
+    DeferredRendering & deferred = *s_deferredRendering;
+    const glm::ivec2 size(Window::Get()->windowWidth(), Window::Get()->windowHeight());
+    if (size != deferred.__size) deferred.Resize(size.x, size.y);
+
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, deferred.__framebuffer);
+    // Alpha of the targets holds data, not coverage
+    OpenGL_State::SetCapability(GL_BLEND, false);
+    OpenGL_State::DepthMask(true);
+
+    constexpr const GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    constexpr const GLfloat clearDepth = 1.0f;
+    for (int i = 0; i < TargetsCount; ++i)
+        glClearNamedFramebufferfv(deferred.__framebuffer, GL_COLOR, i, clearColor);
+    glClearNamedFramebufferfv(deferred.__framebuffer, GL_DEPTH, 0, &clearDepth);
+}
+
+void DeferredRendering::EndGeometry()
+{
+    DeferredRendering & deferred = *s_deferredRendering;
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (mainCamera)
+    {
+        for (int i = 0; i < TargetsCount; ++i)
+            OpenGL_State::BindTextureUnit(targetsUnits[i], deferred.__targets[i]);
+        OpenGL_State::BindTextureUnit(Constants::TextureUnits::gDepth, deferred.__depth);
+
+        deferred.__lightingShader.Use();
+        deferred.__lightingShader.SetUniformMatrix4f("inverseViewProj",
+            glm::inverse(mainCamera->GetProjectionMatrix() * mainCamera->GetViewMatrix()));
+
+        // Every pixel passes, its depth is the one of the G-buffer (gl_FragDepth)
+        OpenGL_State::DepthFunc(GL_ALWAYS);
+        OpenGL_State::PolygonMode(GL_FILL);
+        OpenGL_State::BindVertexArray(deferred.__emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        OpenGL_State::DepthFunc(GL_LEQUAL);
+    }
+
+    OpenGL_State::SetCapability(GL_BLEND, true);
+}
@@ -0,0 +1,94 @@
+/*****************************************************************//**
+ * \file   DeferredRendering.hpp
+ * \brief  Deferred shading path, G-buffer & lighting pass
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 14 2022
+ *********************************************************************/
+#pragma once
+
+// Project includes
+#include "OGL_Implementation\Entity\Entity.hpp"
+#include "OGL_Implementation\Shader\Shader.hpp"
+
+// GLAD includes
+#include <GLAD\glad.h>
+
+// GLM includes
+#include <glm\glm.hpp>
+
+// C++ includes
+#include <array>
+#include <memory>
+
+/**
+ * @brief Alternative to forward shading for opaque PBR entities: the geometry pass draws them
+ * with the DEFERRED variant of pbr.frag, writing albedo, normal, metallic/roughness, ambient
+ * radiance (IBL, per entity reflection probe) & depth into the G-buffer. The lighting pass then
+ * shades point lights once per pixel with a full screen triangle, whatever the overdraw was,
+ * & writes the G-buffer depth to the window framebuffer. Everything else (other shaders,
+ * transparent entities, SSSS transmittance, particles) stays forward, drawn afterwards.
+*/
+class DeferredRendering
+{
+public:
+    struct Settings
+    {
+        /**
+         * @brief Entities accepted by the deferred path go through the G-buffer
+        */
+        bool enabled = false;
+    };
+
+    /**
+     * @brief Color targets of the G-buffer, in the order of the pbr.frag outputs
+    */
+    enum Target
+    {
+        Albedo = 0, // RGBA8: albedo (rgb, gamma encoded), shadows received (a)
+        Normal,     // RGBA16F: world normal (xyz)
+        Material,   // RGBA8: metallic (r), roughness (g)
+        Light,      // RGBA16F: ambient radiance (rgb)
+        TargetsCount
+    };
+
+public:
+    DeferredRendering();
+    ~DeferredRendering();
+
+    static void Init();
+
+    /**
+     * @brief Returns true if the entity is drawn in the G-buffer: opaque PBR entities
+     * without SSSS transmittance, while the deferred path is enabled & its lighting pass compiled
+     * @param entity
+     * @return deferred
+    */
+    static bool Accepts(Entity & entity);
+
+    /**
+     * @brief Binds & clears the G-buffer (resized to the window) for the geometry pass
+    */
+    static void BeginGeometry();
+    /**
+     * @brief Rebinds the window framebuffer & runs the lighting pass over the G-buffer,
+     * to call once the accepted entities are drawn
+    */
+    static void EndGeometry();
+
+    static Settings settings;
+
+private:
+    void Resize(int width, int height);
+
+private:
+    Shader __lightingShader;
+    GLuint __framebuffer;
+    std::array<GLuint, TargetsCount> __targets;
+    GLuint __depth;
+    /**
+     * @brief Without attributes, the full screen triangle comes from gl_VertexID
+    */
+    GLuint __emptyVAO;
+    glm::ivec2 __size;
+};
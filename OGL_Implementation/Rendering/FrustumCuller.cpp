@@ -0,0 +1,136 @@
+/*****************************************************************//**
+ * \file   FrustumCuller.cpp
+ * \brief  FrustumCuller source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 10 2022
+ *********************************************************************/
+#include "FrustumCuller.hpp"
+
+// C++ includes
+#include <bit>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_CULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+Frustum::Frustum(const glm::mat4 & viewProjection)
+{
+    const glm::mat4 m = glm::transpose(viewProjection);
+    planes = {
+        m[3] + m[0], // left
+        m[3] - m[0], // right
+        m[3] + m[1], // bottom
+        m[3] - m[1], // top
+        m[3] + m[2], // near
+        m[3] - m[2]  // far
+    };
+    for (auto & plane : planes)
+        plane /= glm::length(glm::vec3(plane));
+}
+
+FrustumCuller::FrustumCuller()
+{
+}
+
+FrustumCuller::~FrustumCuller()
+{
+}
+
+void FrustumCuller::Gather(const std::vector<Entity *> & entities)
+{
+    __entities = entities;
+
+    const size_t padded = (entities.size() + 3) & ~size_t(3);
+    for (auto * array : { &__centerX, &__centerY, &__centerZ, &__extentX, &__extentY, &__extentZ })
+        array->assign(padded, 0.0f);
+
+    for (size_t i = 0; i < entities.size(); ++i)
+    {
+        const BoundingBox & box = entities[i]->GetWorldBoundingBox();
+        const glm::vec3 center = box.Center(), extents = box.Extents();
+        __centerX[i] = center.x;
+        __centerY[i] = center.y;
+        __centerZ[i] = center.z;
+        __extentX[i] = extents.x;
+        __extentY[i] = extents.y;
+        __extentZ[i] = extents.z;
+    }
+}
+
+void FrustumCuller::Cull(const Frustum & frustum, std::vector<Entity *> & visible) const
+{
+    const size_t count = __entities.size();
+
+    // A box is outside when it is fully behind a plane:
+    // dot(n, center) + w + dot(|n|, extents) < 0
+#ifdef FRUSTUM_CULLER_SSE
+    struct SimdPlane
+    {
+        __m128 nx, ny, nz, w, ax, ay, az;
+    };
+    std::array<SimdPlane, 6> planes;
+    for (size_t p = 0; p < planes.size(); ++p)
+    {
+        const glm::vec4 & plane = frustum.planes[p];
+        planes[p] = {
+            _mm_set1_ps(plane.x), _mm_set1_ps(plane.y), _mm_set1_ps(plane.z), _mm_set1_ps(plane.w),
+            _mm_set1_ps(std::abs(plane.x)), _mm_set1_ps(std::abs(plane.y)), _mm_set1_ps(std::abs(plane.z))
+        };
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    for (size_t i = 0; i < count; i += 4)
+    {
+        const __m128 cx = _mm_loadu_ps(&__centerX[i]);
+        const __m128 cy = _mm_loadu_ps(&__centerY[i]);
+        const __m128 cz = _mm_loadu_ps(&__centerZ[i]);
+        const __m128 ex = _mm_loadu_ps(&__extentX[i]);
+        const __m128 ey = _mm_loadu_ps(&__extentY[i]);
+        const __m128 ez = _mm_loadu_ps(&__extentZ[i]);
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for (const SimdPlane & plane : planes)
+        {
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(plane.nx, cx), _mm_mul_ps(plane.ny, cy)),
+                _mm_add_ps(_mm_mul_ps(plane.nz, cz), plane.w));
+            const __m128 radius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(plane.ax, ex), _mm_mul_ps(plane.ay, ey)),
+                _mm_mul_ps(plane.az, ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+        }
+
+        // Padding lanes are dropped
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_ps(inside));
+        if (i + 4 > count) mask &= (1u << (count - i)) - 1;
+        while (mask)
+        {
+            visible.push_back(__entities[i + std::countr_zero(mask)]);
+            mask &= mask - 1;
+        }
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+    {
+        bool inside = true;
+        for (const glm::vec4 & plane : frustum.planes)
+        {
+            const float distance = plane.x * __centerX[i] + plane.y * __centerY[i] + plane.z * __centerZ[i] + plane.w;
+            const float radius = std::abs(plane.x) * __extentX[i] + std::abs(plane.y) * __extentY[i] + std::abs(plane.z) * __extentZ[i];
+            if (distance + radius < 0.0f)
+            {
+                inside = false;
+                break;
+            }
+        }
+        if (inside) visible.push_back(__entities[i]);
+    }
+#endif
+}
+
+size_t FrustumCuller::GetCount() const
+{
+    return __entities.size();
+}
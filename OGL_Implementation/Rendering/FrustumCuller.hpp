@@ -0,0 +1,67 @@
+/*****************************************************************//**
+ * \file   FrustumCuller.hpp
+ * \brief  Frustum culling of entities
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 10 2022
+ *********************************************************************/
+#pragma once
+
+// Project includes
+#include "OGL_Implementation\Entity\Entity.hpp"
+
+// GLM includes
+#include <glm\glm.hpp>
+
+// C++ includes
+#include <array>
+#include <vector>
+
+/**
+ * @brief View frustum as 6 normalized planes, points p with dot(plane.xyz, p) + plane.w >= 0 are inside
+*/
+struct Frustum
+{
+    /**
+     * @brief Extracts planes from a view projection matrix (Gribb & Hartmann)
+     * @param viewProjection OpenGL clip space ([-w, w] depth)
+    */
+    Frustum(const glm::mat4 & viewProjection);
+
+    std::array<glm::vec4, 6> planes;
+};
+
+/**
+ * @brief Tests world bounding boxes of entities against frusta.
+ * Boxes are gathered once in SoA arrays (centers & extents per axis),
+ * then every frustum tests them 4 at a time with SSE.
+*/
+class FrustumCuller
+{
+public:
+    FrustumCuller();
+    ~FrustumCuller();
+
+    /**
+     * @brief Gathers world bounds of the entities, replacing the previous ones
+     * @param entities
+    */
+    void Gather(const std::vector<Entity *> & entities);
+
+    /**
+     * @brief Appends entities intersecting the frustum, in gathered order
+     * @param frustum
+     * @param visible
+    */
+    void Cull(const Frustum & frustum, std::vector<Entity *> & visible) const;
+
+    size_t GetCount() const;
+
+private:
+    std::vector<Entity *> __entities;
+    /**
+     * @brief Padded to a multiple of 4 lanes
+    */
+    std::vector<float> __centerX, __centerY, __centerZ;
+    std::vector<float> __extentX, __extentY, __extentZ;
+};
@@ -0,0 +1,342 @@
+/*****************************************************************//**
+ * \file   GpuCuller.cpp
+ * \brief  GpuCuller source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 11 2022
+ *********************************************************************/
+#include "GpuCuller.hpp"
+
+// Project includes
+#include "Constants.hpp"
+#include "OGL_Implementation\Window.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
+#include "OGL_Implementation\Mesh\GeometryArena.hpp"
+#include "OGL_Implementation\DebugInfo\Log.hpp"
+
+// C++ includes
+#include <algorithm>
+#include <cmath>
+
+static std::unique_ptr<GpuCuller> s_gpuCuller;
+
+GpuCuller::Settings GpuCuller::settings;
+
+static constexpr const GLuint cullGroupSize = 64;
+static constexpr const GLuint pyramidGroupSize = 8;
+/**
+ * @brief Draws buffer: draw count, then the compacted commands
+*/
+static constexpr const GLintptr drawCountSize = sizeof(GLuint);
+
+GpuCuller::GpuCuller()
+    : __depthPyramidShader{ GenerateShader(Constants::Paths::depthPyramidCompute) }
+    , __cullShader{ GenerateShader(Constants::Paths::cullCompute) }
+    , __compactShader{ GenerateShader(Constants::Paths::cullCompactCompute) }
+    , __alignment{ 256 }
+    , __depthFramebuffer{ 0 }
+    , __depthTexture{ 0 }
+    , __depthPyramid{ 0 }
+    , __depthSize{ 0 }
+    , __pyramidLevels{ 0 }
+    , __depthResolvable{ false }
+    , __hasDepth{ false }
+    , __previousViewProjection{ 1.0f }
+    , __drawsOffset{ 0 }
+    , __visibleModelsOffset{ 0 }
+    , __visibleModelsSize{ 0 }
+    , __maxDrawCount{ 0 }
+{
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &__alignment);
+    for (FrameBuffer * frameBuffer : { &__instances, &__commands, &__draws, &__visibleModels })
+        glCreateBuffers(1, &frameBuffer->buffer);
+    glCreateFramebuffers(1, &__depthFramebuffer);
+}
+
+GpuCuller::~GpuCuller()
+{
+    for (FrameBuffer * frameBuffer : { &__instances, &__commands, &__draws, &__visibleModels })
+        OpenGL_State::DeleteBuffers(1, &frameBuffer->buffer);
+    OpenGL_State::DeleteTextures(1, &__depthTexture);
+    OpenGL_State::DeleteTextures(1, &__depthPyramid);
+    glDeleteFramebuffers(1, &__depthFramebuffer);
+}
+
+void GpuCuller::Init()
+{
+    s_gpuCuller.reset(new GpuCuller());
+}
+
+void GpuCuller::NewFrame()
+{
+    GpuCuller & culler = *s_gpuCuller;
+    for (FrameBuffer * frameBuffer : { &culler.__instances, &culler.__commands, &culler.__draws, &culler.__visibleModels })
+    {
+        if (frameBuffer->capacity) glNamedBufferData(frameBuffer->buffer, frameBuffer->capacity, NULL, GL_STREAM_DRAW);
+        frameBuffer->offset = 0;
+    }
+    culler.__lastValidation = culler.__validation;
+    culler.__validation = ValidationStats();
+}
+
+GLintptr GpuCuller::Allocate(FrameBuffer & frameBuffer, GLsizeiptr size)
+{
+    GLsizeiptr offset = (frameBuffer.offset + __alignment - 1) / __alignment * __alignment;
+    if (offset + size > frameBuffer.capacity)
+    {
+        // Orphans the storage, passes already issued keep using the old one
+        frameBuffer.capacity = std::max(frameBuffer.capacity * 2, size);
+        glNamedBufferData(frameBuffer.buffer, frameBuffer.capacity, NULL, GL_STREAM_DRAW);
+        offset = 0;
+    }
+    frameBuffer.offset = offset + size;
+    return offset;
+}
+
+void GpuCuller::ResizeDepth(int width, int height)
+{
+    OpenGL_State::DeleteTextures(1, &__depthTexture);
+    OpenGL_State::DeleteTextures(1, &__depthPyramid);
+    __depthSize = glm::ivec2(width, height);
+
+    // The window is multisampled, its depth is resolved here by a blit, which needs the same format
+    glCreateTextures(GL_TEXTURE_2D, 1, &__depthTexture);
+    glTextureStorage2D(__depthTexture, 1, GL_DEPTH24_STENCIL8, width, height);
+    glTextureParameteri(__depthTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(__depthTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glNamedFramebufferTexture(__depthFramebuffer, GL_DEPTH_STENCIL_ATTACHMENT, __depthTexture, 0);
+    glNamedFramebufferDrawBuffer(__depthFramebuffer, GL_NONE);
+    glNamedFramebufferReadBuffer(__depthFramebuffer, GL_NONE);
+
+    GLint depthBits = 0, stencilBits = 0;
+    glGetNamedFramebufferAttachmentParameteriv(0, GL_DEPTH, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depthBits);
+    glGetNamedFramebufferAttachmentParameteriv(0, GL_STENCIL, GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &stencilBits);
+    __depthResolvable = depthBits == 24 && stencilBits == 8
+        && glCheckNamedFramebufferStatus(__depthFramebuffer, GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!__depthResolvable)
+        LOG_PRINT(stderr, "Window depth (%d bits, %d stencil bits) can't be resolved, occlusion culling disabled\n", depthBits, stencilBits);
+
+    // Level 0 at half resolution, down to 1x1
+    const glm::ivec2 size = glm::max(__depthSize / 2, glm::ivec2(1));
+    __pyramidLevels = static_cast<int>(std::floor(std::log2(std::max(size.x, size.y)))) + 1;
+    glCreateTextures(GL_TEXTURE_2D, 1, &__depthPyramid);
+    glTextureStorage2D(__depthPyramid, __pyramidLevels, GL_R32F, size.x, size.y);
+    glTextureParameteri(__depthPyramid, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTextureParameteri(__depthPyramid, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(__depthPyramid, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(__depthPyramid, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    __hasDepth = false;
+}
+
+void GpuCuller::CaptureDepth(const glm::mat4 & viewProjection)
+{
+    GpuCuller & culler = *s_gpuCuller;
+    if (!settings.enabled || !settings.occlusion || !culler.__depthPyramidShader.IsReady()) return;
+
+    const int width = Window::Get()->windowWidth(), height = Window::Get()->windowHeight();
+    if (width <= 0 || height <= 0) return;
+    if (glm::ivec2(width, height) != culler.__depthSize) culler.ResizeDepth(width, height);
+
+    if (!culler.__depthResolvable) return;
+
+    // Resolved from its samples, same rectangles (the scissor test applies to blits)
+    OpenGL_State::SetCapability(GL_SCISSOR_TEST, false);
+    glBlitNamedFramebuffer(0, culler.__depthFramebuffer, 0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    culler.__depthPyramidShader.Use();
+    for (int level = 0; level < culler.__pyramidLevels; ++level)
+    {
+        OpenGL_State::BindTextureUnit(0, level == 0 ? culler.__depthTexture : culler.__depthPyramid);
+        culler.__depthPyramidShader.SetUniformInt("sourceLevel", level == 0 ? 0 : level - 1);
+        glBindImageTexture(0, culler.__depthPyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+        GLint levelWidth, levelHeight;
+        glGetTextureLevelParameteriv(culler.__depthPyramid, level, GL_TEXTURE_WIDTH, &levelWidth);
+        glGetTextureLevelParameteriv(culler.__depthPyramid, level, GL_TEXTURE_HEIGHT, &levelHeight);
+        glDispatchCompute((levelWidth + pyramidGroupSize - 1) / pyramidGroupSize, (levelHeight + pyramidGroupSize - 1) / pyramidGroupSize, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+    culler.__previousViewProjection = viewProjection;
+    culler.__hasDepth = true;
+
+    if (settings.validate)
+    {
+        glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+        culler.__pyramidCopy.levels.resize(culler.__pyramidLevels);
+        culler.__pyramidCopy.sizes.resize(culler.__pyramidLevels);
+        for (int level = 0; level < culler.__pyramidLevels; ++level)
+        {
+            glm::ivec2 & size = culler.__pyramidCopy.sizes[level];
+            glGetTextureLevelParameteriv(culler.__depthPyramid, level, GL_TEXTURE_WIDTH, &size.x);
+            glGetTextureLevelParameteriv(culler.__depthPyramid, level, GL_TEXTURE_HEIGHT, &size.y);
+            std::vector<float> & texels = culler.__pyramidCopy.levels[level];
+            texels.resize(static_cast<size_t>(size.x) * size.y);
+            glGetTextureImage(culler.__depthPyramid, level, GL_RED, GL_FLOAT, static_cast<GLsizei>(texels.size() * sizeof(float)), texels.data());
+        }
+    }
+}
+
+bool GpuCuller::CullBatch(const std::vector<Instance> & instances, const std::vector<DrawElementsIndirectCommand> & commands,
+    GLuint modelsBuffer, const glm::mat4 & viewProjection)
+{
+    GpuCuller & culler = *s_gpuCuller;
+    if (!culler.__cullShader.IsReady() || !culler.__compactShader.IsReady()) return false;
+
+    // Every command gets room for all of its instances, counts are filled by cull.comp
+    std::vector<DrawElementsIndirectCommand> gpuCommands(commands);
+    GLuint slots = 0;
+    for (DrawElementsIndirectCommand & command : gpuCommands)
+    {
+        command.baseInstance = slots;
+        slots += command.instanceCount;
+        command.instanceCount = 0;
+    }
+
+    const GLsizeiptr instancesSize = instances.size() * sizeof(Instance);
+    const GLsizeiptr commandsSize = commands.size() * sizeof(DrawElementsIndirectCommand);
+    const GLintptr instancesOffset = culler.Allocate(culler.__instances, instancesSize);
+    const GLintptr commandsOffset = culler.Allocate(culler.__commands, commandsSize);
+    culler.__drawsOffset = culler.Allocate(culler.__draws, drawCountSize + commandsSize);
+    culler.__visibleModelsSize = static_cast<GLsizeiptr>(slots) * sizeof(glm::mat4);
+    culler.__visibleModelsOffset = culler.Allocate(culler.__visibleModels, culler.__visibleModelsSize);
+    culler.__maxDrawCount = static_cast<GLsizei>(commands.size());
+
+    glNamedBufferSubData(culler.__instances.buffer, instancesOffset, instancesSize, instances.data());
+    glNamedBufferSubData(culler.__commands.buffer, commandsOffset, commandsSize, gpuCommands.data());
+    const GLuint zero = 0;
+    glClearNamedBufferSubData(culler.__draws.buffer, GL_R32UI, culler.__drawsOffset, drawCountSize, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    OpenGL_State::BindBufferRange(GL_SHADER_STORAGE_BUFFER, Constants::SSBO::Ids::cullInstances, culler.__instances.buffer, instancesOffset, instancesSize);
+    OpenGL_State::BindBufferRange(GL_SHADER_STORAGE_BUFFER, Constants::SSBO::Ids::cullCommands, culler.__commands.buffer, commandsOffset, commandsSize);
+    OpenGL_State::BindBufferBase(GL_SHADER_STORAGE_BUFFER, Constants::SSBO::Ids::cullModels, modelsBuffer);
+    OpenGL_State::BindBufferRange(GL_SHADER_STORAGE_BUFFER, Constants::SSBO::Ids::instanceData, culler.__visibleModels.buffer, culler.__visibleModelsOffset, culler.__visibleModelsSize);
+    OpenGL_State::BindBufferRange(GL_SHADER_STORAGE_BUFFER, Constants::SSBO::Ids::cullDraws, culler.__draws.buffer, culler.__drawsOffset, drawCountSize + commandsSize);
+
+    const bool useDepthPyramid = settings.occlusion && culler.__hasDepth;
+    culler.__cullShader.Use();
+    culler.__cullShader.SetUniformInt("instancesCount", static_cast<GLint>(instances.size()));
+    culler.__cullShader.SetUniformMatrix4f("viewProjection", viewProjection);
+    culler.__cullShader.SetUniformInt("useDepthPyramid", useDepthPyramid);
+    culler.__cullShader.SetUniformMatrix4f("previousViewProjection", culler.__previousViewProjection);
+    if (useDepthPyramid) OpenGL_State::BindTextureUnit(0, culler.__depthPyramid);
+    glDispatchCompute((static_cast<GLuint>(instances.size()) + cullGroupSize - 1) / cullGroupSize, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    culler.__compactShader.Use();
+    culler.__compactShader.SetUniformInt("commandsCount", static_cast<GLint>(commands.size()));
+    glDispatchCompute((static_cast<GLuint>(commands.size()) + cullGroupSize - 1) / cullGroupSize, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    if (settings.validate) culler.Validate(instances, commands, commandsOffset, viewProjection);
+    return true;
+}
+
+void GpuCuller::DrawBatch(GLenum primitiveMode)
+{
+    GpuCuller & culler = *s_gpuCuller;
+    OpenGL_State::BindBufferRange(GL_SHADER_STORAGE_BUFFER, Constants::SSBO::Ids::instanceData, culler.__visibleModels.buffer, culler.__visibleModelsOffset, culler.__visibleModelsSize);
+    OpenGL_State::BindBuffer(GL_DRAW_INDIRECT_BUFFER, culler.__draws.buffer);
+    OpenGL_State::BindBuffer(GL_PARAMETER_BUFFER, culler.__draws.buffer);
+    OpenGL_State::BindVertexArray(GeometryArena::GetVAO());
+    glMultiDrawElementsIndirectCount(primitiveMode, GL_UNSIGNED_INT, (const GLvoid *)(culler.__drawsOffset + drawCountSize),
+        culler.__drawsOffset, culler.__maxDrawCount, 0);
+}
+
+bool GpuCuller::IsVisible(const Instance & instance, const Frustum & frustum,
+    const glm::mat4 & previousViewProjection, const DepthPyramid * pyramid)
+{
+    const glm::vec3 center(instance.center), extents(instance.extents);
+    for (const glm::vec4 & plane : frustum.planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w + glm::dot(glm::abs(glm::vec3(plane)), extents) < 0.0f)
+            return false;
+    }
+    if (!pyramid || pyramid->levels.empty()) return true;
+
+    glm::vec2 minScreen(1.0f), maxScreen(0.0f);
+    float minDepth = 1.0f;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        const glm::vec3 side((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+        const glm::vec4 clip = previousViewProjection * glm::vec4(center + side * extents, 1.0f);
+        if (clip.w <= 1e-6f || clip.z < -clip.w) return true;
+
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        minScreen = glm::min(minScreen, glm::vec2(ndc) * 0.5f + 0.5f);
+        maxScreen = glm::max(maxScreen, glm::vec2(ndc) * 0.5f + 0.5f);
+        minDepth = std::min(minDepth, ndc.z * 0.5f + 0.5f);
+    }
+    if (maxScreen.x < 0.0f || maxScreen.y < 0.0f || minScreen.x > 1.0f || minScreen.y > 1.0f) return true;
+    minScreen = glm::clamp(minScreen, 0.0f, 1.0f);
+    maxScreen = glm::clamp(maxScreen, 0.0f, 1.0f);
+
+    const glm::vec2 size = (maxScreen - minScreen) * glm::vec2(pyramid->sizes[0]);
+    const int level = std::clamp(static_cast<int>(std::ceil(std::log2(std::max(std::max(size.x, size.y), 1.0f)))),
+        0, static_cast<int>(pyramid->levels.size()) - 1);
+    const glm::ivec2 levelSize = pyramid->sizes[level];
+    const glm::ivec2 p0 = glm::clamp(glm::ivec2(minScreen * glm::vec2(levelSize)), glm::ivec2(0), levelSize - 1);
+    const glm::ivec2 p1 = glm::clamp(glm::ivec2(maxScreen * glm::vec2(levelSize)), glm::ivec2(0), levelSize - 1);
+
+    float maxDepth = 0.0f;
+    for (int y = p0.y; y <= p1.y; ++y)
+        for (int x = p0.x; x <= p1.x; ++x)
+            maxDepth = std::max(maxDepth, pyramid->levels[level][static_cast<size_t>(y) * levelSize.x + x]);
+    return minDepth <= maxDepth;
+}
+
+void GpuCuller::CullReference(const std::vector<Instance> & instances, std::vector<DrawElementsIndirectCommand> & commands,
+    std::vector<GLuint> & visibleModels, std::vector<DrawElementsIndirectCommand> & draws,
+    const Frustum & frustum, const glm::mat4 & previousViewProjection, const DepthPyramid * pyramid)
+{
+    GLuint slots = 0;
+    for (DrawElementsIndirectCommand & command : commands)
+    {
+        command.baseInstance = slots;
+        slots += command.instanceCount;
+        command.instanceCount = 0;
+    }
+    visibleModels.assign(slots, 0);
+
+    for (const Instance & instance : instances)
+    {
+        if (!IsVisible(instance, frustum, previousViewProjection, pyramid)) continue;
+        DrawElementsIndirectCommand & command = commands[instance.command];
+        visibleModels[command.baseInstance + command.instanceCount++] = instance.model;
+    }
+
+    draws.clear();
+    for (const DrawElementsIndirectCommand & command : commands)
+        if (command.instanceCount) draws.push_back(command);
+}
+
+void GpuCuller::Validate(const std::vector<Instance> & instances, const std::vector<DrawElementsIndirectCommand> & commands,
+    GLintptr commandsOffset, const glm::mat4 & viewProjection)
+{
+    std::vector<DrawElementsIndirectCommand> gpuCommands(commands.size());
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glGetNamedBufferSubData(__commands.buffer, commandsOffset, gpuCommands.size() * sizeof(DrawElementsIndirectCommand), gpuCommands.data());
+
+    std::vector<DrawElementsIndirectCommand> cpuCommands(commands), draws;
+    std::vector<GLuint> visibleModels;
+    const bool useDepthPyramid = settings.occlusion && __hasDepth;
+    CullReference(instances, cpuCommands, visibleModels, draws, Frustum(viewProjection), __previousViewProjection,
+        useDepthPyramid ? &__pyramidCopy : nullptr);
+
+    __validation.instances += static_cast<int>(instances.size());
+    for (size_t i = 0; i < commands.size(); ++i)
+    {
+        __validation.visibleGpu += static_cast<int>(gpuCommands[i].instanceCount);
+        __validation.visibleCpu += static_cast<int>(cpuCommands[i].instanceCount);
+        if (gpuCommands[i].instanceCount != cpuCommands[i].instanceCount)
+        {
+            ++__validation.mismatches;
+            LOG_PRINT(stderr, "GPU culling mismatch: command %zu, %u visible on GPU, %u on CPU\n",
+                i, gpuCommands[i].instanceCount, cpuCommands[i].instanceCount);
+        }
+    }
+}
+
+const GpuCuller::ValidationStats & GpuCuller::GetLastValidationStats()
+{
+    return s_gpuCuller->__lastValidation;
+}
@@ -0,0 +1,212 @@
+/*****************************************************************//**
+ * \file   GpuCuller.hpp
+ * \brief  GPU driven culling & compaction of batched draws
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 11 2022
+ *********************************************************************/
+#pragma once
+
+// Project includes
+#include "OGL_Implementation\Shader\Shader.hpp"
+#include "FrustumCuller.hpp"
+
+// GLAD includes
+#include <GLAD\glad.h>
+
+// GLM includes
+#include <glm\glm.hpp>
+
+// C++ includes
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Layout read by glMultiDrawElementsIndirect
+*/
+struct DrawElementsIndirectCommand
+{
+    GLuint count, instanceCount, firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+/**
+ * @brief Culls instances of multi-draw-indirect batches in compute passes:
+ * - cull.comp tests instance bounds against the frustum & a depth pyramid (max depth)
+ *   built from the depth of the previous frame, visible instances append their
+ *   model matrix after their command with an atomic counter
+ * - cull_compact.comp moves commands with visible instances to the front of the draws
+ *   buffer & counts them, the batch is then drawn with one glMultiDrawElementsIndirectCount.
+ * The CPU never reads results back, IsVisible & CullReference run the same tests on the CPU
+ * (validation, without a GPU).
+*/
+class GpuCuller
+{
+public:
+    /**
+     * @brief Instance of a batch (std430 layout of cull.comp)
+    */
+    struct Instance
+    {
+        /**
+         * @brief World bounding box
+        */
+        glm::vec4 center, extents;
+        /**
+         * @brief Index of its command in the batch
+        */
+        GLuint command;
+        /**
+         * @brief Index of its model matrix in the models buffer
+        */
+        GLuint model;
+        GLuint padding[2];
+    };
+
+    /**
+     * @brief Farthest depths ([0, 1] window depth), level 0 at half the resolution of the depth buffer
+    */
+    struct DepthPyramid
+    {
+        std::vector<std::vector<float>> levels;
+        std::vector<glm::ivec2> sizes;
+    };
+
+    struct Settings
+    {
+        /**
+         * @brief Culls batches on the GPU
+        */
+        bool enabled = true;
+        /**
+         * @brief Tests against the depth pyramid of the previous frame
+        */
+        bool occlusion = true;
+        /**
+         * @brief Reads results back & compares them with CullReference (stalls, debug only)
+        */
+        bool validate = false;
+    };
+
+    /**
+     * @brief Validation results of the last frame
+    */
+    struct ValidationStats
+    {
+        int instances = 0;
+        int visibleGpu = 0;
+        int visibleCpu = 0;
+        /**
+         * @brief Commands whose visible instances count differ
+        */
+        int mismatches = 0;
+    };
+
+public:
+    GpuCuller();
+    ~GpuCuller();
+
+    static void Init();
+    /**
+     * @brief Orphans buffers of the previous frame, to call once per frame
+    */
+    static void NewFrame();
+    /**
+     * @brief Copies the depth of the default framebuffer & builds the depth pyramid
+     * tested by the next frame, to call once opaque entities are drawn
+     * @param viewProjection matrix the depth was rendered with
+    */
+    static void CaptureDepth(const glm::mat4 & viewProjection);
+
+    /**
+     * @brief Culls the instances of a batch, the shader drawing it is then to be bound
+     * by the caller before DrawBatch
+     * @param instances
+     * @param commands one per mesh, instanceCount is the maximum amount of instances
+     * @param modelsBuffer buffer holding model matrices of the instances
+     * @param viewProjection camera of this frame
+     * @return false if culling shaders are not ready (nothing done)
+    */
+    static bool CullBatch(const std::vector<Instance> & instances, const std::vector<DrawElementsIndirectCommand> & commands,
+        GLuint modelsBuffer, const glm::mat4 & viewProjection);
+    /**
+     * @brief Draws the last culled batch, visible models are bound to InstanceData
+     * @param primitiveMode
+    */
+    static void DrawBatch(GLenum primitiveMode);
+
+    /**
+     * @brief CPU version of the test of cull.comp
+     * @param instance
+     * @param frustum
+     * @param previousViewProjection view projection the depth pyramid was rendered with
+     * @param pyramid nullptr to only test the frustum
+     * @return true if the instance may be visible
+    */
+    static bool IsVisible(const Instance & instance, const Frustum & frustum,
+        const glm::mat4 & previousViewProjection, const DepthPyramid * pyramid);
+    /**
+     * @brief CPU version of the culling passes, instances are appended in order
+     * @param instances
+     * @param commands [in/out] instanceCount is replaced by the visible instances count
+     * @param visibleModels [out] model index per visible slot (command's baseInstance + slot)
+     * @param draws [out] commands with visible instances
+    */
+    static void CullReference(const std::vector<Instance> & instances, std::vector<DrawElementsIndirectCommand> & commands,
+        std::vector<GLuint> & visibleModels, std::vector<DrawElementsIndirectCommand> & draws,
+        const Frustum & frustum, const glm::mat4 & previousViewProjection, const DepthPyramid * pyramid);
+
+    static const ValidationStats & GetLastValidationStats();
+
+    static Settings settings;
+
+private:
+    /**
+     * @brief GPU written buffer, sub-allocated during the frame & orphaned when it begins
+    */
+    struct FrameBuffer
+    {
+        GLuint buffer = 0;
+        GLsizeiptr capacity = 0, offset = 0;
+    };
+
+    /**
+     * @brief Reserves aligned space in a frame buffer
+     * @return offset
+    */
+    GLintptr Allocate(FrameBuffer & frameBuffer, GLsizeiptr size);
+    void ResizeDepth(int width, int height);
+    void Validate(const std::vector<Instance> & instances, const std::vector<DrawElementsIndirectCommand> & commands,
+        GLintptr commandsOffset, const glm::mat4 & viewProjection);
+
+private:
+    Shader __depthPyramidShader, __cullShader, __compactShader;
+    FrameBuffer __instances, __commands, __draws, __visibleModels;
+    GLint __alignment;
+
+    /**
+     * @brief Single sample copy of the window depth, source of the pyramid
+    */
+    GLuint __depthFramebuffer, __depthTexture, __depthPyramid;
+    glm::ivec2 __depthSize;
+    int __pyramidLevels;
+    /**
+     * @brief Window depth format matches the copy, hasDepth once the pyramid is built from it
+    */
+    bool __depthResolvable, __hasDepth;
+    glm::mat4 __previousViewProjection;
+    /**
+     * @brief CPU copy of the pyramid, read back when validating
+    */
+    DepthPyramid __pyramidCopy;
+
+    /**
+     * @brief Last culled batch
+    */
+    GLintptr __drawsOffset, __visibleModelsOffset;
+    GLsizeiptr __visibleModelsSize;
+    GLsizei __maxDrawCount;
+
+    ValidationStats __validation, __lastValidation;
+};
@@ -0,0 +1,194 @@
+/*****************************************************************//**
+ * \file   LightBenchmark.cpp
+ * \brief  LightBenchmark source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 13 2022
+ *********************************************************************/
+#include "LightBenchmark.hpp"
+
+// Project includes
+#include "LightClusters.hpp"
+#include "OGL_Implementation\DebugInfo\Log.hpp"
+
+// C++ includes
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// Frames rendered before measuring a step (lights count changes, shaders warm up)
+static constexpr const int warmupFrames = 30;
+static constexpr const int sampleFrames = 120;
+static constexpr const int lightCounts[] = { 1, 16, 32, 64, 96, 128 };
+
+LightBenchmark::LightBenchmark(const Mesh & lightMesh, const glm::vec3 & center, float radius)
+    : __lightMesh{ lightMesh }
+    , __center{ center }
+    , __radius{ radius }
+    , __step{ 0 }
+    , __running{ false }
+    , __wasClustered{ true }
+    , __frames{ 0 }
+    , __gpuMs{ 0.0 }
+    , __binningMs{ 0.0 }
+    , __samples{ 0 }
+    , __timersSteps{ -1, -1, -1 }
+    , __currentTimer{ 0 }
+    , __timing{ false }
+{
+}
+
+LightBenchmark::~LightBenchmark()
+{
+    Stop();
+}
+
+void LightBenchmark::Start()
+{
+    Stop();
+
+    // Light counts fitting next to the lights of the scene, each clustered then not
+    const int available = static_cast<int>(PointLight::maxPointLightsCount) - PointLight::GetPointLightsCount();
+    __steps.clear();
+    for (int count : lightCounts)
+    {
+        count = std::min(count, available);
+        if (count <= 0 || (!__steps.empty() && __steps.back().first == count)) continue;
+        __steps.push_back({ count, true });
+        __steps.push_back({ count, false });
+    }
+    if (__steps.empty()) return;
+
+    __results.clear();
+    __wasClustered = LightClusters::settings.enabled;
+    __running = true;
+    __step = 0;
+    BeginStep();
+}
+
+void LightBenchmark::Stop()
+{
+    if (!__running) return;
+    __running = false;
+    __timersSteps.fill(-1);
+    SetLightsCount(0);
+    LightClusters::settings.enabled = __wasClustered;
+}
+
+bool LightBenchmark::IsRunning() const
+{
+    return __running;
+}
+
+void LightBenchmark::SetLightsCount(int count)
+{
+    if (count < static_cast<int>(__lights.size()))
+    {
+        __lights.resize(count);
+        return;
+    }
+
+    // Orbits of random radius, height & speed, lights covering about a third of their orbit
+    std::mt19937 random(static_cast<unsigned int>(__lights.size()));
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    while (static_cast<int>(__lights.size()) < count)
+    {
+        const float orbit = __radius * (0.2f + 0.8f * unit(random));
+        __orbits.resize(__lights.size() + 1);
+        __orbits.back() = glm::vec4(orbit, (unit(random) - 0.5f) * __radius * 0.25f,
+            (0.2f + unit(random)) * (unit(random) < 0.5f ? -1.0f : 1.0f), unit(random) * 6.2831853f);
+
+        const float range = __radius * 0.35f;
+        const float intensity = range * range * LightClusters::settings.cutoff;
+        const glm::vec3 color = glm::vec3(unit(random), unit(random), unit(random)) * 0.5f + 0.5f;
+        __lights.push_back(std::make_unique<PointLight>(__lightMesh));
+        PointLight & light = *__lights.back();
+        light.name = "Benchmark Light";
+        light.scale = glm::vec3(0.1f);
+        light.ChangeDiffuse(color * intensity);
+        light.ChangeSpecular(color * intensity);
+        light.ChangeAmbient(glm::vec3(0.0f));
+    }
+}
+
+void LightBenchmark::BeginStep()
+{
+    SetLightsCount(__steps[__step].first);
+    LightClusters::settings.enabled = __steps[__step].second;
+    __frames = 0;
+    __samples = 0;
+    __gpuMs = 0.0;
+    __binningMs = 0.0;
+}
+
+void LightBenchmark::Update(float time)
+{
+    for (size_t i = 0; i < __lights.size(); ++i)
+    {
+        const glm::vec4 & orbit = __orbits[i];
+        const float angle = orbit.w + orbit.z * time;
+        __lights[i]->pos = __center + glm::vec3(std::cos(angle) * orbit.x, orbit.y, std::sin(angle) * orbit.x);
+    }
+}
+
+void LightBenchmark::BeginFrame()
+{
+    // Reading back finished measures of this step
+    for (size_t i = 0; i < timersCount; ++i)
+    {
+        if (__timersSteps[i] == -1 || !__timers[i].IsResultAvailable()) continue;
+        if (__running && __timersSteps[i] == static_cast<int>(__step))
+        {
+            __gpuMs += static_cast<double>(__timers[i].GetResult()) / 1e6;
+            ++__samples;
+        }
+        __timersSteps[i] = -1;
+    }
+
+    if (!__running || __frames < warmupFrames || __timersSteps[__currentTimer] != -1) return;
+    __timers[__currentTimer].Start();
+    __timersSteps[__currentTimer] = static_cast<int>(__step);
+    __timing = true;
+}
+
+void LightBenchmark::EndFrame()
+{
+    // Only the query started by BeginFrame is ended, the timer may still be pending from an older frame
+    if (__timing)
+    {
+        __timers[__currentTimer].Stop();
+        __currentTimer = (__currentTimer + 1) % timersCount;
+        __timing = false;
+    }
+    if (!__running) return;
+
+    // Every frame after the warmup, GPU timers may skip frames while their results are pending
+    if (__frames >= warmupFrames)
+        __binningMs += LightClusters::GetLastStats().binningMs;
+    ++__frames;
+    if (__samples < sampleFrames) return;
+
+    const Result result = { __steps[__step].first, __steps[__step].second,
+        static_cast<float>(__gpuMs / __samples), static_cast<float>(__binningMs / std::max(__frames - warmupFrames, 1)) };
+    __results.push_back(result);
+    LOG_PRINT(stdout, "%d lights, %s: %.3f ms GPU, %.3f ms binning\n", result.lights,
+        result.clustered ? "clustered" : "all lights", result.gpuMs, result.binningMs);
+
+    if (++__step < __steps.size()) BeginStep();
+    else Stop();
+}
+
+const std::vector<LightBenchmark::Result> & LightBenchmark::GetResults() const
+{
+    return __results;
+}
+
+size_t LightBenchmark::GetStep() const
+{
+    return __step;
+}
+
+size_t LightBenchmark::GetStepsCount() const
+{
+    return __steps.size();
+}
@@ -0,0 +1,113 @@
+/*****************************************************************//**
+ * \file   LightBenchmark.hpp
+ * \brief  Shading time of many moving point lights, with & without clusters
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 13 2022
+ *********************************************************************/
+#pragma once
+
+// Project includes
+#include "OGL_Implementation\Light\PointLight.hpp"
+#include "OGL_Implementation\OpenGL_Timer.hpp"
+
+// C++ includes
+#include <array>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Benchmark scene: spawns point lights orbiting a center, then measures the GPU time
+ * of the timed draws (BeginFrame/EndFrame) for increasing light counts, clustered (LightClusters)
+ * then looping over every light. Lights are destroyed once every step is measured.
+*/
+class LightBenchmark
+{
+public:
+    struct Result
+    {
+        int lights;
+        bool clustered;
+        /**
+         * @brief Average GPU time of the timed draws
+        */
+        float gpuMs;
+        /**
+         * @brief Average CPU time of the light binning
+        */
+        float binningMs;
+    };
+
+public:
+    /**
+     * @brief Constructor
+     * @param lightMesh mesh of the spawned lights
+     * @param center of the orbits
+     * @param radius of the largest orbit
+    */
+    LightBenchmark(const Mesh & lightMesh, const glm::vec3 & center, float radius);
+    ~LightBenchmark();
+
+    /**
+     * @brief Clears previous results & spawns the lights of the first step
+    */
+    void Start();
+    void Stop();
+    bool IsRunning() const;
+
+    /**
+     * @brief Moves the lights, to call before Rendering::Refresh
+     * @param time in seconds
+    */
+    void Update(float time);
+    /**
+     * @brief Brackets the draws whose GPU time is measured
+    */
+    void BeginFrame();
+    void EndFrame();
+
+    const std::vector<Result> & GetResults() const;
+    /**
+     * @brief Step being measured, in [0, steps count]
+    */
+    size_t GetStep() const;
+    size_t GetStepsCount() const;
+
+private:
+    void SetLightsCount(int count);
+    /**
+     * @brief Sets up the lights & clustering of the current step
+    */
+    void BeginStep();
+
+private:
+    const Mesh & __lightMesh;
+    glm::vec3 __center;
+    float __radius;
+    std::vector<std::unique_ptr<PointLight>> __lights;
+    std::vector<glm::vec4> __orbits;
+
+    /**
+     * @brief Lights count & clustering of every step
+    */
+    std::vector<std::pair<int, bool>> __steps;
+    std::vector<Result> __results;
+    size_t __step;
+    bool __running, __wasClustered;
+    int __frames;
+    double __gpuMs, __binningMs;
+    int __samples;
+
+    // GPU timing of the previous frames, read back without stalling
+    static constexpr const size_t timersCount = 3;
+    std::array<OpenGL_Timer, timersCount> __timers;
+    /**
+     * @brief Step measured by each timer, -1 when not pending
+    */
+    std::array<int, timersCount> __timersSteps;
+    size_t __currentTimer;
+    /**
+     * @brief True between a BeginFrame that started the current timer & its EndFrame
+    */
+    bool __timing;
+};
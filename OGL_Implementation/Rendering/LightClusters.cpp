@@ -0,0 +1,290 @@
+/*****************************************************************//**
+ * \file   LightClusters.cpp
+ * \brief  LightClusters source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 13 2022
+ *********************************************************************/
+#include "LightClusters.hpp"
+
+// Project includes
+#include "Constants.hpp"
+#include "OGL_Implementation\Window.hpp"
+#include "OGL_Implementation\Camera.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
+#include "OGL_Implementation\Light\PointLight.hpp"
+#include "OGL_Implementation\Tools\ThreadPool.hpp"
+#include "OGL_Implementation\DebugInfo\Timer.hpp"
+
+// C++ includes
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define LIGHT_CLUSTERS_SSE
+#include <xmmintrin.h>
+#endif
+
+static std::unique_ptr<LightClusters> s_lightClusters;
+
+LightClusters::Settings LightClusters::settings;
+
+LightClusters::LightClusters()
+    : __header{ glm::uvec4(gridX, gridY, gridZ, 1), glm::vec4(0.0f) }
+    , __projection{ 0.0f }
+    , __size{ 0 }
+    , __spheres{ nullptr }
+    , __gridBuffer{ 0 }
+    , __indicesBuffer{ 0 }
+    , __disabledBuffer{ 0 }
+{
+    for (auto * array : { &__minX, &__minY, &__minZ, &__maxX, &__maxY, &__maxZ })
+        array->assign(clustersCount, 0.0f);
+    __sliceDepths.assign(gridZ, glm::vec2(0.0f));
+    __sliceIndices.resize(gridZ);
+    __clusterLights.assign(clustersCount, glm::uvec2(0));
+
+    glCreateBuffers(1, &__gridBuffer);
+    glCreateBuffers(1, &__indicesBuffer);
+
+    // Grid without clusters, also bound as an empty indices buffer
+    struct
+    {
+        GridHeader header;
+        glm::uvec2 clusterLights;
+    } disabled = { { glm::uvec4(gridX, gridY, gridZ, 0), glm::vec4(1.0f, 1.0f, 0.0f, 0.0f) }, glm::uvec2(0) };
+    glCreateBuffers(1, &__disabledBuffer);
+    glNamedBufferStorage(__disabledBuffer, sizeof(disabled), &disabled, 0);
+}
+
+LightClusters::~LightClusters()
+{
+    OpenGL_State::DeleteBuffers(1, &__gridBuffer);
+    OpenGL_State::DeleteBuffers(1, &__indicesBuffer);
+    OpenGL_State::DeleteBuffers(1, &__disabledBuffer);
+}
+
+void LightClusters::Init()
+{
+    s_lightClusters.reset(new LightClusters());
+    Bind(false);
+}
+
+void LightClusters::Update()
+{
+    LightClusters & clusters = *s_lightClusters;
+    const int width = Window::Get()->windowWidth(), height = Window::Get()->windowHeight();
+    if (!settings.enabled || !mainCamera || width <= 0 || height <= 0)
+    {
+        clusters.__stats = Stats();
+        Bind(false);
+        return;
+    }
+
+    Timer timer;
+    timer.Start();
+    clusters.SetProjection(mainCamera->GetFov(), width, height, mainCamera->GetZNear(), mainCamera->GetZFar());
+
+    // Same order as the Lights block
+    const glm::mat4 view = mainCamera->GetViewMatrix();
+    const size_t count = PointLight::GetPointLightsCount();
+    const auto & pointLights = PointLight::GetAllPointLights();
+    std::vector<glm::vec4> spheres(count);
+    for (size_t i = 0; i < count; ++i)
+        spheres[i] = glm::vec4(glm::vec3(view * glm::vec4(pointLights[i]->pos, 1.0f)), pointLights[i]->GetRange(settings.cutoff));
+    clusters.Assign(spheres);
+    clusters.__stats.binningMs = static_cast<float>(timer.GetMsTime());
+
+    clusters.Upload();
+    Bind(true);
+}
+
+void LightClusters::Bind(bool clustered)
+{
+    const LightClusters & clusters = *s_lightClusters;
+    clustered &= settings.enabled;
+    OpenGL_State::BindBufferBase(GL_SHADER_STORAGE_BUFFER, Constants::SSBO::Ids::lightGrid,
+        clustered ? clusters.__gridBuffer : clusters.__disabledBuffer);
+    OpenGL_State::BindBufferBase(GL_SHADER_STORAGE_BUFFER, Constants::SSBO::Ids::lightIndices,
+        clustered ? clusters.__indicesBuffer : clusters.__disabledBuffer);
+}
+
+const LightClusters::Stats & LightClusters::GetLastStats()
+{
+    return s_lightClusters->__stats;
+}
+
+void LightClusters::SetProjection(float fov, int width, int height, float zNear, float zFar)
+{
+    const glm::vec4 projection(fov, zNear, zFar, 0.0f);
+    if (projection == __projection && glm::ivec2(width, height) == __size) return;
+    __projection = projection;
+    __size = glm::ivec2(width, height);
+
+    // Tiles cover the screen in whole pixels, the last ones may go past its edges
+    const int tileWidth = (width + gridX - 1) / gridX, tileHeight = (height + gridY - 1) / gridY;
+    const float logRange = std::log(zFar / zNear);
+    __header.params = glm::vec4(tileWidth, tileHeight, gridZ / logRange, -gridZ * std::log(zNear) / logRange);
+
+    const float tanY = std::tan(glm::radians(fov) * 0.5f);
+    const float tanX = tanY * width / height;
+    for (int z = 0; z < gridZ; ++z)
+    {
+        const float nearDepth = zNear * std::pow(zFar / zNear, static_cast<float>(z) / gridZ);
+        const float farDepth = zNear * std::pow(zFar / zNear, static_cast<float>(z + 1) / gridZ);
+        __sliceDepths[z] = glm::vec2(nearDepth, farDepth);
+        for (int y = 0; y < gridY; ++y)
+        {
+            const float bottom = 2.0f * y * tileHeight / height - 1.0f;
+            const float top = 2.0f * (y + 1) * tileHeight / height - 1.0f;
+            for (int x = 0; x < gridX; ++x)
+            {
+                const float left = 2.0f * x * tileWidth / width - 1.0f;
+                const float right = 2.0f * (x + 1) * tileWidth / width - 1.0f;
+
+                // Box of the 8 corners, the view looks towards -z
+                const int cluster = x + gridX * (y + gridY * z);
+                __minX[cluster] = std::min(left * nearDepth, left * farDepth) * tanX;
+                __maxX[cluster] = std::max(right * nearDepth, right * farDepth) * tanX;
+                __minY[cluster] = std::min(bottom * nearDepth, bottom * farDepth) * tanY;
+                __maxY[cluster] = std::max(top * nearDepth, top * farDepth) * tanY;
+                __minZ[cluster] = -farDepth;
+                __maxZ[cluster] = -nearDepth;
+            }
+        }
+    }
+}
+
+void LightClusters::Assign(const std::vector<glm::vec4> & spheres)
+{
+    __spheres = &spheres;
+    ThreadPool & pool = ThreadPool::Get();
+    __candidates.resize(pool.GetMaxChunkCount());
+    pool.ParallelFor(gridZ, [this](size_t begin, size_t end, size_t chunkId) {
+        for (size_t slice = begin; slice < end; ++slice)
+            AssignSlice(static_cast<int>(slice), chunkId);
+    });
+    __spheres = nullptr;
+
+    // Offsets were relative to the slice
+    __lightIndices.clear();
+    __stats.maxLightsPerCluster = 0;
+    for (int slice = 0; slice < gridZ; ++slice)
+    {
+        const GLuint base = static_cast<GLuint>(__lightIndices.size());
+        for (int cluster = slice * gridX * gridY; cluster < (slice + 1) * gridX * gridY; ++cluster)
+        {
+            __clusterLights[cluster].x += base;
+            __stats.maxLightsPerCluster = std::max(__stats.maxLightsPerCluster, static_cast<int>(__clusterLights[cluster].y));
+        }
+        __lightIndices.insert(__lightIndices.end(), __sliceIndices[slice].begin(), __sliceIndices[slice].end());
+    }
+    __stats.lights = static_cast<int>(spheres.size());
+    __stats.indices = __lightIndices.size();
+}
+
+void LightClusters::AssignSlice(int slice, size_t chunkId)
+{
+    // Lights overlapping the slice in depth
+    const glm::vec2 depths = __sliceDepths[slice];
+    Candidates & candidates = __candidates[chunkId];
+    for (auto * array : { &candidates.x, &candidates.y, &candidates.z, &candidates.radius })
+        array->clear();
+    candidates.indices.clear();
+    for (size_t i = 0; i < __spheres->size(); ++i)
+    {
+        const glm::vec4 & sphere = (*__spheres)[i];
+        if (-sphere.z + sphere.w < depths.x || -sphere.z - sphere.w > depths.y) continue;
+        candidates.x.push_back(sphere.x);
+        candidates.y.push_back(sphere.y);
+        candidates.z.push_back(sphere.z);
+        candidates.radius.push_back(sphere.w);
+        candidates.indices.push_back(static_cast<GLuint>(i));
+    }
+    const size_t count = candidates.indices.size();
+    const size_t padded = (count + 3) & ~size_t(3);
+    for (auto * array : { &candidates.x, &candidates.y, &candidates.z, &candidates.radius })
+        array->resize(padded, 0.0f);
+
+    std::vector<GLuint> & indices = __sliceIndices[slice];
+    indices.clear();
+    for (int cluster = slice * gridX * gridY; cluster < (slice + 1) * gridX * gridY; ++cluster)
+    {
+        const size_t offset = indices.size();
+
+        // Sphere intersects the box when its squared distance to it is below its squared radius
+#ifdef LIGHT_CLUSTERS_SSE
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 minX = _mm_set1_ps(__minX[cluster]), maxX = _mm_set1_ps(__maxX[cluster]);
+        const __m128 minY = _mm_set1_ps(__minY[cluster]), maxY = _mm_set1_ps(__maxY[cluster]);
+        const __m128 minZ = _mm_set1_ps(__minZ[cluster]), maxZ = _mm_set1_ps(__maxZ[cluster]);
+        for (size_t i = 0; i < count; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(&candidates.x[i]);
+            const __m128 y = _mm_loadu_ps(&candidates.y[i]);
+            const __m128 z = _mm_loadu_ps(&candidates.z[i]);
+            const __m128 radius = _mm_loadu_ps(&candidates.radius[i]);
+            const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, x), _mm_sub_ps(x, maxX)), zero);
+            const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, y), _mm_sub_ps(y, maxY)), zero);
+            const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, z), _mm_sub_ps(z, maxZ)), zero);
+            const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+            // Padding lanes are dropped
+            unsigned int mask = static_cast<unsigned int>(_mm_movemask_ps(_mm_cmple_ps(distance, _mm_mul_ps(radius, radius))));
+            if (i + 4 > count) mask &= (1u << (count - i)) - 1;
+            while (mask)
+            {
+                indices.push_back(candidates.indices[i + std::countr_zero(mask)]);
+                mask &= mask - 1;
+            }
+        }
+#else
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float dx = std::max({ __minX[cluster] - candidates.x[i], candidates.x[i] - __maxX[cluster], 0.0f });
+            const float dy = std::max({ __minY[cluster] - candidates.y[i], candidates.y[i] - __maxY[cluster], 0.0f });
+            const float dz = std::max({ __minZ[cluster] - candidates.z[i], candidates.z[i] - __maxZ[cluster], 0.0f });
+            if (dx * dx + dy * dy + dz * dz <= candidates.radius[i] * candidates.radius[i])
+                indices.push_back(candidates.indices[i]);
+        }
+#endif
+        __clusterLights[cluster] = glm::uvec2(offset, indices.size() - offset);
+    }
+}
+
+void LightClusters::Upload()
+{
+    // Orphaned every frame, draws of the previous one keep their storage
+    const GLsizeiptr gridSize = sizeof(GridHeader) + sizeof(glm::uvec2) * __clusterLights.size();
+    glNamedBufferData(__gridBuffer, gridSize, NULL, GL_STREAM_DRAW);
+    glNamedBufferSubData(__gridBuffer, 0, sizeof(GridHeader), &__header);
+    glNamedBufferSubData(__gridBuffer, sizeof(GridHeader), sizeof(glm::uvec2) * __clusterLights.size(), __clusterLights.data());
+
+    // Never empty, binding a buffer without storage is an error
+    const GLsizeiptr indicesSize = sizeof(GLuint) * std::max<size_t>(__lightIndices.size(), 1);
+    glNamedBufferData(__indicesBuffer, indicesSize, NULL, GL_STREAM_DRAW);
+    if (!__lightIndices.empty())
+        glNamedBufferSubData(__indicesBuffer, 0, sizeof(GLuint) * __lightIndices.size(), __lightIndices.data());
+}
+
+const LightClusters::GridHeader & LightClusters::GetHeader() const
+{
+    return __header;
+}
+
+const std::vector<glm::uvec2> & LightClusters::GetClusterLights() const
+{
+    return __clusterLights;
+}
+
+const std::vector<GLuint> & LightClusters::GetLightIndices() const
+{
+    return __lightIndices;
+}
+
+void LightClusters::GetClusterBounds(int cluster, glm::vec3 & min, glm::vec3 & max) const
+{
+    min = glm::vec3(__minX[cluster], __minY[cluster], __minZ[cluster]);
+    max = glm::vec3(__maxX[cluster], __maxY[cluster], __maxZ[cluster]);
+}
@@ -0,0 +1,159 @@
+/*****************************************************************//**
+ * \file   LightClusters.hpp
+ * \brief  Clustered forward shading, lights binned per view cluster
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 13 2022
+ *********************************************************************/
+#pragma once
+
+// GLAD includes
+#include <GLAD\glad.h>
+
+// GLM includes
+#include <glm\glm.hpp>
+
+// C++ includes
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Divides the view frustum of the main camera into a grid of clusters
+ * (screen tiles, depth slices growing exponentially from the near plane) & assigns
+ * every point light to the clusters its range intersects. Binning runs on the CPU,
+ * one depth slice per ThreadPool job, testing 4 lights at a time with SSE.
+ * Shaders find the lights of their fragment in two SSBOs (see PBR/clusters.glsl).
+*/
+class LightClusters
+{
+public:
+    struct Settings
+    {
+        /**
+         * @brief Shaders loop over every light when disabled
+        */
+        bool enabled = true;
+        /**
+         * @brief Fraction of its intensity under which a light is out of range (see PointLight::GetRange)
+        */
+        float cutoff = 1.0f / 256.0f;
+    };
+
+    /**
+     * @brief Header of the LightGrid SSBO (std430), followed by the offset & count of every cluster
+    */
+    struct GridHeader
+    {
+        /**
+         * @brief Grid size (xyz), 0 in w when shaders loop over every light
+        */
+        glm::uvec4 dims;
+        /**
+         * @brief Tile size in pixels (xy), depth slice scale (z) & bias (w): slice = log(depth) * z + w
+        */
+        glm::vec4 params;
+    };
+
+    struct Stats
+    {
+        int lights = 0;
+        /**
+         * @brief Light indices written in all clusters
+        */
+        size_t indices = 0;
+        int maxLightsPerCluster = 0;
+        float binningMs = 0.0f;
+    };
+
+    static constexpr const int gridX = 16, gridY = 9, gridZ = 24;
+    static constexpr const int clustersCount = gridX * gridY * gridZ;
+
+public:
+    LightClusters();
+    ~LightClusters();
+
+    static void Init();
+    /**
+     * @brief Bins lights of this frame for the main camera & uploads the clusters,
+     * to call once lights moved & the camera is up to date
+    */
+    static void Update();
+    /**
+     * @brief Binds the clusters of the main camera, or a grid making shaders loop over
+     * every light (views of other cameras, e.g. reflection probes)
+     * @param clustered
+    */
+    static void Bind(bool clustered);
+
+    static const Stats & GetLastStats();
+
+    /**
+     * @brief Recomputes view space bounds of the clusters if the projection changed
+     * @param fov vertical, in degrees
+     * @param width in pixels
+     * @param height in pixels
+     * @param zNear
+     * @param zFar
+    */
+    void SetProjection(float fov, int width, int height, float zNear, float zFar);
+    /**
+     * @brief Bins lights into the clusters
+     * @param spheres view space centers (xyz) & ranges (w) of the lights, indexed like the Lights block
+    */
+    void Assign(const std::vector<glm::vec4> & spheres);
+
+    const GridHeader & GetHeader() const;
+    /**
+     * @brief Offset in GetLightIndices (x) & lights count (y) per cluster, x first then y then z
+    */
+    const std::vector<glm::uvec2> & GetClusterLights() const;
+    const std::vector<GLuint> & GetLightIndices() const;
+    /**
+     * @brief View space bounds of a cluster
+     * @param cluster index
+     * @param min [out]
+     * @param max [out]
+    */
+    void GetClusterBounds(int cluster, glm::vec3 & min, glm::vec3 & max) const;
+
+    static Settings settings;
+
+private:
+    /**
+     * @brief Lights intersecting the clusters of one depth slice, binned by one job
+     * @param slice
+     * @param chunkId scratch to use
+    */
+    void AssignSlice(int slice, size_t chunkId);
+    void Upload();
+
+private:
+    GridHeader __header;
+    glm::vec4 __projection;
+    glm::ivec2 __size;
+    /**
+     * @brief Bounds per cluster (SoA), & depth range per slice
+    */
+    std::vector<float> __minX, __minY, __minZ, __maxX, __maxY, __maxZ;
+    std::vector<glm::vec2> __sliceDepths;
+
+    const std::vector<glm::vec4> * __spheres;
+    /**
+     * @brief Lights overlapping a slice in depth (SoA, padded to 4 lanes), per chunk
+    */
+    struct Candidates
+    {
+        std::vector<float> x, y, z, radius;
+        std::vector<GLuint> indices;
+    };
+    std::vector<Candidates> __candidates;
+    /**
+     * @brief Light indices & counts per cluster of each slice, concatenated once all are binned
+    */
+    std::vector<std::vector<GLuint>> __sliceIndices;
+    std::vector<glm::uvec2> __clusterLights;
+    std::vector<GLuint> __lightIndices;
+
+    GLuint __gridBuffer, __indicesBuffer, __disabledBuffer;
+    Stats __stats;
+};
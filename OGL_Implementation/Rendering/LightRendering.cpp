@@ -10,19 +10,52 @@
 // Project includes
 #include "Constants.hpp"
 #include "OGL_Implementation\Window.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
+#include "OGL_Implementation\Camera.hpp"
 
 // C++ includes
 #include <format>
+#include <algorithm>
+#include <cmath>
 
 static std::unique_ptr<LightRendering> s_lightRendering;
-static const size_t shadowWidth = 2048, static const shadowHeight = 2048;
+
+LightRendering::Settings LightRendering::settings;
+
+// Shadow atlas tiles, from lights covering the screen down to distant ones
+static constexpr const int maxTileSize = 2048, minTileSize = 128;
+static constexpr const int maxAtlasSize = 8192;
+// Faces of the cube shadow maps of omnidirectional shadows
+static constexpr const int cubeShadowSize = 512;
+
+static void HashCombine(size_t & seed, size_t value)
+{
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+static size_t HashMatrix(const glm::mat4 & matrix)
+{
+    size_t hash = 0;
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            HashCombine(hash, std::hash<float>()(matrix[i][j]));
+    return hash;
+}
 
 #include <stb_image_write.h>
 
 LightRendering::LightRendering()
     : __uboLights{ 0 }
     , __shadowMappingShader{ GenerateShader(Constants::Paths::shadowMappingVertex, Constants::Paths::shadowMappingFrag) }
+    , __pointShadowMappingShader{ GenerateShader(Constants::Paths::pointShadowMappingVertex,
+        Constants::Paths::pointShadowMappingFrag, Constants::Paths::pointShadowMappingGeometry) }
+    , __cubeShadowMaps{ 0 }
+    , __cubeFramebuffer{ 0 }
+    , __cubeCapacity{ 0 }
     , screenshotDepthMap{ false }
+    , __frame{ 0 }
+    , __shadowDraws{ 0 }
+    , __shadowUpdates{ 0 }
 {
     // Allocating UBO ViewProj
     glGenBuffers(1, &__uboLights);
@@ -31,44 +64,29 @@ LightRendering::LightRendering()
 //      + sizeof(DirectionLight_Shader)
 //      + sizeof(SpotLight_Shader)
       + sizeof(int);
-    glBindBuffer(GL_UNIFORM_BUFFER, __uboLights);
+    OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, __uboLights);
     glBufferData(GL_UNIFORM_BUFFER, LightsSize, NULL, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, 0);
 
     // Binds buffer to a specific binding point so that it'll be used at this exact place
     // by shaders
-    glBindBufferRange(GL_UNIFORM_BUFFER, Constants::UBO::Ids::lights, __uboLights, 0, LightsSize);
+    OpenGL_State::BindBufferRange(GL_UNIFORM_BUFFER, Constants::UBO::Ids::lights, __uboLights, 0, LightsSize);
 
-    ////////////////////////
-    // Binding shadow maps
-    ////////////////////////
-    glGenTextures(PointLight::maxPointLightsCount, shadowMaps.data());
-    glGenFramebuffers(PointLight::maxPointLightsCount, __depthMapFbo.data());
-    // create depth texture
-    for (int i = 0; i < PointLight::maxPointLightsCount; ++i)
-    {
-        glBindTexture(GL_TEXTURE_2D, shadowMaps[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, shadowWidth, shadowHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-        constexpr const float borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-        // attach depth texture as FBO's depth buffer
-        glBindFramebuffer(GL_FRAMEBUFFER, __depthMapFbo[i]);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMaps[i], 0);
-        glDrawBuffer(GL_NONE);
-        glReadBuffer(GL_NONE);
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // Shadow maps: grown with the tiles of the lights (see AllocateTiles)
+    __shadowAtlas.Resize(minTileSize);
+
+    // Omnidirectional shadows: grown with the lights using them (see AllocateCubeLayers)
+    glCreateFramebuffers(1, &__cubeFramebuffer);
+    glNamedFramebufferDrawBuffer(__cubeFramebuffer, GL_NONE);
+    glNamedFramebufferReadBuffer(__cubeFramebuffer, GL_NONE);
+    ResizeCubeArray(1);
 }
 
 LightRendering::~LightRendering()
 {
-    glDeleteBuffers(1, &__uboLights);
-    glDeleteTextures(PointLight::maxPointLightsCount, shadowMaps.data());
-    glDeleteFramebuffers(PointLight::maxPointLightsCount, __depthMapFbo.data());
+    OpenGL_State::DeleteBuffers(1, &__uboLights);
+    OpenGL_State::DeleteTextures(1, &__cubeShadowMaps);
+    OpenGL_State::DeleteFramebuffers(1, &__cubeFramebuffer);
 }
 
 GLuint LightRendering::GetUboLights()
@@ -81,9 +99,34 @@ Shader & LightRendering::GetShadowMappingShader()
     return __shadowMappingShader;
 }
 
-const std::array<GLuint, PointLight::maxPointLightsCount> & LightRendering::GetDepthMapFbo() const
+Shader LightRendering::GetShadowMappingShader() const
+{
+    return __shadowMappingShader;
+}
+
+const ShadowAtlas & LightRendering::GetShadowAtlas() const
+{
+    return __shadowAtlas;
+}
+
+GLuint LightRendering::GetShadowMaps() const
+{
+    return __shadowAtlas.GetTexture();
+}
+
+GLuint LightRendering::GetPointShadowMaps() const
+{
+    return __cubeShadowMaps;
+}
+
+int LightRendering::GetShadowDrawsCount() const
+{
+    return __shadowDraws;
+}
+
+int LightRendering::GetShadowUpdatesCount() const
 {
-    return __depthMapFbo;
+    return __shadowUpdates;
 }
 
 void LightRendering::Init()
@@ -97,52 +140,449 @@ const LightRendering & LightRendering::Get()
     throw std::runtime_error("Trying to get LightRendering although it has not been initialized.\n");
 }
 
+int LightRendering::ComputeTileSize(const PointLight & light, int currentSize)
+{
+    if (!light.focus || light.omnidirectionalShadows || light.shadowImportance <= 0.0f) return 0;
+
+    // Screen height fraction covered by the shadow bounds, whole screen from inside
+    float coverage = 1.0f;
+    if (mainCamera)
+    {
+        const BoundingSphere bounds = light.GetShadowBounds();
+        const float distance = glm::length(bounds.center - mainCamera->Position);
+        if (distance > bounds.radius)
+            coverage = std::min(1.0f, bounds.radius / (distance * std::tan(glm::radians(mainCamera->GetFov()) * 0.5f)));
+    }
+
+    // Halves the size for every halving of the score
+    const float score = coverage * light.shadowImportance;
+    const float exactHalvings = -std::log2(std::max(score, 1e-6f));
+    int halvings = static_cast<int>(std::round(exactHalvings));
+    // The current size is kept until the score is a quarter of a halving past the boundary,
+    // so that a camera moving around it doesn't reallocate the tile every frame
+    if (currentSize > 0)
+    {
+        const int currentHalvings = static_cast<int>(std::log2(maxTileSize / currentSize));
+        if (std::abs(exactHalvings - currentHalvings) < 0.75f) halvings = currentHalvings;
+    }
+    halvings = std::clamp(halvings, 0, static_cast<int>(std::log2(maxTileSize / minTileSize)));
+    return maxTileSize >> halvings;
+}
+
+void LightRendering::AllocateTiles(const std::array<PointLight *, PointLight::maxPointLightsCount> & lights, size_t count)
+{
+    // Tiles of removed lights
+    for (auto it = __tiles.begin(); it != __tiles.end();)
+    {
+        if (std::find(lights.begin(), lights.begin() + count, it->first) == lights.begin() + count)
+        {
+            __shadowAtlas.Free(it->second.tile);
+            if (it->second.cubeLayer != -1) __freeCubeLayers.push_back(it->second.cubeLayer);
+            it = __tiles.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    // Requested sizes, shrunk (largest first) until they fit in the largest atlas
+    std::vector<std::pair<int, const PointLight *>> requests;
+    size_t area = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto tile = __tiles.find(lights[i]);
+        const int size = ComputeTileSize(*lights[i], tile != __tiles.end() ? tile->second.size : 0);
+        requests.push_back({ size, lights[i] });
+        area += static_cast<size_t>(size) * size;
+    }
+    const auto largerFirst = [](const auto & a, const auto & b) { return a.first > b.first; };
+    const size_t maxArea = static_cast<size_t>(maxAtlasSize) * maxAtlasSize;
+    while (area > maxArea)
+    {
+        int & size = std::min_element(requests.begin(), requests.end(), largerFirst)->first;
+        area -= static_cast<size_t>(size) * size * 3 / 4;
+        size /= 2;
+    }
+    std::sort(requests.begin(), requests.end(), largerFirst);
+
+    // Smallest power of two atlas holding every tile. Resizing invalidates every tile, so it is only
+    // shrunk once 4 times too large, not every time the camera moves the needs one size down & back
+    int atlasSize = minTileSize;
+    while (static_cast<size_t>(atlasSize) * atlasSize < area) atlasSize *= 2;
+    if (atlasSize > __shadowAtlas.GetSize() || atlasSize * 4 <= __shadowAtlas.GetSize())
+    {
+        __shadowAtlas.Resize(atlasSize);
+        for (auto & [light, lightTile] : __tiles)
+        {
+            lightTile.tile = ShadowAtlas::Tile();
+            lightTile.size = 0;
+        }
+    }
+
+    // Tiles of lights whose size changed, from the largest
+    bool allocated = true;
+    for (const auto & [size, light] : requests)
+    {
+        LightTile & lightTile = __tiles[light];
+        if (lightTile.size == size && lightTile.tile.IsValid() == (size > 0)) continue;
+        __shadowAtlas.Free(lightTile.tile);
+        lightTile.size = size;
+        lightTile.valid = lightTile.staticValid = false;
+        if (size > 0)
+        {
+            lightTile.tile = __shadowAtlas.Allocate(size);
+            allocated &= lightTile.tile.IsValid();
+        }
+    }
+
+    // Fragmented by frees: packing from the largest tile always fits
+    if (!allocated)
+    {
+        __shadowAtlas.Reset();
+        for (const auto & [size, light] : requests)
+        {
+            LightTile & lightTile = __tiles[light];
+            if (size == 0) continue;
+            lightTile.tile = __shadowAtlas.Allocate(size);
+            lightTile.valid = lightTile.staticValid = false;
+        }
+    }
+}
+
+void LightRendering::ResizeCubeArray(int capacity)
+{
+    OpenGL_State::DeleteTextures(1, &__cubeShadowMaps);
+    __cubeCapacity = capacity;
+
+    // Hardware comparison (samplerCubeArrayShadow), filtered over 2x2 texels
+    glCreateTextures(GL_TEXTURE_CUBE_MAP_ARRAY, 1, &__cubeShadowMaps);
+    glTextureStorage3D(__cubeShadowMaps, 1, GL_DEPTH_COMPONENT32F, cubeShadowSize, cubeShadowSize, capacity * 6);
+    glTextureParameteri(__cubeShadowMaps, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(__cubeShadowMaps, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(__cubeShadowMaps, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(__cubeShadowMaps, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(__cubeShadowMaps, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(__cubeShadowMaps, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTextureParameteri(__cubeShadowMaps, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    // Layered attachment, faces are selected with gl_Layer
+    glNamedFramebufferTexture(__cubeFramebuffer, GL_DEPTH_ATTACHMENT, __cubeShadowMaps, 0);
+}
+
+void LightRendering::AllocateCubeLayers(const std::array<PointLight *, PointLight::maxPointLightsCount> & lights, size_t count)
+{
+    int used = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        LightTile & lightTile = __tiles[lights[i]];
+        if (!lights[i]->omnidirectionalShadows && lightTile.cubeLayer != -1)
+        {
+            __freeCubeLayers.push_back(lightTile.cubeLayer);
+            lightTile.cubeLayer = -1;
+            lightTile.valid = false;
+        }
+        used += lights[i]->omnidirectionalShadows;
+    }
+
+    // Every layer is lost when the array grows
+    if (used > __cubeCapacity)
+    {
+        int capacity = __cubeCapacity;
+        while (capacity < used) capacity *= 2;
+        ResizeCubeArray(capacity);
+        __freeCubeLayers.clear();
+        for (auto & [light, lightTile] : __tiles)
+        {
+            if (lightTile.cubeLayer == -1) continue;
+            lightTile.cubeLayer = -1;
+            lightTile.valid = false;
+        }
+    }
+
+    int nextLayer = 0;
+    std::vector<bool> taken(__cubeCapacity, false);
+    for (const auto & [light, lightTile] : __tiles)
+        if (lightTile.cubeLayer != -1) taken[lightTile.cubeLayer] = true;
+    for (size_t i = 0; i < count; ++i)
+    {
+        LightTile & lightTile = __tiles[lights[i]];
+        if (!lights[i]->omnidirectionalShadows || lightTile.cubeLayer != -1) continue;
+        if (!__freeCubeLayers.empty())
+        {
+            lightTile.cubeLayer = __freeCubeLayers.back();
+            __freeCubeLayers.pop_back();
+        }
+        else
+        {
+            while (taken[nextLayer]) ++nextLayer;
+            lightTile.cubeLayer = nextLayer;
+        }
+        taken[lightTile.cubeLayer] = true;
+        lightTile.valid = false;
+    }
+}
+
+void LightRendering::UpdateCasters(const std::vector<Entity *> & entities)
+{
+    ++__frame;
+    __shadowCasters.clear();
+    for (Entity * entity : entities)
+    {
+        if (!entity->castsShadows) continue;
+        __shadowCasters.push_back(entity);
+
+        const glm::mat4 model = entity->GetModelMatrix();
+        const Mesh_Base * mesh = *entity->GetMesh();
+        auto [it, inserted] = __casterStates.try_emplace(entity);
+        CasterState & state = it->second;
+        if (inserted)
+            state = { model, mesh, mesh->GetBoundsVersion(), __frame - static_cast<uint32_t>(settings.staticFrames), __frame };
+        else if (state.model != model || state.mesh != mesh || state.boundsVersion != mesh->GetBoundsVersion())
+            state = { model, mesh, mesh->GetBoundsVersion(), __frame, __frame };
+        state.seenFrame = __frame;
+    }
+
+    // Destroyed entities
+    for (auto it = __casterStates.begin(); it != __casterStates.end();)
+    {
+        if (it->second.seenFrame != __frame) it = __casterStates.erase(it);
+        else ++it;
+    }
+
+    // Casters bounds are gathered once, then culled per light
+    __shadowCuller.Gather(__shadowCasters);
+}
+
+void LightRendering::RenderTile(GLuint framebuffer, const ShadowAtlas::Tile & tile, const std::vector<Entity *> & casters, bool clear)
+{
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    OpenGL_State::Viewport(tile.x, tile.y, tile.size, tile.size);
+    glScissor(tile.x, tile.y, tile.size, tile.size);
+    if (clear) glClear(GL_DEPTH_BUFFER_BIT);
+    for (Entity * caster : casters)
+    {
+        __shadowMappingShader.SetUniformMatrix4f("model", caster->GetModelMatrix());
+        (*caster->GetMesh())->DrawFaces(GL_TRIANGLES);
+    }
+    __shadowDraws += static_cast<int>(casters.size());
+}
+
+size_t LightRendering::GatherCubeCasters(const PointLight & light, LightTile & lightTile)
+{
+    // Faces every caster intersects, casters outside of all 6 frusta are skipped
+    const std::array<glm::mat4, 6> faces = light.GetCubeShadowMatrices();
+    __faceMasks.clear();
+    for (int face = 0; face < 6; ++face)
+    {
+        __visibleCasters.clear();
+        __shadowCuller.Cull(Frustum(faces[face]), __visibleCasters);
+        for (Entity * caster : __visibleCasters)
+            __faceMasks[caster] |= static_cast<uint8_t>(1 << face);
+    }
+
+    size_t signature = 0;
+    for (int i = 0; i < 3; ++i)
+        HashCombine(signature, std::hash<float>()(light.pos[i]));
+    HashCombine(signature, std::hash<int>()(lightTile.cubeLayer));
+    HashCombine(signature, std::hash<int>()(__cubeCapacity));
+    lightTile.faceMasks.clear();
+    for (Entity * caster : __shadowCasters)
+    {
+        const auto it = __faceMasks.find(caster);
+        if (it == __faceMasks.end()) continue;
+        lightTile.dynamicCasters.push_back(caster);
+        lightTile.faceMasks.push_back(it->second);
+        HashCombine(signature, std::hash<const void *>()(caster));
+        HashCombine(signature, std::hash<uint32_t>()(__casterStates[caster].changeFrame));
+        HashCombine(signature, std::hash<uint8_t>()(it->second));
+    }
+    return signature;
+}
+
+void LightRendering::RenderCube(const PointLight & light, LightTile & lightTile)
+{
+    // Only the 6 faces of the layer, glClear would clear the whole layered attachment
+    const float farthest = 1.0f;
+    glClearTexSubImage(__cubeShadowMaps, 0, 0, 0, lightTile.cubeLayer * 6, cubeShadowSize, cubeShadowSize, 6,
+        GL_DEPTH_COMPONENT, GL_FLOAT, &farthest);
+
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, __cubeFramebuffer);
+    OpenGL_State::Viewport(0, 0, cubeShadowSize, cubeShadowSize);
+    glScissor(0, 0, cubeShadowSize, cubeShadowSize);
+
+    // One pass: the geometry shader emits every triangle to the faces of its caster
+    const std::array<glm::mat4, 6> faces = light.GetCubeShadowMatrices();
+    __pointShadowMappingShader.Use();
+    __pointShadowMappingShader.SetUniformMatrix4f("shadowMatrices", faces.data(), static_cast<GLsizei>(faces.size()));
+    __pointShadowMappingShader.SetUniformFloat("lightPos", light.pos);
+    __pointShadowMappingShader.SetUniformFloat("farPlane", PointLight::cubeShadowFarPlane);
+    __pointShadowMappingShader.SetUniformInt("cubeLayer", lightTile.cubeLayer);
+    for (size_t i = 0; i < lightTile.dynamicCasters.size(); ++i)
+    {
+        Entity * caster = lightTile.dynamicCasters[i];
+        __pointShadowMappingShader.SetUniformMatrix4f("model", caster->GetModelMatrix());
+        __pointShadowMappingShader.SetUniformInt("faceMask", lightTile.faceMasks[i]);
+        (*caster->GetMesh())->DrawFaces(GL_TRIANGLES);
+    }
+    __shadowDraws += static_cast<int>(lightTile.dynamicCasters.size());
+    lightTile.cubePosition = light.pos;
+}
+
 void LightRendering::RefreshUbo()
 {
     const int pointLightsCount = PointLight::GetPointLightsCount();
     const auto & pointLights = PointLight::GetAllPointLights();
     const auto & entities = Entity::GetAllEntities();
 
-    glBindBuffer(GL_UNIFORM_BUFFER, s_lightRendering->GetUboLights());
+    OpenGL_State::BindBuffer(GL_UNIFORM_BUFFER, s_lightRendering->GetUboLights());
 
     Shader & shader = s_lightRendering->GetShadowMappingShader();
-    const std::array<GLuint, PointLight::maxPointLightsCount> & framebuffers = s_lightRendering->GetDepthMapFbo();
     shader.Use();
 
-    glViewport(0, 0, shadowWidth, shadowHeight);
+    LightRendering & lightRendering = *s_lightRendering;
+    lightRendering.AllocateTiles(pointLights, pointLightsCount);
+    lightRendering.AllocateCubeLayers(pointLights, pointLightsCount);
+    lightRendering.UpdateCasters(entities);
+    lightRendering.__shadowDraws = 0;
+    lightRendering.__shadowUpdates = 0;
+
+    // Out of date shadow maps: light or casters in its frustum changed since they were rendered
+    std::vector<std::pair<const PointLight *, glm::mat4>> updates;
     for (size_t i = 0; i < pointLightsCount; ++i)
     {
-        auto shaderInfo = pointLights[i]->GetShaderInfo();
-        glBufferSubData(GL_UNIFORM_BUFFER, i * sizeof(PointLight_Shader), sizeof(PointLight_Shader), &shaderInfo);
+        const PointLight & light = *pointLights[i];
+        LightTile & lightTile = lightRendering.__tiles[&light];
+        lightTile.staticCasters.clear();
+        lightTile.dynamicCasters.clear();
 
-        shader.SetUniformMatrix4f("lightSpaceMatrix", shaderInfo.pointLightViewMatrix);
-
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        for (int i = 0; i < entities.size(); ++i)
+        size_t staticSignature = 0, signature = 0;
+        glm::mat4 spaceMatrix(1.0f);
+        if (light.omnidirectionalShadows)
+        {
+            // Cube shadow maps have no static layer, every caster is drawn when they change
+            if (lightTile.cubeLayer == -1) continue;
+            signature = lightRendering.GatherCubeCasters(light, lightTile);
+        }
+        else
         {
-            if (dynamic_cast<PointLight *>(entities[i])) continue;
+            if (!lightTile.tile.IsValid()) continue;
 
-            shader.SetUniformMatrix4f("model", entities[i]->GetModelMatrix());
-            glBindVertexArray(entities[i]->GetMesh().facesVAO());
+            spaceMatrix = light.GetShaderInfo().pointLightViewMatrix;
+            lightRendering.__visibleCasters.clear();
+            lightRendering.__shadowCuller.Cull(Frustum(spaceMatrix), lightRendering.__visibleCasters);
 
-            glDrawArrays(GL_TRIANGLES, 0, entities[i]->GetMesh().facesNVert());
+            // Light state, then casters with the frame they last moved
+            HashCombine(staticSignature, HashMatrix(spaceMatrix));
+            HashCombine(staticSignature, std::hash<int>()(lightRendering.__shadowAtlas.GetSize()));
+            for (Entity * caster : lightRendering.__visibleCasters)
+            {
+                const uint32_t changeFrame = lightRendering.__casterStates[caster].changeFrame;
+                const bool isStatic = lightRendering.__frame - changeFrame >= static_cast<uint32_t>(settings.staticFrames);
+                (isStatic ? lightTile.staticCasters : lightTile.dynamicCasters).push_back(caster);
+                HashCombine(isStatic ? staticSignature : signature, std::hash<const void *>()(caster));
+                HashCombine(isStatic ? staticSignature : signature, std::hash<uint32_t>()(changeFrame));
+            }
+            HashCombine(signature, staticSignature);
         }
+
+        const bool upToDate = settings.cache && lightTile.valid && lightTile.signature == signature
+            && (light.omnidirectionalShadows || (lightTile.staticValid && lightTile.staticSignature == staticSignature));
+        if (upToDate)
+        {
+            lightTile.dirty = false;
+            continue;
+        }
+        if (!lightTile.dirty)
+        {
+            lightTile.dirty = true;
+            lightTile.dirtyFrame = lightRendering.__frame;
+        }
+        lightTile.staticValid &= lightTile.staticSignature == staticSignature;
+        lightTile.staticSignature = staticSignature;
+        lightTile.signature = signature;
+        updates.push_back({ &light, spaceMatrix });
+    }
+
+    // Budget: lights without shadow map first, then the longest out of date
+    if (settings.cache && settings.maxUpdatesPerFrame > 0 && updates.size() > static_cast<size_t>(settings.maxUpdatesPerFrame))
+    {
+        std::stable_sort(updates.begin(), updates.end(), [&](const auto & a, const auto & b) {
+            const LightTile & tileA = lightRendering.__tiles[a.first], & tileB = lightRendering.__tiles[b.first];
+            if (tileA.valid != tileB.valid) return !tileA.valid;
+            return lightRendering.__frame - tileA.dirtyFrame > lightRendering.__frame - tileB.dirtyFrame;
+        });
+        for (size_t i = settings.maxUpdatesPerFrame; i < updates.size(); ++i)
+        {
+            // Kept out of date, compared again next frame
+            LightTile & lightTile = lightRendering.__tiles[updates[i].first];
+            lightTile.signature = 0;
+        }
+        updates.resize(settings.maxUpdatesPerFrame);
+    }
+
+    const ShadowAtlas & atlas = lightRendering.__shadowAtlas;
+    OpenGL_State::PolygonMode(GL_FILL);
+    // Clears stay inside the tile of the light
+    OpenGL_State::SetCapability(GL_SCISSOR_TEST, true);
+    for (const auto & [light, spaceMatrix] : updates)
+    {
+        LightTile & lightTile = lightRendering.__tiles[light];
+        if (light->omnidirectionalShadows)
+        {
+            lightRendering.RenderCube(*light, lightTile);
+            shader.Use();
+        }
+        else if (!settings.cache)
+        {
+            shader.SetUniformMatrix4f("lightSpaceMatrix", spaceMatrix);
+            lightTile.staticCasters.insert(lightTile.staticCasters.end(), lightTile.dynamicCasters.begin(), lightTile.dynamicCasters.end());
+            lightRendering.RenderTile(atlas.GetFramebuffer(), lightTile.tile, lightTile.staticCasters, true);
+            lightTile.staticValid = false;
+        }
+        else
+        {
+            shader.SetUniformMatrix4f("lightSpaceMatrix", spaceMatrix);
+            if (!lightTile.staticValid)
+            {
+                lightRendering.RenderTile(atlas.GetStaticFramebuffer(), lightTile.tile, lightTile.staticCasters, true);
+                lightTile.staticValid = true;
+            }
+            atlas.CopyStaticTile(lightTile.tile);
+            lightRendering.RenderTile(atlas.GetFramebuffer(), lightTile.tile, lightTile.dynamicCasters, false);
+        }
+        lightTile.valid = true;
+        lightTile.dirty = false;
+        lightTile.spaceMatrix = spaceMatrix;
+        ++lightRendering.__shadowUpdates;
+    }
+    OpenGL_State::SetCapability(GL_SCISSOR_TEST, false);
+
+    // Lights sample the shadow map as it was rendered, none until it is
+    for (size_t i = 0; i < pointLightsCount; ++i)
+    {
+        const LightTile & lightTile = lightRendering.__tiles[pointLights[i]];
+        auto shaderInfo = pointLights[i]->GetShaderInfo();
+        shaderInfo.pointLightViewMatrix = lightTile.spaceMatrix;
+        const bool cube = pointLights[i]->omnidirectionalShadows && lightTile.cubeLayer != -1;
+        shaderInfo.shadowRect = lightTile.valid && !cube ? atlas.GetRect(lightTile.tile) : glm::vec4(0.0f);
+        shaderInfo.cubeShadow = lightTile.valid && cube
+            ? glm::vec4(lightTile.cubePosition, static_cast<float>(lightTile.cubeLayer)) : glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+        glBufferSubData(GL_UNIFORM_BUFFER, i * sizeof(PointLight_Shader), sizeof(PointLight_Shader), &shaderInfo);
     }
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, atlas.GetFramebuffer());
 
     if (s_lightRendering->screenshotDepthMap)
     {
-        GLubyte * pixels = new GLubyte[shadowWidth * shadowHeight * 1];
+        const int atlasSize = atlas.GetSize();
+        GLubyte * pixels = new GLubyte[atlasSize * atlasSize * 1];
         glPixelStorei(GL_PACK_ALIGNMENT, 1);
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glReadPixels(0, 0, shadowWidth, shadowHeight, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, pixels);
-        stbi_write_bmp("screenshots/TEST.bmp", shadowWidth, shadowHeight, 1, pixels);
+        glReadPixels(0, 0, atlasSize, atlasSize, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, pixels);
+        stbi_write_bmp("screenshots/TEST.bmp", atlasSize, atlasSize, 1, pixels);
         delete[] pixels;
         s_lightRendering->screenshotDepthMap = false;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glViewport(0, 0, Window::Get()->windowWidth(), Window::Get()->windowHeight());
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    OpenGL_State::Viewport(0, 0, Window::Get()->windowWidth(), Window::Get()->windowHeight());
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     glBufferSubData(GL_UNIFORM_BUFFER, sizeof(PointLight_Shader) * PointLight::maxPointLightsCount,
@@ -9,6 +9,11 @@
 
 // Project includes
 #include "OGL_Implementation\Light\Light.hpp"
+#include "FrustumCuller.hpp"
+#include "ShadowAtlas.hpp"
+
+// C++ includes
+#include <unordered_map>
 
 /**
  * @brief Manages All variables needed GPU-side and gives everything for shaders
@@ -16,13 +21,48 @@
 */
 class LightRendering
 {
+public:
+    /**
+     * @brief Shadow maps caching settings
+    */
+    struct Settings
+    {
+        /**
+         * @brief Re-renders shadow maps only when their light or casters changed,
+         * static casters are cached in their own layer
+        */
+        bool cache = true;
+        /**
+         * @brief Maximum shadow maps re-rendered per frame while caching, 0 for no limit
+        */
+        int maxUpdatesPerFrame = 4;
+        /**
+         * @brief Frames a caster has to stay still to be static
+        */
+        int staticFrames = 30;
+    };
+
 public:
     LightRendering();
     ~LightRendering();
 
     GLuint GetUboLights();
     Shader & GetShadowMappingShader();
-    const std::array<GLuint, PointLight::maxPointLightsCount> & GetDepthMapFbo() const;
+    /**
+     * @brief Depth only shader (lightSpaceMatrix, model), also used by the depth pre-pass of the camera
+    */
+    Shader GetShadowMappingShader() const;
+    const ShadowAtlas & GetShadowAtlas() const;
+    /**
+     * @brief Returns shadow casters drawn in all shadow maps at the last refresh
+     * @return draws
+    */
+    int GetShadowDrawsCount() const;
+    /**
+     * @brief Returns shadow maps re-rendered at the last refresh
+     * @return updates
+    */
+    int GetShadowUpdatesCount() const;
 
     static void Init();
     static const LightRendering & Get();
@@ -30,14 +70,127 @@ public:
 
     static void PrintDepthMap();
 
+    /**
+     * @brief Shadow atlas texture, one tile per point light
+    */
+    GLuint GetShadowMaps() const;
+    /**
+     * @brief Cube map array, one layer per light with omnidirectional shadows
+    */
+    GLuint GetPointShadowMaps() const;
+
 public:
-    std::array<GLuint, PointLight::maxPointLightsCount> shadowMaps;
     bool screenshotDepthMap;
 
+    static Settings settings;
+
+private:
+    struct LightTile;
+
+    /**
+     * @brief Tile size of a light, from the screen coverage of its shadow bounds & its importance
+     * @param light
+     * @param currentSize size of its tile, kept near the boundaries between sizes (0 if none)
+     * @return power of two size, 0 when the light needs no shadow map
+    */
+    static int ComputeTileSize(const PointLight & light, int currentSize);
+    /**
+     * @brief Resizes the atlas to fit the tiles of this frame & allocates tiles of lights
+     * whose size changed, repacking everything if the quadtree is too fragmented
+     * @param lights
+    */
+    void AllocateTiles(const std::array<PointLight *, PointLight::maxPointLightsCount> & lights, size_t count);
+    /**
+     * @brief Gives a cube map array layer to lights with omnidirectional shadows,
+     * growing the array when they don't fit
+    */
+    void AllocateCubeLayers(const std::array<PointLight *, PointLight::maxPointLightsCount> & lights, size_t count);
+    void ResizeCubeArray(int capacity);
+    /**
+     * @brief Tracks when every caster last moved, gathers their bounds
+     * @param entities
+    */
+    void UpdateCasters(const std::vector<Entity *> & entities);
+    /**
+     * @brief Clears a tile of a layer & draws casters in it
+    */
+    void RenderTile(GLuint framebuffer, const ShadowAtlas::Tile & tile, const std::vector<Entity *> & casters, bool clear);
+    /**
+     * @brief Culls casters against the 6 faces of the cube shadow map of the light
+     * into its dynamic casters & their face masks
+     * @return signature of the light & its casters
+    */
+    size_t GatherCubeCasters(const PointLight & light, LightTile & lightTile);
+    /**
+     * @brief Clears the cube map array layer of the light & draws its casters in it
+    */
+    void RenderCube(const PointLight & light, LightTile & lightTile);
+
 private:
-    std::array<GLuint, PointLight::maxPointLightsCount> __depthMapFbo;
+    ShadowAtlas __shadowAtlas;
+    /**
+     * @brief Tile & requested size per light, kept while the size doesn't change,
+     * & the state its layers were rendered with
+    */
+    struct LightTile
+    {
+        ShadowAtlas::Tile tile;
+        int size = 0;
+        /**
+         * @brief Layers hold a rendered shadow map
+        */
+        bool valid = false, staticValid = false;
+        /**
+         * @brief Light space matrix of the rendered shadow map
+        */
+        glm::mat4 spaceMatrix = glm::mat4(1.0f);
+        /**
+         * @brief Light & casters (static ones, then all) the layers were rendered with
+        */
+        size_t staticSignature = 0, signature = 0;
+        /**
+         * @brief Frame the shadow map became out of date, oldest ones are updated first
+        */
+        uint32_t dirtyFrame = 0;
+        bool dirty = false;
+        std::vector<Entity *> staticCasters, dynamicCasters;
+        /**
+         * @brief Layer in the cube map array for omnidirectional shadows, -1 without,
+         * position it was rendered from & faces intersected by each of dynamicCasters
+        */
+        int cubeLayer = -1;
+        glm::vec3 cubePosition = glm::vec3(0.0f);
+        std::vector<uint8_t> faceMasks;
+    };
+    /**
+     * @brief Transform a caster was last seen with
+    */
+    struct CasterState
+    {
+        glm::mat4 model;
+        const Mesh_Base * mesh;
+        uint32_t boundsVersion;
+        uint32_t changeFrame, seenFrame;
+    };
+    std::unordered_map<const PointLight *, LightTile> __tiles;
+    std::unordered_map<const Entity *, CasterState> __casterStates;
+    uint32_t __frame;
     GLuint __uboLights;
     Shader __shadowMappingShader;
+    /**
+     * @brief Omnidirectional shadows: cube map array rendered in one layered pass per light
+    */
+    Shader __pointShadowMappingShader;
+    GLuint __cubeShadowMaps, __cubeFramebuffer;
+    int __cubeCapacity;
+    std::vector<int> __freeCubeLayers;
+    std::unordered_map<const Entity *, uint8_t> __faceMasks;
+    /**
+     * @brief Casters culled against each light frustum
+    */
+    FrustumCuller __shadowCuller;
+    std::vector<Entity *> __shadowCasters, __visibleCasters;
+    int __shadowDraws, __shadowUpdates;
 };
 
 /**
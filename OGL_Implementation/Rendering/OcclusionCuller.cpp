@@ -0,0 +1,344 @@
+/*****************************************************************//**
+ * \file   OcclusionCuller.cpp
+ * \brief  OcclusionCuller source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 10 2022
+ *********************************************************************/
+#include "OcclusionCuller.hpp"
+
+// Project includes
+#include "OGL_Implementation\Tools\ThreadPool.hpp"
+
+// C++ includes
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define OCCLUSION_CULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+static constexpr const float farDepth = 1.0f;
+static constexpr const size_t trianglesPerChunk = 256;
+static constexpr const int rowsPerChunk = 8;
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+    : __width{ (std::max(width, 4) + 3) & ~3 }
+    , __height{ std::max(height, 1) }
+    , __viewProjection{ 1.0f }
+    , __trianglesCount{ 0 }
+{
+    glm::ivec2 size(__width, __height);
+    while (true)
+    {
+        __pyramidSizes.push_back(size);
+        __pyramid.emplace_back(static_cast<size_t>(size.x) * size.y, farDepth);
+        if (size.x == 1 && size.y == 1) break;
+        size = glm::max((size + 1) / 2, glm::ivec2(1));
+    }
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+}
+
+void OcclusionCuller::Begin(const glm::mat4 & viewProjection)
+{
+    __viewProjection = viewProjection;
+    __occluders.clear();
+    std::fill(__pyramid[0].begin(), __pyramid[0].end(), farDepth);
+}
+
+void OcclusionCuller::AddOccluder(const std::vector<glm::vec3> & triangles, const glm::mat4 & model)
+{
+    if (triangles.size() < 3) return;
+    __occluders.push_back({ &triangles, __viewProjection * model, 0 });
+}
+
+bool OcclusionCuller::AddOccluder(const Entity & entity)
+{
+    if (!entity.occluder) return false;
+
+    const Mesh_Base * mesh = **entity.occluder;
+    MeshTriangles & cache = __meshTriangles[mesh];
+    if (cache.boundsVersion != mesh->GetBoundsVersion())
+    {
+        AssembleTriangles(*mesh->GetVerticesPos(), *mesh->GetFaces(), cache.triangles);
+        cache.boundsVersion = mesh->GetBoundsVersion();
+    }
+    if (cache.triangles.empty()) return false;
+    AddOccluder(cache.triangles, entity.GetModelMatrix());
+    return true;
+}
+
+void OcclusionCuller::AssembleTriangles(const std::vector<VertexPos> & vertices, const std::vector<Face> & faces, std::vector<glm::vec3> & triangles)
+{
+    triangles.clear();
+    triangles.reserve(faces.size() * 3);
+    for (const Face & face : faces)
+    {
+        const std::vector<int> & v = face.v;
+        for (size_t i = 1; i + 1 < v.size(); ++i)
+        {
+            const int a = v[0], b = v[i], c = v[i + 1];
+            if (std::min({ a, b, c }) < 0 || static_cast<size_t>(std::max({ a, b, c })) >= vertices.size()) continue;
+            triangles.insert(triangles.end(), { vertices[a], vertices[b], vertices[c] });
+        }
+    }
+}
+
+void OcclusionCuller::Rasterize()
+{
+    size_t count = 0;
+    for (Occluder & occluder : __occluders)
+    {
+        occluder.first = count;
+        count += occluder.triangles->size() / 3;
+    }
+    __triangles.resize(count);
+
+    ThreadPool & pool = ThreadPool::Get();
+    pool.ParallelFor(count, [this](size_t begin, size_t end, size_t) { SetupTriangles(begin, end); }, trianglesPerChunk);
+    pool.ParallelFor(static_cast<size_t>(__height), [this](size_t begin, size_t end, size_t) {
+        RasterizeRows(static_cast<int>(begin), static_cast<int>(end));
+    }, rowsPerChunk);
+    BuildPyramid();
+
+    __trianglesCount = std::count_if(__triangles.begin(), __triangles.end(), [](const ScreenTriangle & triangle) { return triangle.valid; });
+    __occluders.clear();
+}
+
+void OcclusionCuller::SetupTriangles(size_t begin, size_t end)
+{
+    // Occluder of the first triangle, the next ones follow in order
+    size_t occluderId = std::upper_bound(__occluders.begin(), __occluders.end(), begin,
+        [](size_t triangle, const Occluder & occluder) { return triangle < occluder.first; }) - __occluders.begin() - 1;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        while (occluderId + 1 < __occluders.size() && __occluders[occluderId + 1].first <= i) ++occluderId;
+        const Occluder & occluder = __occluders[occluderId];
+        ScreenTriangle & triangle = __triangles[i];
+        triangle.valid = false;
+
+        std::array<glm::vec3, 3> v;
+        bool clipped = false;
+        for (size_t j = 0; j < 3; ++j)
+        {
+            const glm::vec4 clip = occluder.modelViewProjection * glm::vec4((*occluder.triangles)[(i - occluder.first) * 3 + j], 1.0f);
+            // Crossing the near plane: dropped, occluding less is still correct
+            if (clip.w <= 1e-6f || clip.z < -clip.w)
+            {
+                clipped = true;
+                break;
+            }
+            v[j] = glm::vec3((clip.x / clip.w * 0.5f + 0.5f) * __width, (clip.y / clip.w * 0.5f + 0.5f) * __height, clip.z / clip.w);
+        }
+        if (clipped) continue;
+
+        // Edge j is opposite to vertex j, so that edge / area is its barycentric coordinate
+        for (size_t j = 0; j < 3; ++j)
+        {
+            const glm::vec3 & a = v[(j + 1) % 3], & b = v[(j + 2) % 3];
+            triangle.edgeA[j] = a.y - b.y;
+            triangle.edgeB[j] = b.x - a.x;
+            triangle.edgeC[j] = a.x * b.y - a.y * b.x;
+        }
+        const float area = triangle.edgeA[0] * v[0].x + triangle.edgeB[0] * v[0].y + triangle.edgeC[0];
+        if (std::abs(area) < 1e-8f) continue;
+
+        // Both windings are rasterized, occluders can be open surfaces
+        const float inverseArea = 1.0f / area;
+        triangle.depthA = triangle.depthB = triangle.depthC = 0.0f;
+        for (size_t j = 0; j < 3; ++j)
+        {
+            triangle.edgeA[j] *= inverseArea;
+            triangle.edgeB[j] *= inverseArea;
+            triangle.edgeC[j] *= inverseArea;
+            triangle.depthA += triangle.edgeA[j] * v[j].z;
+            triangle.depthB += triangle.edgeB[j] * v[j].z;
+            triangle.depthC += triangle.edgeC[j] * v[j].z;
+        }
+
+        const glm::vec3 minV = glm::min(v[0], glm::min(v[1], v[2]));
+        const glm::vec3 maxV = glm::max(v[0], glm::max(v[1], v[2]));
+        triangle.minX = std::max(0, static_cast<int>(std::floor(minV.x)));
+        triangle.maxX = std::min(__width - 1, static_cast<int>(std::floor(maxV.x)));
+        triangle.minY = std::max(0, static_cast<int>(std::floor(minV.y)));
+        triangle.maxY = std::min(__height - 1, static_cast<int>(std::floor(maxV.y)));
+        triangle.valid = triangle.minX <= triangle.maxX && triangle.minY <= triangle.maxY && minV.z <= farDepth;
+    }
+}
+
+void OcclusionCuller::RasterizeRows(int beginRow, int endRow)
+{
+    std::vector<float> & depth = __pyramid[0];
+#ifdef OCCLUSION_CULLER_SSE
+    const __m128 pixelCenters = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+#endif
+
+    for (const ScreenTriangle & triangle : __triangles)
+    {
+        if (!triangle.valid) continue;
+        const int minY = std::max(triangle.minY, beginRow);
+        const int maxY = std::min(triangle.maxY, endRow - 1);
+
+#ifdef OCCLUSION_CULLER_SSE
+        const __m128 a0 = _mm_set1_ps(triangle.edgeA[0]), a1 = _mm_set1_ps(triangle.edgeA[1]), a2 = _mm_set1_ps(triangle.edgeA[2]);
+        const __m128 depthA = _mm_set1_ps(triangle.depthA);
+#endif
+        for (int y = minY; y <= maxY; ++y)
+        {
+            const float py = y + 0.5f;
+            float * row = &depth[static_cast<size_t>(y) * __width];
+#ifdef OCCLUSION_CULLER_SSE
+            const __m128 row0 = _mm_set1_ps(triangle.edgeB[0] * py + triangle.edgeC[0]);
+            const __m128 row1 = _mm_set1_ps(triangle.edgeB[1] * py + triangle.edgeC[1]);
+            const __m128 row2 = _mm_set1_ps(triangle.edgeB[2] * py + triangle.edgeC[2]);
+            const __m128 rowDepth = _mm_set1_ps(triangle.depthB * py + triangle.depthC);
+
+            // Width is a multiple of 4, so are the blocks
+            for (int x = triangle.minX & ~3; x <= triangle.maxX; x += 4)
+            {
+                const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixelCenters);
+                const __m128 inside = _mm_and_ps(
+                    _mm_and_ps(
+                        _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), row0), zero),
+                        _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), row1), zero)),
+                    _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), row2), zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+
+                const __m128 z = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+                const __m128 previous = _mm_loadu_ps(row + x);
+                _mm_storeu_ps(row + x, _mm_or_ps(
+                    _mm_and_ps(inside, _mm_min_ps(previous, z)),
+                    _mm_andnot_ps(inside, previous)));
+            }
+#else
+            for (int x = triangle.minX; x <= triangle.maxX; ++x)
+            {
+                const float px = x + 0.5f;
+                bool inside = true;
+                for (size_t j = 0; j < 3; ++j)
+                    inside &= triangle.edgeA[j] * px + triangle.edgeB[j] * py + triangle.edgeC[j] >= 0.0f;
+                if (inside)
+                    row[x] = std::min(row[x], triangle.depthA * px + triangle.depthB * py + triangle.depthC);
+            }
+#endif
+        }
+    }
+}
+
+void OcclusionCuller::BuildPyramid()
+{
+    for (size_t level = 1; level < __pyramid.size(); ++level)
+    {
+        const std::vector<float> & source = __pyramid[level - 1];
+        const glm::ivec2 sourceSize = __pyramidSizes[level - 1];
+        const glm::ivec2 size = __pyramidSizes[level];
+        std::vector<float> & destination = __pyramid[level];
+
+        for (int y = 0; y < size.y; ++y)
+        {
+            const int y0 = y * 2, y1 = std::min(y0 + 1, sourceSize.y - 1);
+            for (int x = 0; x < size.x; ++x)
+            {
+                const int x0 = x * 2, x1 = std::min(x0 + 1, sourceSize.x - 1);
+                destination[static_cast<size_t>(y) * size.x + x] = std::max(
+                    std::max(source[static_cast<size_t>(y0) * sourceSize.x + x0], source[static_cast<size_t>(y0) * sourceSize.x + x1]),
+                    std::max(source[static_cast<size_t>(y1) * sourceSize.x + x0], source[static_cast<size_t>(y1) * sourceSize.x + x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::IsVisible(const BoundingBox & worldBox) const
+{
+    if (!worldBox.IsValid()) return true;
+
+    glm::vec2 minScreen(std::numeric_limits<float>::max()), maxScreen(-std::numeric_limits<float>::max());
+    float minDepth = std::numeric_limits<float>::max();
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        const glm::vec3 position(
+            (corner & 1) ? worldBox.max.x : worldBox.min.x,
+            (corner & 2) ? worldBox.max.y : worldBox.min.y,
+            (corner & 4) ? worldBox.max.z : worldBox.min.z);
+        const glm::vec4 clip = __viewProjection * glm::vec4(position, 1.0f);
+        if (clip.w <= 1e-6f || clip.z < -clip.w) return true;
+
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        const glm::vec2 screen = (glm::vec2(ndc) * 0.5f + 0.5f) * glm::vec2(__width, __height);
+        minScreen = glm::min(minScreen, screen);
+        maxScreen = glm::max(maxScreen, screen);
+        minDepth = std::min(minDepth, ndc.z);
+    }
+    // Outside of the screen, left to the frustum culling
+    if (maxScreen.x < 0.0f || maxScreen.y < 0.0f || minScreen.x > __width || minScreen.y > __height) return true;
+
+    int x0 = std::clamp(static_cast<int>(std::floor(minScreen.x)), 0, __width - 1);
+    int x1 = std::clamp(static_cast<int>(std::floor(maxScreen.x)), 0, __width - 1);
+    int y0 = std::clamp(static_cast<int>(std::floor(minScreen.y)), 0, __height - 1);
+    int y1 = std::clamp(static_cast<int>(std::floor(maxScreen.y)), 0, __height - 1);
+
+    // Coarsest level where the rectangle spans at most 4x4 texels
+    size_t level = 0;
+    while (level + 1 < __pyramid.size() && (x1 - x0 >= 4 || y1 - y0 >= 4))
+    {
+        x0 >>= 1; x1 >>= 1;
+        y0 >>= 1; y1 >>= 1;
+        ++level;
+    }
+
+    const std::vector<float> & depths = __pyramid[level];
+    const int width = __pyramidSizes[level].x;
+    for (int y = y0; y <= y1; ++y)
+        for (int x = x0; x <= x1; ++x)
+            if (depths[static_cast<size_t>(y) * width + x] >= minDepth) return true;
+    return false;
+}
+
+size_t OcclusionCuller::Cull(std::vector<Entity *> & entities)
+{
+    // Bounds are cached by entities, gathered here so that workers only read
+    __boxes.resize(entities.size());
+    for (size_t i = 0; i < entities.size(); ++i)
+        __boxes[i] = entities[i]->GetWorldBoundingBox();
+
+    __visible.resize(entities.size());
+    ThreadPool::Get().ParallelFor(entities.size(), [this, &entities](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i)
+            __visible[i] = entities[i]->occluder.has_value() || IsVisible(__boxes[i]);
+    }, 64);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < entities.size(); ++i)
+        if (__visible[i]) entities[kept++] = entities[i];
+    const size_t removed = entities.size() - kept;
+    entities.resize(kept);
+    return removed;
+}
+
+int OcclusionCuller::GetWidth() const
+{
+    return __width;
+}
+
+int OcclusionCuller::GetHeight() const
+{
+    return __height;
+}
+
+const std::vector<float> & OcclusionCuller::GetDepthBuffer() const
+{
+    return __pyramid[0];
+}
+
+size_t OcclusionCuller::GetTrianglesCount() const
+{
+    return __trianglesCount;
+}
@@ -0,0 +1,143 @@
+/*****************************************************************//**
+ * \file   OcclusionCuller.hpp
+ * \brief  CPU software occlusion culling of entities
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 10 2022
+ *********************************************************************/
+#pragma once
+
+// Project includes
+#include "OGL_Implementation\Entity\Entity.hpp"
+
+// GLM includes
+#include <glm\glm.hpp>
+
+// C++ includes
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Rasterizes occluders (see Entity::occluder) on the CPU into a low resolution
+ * depth buffer, reduces it into a pyramid of farthest depths, then tests bounding boxes
+ * of entities against it. Everything runs on the ThreadPool, without GPU readback,
+ * so results are available in the frame they are computed for.
+ * Rows are rasterized in parallel bands, 4 pixels at a time with SSE.
+ * Coverage is sampled at pixel centers: occluders should not exceed what they represent.
+*/
+class OcclusionCuller
+{
+public:
+    /**
+     * @brief Constructor
+     * @param width in pixels, rounded up to a multiple of 4
+     * @param height in pixels
+    */
+    OcclusionCuller(int width = 256, int height = 128);
+    ~OcclusionCuller();
+
+    /**
+     * @brief Clears the depth buffer & the queued occluders for a new view
+     * @param viewProjection OpenGL clip space ([-w, w] depth)
+    */
+    void Begin(const glm::mat4 & viewProjection);
+    /**
+     * @brief Queues triangles to rasterize
+     * @param triangles 3 positions per triangle, has to stay alive until Rasterize
+     * @param model
+    */
+    void AddOccluder(const std::vector<glm::vec3> & triangles, const glm::mat4 & model);
+    /**
+     * @brief Queues the occluder mesh of the entity, its triangles are assembled from
+     * the CPU side positions & faces of the mesh once & cached until the mesh changes
+     * @param entity
+     * @return false if the entity has no occluder (or its mesh has no faces)
+    */
+    bool AddOccluder(const Entity & entity);
+    /**
+     * @brief Assembles faces into triangles (polygons as fans), out of range indices are skipped
+     * @param vertices
+     * @param faces
+     * @param triangles 3 positions per triangle, replaced
+    */
+    static void AssembleTriangles(const std::vector<VertexPos> & vertices, const std::vector<Face> & faces, std::vector<glm::vec3> & triangles);
+    /**
+     * @brief Rasterizes queued occluders & builds the depth pyramid
+    */
+    void Rasterize();
+
+    /**
+     * @brief Tests a world space box against the depth pyramid.
+     * Boxes crossing the near plane or outside of the screen are visible.
+     * @param worldBox
+     * @return false if occluders fully hide the box
+    */
+    bool IsVisible(const BoundingBox & worldBox) const;
+    /**
+     * @brief Removes hidden entities, keeping the order of the others.
+     * Entities with an occluder are kept (they would hide themselves).
+     * @param entities
+     * @return amount of entities removed
+    */
+    size_t Cull(std::vector<Entity *> & entities);
+
+    int GetWidth() const;
+    int GetHeight() const;
+    /**
+     * @brief NDC depth per pixel, rows from the bottom of the screen
+    */
+    const std::vector<float> & GetDepthBuffer() const;
+    /**
+     * @brief Triangles rasterized by the last Rasterize (clipped ones excluded)
+    */
+    size_t GetTrianglesCount() const;
+
+private:
+    struct Occluder
+    {
+        const std::vector<glm::vec3> * triangles;
+        glm::mat4 modelViewProjection;
+        /**
+         * @brief Index of its first triangle in __triangles
+        */
+        size_t first;
+    };
+
+    /**
+     * @brief Triangle in pixels, as edge functions A.x + B.y + C (>= 0 inside)
+     * & depth plane, set up once for every band
+    */
+    struct ScreenTriangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3];
+        float depthA, depthB, depthC;
+        int minX, maxX, minY, maxY;
+        bool valid;
+    };
+
+    struct MeshTriangles
+    {
+        uint32_t boundsVersion = 0;
+        std::vector<glm::vec3> triangles;
+    };
+
+    void SetupTriangles(size_t begin, size_t end);
+    void RasterizeRows(int beginRow, int endRow);
+    void BuildPyramid();
+
+private:
+    int __width, __height;
+    glm::mat4 __viewProjection;
+    std::vector<Occluder> __occluders;
+    std::vector<ScreenTriangle> __triangles;
+    size_t __trianglesCount;
+    /**
+     * @brief Level 0 is the depth buffer, each next level keeps the farthest depth of 2x2 texels
+    */
+    std::vector<std::vector<float>> __pyramid;
+    std::vector<glm::ivec2> __pyramidSizes;
+    std::vector<BoundingBox> __boxes;
+    std::vector<uint8_t> __visible;
+    std::unordered_map<const Mesh_Base *, MeshTriangles> __meshTriangles;
+};
@@ -6,6 +6,10 @@
  * \date   April, 15 2022
  *********************************************************************/
 #include "ParticleSystemRendering.hpp"
+
+// Project includes
+#include "Constants.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
 
 #include <glm/gtx/string_cast.hpp>
 
@@ -29,22 +33,22 @@ ParticleSystemRendering::ParticleSystemRendering()
         1.0f, 1.0f, 0.0f, 1.0f, 1.0f,
         1.0f, 0.0f, 0.0f, 1.0f, 0.0f
     };
-    glBindVertexArray(__vao);
+    OpenGL_State::BindVertexArray(__vao);
     // Fill mesh buffer
-    glBindBuffer(GL_ARRAY_BUFFER, __vbo);
+    OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(particle_quad), particle_quad, GL_STATIC_DRAW);
     // Set mesh attributes
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *)(sizeof(GLfloat) * 3));
-    glBindVertexArray(0);
+    OpenGL_State::BindVertexArray(0);
 }
 
 ParticleSystemRendering::~ParticleSystemRendering()
 {
-    glDeleteVertexArrays(1, &__vao);
-    glDeleteBuffers(1, &__vbo);
+    OpenGL_State::DeleteVertexArrays(1, &__vao);
+    OpenGL_State::DeleteBuffers(1, &__vbo);
 }
 
 void ParticleSystemRendering::Init()
@@ -82,8 +86,8 @@ void ParticleSystemRendering::DrawParticleSystem(ParticleSystem_Base * particleS
 {
     const auto & particles = particleSystem->GetParticles();
 
-    //glBlendFunc(GL_ONE_MINUS_SRC_COLOR, GL_DST_ALPHA);
-    //glDepthMask(GL_FALSE);
+    //OpenGL_State::BlendFunc(GL_ONE_MINUS_SRC_COLOR, GL_DST_ALPHA);
+    //OpenGL_State::DepthMask(false);
 
     const glm::mat4 & parentMatrix = particleSystem->GetModelMatrix();
 
@@ -96,22 +100,17 @@ void ParticleSystemRendering::DrawParticleSystem(ParticleSystem_Base * particleS
             shader.Use();
 
             shader.SetUniformMatrix4f("model", parentMatrix * particle->GetModelMatrix());
-            shader.SetUniformInt("_texture", 0);
 
-            glActiveTexture(GL_TEXTURE0);
-            if (texture.GetWidth() != 0)
-                glBindTexture(GL_TEXTURE_2D, texture.GetTexture());
-            else
-                glBindTexture(GL_TEXTURE_2D, 0);
+            OpenGL_State::BindTextureUnit(Constants::TextureUnits::texture, texture.GetWidth() != 0 ? texture.GetTexture() : 0);
             switch (particleSystem->GetParticlePropertiesStyle())
             {
                 case Particle_Base::ParticlePropertiesStyle::Color:
                     shader.SetUniformFloat("ParticleColor", particle->color);
                     break;
             }
-            glBindVertexArray(s_particleSystemRendering->GetVAO());
+            OpenGL_State::BindVertexArray(s_particleSystemRendering->GetVAO());
+            OpenGL_State::PolygonMode(GL_FILL);
             glDrawArrays(GL_TRIANGLES, 0, 6);
-            glBindVertexArray(0);
         }
         if (particleSystem->displayMode & RenderingMode::WireframeMode)
         {
@@ -121,11 +120,9 @@ void ParticleSystemRendering::DrawParticleSystem(ParticleSystem_Base * particleS
             // use the same color for all points
             shader.SetUniformFloat("ourColor", WireframeColors[0]);
 
-            glBindVertexArray(s_particleSystemRendering->GetVAO());
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+            OpenGL_State::BindVertexArray(s_particleSystemRendering->GetVAO());
+            OpenGL_State::PolygonMode(GL_LINE);
             glDrawArrays(GL_TRIANGLES, 0, 6);
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            glBindVertexArray(0);
         }
         if (particleSystem->displayMode & RenderingMode::VerticesMode)
         {
@@ -135,12 +132,11 @@ void ParticleSystemRendering::DrawParticleSystem(ParticleSystem_Base * particleS
             // use the same color for all points
             shader.SetUniformFloat("ourColor", WireframeColors[0]);
 
-            glBindVertexArray(s_particleSystemRendering->GetVAO());
+            OpenGL_State::BindVertexArray(s_particleSystemRendering->GetVAO());
             glDrawArrays(GL_POINTS, 0, 6);
-            glBindVertexArray(0);
         }
     }
 
-    //glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Blending options
-    //glDepthMask(GL_TRUE);
+    //OpenGL_State::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Blending options
+    //OpenGL_State::DepthMask(true);
 }
@@ -0,0 +1,417 @@
+/*****************************************************************//**
+ * \file   RenderQueue.cpp
+ * \brief  RenderQueue source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 08 2022
+ *********************************************************************/
+#include "RenderQueue.hpp"
+
+// Project includes
+#include "Rendering.hpp"
+#include "OGL_Implementation\Camera.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
+#include "OGL_Implementation\Cubemap\ReflectionProbe.hpp"
+
+// C++ includes
+#include <algorithm>
+#include <array>
+
+/**
+ * @brief Moving average of GPU timings, smoothing the noise between frames
+*/
+static void Average(float & average, float sample)
+{
+    average = average == 0.0f ? sample : average * 0.95f + sample * 0.05f;
+}
+
+RenderQueue::RenderQueue()
+    : __occlusionCulling{ true }
+    , __depthPrePass{ false }
+    , __currentTimer{ 0 }
+{
+}
+
+RenderQueue::~RenderQueue()
+{
+}
+
+void RenderQueue::Add(Entity & entity)
+{
+    __entities.push_back(&entity);
+}
+
+void RenderQueue::AddPackets(Entity & entity)
+{
+    // Meshes of the arena share their VAO, the mesh itself is the state that changes
+    const uintptr_t mesh = reinterpret_cast<uintptr_t>(*entity.GetMesh());
+    if (DisplayMode & RenderingMode::FacesMode)
+    {
+        uintptr_t material = static_cast<uintptr_t>(entity.GetTexture().GetTexture());
+        if (Pbr_Material * pbr = entity.GetPbrMaterial()) material = reinterpret_cast<uintptr_t>(pbr);
+        else if (Material * mat = entity.GetMaterial()) material = reinterpret_cast<uintptr_t>(mat);
+        // Drawn forward until the G-buffer variant is compiled
+        Shader gBufferShader = Rendering::ResolveGBufferShader(entity);
+        const bool gBuffer = DeferredRendering::Accepts(entity) && gBufferShader.IsReady();
+        AddPacket(entity, gBuffer ? Pass::GBuffer : Pass::Faces, gBuffer ? gBufferShader : Rendering::ResolveFaceShader(entity), material, mesh);
+
+        // Per entity uniforms (shader attributes, other attributes) can't be shared by a batch
+        Packet & packet = __packets.back();
+        packet.sssStencil = gBuffer ? 0 : SubsurfaceScattering::Tag(entity);
+        packet.batchable = !entity.transparent && entity.shaderAttributes.empty() && entity.attributes.size() <= 1;
+        if (packet.batchable)
+        {
+            packet.instancedShader = Rendering::ResolveInstancedFaceShader(entity, gBuffer);
+            packet.inArena = (*entity.GetMesh())->IsInArena();
+            if ((*entity.GetMesh())->HasTextureCoordinates() && entity.GetTexture().GetWidth() != 0)
+                packet.texture = entity.GetTexture().GetTexture();
+            if (entity.GetPbrMaterial())
+            {
+                const ReflectionProbe * probe = ReflectionProbe::FindClosest(entity.GetWorldPosition());
+                packet.reflection = probe ? probe->GetPrefilterMap() : 0;
+            }
+        }
+    }
+    if (DisplayMode & RenderingMode::WireframeMode)
+        AddPacket(entity, Pass::Wireframe, entity.GetWireframeShader(), 0, mesh);
+    if (DisplayMode & RenderingMode::VerticesMode)
+        AddPacket(entity, Pass::Vertices, entity.GetPointShader(), 0, mesh);
+}
+
+void RenderQueue::AddPacket(Entity & entity, Pass pass, const Shader & shader, uintptr_t material, uintptr_t meshPointer)
+{
+    const uint32_t program = DenseId(__programIds, shader.Program());
+    const uint32_t materialId = DenseId(__materialIds, material);
+    const uint32_t mesh = DenseId(__meshIds, meshPointer);
+
+    // View depth quantized on 16 bits over [0, zFar]
+    uint64_t depth = 0;
+    if (mainCamera)
+    {
+        const float viewDepth = glm::dot(entity.GetWorldPosition() - mainCamera->Position, mainCamera->Front);
+        depth = static_cast<uint64_t>(std::clamp(viewDepth / mainCamera->GetZFar(), 0.0f, 1.0f) * 0xFFFF);
+    }
+
+    const bool translucent = entity.transparent && pass == Pass::Faces;
+    uint64_t key = (static_cast<uint64_t>(pass) << 62) | (static_cast<uint64_t>(translucent) << 61);
+    if (translucent)
+    {
+        key |= ((0xFFFF - depth) << 45)
+            | (static_cast<uint64_t>(program & 0xFFFF) << 29)
+            | (static_cast<uint64_t>(materialId & 0x7FFF) << 14)
+            | static_cast<uint64_t>(mesh & 0x3FFF);
+    }
+    else
+    {
+        key |= (static_cast<uint64_t>(program & 0xFFFF) << 45)
+            | (static_cast<uint64_t>(materialId & 0x7FFF) << 30)
+            | (static_cast<uint64_t>(mesh & 0x3FFF) << 16)
+            | depth;
+    }
+
+    __items.push_back({ key, static_cast<uint32_t>(__packets.size()) });
+    __packets.push_back({ &entity, shader, pass, program, materialId, mesh, shader, 0, 0, false, false, false, 0 });
+}
+
+void RenderQueue::Submit()
+{
+    __stats = Stats();
+    __stats.entities = static_cast<int>(__entities.size());
+
+    __visibleEntities.clear();
+    if (mainCamera)
+    {
+        const glm::mat4 viewProjection = mainCamera->GetProjectionMatrix() * mainCamera->GetViewMatrix();
+        __culler.Gather(__entities);
+        __culler.Cull(Frustum(viewProjection), __visibleEntities);
+        __stats.culled = static_cast<int>(__entities.size() - __visibleEntities.size());
+
+        if (__occlusionCulling)
+        {
+            // Occluders outside of the frustum can't hide anything
+            bool hasOccluders = false;
+            __occlusionCuller.Begin(viewProjection);
+            for (Entity * entity : __visibleEntities)
+                hasOccluders |= __occlusionCuller.AddOccluder(*entity);
+            if (hasOccluders)
+            {
+                __occlusionCuller.Rasterize();
+                __stats.occluded = static_cast<int>(__occlusionCuller.Cull(__visibleEntities));
+            }
+        }
+    }
+    else
+        __visibleEntities = __entities;
+    SubsurfaceScattering::BeginFrame();
+    for (Entity * entity : __visibleEntities)
+        AddPackets(*entity);
+
+    __stats.packets = static_cast<int>(__packets.size());
+    __stats.unsorted = CountStateChanges(false);
+    Sort();
+    __stats.sorted = CountStateChanges(true);
+
+    // G-buffer packets come first, shaded all at once by the lighting pass
+    size_t gBufferEnd = 0;
+    while (gBufferEnd < __items.size() && __packets[__items[gBufferEnd].packet].pass == Pass::GBuffer) ++gBufferEnd;
+    __stats.deferred = static_cast<int>(gBufferEnd);
+    if (gBufferEnd)
+    {
+        DeferredRendering::BeginGeometry();
+        SubmitPackets(0, gBufferEnd);
+        DeferredRendering::EndGeometry();
+    }
+
+    // Opaque forward faces follow, then transparent faces & the other passes
+    size_t opaqueEnd = gBufferEnd;
+    while (opaqueEnd < __items.size())
+    {
+        const Packet & packet = __packets[__items[opaqueEnd].packet];
+        if (packet.pass != Pass::Faces || packet.entity->transparent) break;
+        ++opaqueEnd;
+    }
+
+    ReadGpuTimings();
+    FrameTimers & timers = __timers[__currentTimer];
+    const bool timed = opaqueEnd > gBufferEnd && !timers.pending;
+    // GPU occlusion culls the shading batches against the previous frame: an object coming out from
+    // behind another one would get its depth from the pre-pass but no color, so one excludes the other
+    if (__depthPrePass && !(GpuCuller::settings.enabled && GpuCuller::settings.occlusion))
+    {
+        if (timed) timers.prePass.StartTimestamp();
+        SubmitDepthPrePass(gBufferEnd, opaqueEnd);
+        if (timed) timers.prePass.StopTimestamp();
+    }
+    // Opaque faces tag the pixels they cover, the last visible surface wins
+    if (SubsurfaceScattering::IsTagging())
+    {
+        OpenGL_State::SetCapability(GL_STENCIL_TEST, true);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    }
+    if (timed) timers.shading.StartTimestamp();
+    SubmitPackets(gBufferEnd, opaqueEnd);
+    if (timed)
+    {
+        timers.shading.StopTimestamp();
+        timers.pending = true;
+        timers.prePassed = __stats.prePassed > 0;
+        __currentTimer = (__currentTimer + 1) % timersCount;
+    }
+    SubsurfaceScattering::Resolve();
+
+    // Depth tested by the GPU culling of the next frame, opaque surfaces only:
+    // transparent faces & overlays would hide what is seen through them
+    if (mainCamera && GpuCuller::settings.enabled)
+        GpuCuller::CaptureDepth(mainCamera->GetProjectionMatrix() * mainCamera->GetViewMatrix());
+
+    SubmitPackets(opaqueEnd, __items.size());
+    OpenGL_State::DepthFunc(GL_LEQUAL);
+    OpenGL_State::DepthMask(true);
+
+    // Capacity is kept for the next frame
+    __entities.clear();
+    __packets.clear();
+    __items.clear();
+    __programIds.clear();
+    __materialIds.clear();
+    __meshIds.clear();
+}
+
+void RenderQueue::SubmitPackets(size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end;)
+    {
+        Packet & packet = __packets[__items[i].packet];
+        // Depth of pre-passed packets is already written, only the visible pixels pass
+        OpenGL_State::DepthFunc(packet.prePassed ? GL_EQUAL : GL_LEQUAL);
+        OpenGL_State::DepthMask(!packet.prePassed);
+        if (packet.pass == Pass::Faces && SubsurfaceScattering::IsTagging())
+            glStencilFunc(GL_ALWAYS, packet.sssStencil, 0xFF);
+        switch (packet.pass)
+        {
+            case Pass::GBuffer:
+            case Pass::Faces:
+            {
+                size_t batchEnd = i + 1;
+                while (batchEnd < end && CanBatch(packet, __packets[__items[batchEnd].packet])) ++batchEnd;
+                SubmitFaces(i, batchEnd);
+                i = batchEnd;
+                continue;
+            }
+            case Pass::Wireframe:
+                Rendering::DrawWireframe(*packet.entity);
+                break;
+            case Pass::Vertices:
+                Rendering::DrawVertices(*packet.entity);
+                break;
+        }
+        ++__stats.drawCalls;
+        ++i;
+    }
+}
+
+void RenderQueue::SubmitDepthPrePass(size_t begin, size_t end)
+{
+    Shader shader = LightRendering::Get().GetShadowMappingShader();
+    if (!mainCamera || !shader.IsReady()) return;
+
+    shader.Use();
+    // Same matrix as viewProj of the CameraProps block, for depths to be equal
+    shader.SetUniformMatrix4f("lightSpaceMatrix", mainCamera->GetProjectionMatrix() * mainCamera->GetViewMatrix());
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    OpenGL_State::DepthFunc(GL_LEQUAL);
+    OpenGL_State::DepthMask(true);
+    OpenGL_State::PolygonMode(GL_FILL);
+    for (size_t i = begin; i < end; ++i)
+    {
+        Packet & packet = __packets[__items[i].packet];
+        if ((*packet.shader)->GetPrimitiveMode() != GL_TRIANGLES) continue;
+        shader.SetUniformMatrix4f("model", packet.entity->GetModelMatrix());
+        (*packet.entity->GetMesh())->DrawFaces(GL_TRIANGLES);
+        packet.prePassed = true;
+        ++__stats.prePassed;
+    }
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void RenderQueue::ReadGpuTimings()
+{
+    for (FrameTimers & timers : __timers)
+    {
+        // Pre-pass timestamps come before the shading ones
+        if (!timers.pending || !timers.shading.IsResultAvailable()) continue;
+        const float shadingMs = static_cast<float>(timers.shading.GetResult() / 1e6);
+        if (timers.prePassed)
+        {
+            Average(__gpuTimings.prePassMs, static_cast<float>(timers.prePass.GetResult() / 1e6));
+            Average(__gpuTimings.prePassShadingMs, shadingMs);
+        }
+        else
+            Average(__gpuTimings.shadingMs, shadingMs);
+        timers.pending = false;
+    }
+}
+
+const RenderQueue::Stats & RenderQueue::GetLastStats() const
+{
+    return __stats;
+}
+
+const RenderQueue::GpuTimings & RenderQueue::GetGpuTimings() const
+{
+    return __gpuTimings;
+}
+
+void RenderQueue::SetDepthPrePass(bool enabled)
+{
+    __depthPrePass = enabled;
+}
+
+bool RenderQueue::IsDepthPrePassEnabled() const
+{
+    return __depthPrePass;
+}
+
+void RenderQueue::SetOcclusionCulling(bool enabled)
+{
+    __occlusionCulling = enabled;
+}
+
+bool RenderQueue::IsOcclusionCullingEnabled() const
+{
+    return __occlusionCulling;
+}
+
+void RenderQueue::Sort()
+{
+    const size_t count = __items.size();
+    if (count < 2) return;
+
+    // Digits equal in every key don't change the order
+    uint64_t andMask = ~0ull, orMask = 0;
+    for (const SortItem & item : __items)
+    {
+        andMask &= item.key;
+        orMask |= item.key;
+    }
+    const uint64_t varyingBits = andMask ^ orMask;
+
+    __itemsTmp.resize(count);
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        if (((varyingBits >> shift) & 0xFF) == 0) continue;
+
+        std::array<uint32_t, 256> offsets = { 0 };
+        for (const SortItem & item : __items)
+            ++offsets[(item.key >> shift) & 0xFF];
+        uint32_t sum = 0;
+        for (uint32_t & offset : offsets)
+        {
+            const uint32_t digitCount = offset;
+            offset = sum;
+            sum += digitCount;
+        }
+        for (const SortItem & item : __items)
+            __itemsTmp[offsets[(item.key >> shift) & 0xFF]++] = item;
+        __items.swap(__itemsTmp);
+    }
+}
+
+bool RenderQueue::CanBatch(const Packet & first, const Packet & packet)
+{
+    return first.batchable && packet.batchable
+        && packet.pass == first.pass
+        && packet.program == first.program
+        && packet.material == first.material
+        && (packet.mesh == first.mesh || (packet.inArena && first.inArena))
+        && packet.instancedShader.GetShaderDatabaseID() == first.instancedShader.GetShaderDatabaseID()
+        && packet.texture == first.texture
+        && packet.reflection == first.reflection
+        && packet.prePassed == first.prePassed
+        && packet.sssStencil == first.sssStencil;
+}
+
+void RenderQueue::SubmitFaces(size_t begin, size_t end)
+{
+    Packet & first = __packets[__items[begin].packet];
+    if (end - begin > 1 && first.instancedShader.IsReady() && first.instancedShader.SupportsInstancing())
+    {
+        __batch.clear();
+        for (size_t i = begin; i < end; ++i)
+            __batch.push_back(__packets[__items[i].packet].entity);
+        Rendering::DrawFacesBatch(__batch, first.instancedShader);
+
+        ++__stats.drawCalls;
+        ++__stats.batchedDraws;
+        __stats.batchedEntities += static_cast<int>(end - begin);
+        return;
+    }
+
+    // Single entity, or INSTANCED variant still compiling
+    for (size_t i = begin; i < end; ++i)
+    {
+        Packet & packet = __packets[__items[i].packet];
+        Rendering::DrawFaces(*packet.entity, packet.shader);
+        ++__stats.drawCalls;
+    }
+}
+
+RenderQueue::StateChanges RenderQueue::CountStateChanges(bool sorted) const
+{
+    StateChanges changes;
+    const Packet * previous = nullptr;
+    for (size_t i = 0; i < __packets.size(); ++i)
+    {
+        const Packet & packet = sorted ? __packets[__items[i].packet] : __packets[i];
+        if (!previous || previous->program != packet.program) ++changes.programs;
+        if (!previous || previous->material != packet.material) ++changes.materials;
+        if (!previous || previous->mesh != packet.mesh) ++changes.meshes;
+        previous = &packet;
+    }
+    return changes;
+}
+
+uint32_t RenderQueue::DenseId(std::unordered_map<uintptr_t, uint32_t> & ids, uintptr_t value)
+{
+    return ids.emplace(value, static_cast<uint32_t>(ids.size())).first->second;
+}
@@ -0,0 +1,239 @@
+/*****************************************************************//**
+ * \file   RenderQueue.hpp
+ * \brief  Sorted queue of draw packets
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 08 2022
+ *********************************************************************/
+#pragma once
+
+// Project includes
+#include "OGL_Implementation\Entity\Entity.hpp"
+#include "FrustumCuller.hpp"
+#include "OcclusionCuller.hpp"
+#include "OGL_Implementation\OpenGL_Timer.hpp"
+
+// C++ includes
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Collects the draws of a frame as packets with a 64 bits sort key, radix sorts
+ * them, then submits them so that draws sharing a program, material & mesh follow each other.
+ * Key layout (most significant first):
+ * - pass (2 bits): G-buffer faces (DeferredRendering), faces, wireframes, vertices
+ * - translucency (1 bit): opaque first
+ * - opaque: program (16), material (15), mesh (14), depth (16) front to back for early-Z
+ * - transparent: inverted depth (16) back to front, program (16), material (15), mesh (14)
+ * Consecutive opaque faces packets sharing their program & material state are drawn with one
+ * call: a multi-draw-indirect over meshes of the GeometryArena, or an instanced draw of a same mesh.
+ * G-buffer faces are drawn first, then shaded by the deferred lighting pass before the other passes.
+ * With the depth pre-pass, opaque faces are first drawn in the depth buffer only, then shaded
+ * with GL_EQUAL & depth writes off: every visible pixel is shaded once, whatever the draw order.
+ * Opaque forward faces write the stencil value of their entity for the SSS post-process
+ * (SubsurfaceScattering), resolved before transparent faces & the other passes.
+*/
+class RenderQueue
+{
+public:
+    enum class Pass : uint8_t
+    {
+        GBuffer   = 0,
+        Faces     = 1,
+        Wireframe = 2,
+        Vertices  = 3
+    };
+
+    /**
+     * @brief State changes between consecutive packets
+    */
+    struct StateChanges
+    {
+        int programs = 0;
+        int materials = 0;
+        int meshes = 0;
+    };
+
+    /**
+     * @brief Statistics of a submitted frame
+    */
+    struct Stats
+    {
+        /**
+         * @brief Entities added, entities outside of the camera frustum
+         * & entities hidden by occluders
+        */
+        int entities = 0;
+        int culled = 0;
+        int occluded = 0;
+        int packets = 0;
+        /**
+         * @brief Changes in the order draws were added (what immediate drawing costs)
+        */
+        StateChanges unsorted;
+        /**
+         * @brief Changes in the sorted order, as submitted
+        */
+        StateChanges sorted;
+        /**
+         * @brief Draw calls issued, instanced ones included
+        */
+        int drawCalls = 0;
+        /**
+         * @brief Batched draw calls & entities they drew
+        */
+        int batchedDraws = 0;
+        int batchedEntities = 0;
+        /**
+         * @brief Entities drawn in the G-buffer of the deferred path
+        */
+        int deferred = 0;
+        /**
+         * @brief Entities drawn in the depth pre-pass
+        */
+        int prePassed = 0;
+    };
+
+    /**
+     * @brief GPU time of the opaque forward faces, averaged over the frames measured in each mode
+    */
+    struct GpuTimings
+    {
+        /**
+         * @brief With the depth pre-pass: pre-pass & shading
+        */
+        float prePassMs = 0.0f;
+        float prePassShadingMs = 0.0f;
+        /**
+         * @brief Without the depth pre-pass
+        */
+        float shadingMs = 0.0f;
+    };
+
+public:
+    RenderQueue();
+    ~RenderQueue();
+
+    /**
+     * @brief Adds the entity, its packets (according to DisplayMode) are built at Submit if it is visible
+     * @param entity has to stay alive until Submit
+    */
+    void Add(Entity & entity);
+
+    /**
+     * @brief Culls entities against the main camera frustum (then occluders if enabled),
+     * sorts & draws packets of the visible ones, then empties the queue
+    */
+    void Submit();
+
+    /**
+     * @brief Enables the CPU occlusion culling of entities by occluders (see Entity::occluder)
+     * @param enabled
+    */
+    void SetOcclusionCulling(bool enabled);
+    bool IsOcclusionCullingEnabled() const;
+
+    /**
+     * @brief Draws opaque faces in a depth only pre-pass (shadow mapping depth shader with the
+     * camera matrices) before shading them. Faces shaders have to compute gl_Position as
+     * viewProj * model * vec4(aPos, 1.0) & declare it invariant to pass GL_EQUAL.
+     * Skipped while GPU occlusion culling is enabled, it would leave culled objects without color.
+     * @param enabled
+    */
+    void SetDepthPrePass(bool enabled);
+    bool IsDepthPrePassEnabled() const;
+
+    /**
+     * @brief Returns statistics of the last Submit
+     * @return stats
+    */
+    const Stats & GetLastStats() const;
+    const GpuTimings & GetGpuTimings() const;
+
+private:
+    struct Packet
+    {
+        Entity * entity;
+        Shader shader;
+        Pass pass;
+        uint32_t program, material, mesh;
+        /**
+         * @brief Faces only: state not covered by the key, compared before instancing
+        */
+        Shader instancedShader;
+        GLuint texture, reflection;
+        bool batchable, inArena;
+        /**
+         * @brief Depth already written by the pre-pass, shaded with GL_EQUAL
+        */
+        bool prePassed;
+        /**
+         * @brief Faces only: stencil value of the SSS post-process, 0 if the entity isn't tagged
+        */
+        uint8_t sssStencil;
+    };
+
+    /**
+     * @brief Sort entry, packets themselves are not moved
+    */
+    struct SortItem
+    {
+        uint64_t key;
+        uint32_t packet;
+    };
+
+    void AddPackets(Entity & entity);
+    void AddPacket(Entity & entity, Pass pass, const Shader & shader, uintptr_t material, uintptr_t mesh);
+    /**
+     * @brief LSD radix sort on 8 bits digits, skipping digits shared by every key
+    */
+    void Sort();
+    StateChanges CountStateChanges(bool sorted) const;
+    static bool CanBatch(const Packet & first, const Packet & packet);
+    /**
+     * @brief Draws packets [begin, end) of the sorted items
+    */
+    void SubmitPackets(size_t begin, size_t end);
+    /**
+     * @brief Draws packets of faces [begin, end) of the sorted items, batched when possible
+    */
+    void SubmitFaces(size_t begin, size_t end);
+    /**
+     * @brief Draws opaque faces packets [begin, end) of the sorted items in the depth buffer only,
+     * packets with other primitives than triangles (e.g. patches) are left to the main pass
+    */
+    void SubmitDepthPrePass(size_t begin, size_t end);
+    /**
+     * @brief Averages the GPU timings of previous frames which are available
+    */
+    void ReadGpuTimings();
+    static uint32_t DenseId(std::unordered_map<uintptr_t, uint32_t> & ids, uintptr_t value);
+
+private:
+    std::vector<Entity *> __entities, __visibleEntities;
+    FrustumCuller __culler;
+    OcclusionCuller __occlusionCuller;
+    bool __occlusionCulling;
+    std::vector<Packet> __packets;
+    std::vector<SortItem> __items, __itemsTmp;
+    std::vector<Entity *> __batch;
+    /**
+     * @brief Frame local compact ids, so that keys fields stay small
+    */
+    std::unordered_map<uintptr_t, uint32_t> __programIds, __materialIds, __meshIds;
+    Stats __stats;
+
+    bool __depthPrePass;
+    // Opaque faces timings of the previous frames, read back without stalling
+    struct FrameTimers
+    {
+        OpenGL_Timer prePass, shading;
+        bool pending = false, prePassed = false;
+    };
+    static constexpr const size_t timersCount = 3;
+    std::array<FrameTimers, timersCount> __timers;
+    size_t __currentTimer;
+    GpuTimings __gpuTimings;
+};
@@ -9,7 +9,15 @@
 
 // C++ includes
 #include "OGL_Implementation\OpenGL_Timer.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
 #include "OGL_Implementation\Camera.hpp"
+#include "OGL_Implementation\Cubemap\ReflectionProbe.hpp"
+
+// C++ includes
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
 
 // Wireframe/Points Color
 static constexpr const glm::vec3 color = glm::vec3(0.1f, 0.95f, 0.1f);
@@ -29,20 +37,22 @@ RenderingMode DisplayMode = RenderingMode::FacesMode;
 
 Rendering::Rendering()
 	: __textVAO{ 0 }
-	, __textVBO{ 0 }
 	, __cubeVAO{ 0 }
 	, __cubeVBO{ 0 }
 {
-	// Configure VAO/VBO for texture quads
+	// Configure VAO for text quads, streamed by DrawTextBatches (storage allocated on first use)
 	glGenVertexArrays(1, &__textVAO);
-	glGenBuffers(1, &__textVBO);
-	glBindVertexArray(__textVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, __textVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 4 * 4, NULL, GL_DYNAMIC_DRAW);
+	glGenBuffers(1, &__textStream.buffer);
+	OpenGL_State::BindVertexArray(__textVAO);
+	OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __textStream.buffer);
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void *)offsetof(TextVertex, vertex));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void *)offsetof(TextVertex, anchor));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void *)offsetof(TextVertex, color));
+	OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, 0);
+	OpenGL_State::BindVertexArray(0);
 
 	constexpr const float vertices[] = {
             // back face
@@ -91,30 +101,35 @@ Rendering::Rendering()
 	glGenVertexArrays(1, &__cubeVAO);
 	glGenBuffers(1, &__cubeVBO);
 	// fill buffer
-	glBindBuffer(GL_ARRAY_BUFFER, __cubeVBO);
+	OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, __cubeVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 	// link vertex attributes
-	glBindVertexArray(__cubeVAO);
+	OpenGL_State::BindVertexArray(__cubeVAO);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
 	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, 0);
+	OpenGL_State::BindVertexArray(0);
+
+	// Batches data, allocated on first use
+	glGenBuffers(1, &__modelsStream.buffer);
+	glGenBuffers(1, &__commandsStream.buffer);
 }
 
 Rendering::~Rendering()
 {
-	glDeleteVertexArrays(1, &__textVAO);
-	glDeleteBuffers(1, &__textVBO);
-	glDeleteVertexArrays(1, &__cubeVAO);
-	glDeleteBuffers(1, &__cubeVBO);
+	OpenGL_State::DeleteVertexArrays(1, &__textVAO);
+	OpenGL_State::DeleteBuffers(1, &__textStream.buffer);
+	OpenGL_State::DeleteVertexArrays(1, &__cubeVAO);
+	OpenGL_State::DeleteBuffers(1, &__cubeVBO);
+	OpenGL_State::DeleteBuffers(1, &__modelsStream.buffer);
+	OpenGL_State::DeleteBuffers(1, &__commandsStream.buffer);
 }
 
 GLuint Rendering::GetTextVAO() { return __textVAO; }
-GLuint Rendering::GetTextVBO() { return __textVBO; }
 GLuint Rendering::GetCubeVAO() { return __cubeVAO; }
 GLuint Rendering::GetCubeVBO() { return __cubeVBO; }
 
@@ -123,17 +138,79 @@ void Rendering::Init()
 	s_Rendering.reset(new Rendering());
 	LightRendering::Init();
 	ParticleSystemRendering::Init();
+	GpuCuller::Init();
+	LightClusters::Init();
+	DeferredRendering::Init();
+	SubsurfaceScattering::Init();
 	LoadShadersAndFonts();
 }
 
 void Rendering::Refresh()
 {
+	OpenGL_State::NewFrame();
+	for (StreamBuffer * stream : { &s_Rendering->__modelsStream, &s_Rendering->__commandsStream, &s_Rendering->__textStream })
+	{
+		if (stream->capacity) glNamedBufferData(stream->buffer, stream->capacity, NULL, GL_STREAM_DRAW);
+		stream->offset = 0;
+	}
+	GpuCuller::NewFrame();
+	PollShaders();
+	UpdateFonts();
 	LightRendering::RefreshUbo();
+	LightClusters::Update();
+	BindFrameTextures();
+	// Needs lights & shadows of this frame
+	ReflectionProbe::UpdateProbes();
+}
+
+void Rendering::BindFrameTextures()
+{
+	OpenGL_State::BindTextureUnit(Constants::TextureUnits::shadowMaps, LightRendering::Get().GetShadowMaps());
+	OpenGL_State::BindTextureUnit(Constants::TextureUnits::pointShadowMaps, LightRendering::Get().GetPointShadowMaps());
+	if (s_cubemap)
+	{
+		OpenGL_State::BindTextureUnit(Constants::TextureUnits::irradianceMap, s_cubemap->irradianceMap);
+		OpenGL_State::BindTextureUnit(Constants::TextureUnits::prefilterMap, s_cubemap->prefilterMap);
+		OpenGL_State::BindTextureUnit(Constants::TextureUnits::brdfLUT, s_cubemap->brdfLUTTexture);
+	}
+}
+
+static ShaderFeatures GetFaceFeatures(Entity & entity)
+{
+	ShaderFeatures features = entity.shaderFeatures;
+	for (const auto & pair : entity.attributes)
+		features |= pair.second->GetShaderFeatures();
+	return features;
+}
+
+Shader Rendering::ResolveInstancedFaceShader(Entity & entity, bool gBuffer)
+{
+	return entity.GetFaceShader().GetVariant(GetFaceFeatures(entity) | InstancedFeature | (gBuffer ? DeferredFeature : NoShaderFeature));
+}
+
+Shader Rendering::ResolveGBufferShader(Entity & entity)
+{
+	return entity.GetFaceShader().GetVariant(GetFaceFeatures(entity) | DeferredFeature);
+}
+
+Shader Rendering::ResolveFaceShader(Entity & entity)
+{
+	const ShaderFeatures features = GetFaceFeatures(entity);
+
+	// Variant still compiling, drawing with the base or default one meanwhile
+	Shader shader = entity.GetFaceShader().GetVariant(features);
+	if (!shader.IsReady()) shader = entity.GetFaceShader();
+	if (!shader.IsReady()) shader = GetDefaultFaceShader();
+	return shader;
 }
 
 void Rendering::DrawFaces(Entity & entity)
 {
-	Shader & shader = entity.GetFaceShader();
+	DrawFaces(entity, ResolveFaceShader(entity));
+}
+
+void Rendering::DrawFaces(Entity & entity, Shader shader)
+{
 	// Current Heaviest Line
 	const glm::mat4 & model = entity.GetModelMatrix();
 
@@ -144,21 +221,104 @@ void Rendering::DrawFaces(Entity & entity)
 	//glUniformMatrix4fv(id, 1, GL_FALSE, glm::value_ptr(model));
 	shader.SetUniformMatrix4f("model", model);
 
+	(*entity.GetMesh())->DrawFaces(BindFacesState(entity, shader));
+}
+
+void Rendering::DrawFacesBatch(const std::vector<Entity *> & entities, Shader shader)
+{
+	Rendering & rendering = *s_Rendering;
+
+	// Model matrices, read by the INSTANCED variant at gl_BaseInstance + gl_InstanceID
+	rendering.__batchModels.clear();
+	for (Entity * entity : entities)
+		rendering.__batchModels.push_back(entity->GetModelMatrix());
+	const GLintptr modelsOffset = Stream(rendering.__modelsStream, GL_SHADER_STORAGE_BUFFER,
+		rendering.__batchModels.data(), rendering.__batchModels.size() * sizeof(glm::mat4), sizeof(glm::mat4));
+	const GLuint baseInstance = static_cast<GLuint>(modelsOffset / sizeof(glm::mat4));
+	OpenGL_State::BindBufferBase(GL_SHADER_STORAGE_BUFFER, Constants::SSBO::Ids::instanceData, rendering.__modelsStream.buffer);
+
+	const Mesh_Base & firstMesh = **entities.front()->GetMesh();
+	if (!firstMesh.IsInArena())
+	{
+		shader.Use();
+		firstMesh.DrawFaces(BindFacesState(*entities.front(), shader), static_cast<GLsizei>(entities.size()), baseInstance);
+		return;
+	}
+
+	// One command per run of the same mesh
+	rendering.__batchCommands.clear();
+	rendering.__batchInstances.clear();
+	const Mesh_Base * previousMesh = nullptr;
+	for (size_t i = 0; i < entities.size(); ++i)
+	{
+		const BoundingBox & worldBox = entities[i]->GetWorldBoundingBox();
+		rendering.__batchInstances.push_back({ glm::vec4(worldBox.Center(), 0.0f), glm::vec4(worldBox.Extents(), 0.0f),
+			static_cast<GLuint>(rendering.__batchCommands.size()), baseInstance + static_cast<GLuint>(i), { 0, 0 } });
+
+		const Mesh_Base * mesh = *entities[i]->GetMesh();
+		if (mesh == previousMesh)
+		{
+			--rendering.__batchInstances.back().command;
+			++rendering.__batchCommands.back().instanceCount;
+			continue;
+		}
+		const GeometryArena::Allocation & allocation = mesh->GetArenaAllocation();
+		rendering.__batchCommands.push_back({ allocation.indexCount, 1, allocation.firstIndex,
+			static_cast<GLint>(allocation.baseVertex), baseInstance + static_cast<GLuint>(i) });
+		previousMesh = mesh;
+	}
+
+	// Culled & compacted on the GPU, before binding the shader (compute passes change the program)
+	if (GpuCuller::settings.enabled && mainCamera
+		&& GpuCuller::CullBatch(rendering.__batchInstances, rendering.__batchCommands, rendering.__modelsStream.buffer,
+			mainCamera->GetProjectionMatrix() * mainCamera->GetViewMatrix()))
+	{
+		shader.Use();
+		GpuCuller::DrawBatch(BindFacesState(*entities.front(), shader));
+		return;
+	}
+
+	shader.Use();
+	const GLenum primitiveMode = BindFacesState(*entities.front(), shader);
+	const GLintptr commandsOffset = Stream(rendering.__commandsStream, GL_DRAW_INDIRECT_BUFFER,
+		rendering.__batchCommands.data(), rendering.__batchCommands.size() * sizeof(DrawElementsIndirectCommand), sizeof(GLuint));
+
+	OpenGL_State::BindVertexArray(GeometryArena::GetVAO());
+	glMultiDrawElementsIndirect(primitiveMode, GL_UNSIGNED_INT, (const GLvoid *)commandsOffset, static_cast<GLsizei>(rendering.__batchCommands.size()), 0);
+}
+
+GLintptr Rendering::Stream(StreamBuffer & stream, GLenum target, const void * data, GLsizeiptr size, GLsizeiptr alignment)
+{
+	GLsizeiptr offset = (stream.offset + alignment - 1) / alignment * alignment;
+
+	OpenGL_State::BindBuffer(target, stream.buffer);
+	if (offset + size > stream.capacity)
+	{
+		// Orphans the storage, draws already issued keep reading the old one
+		stream.capacity = std::max(stream.capacity * 2, size);
+		glBufferData(target, stream.capacity, NULL, GL_STREAM_DRAW);
+		offset = 0;
+	}
+	// Storage is orphaned every frame (see Refresh), the range can't be in use
+	void * destination = glMapBufferRange(target, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	memcpy(destination, data, size);
+	glUnmapBuffer(target);
+	stream.offset = offset + size;
+	return offset;
+}
+
+GLenum Rendering::BindFacesState(Entity & entity, Shader & shader)
+{
 	if ((*entity.GetMesh())->HasTextureCoordinates() && entity.GetTexture().GetWidth() != 0)
 	{
-		shader.SetUniformInt("_texture", 0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, entity.GetTexture().GetTexture());
+		OpenGL_State::BindTextureUnit(Constants::TextureUnits::texture, entity.GetTexture().GetTexture());
 	}
 	else
 	{
 		shader.SetUniformInt("useTexture", 0);
 	}
 
-	for (const auto & pair : entity.shaderAttributes)
-	{
-		pair.second->Render(pair.first, shader);
-	}
+	entity.UploadShaderAttributes(shader);
 
 	for (const auto & pair : entity.attributes)
 	{
@@ -166,21 +326,19 @@ void Rendering::DrawFaces(Entity & entity)
 		attribute.Render(shader);
 	}
 
-	glBindVertexArray(entity.GetMesh().facesVAO());
+	// Local reflections: closest probe replaces the global prefiltered map (restored otherwise,
+	// filtered by the state cache while consecutive entities use the same map)
+	if (entity.GetPbrMaterial() && s_cubemap)
+	{
+		const ReflectionProbe * probe = ReflectionProbe::FindClosest(entity.GetWorldPosition());
+		OpenGL_State::BindTextureUnit(Constants::TextureUnits::prefilterMap, probe ? probe->GetPrefilterMap() : s_cubemap->prefilterMap);
+	}
+
+	OpenGL_State::PolygonMode(GL_FILL);
 
 	GLenum primitiveMode = (*shader)->GetPrimitiveMode();
 	if (primitiveMode == GL_PATCHES) glPatchParameteri(GL_PATCH_VERTICES, 25);
-
-	switch (entity.GetMesh().GetDrawMode())
-	{
-		case Mesh_Base::DrawMode::DrawElements:
-			glDrawElements(primitiveMode, entity.GetMesh().facesNVert(), GL_UNSIGNED_INT, 0);
-			break;
-		case Mesh_Base::DrawMode::DrawArrays:
-			glDrawArrays(primitiveMode, 0, entity.GetMesh().facesNVert());
-			break;
-	}
-	glBindVertexArray(0);
+	return primitiveMode;
 }
 
 void Rendering::DrawWireframe(Entity & entity)
@@ -195,26 +353,15 @@ void Rendering::DrawWireframe(Entity & entity)
 	// use the same color for all points
 	shader.SetUniformFloat("ourColor", WireframeColors[0]);
 
-	for(const auto & pair : entity.shaderAttributes)
-		pair.second->Render(pair.first, shader);
+	entity.UploadShaderAttributes(shader);
 
-	glBindVertexArray(entity.GetMesh().facesVAO());
-	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	OpenGL_State::PolygonMode(GL_LINE);
 
 	GLenum primitiveMode = (*shader)->GetPrimitiveMode();
 	if (primitiveMode == GL_PATCHES) glPatchParameteri(GL_PATCH_VERTICES, 25);
 
-	switch (entity.GetMesh().GetDrawMode())
-	{
-		case Mesh_Base::DrawMode::DrawElements:
-			glDrawElements(primitiveMode, entity.GetMesh().facesNVert(), GL_UNSIGNED_INT, 0);
-			break;
-		case Mesh_Base::DrawMode::DrawArrays:
-			glDrawArrays(primitiveMode, 0, entity.GetMesh().facesNVert());
-			break;
-	}
-	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-	glBindVertexArray(0);
+	(*entity.GetMesh())->DrawFaces(primitiveMode);
+	// Not restored, every filled draw sets GL_FILL which is filtered when already set
 }
 
 void Rendering::DrawVertices(Entity & entity)
@@ -229,10 +376,9 @@ void Rendering::DrawVertices(Entity & entity)
 	// use the same color for all points
 	shader.SetUniformFloat("ourColor", WireframeColors[0]);
 
-	glBindVertexArray(entity.GetMesh().verticesVAO());
+	OpenGL_State::BindVertexArray(entity.GetMesh().verticesVAO());
 
 	glDrawArrays(GL_POINTS, 0, entity.GetMesh().verticesNVert());
-	glBindVertexArray(0);
 }
 
 void Rendering::DrawEntity(Entity & entity)
@@ -251,11 +397,11 @@ void Rendering::DrawImage(Image2D & image)
 {
 	image.shaderFace.Use();
 
-	glDepthMask(GL_FALSE);
+	OpenGL_State::DepthMask(false);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, image.texture.GetTexture());
-	glBindVertexArray(image.mesh.facesVAO());
+	OpenGL_State::BindTextureUnit(0, image.texture.GetTexture());
+	OpenGL_State::BindVertexArray(image.mesh.facesVAO());
+	OpenGL_State::PolygonMode(GL_FILL);
 
 	const glm::vec2 & wDimensions = mainCamera->GetWindowDimensions();
 
@@ -266,144 +412,129 @@ void Rendering::DrawImage(Image2D & image)
 		{ wDimensions.x, wDimensions.y,   1.0, 1.0 }
 	};
 
-	glBindBuffer(GL_ARRAY_BUFFER, image.mesh.facesVBO());
+	OpenGL_State::BindBuffer(GL_ARRAY_BUFFER, image.mesh.facesVBO());
 	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // Be sure to use glBufferSubData and not glBufferData
 
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
-	glBindVertexArray(0);
-
-	glDepthMask(GL_TRUE);
+	OpenGL_State::DepthMask(true);
 }
 
 void Rendering::DrawText(Text2D & text)
 {
-	text.shader.Use();
-	text.shader.SetUniformFloat("textColor", text.color);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(s_Rendering->GetTextVAO());
-
 	const glm::vec2 & wDimensions = mainCamera->GetWindowDimensions();
+	LayoutText(text.font, text.shader, text.str, text.pos * wDimensions, text.scale, text.centered, glm::vec3(0.0f), text.color);
+}
 
-	// Iterate through all characters
-	const auto & characters = text.font.GetCharacters();
-	GLfloat x = text.pos.x * wDimensions.x, y = text.pos.y * wDimensions.y;
-	GLfloat scale = text.scale / text.font.GetFontSize();
-
-	// Centering text
-	if (text.centered)
+void Rendering::DrawText(Text3D & text)
+{
+	// The billboard keeps the translation of the model matrix only
+	LayoutText(text.font, text.shader, text.str, glm::vec2(0.0f), text.scale, text.centered, glm::vec3(text.GetModelMatrix()[3]), text.color);
+}
+
+/**
+ * @brief Decodes UTF-8, invalid sequences give U+FFFD
+*/
+static std::u32string DecodeUtf8(const std::string & str)
+{
+	std::u32string codepoints;
+	codepoints.reserve(str.size());
+	for (size_t i = 0; i < str.size();)
 	{
-		GLfloat totalW = 0.0f;
-		int i = 0;
-		for (const auto & c : text.str)
+		const unsigned char lead = static_cast<unsigned char>(str[i]);
+		const size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+		char32_t codepoint = length == 1 ? lead : length == 2 ? lead & 0x1F : length == 3 ? lead & 0x0F : lead & 0x07;
+		size_t j = 1;
+		for (; length && j < length && i + j < str.size() && (static_cast<unsigned char>(str[i + j]) & 0xC0) == 0x80; ++j)
+			codepoint = (codepoint << 6) | (str[i + j] & 0x3F);
+		if (length == 0 || j != length)
 		{
-			const Character & ch = *characters.at(c);
-
-			if (i + 1 != text.str.size())
-				totalW += ((ch.GetAdvance() >> 6) * scale);
-			else
-				totalW += (ch.GetSize().x * scale);
-			++i;
+			codepoints.push_back(0xFFFD);
+			i += j;
+			continue;
 		}
-		x -= totalW / 2.0f;
+		codepoints.push_back(codepoint);
+		i += length;
 	}
-
-	for (const auto & c : text.str)
+	return codepoints;
+}
+
+void Rendering::LayoutText(const Font & font, const Shader & shader, const std::string & str, glm::vec2 position,
+	GLfloat scale, bool centered, const glm::vec3 & anchor, const glm::vec3 & color)
+{
+	Rendering & rendering = *s_Rendering;
+	auto batch = std::find_if(rendering.__textBatches.begin(), rendering.__textBatches.end(), [&](const TextBatch & textBatch) {
+		return textBatch.font.GetFontDatabaseID() == font.GetFontDatabaseID() && textBatch.shader.GetShaderDatabaseID() == shader.GetShaderDatabaseID();
+	});
+	if (batch == rendering.__textBatches.end())
 	{
-		const Character & ch = *characters.at(c);
-
-		GLfloat xpos = x + ch.GetBearing().x * scale;
-		GLfloat ypos = y - (ch.GetSize().y - ch.GetBearing().y) * scale;
-
-		GLfloat w = ch.GetSize().x * scale;
-		GLfloat h = ch.GetSize().y * scale;
-		// Update VBO for each character
-		GLfloat vertices[4][4] = {
-			{ xpos,     ypos,       0.0, 0.0 },
-			{ xpos + w, ypos,       1.0, 0.0 },
-			{ xpos,     ypos + h,   0.0, 1.0 },
-			{ xpos + w, ypos + h,   1.0, 1.0 }
-		};
-		// Render glyph texture over quad
-		glBindTexture(GL_TEXTURE_2D, ch.GetTextureID());
-		// Update content of VBO memory
-		glBindBuffer(GL_ARRAY_BUFFER, s_Rendering->GetTextVBO());
-		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // Be sure to use glBufferSubData and not glBufferData
-
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		// Render quad
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4); // GL_TRIANGLE_STRIP vs. GL_TRIANGLES, STRIP has more performance
-		// Now advance cursors for next glyph (note that advance is number of 1/64 pixels)
-		x += (ch.GetAdvance() >> 6) * scale; // Bitshift by 6 to get value in pixels (2^6 = 64 (divide amount of 1/64th pixels by 64 to get amount of pixels))
+		rendering.__textBatches.push_back({ font, shader, {} });
+		batch = rendering.__textBatches.end() - 1;
 	}
-	glBindVertexArray(0);
-	glBindTexture(GL_TEXTURE_2D, 0);
-}
-
-void Rendering::DrawText(Text3D & text)
-{
-	text.shader.Use();
-	text.shader.SetUniformFloat("textColor", text.color);
-
-	text.shader.SetUniformMatrix4f("model", text.GetModelMatrix());
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(s_Rendering->GetTextVAO());
-
-	// Iterate through all characters
-	const auto & characters = text.font.GetCharacters();
-	GLfloat x = 0.0f, y = 0.0f;
-	GLfloat scale = text.scale / text.font.GetFontSize();
+	// Iterate through all characters, the ones not ready yet are queued by the font & skipped
+	std::vector<const Character *> characters;
+	characters.reserve(str.size());
+	for (char32_t c : DecodeUtf8(str))
+		if (const Character * ch = font.GetCharacter(c))
+			characters.push_back(ch);
+	scale /= font.GetFontSize();
 
 	// Centering text
-	if (text.centered)
+	if (centered)
 	{
 		GLfloat totalW = 0.0f;
-		int i = 0;
-		for (const auto & c : text.str)
+		for (size_t i = 0; i < characters.size(); ++i)
 		{
-			const Character & ch = *characters.at(c);
+			const Character & ch = *characters[i];
 
-			if (i + 1 != text.str.size())
+			if (i + 1 != characters.size())
 				totalW += ((ch.GetAdvance() >> 6) * scale);
 			else
 				totalW += (ch.GetSize().x * scale);
-			++i;
 		}
-		x -= totalW / 2.0f;
+		position.x -= totalW / 2.0f;
 	}
 
-	for (const auto & c : text.str)
+	for (const Character * character : characters)
 	{
-		const Character & ch = *characters.at(c);
+		const Character & ch = *character;
 
-		GLfloat xpos = x + ch.GetBearing().x * scale;
-		GLfloat ypos = y - (ch.GetSize().y - ch.GetBearing().y) * scale;
+		GLfloat xpos = position.x + ch.GetBearing().x * scale;
+		GLfloat ypos = position.y - (ch.GetSize().y - ch.GetBearing().y) * scale;
 
 		GLfloat w = ch.GetSize().x * scale;
 		GLfloat h = ch.GetSize().y * scale;
-		// Update VBO for each character
-		GLfloat vertices[4][4] = {
-			{ xpos,     ypos,       0.0, 0.0 },
-			{ xpos + w, ypos,       1.0, 0.0 },
-			{ xpos,     ypos + h,   0.0, 1.0 },
-			{ xpos + w, ypos + h,   1.0, 1.0 }
-		};
-		// Render glyph texture over quad
-		glBindTexture(GL_TEXTURE_2D, ch.GetTextureID());
-		// Update content of VBO memory
-		glBindBuffer(GL_ARRAY_BUFFER, s_Rendering->GetTextVBO());
-		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // Be sure to use glBufferSubData and not glBufferData
-
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		// Render quad
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4); // GL_TRIANGLE_STRIP vs. GL_TRIANGLES, STRIP has more performance
+		// Bitmap rows go down from the top of the glyph, the top of the quad samples the first one
+		const glm::vec4 & rect = ch.GetAtlasRect();
+		const glm::vec4 bottomLeft(xpos, ypos, rect.x, rect.y + rect.w);
+		const glm::vec4 bottomRight(xpos + w, ypos, rect.x + rect.z, rect.y + rect.w);
+		const glm::vec4 topLeft(xpos, ypos + h, rect.x, rect.y);
+		const glm::vec4 topRight(xpos + w, ypos + h, rect.x + rect.z, rect.y);
+		for (const glm::vec4 & vertex : { bottomLeft, bottomRight, topLeft, topLeft, bottomRight, topRight })
+			batch->vertices.push_back({ vertex, anchor, color });
 		// Now advance cursors for next glyph (note that advance is number of 1/64 pixels)
-		x += (ch.GetAdvance() >> 6) * scale; // Bitshift by 6 to get value in pixels (2^6 = 64 (divide amount of 1/64th pixels by 64 to get amount of pixels))
+		position.x += (ch.GetAdvance() >> 6) * scale; // Bitshift by 6 to get value in pixels (2^6 = 64 (divide amount of 1/64th pixels by 64 to get amount of pixels))
+	}
+}
+
+void Rendering::DrawTextBatches()
+{
+	Rendering & rendering = *s_Rendering;
+	OpenGL_State::BindVertexArray(rendering.__textVAO);
+	OpenGL_State::PolygonMode(GL_FILL);
+	for (TextBatch & batch : rendering.__textBatches)
+	{
+		if (batch.vertices.empty()) continue;
+
+		// Aligned on the vertex size, the offset is a first vertex
+		const GLintptr offset = Stream(rendering.__textStream, GL_ARRAY_BUFFER, batch.vertices.data(),
+			batch.vertices.size() * sizeof(TextVertex), sizeof(TextVertex));
+		batch.shader.Use();
+		OpenGL_State::BindTextureUnit(0, batch.font.GetAtlasTexture());
+		glDrawArrays(GL_TRIANGLES, static_cast<GLint>(offset / sizeof(TextVertex)), static_cast<GLsizei>(batch.vertices.size()));
+		batch.vertices.clear();
 	}
-	glBindVertexArray(0);
-	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Rendering::RotateFonts()
@@ -415,8 +546,8 @@ void Rendering::DrawBrdfCubemap(Brdf_Cubemap & cubemap)
 {
 	cubemap.shader.Use();
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap.cubemapTexture);
+	OpenGL_State::BindTextureUnit(0, cubemap.cubemapTexture);
+	OpenGL_State::PolygonMode(GL_FILL);
 	RenderCube();
 }
 
@@ -453,9 +584,15 @@ void Rendering::LoadShadersAndFonts()
 	Shader axisDisplayerShader = GenerateShader(Constants::Paths::axisDisplayerShaderVertex, Constants::Paths::axisDisplayerShaderFrag);
 
 	Shader backgroundShader = GenerateShader(Constants::Paths::backgroundVertex, Constants::Paths::backgroundFrag);
-	backgroundShader.SetUniformInt("environmentMap", 0);
 
 	Shader pbrShader = GenerateShader(Constants::Paths::pbrVertex, Constants::Paths::pbrFrag);
+
+	// Every program is handed to the driver before waiting for any of them
+	SubmitShaders();
+	// Used in place of face shaders still compiling
+	faceShader.WaitUntilReady();
+
+	backgroundShader.SetUniformInt("environmentMap", 0);
 
 	shaders.insert({Constants::Paths::lightShaderVertex,     std::make_unique<Shader>(lightShader)});
 	shaders.insert({Constants::Paths::pointShaderVertex,     std::make_unique<Shader>(pointShader)});
@@ -495,6 +632,8 @@ void Rendering::LoadShadersAndFonts()
 
 	faceShader.AddGlobalUbo(Constants::UBO::Ids::lights, Constants::UBO::Names::lights);
 	pbrShader.AddGlobalUbo(Constants::UBO::Ids::lights, Constants::UBO::Names::lights);
+	pbrShader.AddGlobalUbo(Constants::UBO::Ids::sphericalHarmonics, Constants::UBO::Names::sphericalHarmonics);
+	pbrShader.AddGlobalUbo(Constants::UBO::Ids::entityAttributes, Constants::UBO::Names::entityAttributes);
 
 	text2DShader.AddGlobalUbo(Constants::UBO::Ids::projection, Constants::UBO::Names::projection);
 	text3DShader.AddGlobalUbo(Constants::UBO::Ids::cameraProps, Constants::UBO::Names::cameraProps);
@@ -503,9 +642,8 @@ void Rendering::LoadShadersAndFonts()
 void Rendering::RenderCube()
 {
 	// render Cube
-	glBindVertexArray(s_Rendering->GetCubeVAO());
+	OpenGL_State::BindVertexArray(s_Rendering->GetCubeVAO());
 	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
 }
 
 Shader & Rendering::Shaders(const std::string & str)
@@ -14,6 +14,10 @@
 #include "OGL_Implementation\Cubemap\Brdf_Cubemap.hpp"
 #include "LightRendering.hpp"
 #include "ParticleSystemRendering.hpp"
+#include "GpuCuller.hpp"
+#include "LightClusters.hpp"
+#include "DeferredRendering.hpp"
+#include "SubsurfaceScattering.hpp"
 #include "Constants.hpp"
 
 /**
@@ -26,12 +30,47 @@ public:
     ~Rendering();
 public:
     GLuint GetTextVAO();
-    GLuint GetTextVBO();
     GLuint GetCubeVAO();
     GLuint GetCubeVBO();
 
 private:
-    GLuint __textVAO, __textVBO, __cubeVAO, __cubeVBO;
+    /**
+     * @brief Buffer written sequentially during the frame, orphaned when it begins
+    */
+    struct StreamBuffer
+    {
+        GLuint buffer = 0;
+        GLsizeiptr capacity = 0, offset = 0;
+    };
+
+    /**
+     * @brief Vertex of text quads, 2D texts have no anchor & their position in pixels
+    */
+    struct TextVertex
+    {
+        glm::vec4 vertex; // position relative to the anchor (xy), atlas UV (zw)
+        glm::vec3 anchor; // 3D texts: world position of the billboard
+        glm::vec3 color;
+    };
+    /**
+     * @brief Quads of the texts sharing a font (atlas) & shader, drawn at once
+    */
+    struct TextBatch
+    {
+        Font font;
+        Shader shader;
+        std::vector<TextVertex> vertices;
+    };
+
+    GLuint __textVAO, __cubeVAO, __cubeVBO;
+    /**
+     * @brief Model matrices (InstanceData) & indirect commands of batched draws, quads of texts
+    */
+    StreamBuffer __modelsStream, __commandsStream, __textStream;
+    std::vector<TextBatch> __textBatches;
+    std::vector<glm::mat4> __batchModels;
+    std::vector<DrawElementsIndirectCommand> __batchCommands;
+    std::vector<GpuCuller::Instance> __batchInstances;
 
 public:
     /**
@@ -41,7 +80,43 @@ public:
     static void Refresh();
 
     // Entities
+    /**
+     * @brief Returns the face shader variant matching the entity's features,
+     * or a ready fallback while it compiles
+     * @param entity
+     * @return shader
+    */
+    static Shader ResolveFaceShader(Entity & entity);
+    /**
+     * @brief Returns the INSTANCED variant of the faces shader of the entity, may still be compiling
+     * @param entity
+     * @param gBuffer DEFERRED variant, writing the G-buffer (see DeferredRendering)
+     * @return shader
+    */
+    static Shader ResolveInstancedFaceShader(Entity & entity, bool gBuffer = false);
+    /**
+     * @brief Returns the DEFERRED variant of the faces shader of the entity, writing
+     * the G-buffer (see DeferredRendering), may still be compiling
+     * @param entity
+     * @return shader
+    */
+    static Shader ResolveGBufferShader(Entity & entity);
     static void DrawFaces(Entity & entity);
+    /**
+     * @brief Draws faces with an already resolved shader (see ResolveFaceShader)
+     * @param entity
+     * @param shader
+    */
+    static void DrawFaces(Entity & entity, Shader shader);
+    /**
+     * @brief Draws entities sharing material & shader state with one draw call, the first
+     * entity gives the shared state. Meshes of the GeometryArena are drawn with one
+     * glMultiDrawElementsIndirect, culled on the GPU when GpuCuller is enabled,
+     * other meshes have to be the same for every entity (instanced).
+     * @param entities sorted by mesh
+     * @param shader INSTANCED variant supporting instancing (see Shader_Base::SupportsInstancing)
+    */
+    static void DrawFacesBatch(const std::vector<Entity *> & entities, Shader shader);
     static void DrawWireframe(Entity & entity);
     static void DrawVertices(Entity & entity);
 
@@ -53,8 +128,16 @@ public:
     static void DrawImage(Image2D & image);
 
     // Text
+    /**
+     * @brief Lays out the quads of a text in the batch of its font & shader, drawn by DrawTextBatches
+     * @param text
+    */
     static void DrawText(Text2D & text);
     static void DrawText(Text3D & text);
+    /**
+     * @brief Draws the texts laid out since the last call, one draw call per font & shader
+    */
+    static void DrawTextBatches();
 
     static void RotateFonts();
 
@@ -64,9 +147,37 @@ public:
     // ParticleSystem
     static void DrawParticleSystem(ParticleSystem_Base * particleSystem);
 
+    /**
+     * @brief Draws the unit cube used by cubemap captures
+    */
+    static void RenderCube();
+
 private:
     static void LoadShadersAndFonts();
-    static void RenderCube();
+    /**
+     * @brief Binds textures constant for the frame (IBL & shadow maps) to their reserved units
+    */
+    static void BindFrameTextures();
+    /**
+     * @brief Binds faces state of the entity, except its model matrix & mesh
+     * @param entity
+     * @param shader already in use
+     * @return primitive mode to draw with
+    */
+    static GLenum BindFacesState(Entity & entity, Shader & shader);
+    /**
+     * @brief Appends data to a stream buffer, left bound to target
+     * @return offset of the data in the buffer
+    */
+    static GLintptr Stream(StreamBuffer & stream, GLenum target, const void * data, GLsizeiptr size, GLsizeiptr alignment);
+    /**
+     * @brief Appends the quads of a string (UTF-8) to the batch of its font & shader,
+     * glyphs not rasterized yet are skipped until they are
+     * @param position of the baseline start, relative to the anchor
+     * @param scale size of the glyphs, in units per font size
+    */
+    static void LayoutText(const Font & font, const Shader & shader, const std::string & str, glm::vec2 position,
+        GLfloat scale, bool centered, const glm::vec3 & anchor, const glm::vec3 & color);
 
 public:
     static Shader & Shaders(const std::string & str);
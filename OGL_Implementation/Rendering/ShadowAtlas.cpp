@@ -0,0 +1,175 @@
+/*****************************************************************//**
+ * \file   ShadowAtlas.cpp
+ * \brief  ShadowAtlas source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 12 2022
+ *********************************************************************/
+#include "ShadowAtlas.hpp"
+
+// Project includes
+#include "OGL_Implementation\OpenGL_State.hpp"
+
+bool ShadowAtlas::Tile::IsValid() const
+{
+    return size > 0;
+}
+
+ShadowAtlas::ShadowAtlas()
+    : __texture{ 0 }
+    , __framebuffer{ 0 }
+    , __staticTexture{ 0 }
+    , __staticFramebuffer{ 0 }
+    , __size{ 0 }
+    , __usedArea{ 0 }
+{
+    for (GLuint * framebuffer : { &__framebuffer, &__staticFramebuffer })
+    {
+        glCreateFramebuffers(1, framebuffer);
+        glNamedFramebufferDrawBuffer(*framebuffer, GL_NONE);
+        glNamedFramebufferReadBuffer(*framebuffer, GL_NONE);
+    }
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+    OpenGL_State::DeleteFramebuffers(1, &__framebuffer);
+    OpenGL_State::DeleteFramebuffers(1, &__staticFramebuffer);
+    OpenGL_State::DeleteTextures(1, &__texture);
+    OpenGL_State::DeleteTextures(1, &__staticTexture);
+}
+
+void ShadowAtlas::Resize(int size)
+{
+    OpenGL_State::DeleteTextures(1, &__texture);
+    OpenGL_State::DeleteTextures(1, &__staticTexture);
+    __size = size;
+
+    for (GLuint * texture : { &__texture, &__staticTexture })
+    {
+        glCreateTextures(GL_TEXTURE_2D, 1, texture);
+        glTextureStorage2D(*texture, 1, GL_DEPTH_COMPONENT32F, size, size);
+        glTextureParameteri(*texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(*texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTextureParameteri(*texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(*texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glNamedFramebufferTexture(__framebuffer, GL_DEPTH_ATTACHMENT, __texture, 0);
+    glNamedFramebufferTexture(__staticFramebuffer, GL_DEPTH_ATTACHMENT, __staticTexture, 0);
+
+    Reset();
+}
+
+void ShadowAtlas::Reset()
+{
+    __nodes.clear();
+    __freeChildren.clear();
+    __nodes.push_back({ 0, 0, __size, -1, -1, false });
+    __usedArea = 0;
+}
+
+int ShadowAtlas::Split(int node)
+{
+    int children;
+    if (!__freeChildren.empty())
+    {
+        children = __freeChildren.back();
+        __freeChildren.pop_back();
+    }
+    else
+    {
+        children = static_cast<int>(__nodes.size());
+        __nodes.resize(__nodes.size() + 4);
+    }
+
+    const Node parent = __nodes[node];
+    const int half = parent.size / 2;
+    for (int i = 0; i < 4; ++i)
+        __nodes[children + i] = { parent.x + (i & 1) * half, parent.y + (i >> 1) * half, half, node, -1, false };
+    __nodes[node].children = children;
+    return children;
+}
+
+ShadowAtlas::Tile ShadowAtlas::Allocate(int size)
+{
+    // Smallest free leaf large enough, exact fits avoid splitting larger nodes
+    int best = -1;
+    for (int i = 0; i < static_cast<int>(__nodes.size()); ++i)
+    {
+        const Node & node = __nodes[i];
+        if (node.size == 0 || node.used || node.children != -1 || node.size < size) continue;
+        if (best == -1 || node.size < __nodes[best].size) best = i;
+        if (node.size == size) break;
+    }
+    if (best == -1) return Tile();
+
+    while (__nodes[best].size > size)
+        best = Split(best);
+
+    Node & node = __nodes[best];
+    node.used = true;
+    __usedArea += static_cast<size_t>(size) * size;
+    return { node.x, node.y, node.size, best };
+}
+
+void ShadowAtlas::Free(Tile & tile)
+{
+    if (!tile.IsValid()) return;
+
+    int node = tile.node;
+    __nodes[node].used = false;
+    __usedArea -= static_cast<size_t>(tile.size) * tile.size;
+    tile = Tile();
+
+    // Parents whose 4 children are free leaves become free leaves
+    for (int parent = __nodes[node].parent; parent != -1; parent = __nodes[parent].parent)
+    {
+        const int children = __nodes[parent].children;
+        for (int i = 0; i < 4; ++i)
+        {
+            const Node & child = __nodes[children + i];
+            if (child.used || child.children != -1) return;
+        }
+        for (int i = 0; i < 4; ++i)
+            __nodes[children + i].size = 0;
+        __nodes[parent].children = -1;
+        __freeChildren.push_back(children);
+    }
+}
+
+glm::vec4 ShadowAtlas::GetRect(const Tile & tile) const
+{
+    if (!tile.IsValid()) return glm::vec4(0.0f);
+    return glm::vec4(tile.x, tile.y, tile.size, tile.size) / static_cast<float>(__size);
+}
+
+void ShadowAtlas::CopyStaticTile(const Tile & tile) const
+{
+    glCopyImageSubData(__staticTexture, GL_TEXTURE_2D, 0, tile.x, tile.y, 0,
+        __texture, GL_TEXTURE_2D, 0, tile.x, tile.y, 0, tile.size, tile.size, 1);
+}
+
+GLuint ShadowAtlas::GetTexture() const
+{
+    return __texture;
+}
+
+GLuint ShadowAtlas::GetFramebuffer() const
+{
+    return __framebuffer;
+}
+
+GLuint ShadowAtlas::GetStaticFramebuffer() const
+{
+    return __staticFramebuffer;
+}
+
+int ShadowAtlas::GetSize() const
+{
+    return __size;
+}
+
+size_t ShadowAtlas::GetUsedArea() const
+{
+    return __usedArea;
+}
@@ -0,0 +1,118 @@
+/*****************************************************************//**
+ * \file   ShadowAtlas.hpp
+ * \brief  Shadow maps of every light packed in one depth texture
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 12 2022
+ *********************************************************************/
+#pragma once
+
+// GLAD includes
+#include <GLAD\glad.h>
+
+// GLM includes
+#include <glm\glm.hpp>
+
+// C++ includes
+#include <vector>
+
+/**
+ * @brief Square depth texture subdivided by a quadtree: every node is either a free leaf,
+ * a tile in use or split into 4 children of half its size. Tiles have power of two sizes,
+ * allocating them from the largest to the smallest fills the atlas without gaps.
+ * A second texture with the same layout caches shadow maps of static casters.
+*/
+class ShadowAtlas
+{
+public:
+    /**
+     * @brief Square region of the atlas, invalid when size is 0
+    */
+    struct Tile
+    {
+        int x = 0, y = 0, size = 0;
+        /**
+         * @brief Quadtree node of the tile
+        */
+        int node = -1;
+
+        bool IsValid() const;
+    };
+
+public:
+    ShadowAtlas();
+    ~ShadowAtlas();
+
+    /**
+     * @brief Recreates the texture, every tile is freed
+     * @param size power of two, in texels
+    */
+    void Resize(int size);
+    /**
+     * @brief Frees every tile, keeping the texture
+    */
+    void Reset();
+
+    /**
+     * @brief Takes the smallest free node fitting the tile, splitting it until it has its size
+     * @param size power of two, in texels
+     * @return invalid tile if no free node is large enough
+    */
+    Tile Allocate(int size);
+    /**
+     * @brief Releases a tile, merging free siblings back into their parent
+     * @param tile
+    */
+    void Free(Tile & tile);
+
+    /**
+     * @brief UV offset (xy) & scale (zw) of the tile in the atlas, zero for an invalid tile
+     * @param tile
+     * @return rect
+    */
+    glm::vec4 GetRect(const Tile & tile) const;
+
+    /**
+     * @brief Copies a tile of the static layer to the sampled texture
+     * @param tile
+    */
+    void CopyStaticTile(const Tile & tile) const;
+
+    GLuint GetTexture() const;
+    GLuint GetFramebuffer() const;
+    GLuint GetStaticFramebuffer() const;
+    int GetSize() const;
+    /**
+     * @brief Texels covered by allocated tiles
+    */
+    size_t GetUsedArea() const;
+
+private:
+    struct Node
+    {
+        int x, y, size;
+        int parent;
+        /**
+         * @brief Index of the first of its 4 children, -1 for leaves
+        */
+        int children;
+        bool used;
+    };
+
+    /**
+     * @brief Splits a free leaf into 4 free children
+     * @return index of the first child
+    */
+    int Split(int node);
+
+private:
+    GLuint __texture, __framebuffer;
+    GLuint __staticTexture, __staticFramebuffer;
+    int __size;
+    size_t __usedArea;
+    std::vector<Node> __nodes;
+    /**
+     * @brief Groups of 4 children released by merges, reused by the next splits
+    */
+    std::vector<int> __freeChildren;
+};
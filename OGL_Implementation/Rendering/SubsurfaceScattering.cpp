@@ -0,0 +1,248 @@
+/*****************************************************************//**
+ * \file   SubsurfaceScattering.cpp
+ * \brief  SubsurfaceScattering source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 14 2022
+ *********************************************************************/
+#include "SubsurfaceScattering.hpp"
+
+// Project includes
+#include "Constants.hpp"
+#include "OGL_Implementation\Window.hpp"
+#include "OGL_Implementation\Camera.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
+
+// C++ includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static std::unique_ptr<SubsurfaceScattering> s_subsurfaceScattering;
+
+SubsurfaceScattering::Settings SubsurfaceScattering::settings;
+
+static constexpr const float noDepth = std::numeric_limits<float>::max();
+static const glm::vec4 noRegion(noDepth, noDepth, -noDepth, -noDepth);
+
+SubsurfaceScattering::SubsurfaceScattering()
+    : __downsampleShader{ GenerateShader(Constants::Paths::fullscreenTriangleVertex, Constants::Paths::sssDownsampleFrag) }
+    , __blurShader{ GenerateShader(Constants::Paths::fullscreenTriangleVertex, Constants::Paths::sssBlurFrag) }
+    , __upsampleShader{ GenerateShader(Constants::Paths::fullscreenTriangleVertex, Constants::Paths::sssUpsampleFrag) }
+    , __sceneFramebuffer{ 0 }
+    , __sceneColor{ 0 }
+    , __sceneDepth{ 0 }
+    , __sceneStencil{ 0 }
+    , __downsampleFramebuffer{ 0 }
+    , __blurFramebuffers{ 0 }
+    , __halfColors{ 0 }
+    , __halfDepth{ 0 }
+    , __emptyVAO{ 0 }
+    , __size{ 0 }
+    , __region{ noRegion }
+    , __closestDepth{ noDepth }
+    , __active{ false }
+    , __tagging{ false }
+{
+    __downsampleShader.AddGlobalUbo(Constants::UBO::Ids::cameraProps, Constants::UBO::Names::cameraProps);
+    __upsampleShader.AddGlobalUbo(Constants::UBO::Ids::cameraProps, Constants::UBO::Names::cameraProps);
+
+    glCreateFramebuffers(1, &__sceneFramebuffer);
+    glCreateFramebuffers(1, &__downsampleFramebuffer);
+    glCreateFramebuffers(2, __blurFramebuffers.data());
+    constexpr const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glNamedFramebufferDrawBuffers(__downsampleFramebuffer, 2, drawBuffers);
+    glCreateVertexArrays(1, &__emptyVAO);
+}
+
+SubsurfaceScattering::~SubsurfaceScattering()
+{
+    OpenGL_State::DeleteFramebuffers(1, &__sceneFramebuffer);
+    OpenGL_State::DeleteFramebuffers(1, &__downsampleFramebuffer);
+    OpenGL_State::DeleteFramebuffers(2, __blurFramebuffers.data());
+    OpenGL_State::DeleteTextures(1, &__sceneStencil);
+    OpenGL_State::DeleteTextures(1, &__sceneColor);
+    OpenGL_State::DeleteTextures(1, &__sceneDepth);
+    OpenGL_State::DeleteTextures(2, __halfColors.data());
+    OpenGL_State::DeleteTextures(1, &__halfDepth);
+    OpenGL_State::DeleteVertexArrays(1, &__emptyVAO);
+}
+
+void SubsurfaceScattering::Init()
+{
+    s_subsurfaceScattering.reset(new SubsurfaceScattering());
+}
+
+void SubsurfaceScattering::Resize(int width, int height)
+{
+    // The view goes first, it references the depth/stencil texture
+    OpenGL_State::DeleteTextures(1, &__sceneStencil);
+    OpenGL_State::DeleteTextures(1, &__sceneColor);
+    OpenGL_State::DeleteTextures(1, &__sceneDepth);
+    OpenGL_State::DeleteTextures(2, __halfColors.data());
+    OpenGL_State::DeleteTextures(1, &__halfDepth);
+    __size = glm::ivec2(width, height);
+
+    // Same depth/stencil format as the window (Window::Initialize), blits require it
+    glCreateTextures(GL_TEXTURE_2D, 1, &__sceneColor);
+    glTextureStorage2D(__sceneColor, 1, GL_RGBA8, width, height);
+    glCreateTextures(GL_TEXTURE_2D, 1, &__sceneDepth);
+    glTextureStorage2D(__sceneDepth, 1, GL_DEPTH24_STENCIL8, width, height);
+    // Views need a name which was never bound, hence glGenTextures
+    glGenTextures(1, &__sceneStencil);
+    glTextureView(__sceneStencil, GL_TEXTURE_2D, __sceneDepth, GL_DEPTH24_STENCIL8, 0, 1, 0, 1);
+    glTextureParameteri(__sceneStencil, GL_DEPTH_STENCIL_TEXTURE_MODE, GL_STENCIL_INDEX);
+    glNamedFramebufferTexture(__sceneFramebuffer, GL_COLOR_ATTACHMENT0, __sceneColor, 0);
+    glNamedFramebufferTexture(__sceneFramebuffer, GL_DEPTH_STENCIL_ATTACHMENT, __sceneDepth, 0);
+    // Only read with texelFetch, stencil indices can't be filtered
+    for (GLuint texture : { __sceneColor, __sceneDepth, __sceneStencil })
+    {
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    const glm::ivec2 halfSize = (__size + 1) / 2;
+    glCreateTextures(GL_TEXTURE_2D, 2, __halfColors.data());
+    glCreateTextures(GL_TEXTURE_2D, 1, &__halfDepth);
+    glTextureStorage2D(__halfColors[0], 1, GL_RGBA16F, halfSize.x, halfSize.y);
+    glTextureStorage2D(__halfColors[1], 1, GL_RGBA16F, halfSize.x, halfSize.y);
+    glTextureStorage2D(__halfDepth, 1, GL_R32F, halfSize.x, halfSize.y);
+    // The blur samples between texels
+    for (GLuint texture : { __halfColors[0], __halfColors[1], __halfDepth })
+    {
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    // Downsample: color 0 & depth, horizontal blur: color 0 to 1, vertical blur: color 1 to 0
+    glNamedFramebufferTexture(__downsampleFramebuffer, GL_COLOR_ATTACHMENT0, __halfColors[0], 0);
+    glNamedFramebufferTexture(__downsampleFramebuffer, GL_COLOR_ATTACHMENT1, __halfDepth, 0);
+    glNamedFramebufferTexture(__blurFramebuffers[0], GL_COLOR_ATTACHMENT0, __halfColors[1], 0);
+    glNamedFramebufferTexture(__blurFramebuffers[1], GL_COLOR_ATTACHMENT0, __halfColors[0], 0);
+}
+
+void SubsurfaceScattering::BeginFrame()
+{
+    SubsurfaceScattering & sss = *s_subsurfaceScattering;
+    // Nothing is tagged until the passes are compiled
+    sss.__active = settings.enabled && mainCamera && sss.__downsampleShader.IsReady()
+        && sss.__blurShader.IsReady() && sss.__upsampleShader.IsReady();
+    sss.__tagging = false;
+    sss.__region = noRegion;
+    sss.__closestDepth = noDepth;
+    sss.__stats = Stats();
+}
+
+uint8_t SubsurfaceScattering::Tag(Entity & entity)
+{
+    SubsurfaceScattering & sss = *s_subsurfaceScattering;
+    const float * width = entity.GetShaderAttribute<float>("sssWidth");
+    if (!sss.__active || entity.transparent || !(entity.shaderFeatures & SsssFeature) || !width || *width <= 0.0f)
+        return 0;
+
+    // Screen bounds of the entity, the whole window if it crosses the near plane
+    const BoundingBox & box = entity.GetWorldBoundingBox();
+    const glm::mat4 viewProjection = mainCamera->GetProjectionMatrix() * mainCamera->GetViewMatrix();
+    for (int i = 0; i < 8; ++i)
+    {
+        const glm::vec3 corner(i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z);
+        const glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+        // Also catches boxes without bounds
+        if (!std::isfinite(clip.w) || clip.w <= mainCamera->GetZNear())
+        {
+            sss.__region = glm::vec4(-1.0f, -1.0f, 1.0f, 1.0f);
+            sss.__closestDepth = mainCamera->GetZNear();
+            break;
+        }
+        const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+        sss.__region = glm::vec4(glm::min(glm::vec2(sss.__region), ndc), glm::max(glm::vec2(sss.__region.z, sss.__region.w), ndc));
+        sss.__closestDepth = std::min(sss.__closestDepth, clip.w);
+    }
+
+    sss.__tagging = true;
+    ++sss.__stats.tagged;
+    return static_cast<uint8_t>(std::clamp(std::lround(*width / settings.maxWidth * 255.0f), 1l, 255l));
+}
+
+bool SubsurfaceScattering::IsTagging()
+{
+    return s_subsurfaceScattering->__tagging;
+}
+
+void SubsurfaceScattering::Resolve()
+{
+    SubsurfaceScattering & sss = *s_subsurfaceScattering;
+    if (!sss.__tagging) return;
+    sss.__tagging = false;
+    OpenGL_State::SetCapability(GL_STENCIL_TEST, false);
+
+    const glm::ivec2 size(Window::Get()->windowWidth(), Window::Get()->windowHeight());
+    if (size != sss.__size) sss.Resize(size.x, size.y);
+
+    // Blur reach at the closest tagged depth: kernel offsets span [-3, 3] * width / 3 in UV of the projection window
+    const float distanceToProjectionWindow = 1.0f / std::tan(0.5f * glm::radians(mainCamera->GetFov()));
+    const float reach = settings.maxWidth * distanceToProjectionWindow / sss.__closestDepth;
+    // Window pixels, 2 more for the footprint of the upsample, even so that half resolution texels cover the same pixels
+    glm::ivec2 regionMin = glm::ivec2(glm::floor((glm::vec2(sss.__region) * 0.5f + 0.5f - reach) * glm::vec2(size))) - 2;
+    glm::ivec2 regionMax = glm::ivec2(glm::ceil((glm::vec2(sss.__region.z, sss.__region.w) * 0.5f + 0.5f + reach) * glm::vec2(size))) + 2;
+    regionMin = glm::clamp(regionMin / 2 * 2, glm::ivec2(0), size);
+    regionMax = glm::clamp((regionMax + 1) / 2 * 2, glm::ivec2(0), size);
+    sss.__stats.region = glm::max(regionMax - regionMin, glm::ivec2(0));
+    if (sss.__stats.region.x == 0 || sss.__stats.region.y == 0) return;
+    const glm::ivec2 halfMin = regionMin / 2, halfMax = (regionMax + 1) / 2;
+
+    // Region of the window, resolved from its samples (before the scissor test, which applies to blits)
+    glBlitNamedFramebuffer(0, sss.__sceneFramebuffer, regionMin.x, regionMin.y, regionMax.x, regionMax.y,
+        regionMin.x, regionMin.y, regionMax.x, regionMax.y, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+
+    OpenGL_State::SetCapability(GL_BLEND, false);
+    OpenGL_State::SetCapability(GL_DEPTH_TEST, false);
+    OpenGL_State::SetCapability(GL_SCISSOR_TEST, true);
+    OpenGL_State::PolygonMode(GL_FILL);
+    OpenGL_State::BindVertexArray(sss.__emptyVAO);
+    OpenGL_State::BindTextureUnit(Constants::TextureUnits::sssSceneColor, sss.__sceneColor);
+    OpenGL_State::BindTextureUnit(Constants::TextureUnits::sssSceneDepth, sss.__sceneDepth);
+    OpenGL_State::BindTextureUnit(Constants::TextureUnits::sssSceneStencil, sss.__sceneStencil);
+    OpenGL_State::BindTextureUnit(Constants::TextureUnits::sssDepth, sss.__halfDepth);
+
+    // Half resolution passes over the region
+    OpenGL_State::Viewport(0, 0, (size.x + 1) / 2, (size.y + 1) / 2);
+    glScissor(halfMin.x, halfMin.y, halfMax.x - halfMin.x, halfMax.y - halfMin.y);
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, sss.__downsampleFramebuffer);
+    sss.__downsampleShader.Use();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    const glm::vec2 directions[2] = { glm::vec2(1.0f, 0.0f), glm::vec2(0.0f, 1.0f) };
+    sss.__blurShader.Use();
+    sss.__blurShader.SetUniformFloat("sssWidth", settings.maxWidth);
+    sss.__blurShader.SetUniformFloat("fovy", mainCamera->GetFov());
+    for (int i = 0; i < 2; ++i)
+    {
+        OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, sss.__blurFramebuffers[i]);
+        OpenGL_State::BindTextureUnit(Constants::TextureUnits::sssColor, sss.__halfColors[i]);
+        sss.__blurShader.SetUniformFloat("direction", directions[i]);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    // Back to the window, only over tagged pixels
+    OpenGL_State::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    OpenGL_State::Viewport(0, 0, size.x, size.y);
+    glScissor(regionMin.x, regionMin.y, regionMax.x - regionMin.x, regionMax.y - regionMin.y);
+    OpenGL_State::SetCapability(GL_STENCIL_TEST, true);
+    glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    OpenGL_State::BindTextureUnit(Constants::TextureUnits::sssColor, sss.__halfColors[0]);
+    sss.__upsampleShader.Use();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    OpenGL_State::SetCapability(GL_STENCIL_TEST, false);
+    OpenGL_State::SetCapability(GL_SCISSOR_TEST, false);
+    OpenGL_State::SetCapability(GL_DEPTH_TEST, true);
+    OpenGL_State::SetCapability(GL_BLEND, true);
+}
+
+const SubsurfaceScattering::Stats & SubsurfaceScattering::GetLastStats()
+{
+    return s_subsurfaceScattering->__stats;
+}
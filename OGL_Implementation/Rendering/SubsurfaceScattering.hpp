@@ -0,0 +1,123 @@
+/*****************************************************************//**
+ * \file   SubsurfaceScattering.hpp
+ * \brief  Separable screen-space subsurface scattering, half resolution post-process
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 14 2022
+ *********************************************************************/
+#pragma once
+
+// Project includes
+#include "OGL_Implementation\Entity\Entity.hpp"
+#include "OGL_Implementation\Shader\Shader.hpp"
+
+// GLAD includes
+#include <GLAD\glad.h>
+
+// GLM includes
+#include <glm\glm.hpp>
+
+// C++ includes
+#include <array>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief Reflectance blur of skin (SeparableSSS.h) as a post-process over the opaque forward faces,
+ * instead of per fragment work in the lit draws. Opaque faces write a stencil value in the window
+ * framebuffer: the SSS width of their entity (SSSS feature) quantized over [0, maxWidth], 0 for
+ * the others, so the last visible surface wins. Resolve then copies the screen rectangle covering
+ * the tagged entities (grown by the blur reach), downsamples it to half resolution (linear HDR
+ * color, strength, linear depth), blurs it horizontally then vertically & composites it back
+ * over tagged pixels only (stencil test), weighting the half resolution texels by their depth.
+ * The cost follows the on-screen skin area. Transmittance stays in pbr.frag, it needs the lights.
+*/
+class SubsurfaceScattering
+{
+public:
+    struct Settings
+    {
+        bool enabled = false;
+        /**
+         * @brief Largest SSS width, in world units, stencil values are quantized over [0, maxWidth]
+        */
+        float maxWidth = 0.025f;
+    };
+
+    /**
+     * @brief Statistics of the last resolved frame
+    */
+    struct Stats
+    {
+        int tagged = 0;
+        /**
+         * @brief Size of the rectangle processed, in window pixels
+        */
+        glm::ivec2 region = glm::ivec2(0);
+    };
+
+public:
+    SubsurfaceScattering();
+    ~SubsurfaceScattering();
+
+    static void Init();
+
+    /**
+     * @brief Resets the tagged region, to call before the entities of the frame are tagged
+    */
+    static void BeginFrame();
+    /**
+     * @brief Returns the stencil value the opaque faces of the entity have to write & extends
+     * the tagged region with its bounds
+     * @param entity
+     * @return stencil value, 0 if the entity isn't tagged (disabled, transparent or without SSSS feature)
+    */
+    static uint8_t Tag(Entity & entity);
+    /**
+     * @brief Returns true if entities were tagged since BeginFrame & Resolve hasn't run yet,
+     * opaque faces then have to write their stencil value
+    */
+    static bool IsTagging();
+    /**
+     * @brief Blurs the tagged pixels of the window framebuffer, to call once the opaque faces are drawn
+    */
+    static void Resolve();
+
+    static const Stats & GetLastStats();
+
+    static Settings settings;
+
+private:
+    void Resize(int width, int height);
+
+private:
+    Shader __downsampleShader, __blurShader, __upsampleShader;
+    /**
+     * @brief Copy of the window: color & depth/stencil, stencil read through a view of the latter
+    */
+    GLuint __sceneFramebuffer;
+    GLuint __sceneColor, __sceneDepth, __sceneStencil;
+    /**
+     * @brief Half resolution color ping-pong & linear depth
+    */
+    GLuint __downsampleFramebuffer;
+    std::array<GLuint, 2> __blurFramebuffers;
+    std::array<GLuint, 2> __halfColors;
+    GLuint __halfDepth;
+    /**
+     * @brief Without attributes, the full screen triangle comes from gl_VertexID
+    */
+    GLuint __emptyVAO;
+    glm::ivec2 __size;
+
+    /**
+     * @brief Tagged region in NDC (min xy, max zw) & closest view depth of the tagged entities
+    */
+    glm::vec4 __region;
+    float __closestDepth;
+    /**
+     * @brief Enabled & compiled this frame, entities tagged since BeginFrame
+    */
+    bool __active, __tagging;
+    Stats __stats;
+};
@@ -8,6 +8,29 @@
 #include "Shader.hpp"
 
 static std::vector<std::unique_ptr<Shader_Base>> shaderDB;
+/**
+ * @brief Key = base shader id << 32 | features
+*/
+static std::unordered_map<uint64_t, GLuint> variantDB;
+
+static constexpr const std::pair<ShaderFeature, const char *> shaderFeaturesNames[] = {
+    { ShadowFeature,        "SHADOW" },
+    { SsssFeature,          "SSSS" },
+    { IrradianceSHFeature,  "IRRADIANCE_SH" },
+    { NormalFlatFeature,    "NORMAL_FLAT" },
+    { DiffuseColorFeature,  "DIFFUSE_COLOR" },
+    { SpecularColorFeature, "SPECULAR_COLOR" },
+    { InstancedFeature,     "INSTANCED" },
+    { DeferredFeature,      "DEFERRED" },
+};
+
+ShaderPreprocessor::Defines GetShaderFeaturesDefines(ShaderFeatures features)
+{
+    ShaderPreprocessor::Defines defines;
+    for (const auto & feature : shaderFeaturesNames)
+        if (features & feature.first) defines.push_back({ feature.second, "1" });
+    return defines;
+}
 
 Shader::Shader(const GLuint shaderId)
     : __shaderId{ shaderId }
@@ -24,6 +47,16 @@ void Shader::Use() const
     shaderDB[__shaderId]->Use();
 }
 
+bool Shader::IsReady() const
+{
+    return shaderDB[__shaderId]->IsReady();
+}
+
+void Shader::WaitUntilReady() const
+{
+    shaderDB[__shaderId]->WaitUntilReady();
+}
+
 void Shader::AddGlobalUbo(const GLuint bindingPoint, const char * bindingPointName) const
 {
     shaderDB[__shaderId]->AddGlobalUbo(bindingPoint, bindingPointName);
@@ -34,12 +67,25 @@ GLuint Shader::GetShaderDatabaseID() const
     return __shaderId;
 }
 
-void Shader::SetUniformInt(const GLchar * uniformName, const GLint nb)
+Shader Shader::GetVariant(ShaderFeatures features) const
+{
+    if (features == NoShaderFeature) return *this;
+
+    const uint64_t key = (static_cast<uint64_t>(__shaderId) << 32) | features;
+    const auto it = variantDB.find(key);
+    if (it != variantDB.end()) return Shader(it->second);
+
+    shaderDB.emplace_back(new Shader_Base(*shaderDB[__shaderId], GetShaderFeaturesDefines(features)));
+    variantDB[key] = shaderDB.size() - 1;
+    return Shader(shaderDB.size() - 1);
+}
+
+void Shader::SetUniformInt(const UniformName uniformName, const GLint nb)
 {
     shaderDB[__shaderId]->SetUniformInt(uniformName, nb);
 }
 
-void Shader::SetUniformInt(const GLchar * uniformName, const std::vector<GLint> & nb)
+void Shader::SetUniformInt(const UniformName uniformName, const std::vector<GLint> & nb)
 {
     shaderDB[__shaderId]->SetUniformInt(uniformName, nb);
 }
@@ -62,46 +108,93 @@ Shader GenerateShader(const GLchar * vertexPath, const GLchar * fragmentPath, co
     return Shader(shaderDB.size() - 1);
 }
 
-void Shader::SetUniformFloat(const GLchar * uniformName, const GLfloat nb)
+Shader GenerateShader(const GLchar * computePath)
+{
+    shaderDB.emplace_back(new Shader_Base(computePath));
+    return Shader(shaderDB.size() - 1);
+}
+
+void SubmitShaders()
+{
+    for (const auto & shader : shaderDB)
+        shader->SubmitCompilation();
+}
+
+size_t PollShaders()
+{
+    static size_t lastPendingCount = static_cast<size_t>(-1);
+
+    size_t pendingCount = 0;
+    for (const auto & shader : shaderDB)
+        if (!shader->IsReady()) ++pendingCount;
+
+    // Cache statistics are complete once a batch is done
+    if (pendingCount == 0 && lastPendingCount != 0)
+        Shader_Base::LogProgramCacheStats();
+    lastPendingCount = pendingCount;
+    return pendingCount;
+}
+
+void Shader::SetUniformFloat(const UniformName uniformName, const GLfloat nb)
 {
     shaderDB[__shaderId]->SetUniformFloat(uniformName, nb);
 }
 
-void Shader::SetUniformFloat(const GLchar * uniformName, const glm::vec2 & nbs)
+void Shader::SetUniformFloat(const UniformName uniformName, const glm::vec2 & nbs)
 {
     shaderDB[__shaderId]->SetUniformFloat(uniformName, nbs);
 }
 
-void Shader::SetUniformFloat(const GLchar * uniformName, const GLfloat nb1, const GLfloat nb2)
+void Shader::SetUniformFloat(const UniformName uniformName, const GLfloat nb1, const GLfloat nb2)
 {
     shaderDB[__shaderId]->SetUniformFloat(uniformName, nb1, nb2);
 }
 
-void Shader::SetUniformFloat(const GLchar * uniformName, const glm::vec3 & nbs)
+void Shader::SetUniformFloat(const UniformName uniformName, const glm::vec3 & nbs)
 {
     shaderDB[__shaderId]->SetUniformFloat(uniformName, nbs);
 }
 
-void Shader::SetUniformFloat(const GLchar * uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3)
+void Shader::SetUniformFloat(const UniformName uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3)
 {
     shaderDB[__shaderId]->SetUniformFloat(uniformName, nb1, nb2, nb3);
 }
 
-void Shader::SetUniformFloat(const GLchar * uniformName, const glm::vec4 & nbs)
+void Shader::SetUniformFloat(const UniformName uniformName, const glm::vec4 & nbs)
 {
     shaderDB[__shaderId]->SetUniformFloat(uniformName, nbs);
 }
 
-void Shader::SetUniformFloat(const GLchar * uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3, const GLfloat nb4)
+void Shader::SetUniformFloat(const UniformName uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3, const GLfloat nb4)
 {
     shaderDB[__shaderId]->SetUniformFloat(uniformName, nb1, nb2, nb3, nb4);
 }
 
-void Shader::SetUniformMatrix4f(const GLchar * uniformName, const glm::mat4 & mat)
+void Shader::SetUniformMatrix4f(const UniformName uniformName, const glm::mat4 & mat)
 {
     shaderDB[__shaderId]->SetUniformMatrix4f(uniformName, mat);
 }
 
+void Shader::SetUniformMatrix4f(const UniformName uniformName, const glm::mat4 * mats, const GLsizei count)
+{
+    shaderDB[__shaderId]->SetUniformMatrix4f(uniformName, mats, count);
+}
+
+GLint Shader::GetEntityAttributeOffset(const UniformName uniformName)
+{
+    return shaderDB[__shaderId]->GetEntityAttributeOffset(uniformName);
+}
+
+GLint Shader::GetEntityAttributesSize()
+{
+    return shaderDB[__shaderId]->GetEntityAttributesSize();
+}
+
+bool Shader::SupportsInstancing()
+{
+    return shaderDB[__shaderId]->SupportsInstancing();
+}
+
 Shader_Base * Shader::operator*()
 {
     return shaderDB[__shaderId].get();
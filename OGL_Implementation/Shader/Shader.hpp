@@ -15,6 +15,35 @@
 #include <vector>
 #include <unordered_map>
 
+/**
+ * @brief Features compiled in or out of shaders (shader variants), each one
+ * is given to GLSL as a #define of the name in comment.
+*/
+enum ShaderFeature : uint32_t
+{
+    NoShaderFeature      = 0,
+    ShadowFeature        = 1 << 0, // SHADOW: shadow maps of point lights are sampled
+    SsssFeature          = 1 << 1, // SSSS: light transmittance through thin parts (SeparableSSS.h)
+    IrradianceSHFeature  = 1 << 2, // IRRADIANCE_SH: diffuse IBL from spherical harmonics
+    NormalFlatFeature    = 1 << 3, // NORMAL_FLAT: faces normals instead of smooth normals
+    DiffuseColorFeature  = 1 << 4, // DIFFUSE_COLOR: material diffuse color instead of texture
+    SpecularColorFeature = 1 << 5, // SPECULAR_COLOR: material specular color instead of texture
+    InstancedFeature     = 1 << 6, // INSTANCED: model matrices read from the InstanceData buffer
+    DeferredFeature      = 1 << 7, // DEFERRED: writes the G-buffer instead of shading (see DeferredRendering)
+};
+
+/**
+ * @brief Bitmask of ShaderFeature
+*/
+using ShaderFeatures = uint32_t;
+
+/**
+ * @brief Returns the #define block of a feature bitmask
+ * @param features
+ * @return defines
+*/
+ShaderPreprocessor::Defines GetShaderFeaturesDefines(ShaderFeatures features);
+
 /**
  * @brief Contains Shader Id and methods related
  * to the shader database.
@@ -36,21 +65,41 @@ public:
 public:
     GLuint Program() const;
     void Use() const;
+    /**
+     * @brief Returns true once compiled & linked, never blocks (see Shader_Base::IsReady)
+     * @return ready
+    */
+    bool IsReady() const;
+    void WaitUntilReady() const;
     void AddGlobalUbo(const GLuint bindingPoint, const char * bindingPointName) const;
     GLuint GetShaderDatabaseID() const;
 
-    void SetUniformInt(const GLchar * uniformName, const GLint nb);
-    void SetUniformInt(const GLchar * uniformName, const std::vector<GLint> & nb);
+    /**
+     * @brief Returns the variant of this shader compiled with the given features,
+     * created (and compiled asynchronously) on first request then cached.
+     * Variants keep the global UBOs of their base shader.
+     * @param features
+     * @return variant, the shader itself if features is NoShaderFeature
+    */
+    Shader GetVariant(ShaderFeatures features) const;
+
+    void SetUniformInt(const UniformName uniformName, const GLint nb);
+    void SetUniformInt(const UniformName uniformName, const std::vector<GLint> & nb);
+
+    void SetUniformFloat(const UniformName uniformName, const GLfloat nb);
+    void SetUniformFloat(const UniformName uniformName, const glm::vec2 & nbs);
+    void SetUniformFloat(const UniformName uniformName, const GLfloat nb1, const GLfloat nb2);
+    void SetUniformFloat(const UniformName uniformName, const glm::vec3 & nbs);
+    void SetUniformFloat(const UniformName uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3);
+    void SetUniformFloat(const UniformName uniformName, const glm::vec4 & nbs);
+    void SetUniformFloat(const UniformName uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3, const GLfloat nb4);
 
-    void SetUniformFloat(const GLchar * uniformName, const GLfloat nb);
-    void SetUniformFloat(const GLchar * uniformName, const glm::vec2 & nbs);
-    void SetUniformFloat(const GLchar * uniformName, const GLfloat nb1, const GLfloat nb2);
-    void SetUniformFloat(const GLchar * uniformName, const glm::vec3 & nbs);
-    void SetUniformFloat(const GLchar * uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3);
-    void SetUniformFloat(const GLchar * uniformName, const glm::vec4 & nbs);
-    void SetUniformFloat(const GLchar * uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3, const GLfloat nb4);
+    void SetUniformMatrix4f(const UniformName uniformName, const glm::mat4 & mat);
+    void SetUniformMatrix4f(const UniformName uniformName, const glm::mat4 * mats, const GLsizei count);
 
-    void SetUniformMatrix4f(const GLchar * uniformName, const glm::mat4 & mat);
+    GLint GetEntityAttributeOffset(const UniformName uniformName);
+    GLint GetEntityAttributesSize();
+    bool SupportsInstancing();
 
     Shader_Base * operator*();
     const Shader_Base * operator*() const;
@@ -74,6 +123,12 @@ Shader GenerateShader(const GLchar * vertexPath, const GLchar * fragmentPath);
 */
 Shader GenerateShader(const GLchar * vertexPath, const GLchar * fragmentPath, const GLchar * geometryPath);
 
+/*
+ * @brief Generates compute shader from a GLSL file
+ * @param Compute Path
+*/
+Shader GenerateShader(const GLchar * computePath);
+
 /*
  * @brief Generates shader from GLSL files
  * @param Vertex Path
@@ -82,3 +137,16 @@ Shader GenerateShader(const GLchar * vertexPath, const GLchar * fragmentPath, co
  * @param TES Path
 */
 Shader GenerateShader(const GLchar * vertexPath, const GLchar * fragmentPath, const GLchar * tcsPath, const GLchar * tesPath);
+
+/*
+ * @brief Shaders are generated asynchronously: GenerateShader only starts preprocessing
+ * on worker threads. Submits the compilation of every generated shader to the driver,
+ * without waiting for any of them, to call once a batch of shaders has been generated.
+*/
+void SubmitShaders();
+
+/*
+ * @brief Polls shaders being compiled without blocking, to call once per frame
+ * @return number of shaders still not ready
+*/
+size_t PollShaders();
@@ -0,0 +1,225 @@
+/*****************************************************************//**
+ * \file   ShaderPreprocessor.cpp
+ * \brief  ShaderPreprocessor source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 05 2022
+ *********************************************************************/
+#include "ShaderPreprocessor.hpp"
+
+// Project includes
+#include "OGL_Implementation\DebugInfo\Log.hpp"
+
+// C++ includes
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <format>
+#include <mutex>
+#include <regex>
+#include <stdexcept>
+
+static std::string NormalizePath(const std::string & path)
+{
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+static bool StartsWithDirective(const std::string & line, size_t start, const char * directive)
+{
+    return line.compare(start, strlen(directive), directive) == 0;
+}
+
+ShaderPreprocessor::ShaderPreprocessor()
+{
+}
+
+ShaderPreprocessor & ShaderPreprocessor::Get()
+{
+    static ShaderPreprocessor preprocessor;
+    return preprocessor;
+}
+
+uint64_t ShaderPreprocessor::Hash(const void * data, size_t size, uint64_t hash)
+{
+    const unsigned char * bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+ShaderPreprocessor::Result ShaderPreprocessor::Process(const std::string & path, const Defines & defines)
+{
+    const std::string mainPath = NormalizePath(path);
+
+    // First pass only walks cached files, so that the output is allocated once
+    std::vector<std::string> included;
+    size_t size = ComputeSize(mainPath, included);
+    for (const auto & define : defines)
+        size += define.first.size() + define.second.size() + 10;
+
+    Result result;
+    result.source.reserve(size + included.size() * 32);
+    result.files.reserve(included.size());
+    result.hash = Hash(nullptr, 0);
+    for (const auto & define : defines)
+    {
+        result.hash = Hash(define.first.data(), define.first.size(), result.hash);
+        result.hash = Hash(define.second.data(), define.second.size(), result.hash);
+    }
+
+    result.files.push_back(mainPath);
+    Append(mainPath, &defines, result);
+    return result;
+}
+
+void ShaderPreprocessor::ClearCache()
+{
+    std::unique_lock<std::shared_mutex> lk(__filesMutex);
+    __files.clear();
+}
+
+std::string ShaderPreprocessor::MapLog(const std::string & log, const std::vector<std::string> & files)
+{
+    // NVIDIA: "0(12) : error", AMD/Intel: "ERROR: 0:12: ...", Mesa: "0:12(5): error"
+    static const std::regex sourceNumber(R"((^|\s)(\d+)(?:\((\d+)\)|:(\d+)(?=[:(])))");
+
+    std::string mapped;
+    mapped.reserve(log.size() + files.size() * 32);
+    auto begin = log.cbegin();
+    for (std::sregex_iterator it(log.cbegin(), log.cend(), sourceNumber), end; it != end; ++it)
+    {
+        const std::smatch & match = *it;
+        const size_t index = std::stoul(match[2].str());
+        if (index >= files.size()) continue;
+
+        mapped.append(begin, match[0].first);
+        if (match[3].matched)
+            mapped += std::format("{}{}({})", match[1].str(), files[index], match[3].str());
+        else
+            mapped += std::format("{}{}:{}", match[1].str(), files[index], match[4].str());
+        begin = match[0].second;
+    }
+    mapped.append(begin, log.cend());
+    return mapped;
+}
+
+std::shared_ptr<const ShaderPreprocessor::SourceFile> ShaderPreprocessor::LoadFile(const std::string & path)
+{
+    {
+        std::shared_lock<std::shared_mutex> lk(__filesMutex);
+        auto it = __files.find(path);
+        if (it != __files.end()) return it->second;
+    }
+
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open())
+    {
+        LOG_PRINT(stderr, "ERROR: could not open the shader at: %s\n", path.c_str());
+        throw std::runtime_error("Couldn't open shader file " + path);
+    }
+    const std::string content((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    auto file = std::make_shared<SourceFile>();
+    file->hash = Hash(content.data(), content.size());
+
+    const std::string directory = std::filesystem::path(path).parent_path().generic_string();
+    SourceFile::Chunk chunk;
+    chunk.text.reserve(content.size());
+    size_t lineNumber = 1;
+    for (size_t lineStart = 0; lineStart < content.size(); ++lineNumber)
+    {
+        size_t lineEnd = content.find('\n', lineStart);
+        lineEnd = (lineEnd == std::string::npos) ? content.size() : lineEnd + 1;
+        const std::string line = content.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd;
+
+        const size_t first = line.find_first_not_of(" \t");
+        if (first != std::string::npos && StartsWithDirective(line, first, "#include"))
+        {
+            std::string includePath = line.substr(first + strlen("#include"));
+            includePath.erase(std::remove_if(includePath.begin(), includePath.end(),
+                [](char c) { return c == '"' || c == '<' || c == '>' || c == ' ' || c == '\t' || c == '\r' || c == '\n'; }),
+                includePath.end());
+
+            chunk.include = NormalizePath(directory.empty() ? includePath : directory + '/' + includePath);
+            chunk.nextLine = lineNumber + 1;
+            file->chunks.push_back(std::move(chunk));
+            chunk = SourceFile::Chunk();
+            continue;
+        }
+        if (first != std::string::npos && StartsWithDirective(line, first, "#pragma once"))
+        {
+            // Every file is included once anyway, keeping the line count
+            chunk.text += '\n';
+            continue;
+        }
+
+        chunk.text += line;
+        if (line.back() != '\n') chunk.text += '\n';
+
+        if (file->versionChunk == std::string::npos && first != std::string::npos && StartsWithDirective(line, first, "#version"))
+        {
+            file->versionChunk = file->chunks.size();
+            file->versionOffset = chunk.text.size();
+            file->versionLine = lineNumber;
+        }
+    }
+    file->chunks.push_back(std::move(chunk));
+
+    // Another thread may have loaded it meanwhile, keeping the first one
+    std::unique_lock<std::shared_mutex> lk(__filesMutex);
+    return __files.emplace(path, std::move(file)).first->second;
+}
+
+size_t ShaderPreprocessor::ComputeSize(const std::string & path, std::vector<std::string> & included)
+{
+    included.push_back(path);
+
+    size_t size = 0;
+    for (const auto & chunk : LoadFile(path)->chunks)
+    {
+        size += chunk.text.size();
+        if (!chunk.include.empty() && std::find(included.begin(), included.end(), chunk.include) == included.end())
+            size += ComputeSize(chunk.include, included);
+    }
+    return size;
+}
+
+void ShaderPreprocessor::Append(const std::string & path, const Defines * defines, Result & result)
+{
+    const auto file = LoadFile(path);
+    const size_t sourceNumber = result.files.size() - 1;
+    result.hash = Hash(&file->hash, sizeof(file->hash), result.hash);
+
+    for (size_t i = 0; i < file->chunks.size(); ++i)
+    {
+        const SourceFile::Chunk & chunk = file->chunks[i];
+
+        // #version has to stay the first directive, defines go right after it
+        if (defines && !defines->empty() && (i == file->versionChunk || (i == 0 && file->versionChunk == std::string::npos)))
+        {
+            const size_t offset = (i == file->versionChunk) ? file->versionOffset : 0;
+            result.source.append(chunk.text, 0, offset);
+            for (const auto & define : *defines)
+                result.source += std::format("#define {} {}\n", define.first, define.second);
+            result.source += std::format("#line {} {}\n", (offset ? file->versionLine + 1 : 1), sourceNumber);
+            result.source.append(chunk.text, offset);
+        }
+        else
+            result.source += chunk.text;
+
+        if (chunk.include.empty()) continue;
+
+        if (std::find(result.files.begin(), result.files.end(), chunk.include) == result.files.end())
+        {
+            result.files.push_back(chunk.include);
+            result.source += std::format("#line 1 {}\n", result.files.size() - 1);
+            Append(chunk.include, nullptr, result);
+        }
+        result.source += std::format("#line {} {}\n", chunk.nextLine, sourceNumber);
+    }
+}
@@ -0,0 +1,128 @@
+/*****************************************************************//**
+ * \file   ShaderPreprocessor.hpp
+ * \brief  GLSL preprocessor resolving #include with a source cache
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 05 2022
+ *********************************************************************/
+#pragma once
+
+// C++ includes
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+
+/**
+ * @brief Resolves #include "file" directives of GLSL files (paths relative to the including file).
+ * - Files are read & split once, then kept in a cache shared by every thread.
+ * - Each file is included at most once per shader (#pragma once semantics, the directive is optional).
+ * - #define blocks can be injected right after #version (shader variants).
+ * - #line directives are emitted around includes, so that compile errors can be
+ *   mapped back to the right file with MapLog.
+*/
+class ShaderPreprocessor
+{
+public:
+    /**
+     * @brief Macros injected after #version as '#define name value'
+    */
+    using Defines = std::vector<std::pair<std::string, std::string>>;
+
+    /**
+     * @brief Preprocessed source
+    */
+    struct Result
+    {
+        std::string source;
+        /**
+         * @brief Source string numbers used in #line directives, files[0] is the main file
+        */
+        std::vector<std::string> files;
+        /**
+         * @brief Hash of every file content & defines, stable between launches
+        */
+        uint64_t hash = 0;
+    };
+
+private:
+    ShaderPreprocessor();
+
+public:
+    /**
+     * @brief Returns the preprocessor, creating it if needed
+     * @return preprocessor
+    */
+    static ShaderPreprocessor & Get();
+
+    /**
+     * @brief Preprocesses a shader file, thread-safe
+     * @param path main file
+     * @param defines macros injected after #version
+     * @return result
+     * @throw std::runtime_error if a file can't be read
+    */
+    Result Process(const std::string & path, const Defines & defines = {});
+
+    /**
+     * @brief Forgets cached files (e.g. to reload edited shaders)
+    */
+    void ClearCache();
+
+    /**
+     * @brief Replaces source string numbers of a driver log by file names,
+     * handles "0(12) : error" and "0:12: error" styles.
+     * @param log info log
+     * @param files Result::files
+     * @return mapped log
+    */
+    static std::string MapLog(const std::string & log, const std::vector<std::string> & files);
+
+    /**
+     * @brief FNV-1a 64 bits
+     * @param data
+     * @param size
+     * @param hash previous hash to chain with
+     * @return hash
+    */
+    static uint64_t Hash(const void * data, size_t size, uint64_t hash = 14695981039346656037ull);
+
+private:
+    /**
+     * @brief File split around its #include directives
+    */
+    struct SourceFile
+    {
+        struct Chunk
+        {
+            std::string text;
+            /**
+             * @brief Normalized path of the file included after text, empty if none
+            */
+            std::string include;
+            /**
+             * @brief Line following the #include directive
+            */
+            size_t nextLine = 0;
+        };
+
+        std::vector<Chunk> chunks;
+        /**
+         * @brief Chunk containing #version & offset right after its line (npos if no #version)
+        */
+        size_t versionChunk = std::string::npos;
+        size_t versionOffset = 0;
+        size_t versionLine = 0;
+        uint64_t hash = 0;
+    };
+
+    std::shared_ptr<const SourceFile> LoadFile(const std::string & path);
+    size_t ComputeSize(const std::string & path, std::vector<std::string> & included);
+    void Append(const std::string & path, const Defines * defines, Result & result);
+
+private:
+    std::shared_mutex __filesMutex;
+    std::unordered_map<std::string, std::shared_ptr<const SourceFile>> __files;
+};
@@ -11,224 +11,610 @@
 #include <glm\gtc\type_ptr.hpp>
 
 // Project includes
+#include "Constants.hpp"
 #include "OGL_Implementation\DebugInfo\Log.hpp"
-#include "Shadinclude.hpp"
+#include "OGL_Implementation\Tools\ThreadPool.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
+#include "ShaderPreprocessor.hpp"
+
+// C++ includes
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <vector>
+
+static Shader_Base::ProgramCacheStats programCacheStats;
 
 /**
- * @brief Program memory for Use() because it is a heavy process
+ * @brief Sampler uniform & its reserved texture unit
 */
-static GLuint programUsed = -1;
+struct SamplerUnit
+{
+	UniformName name;
+	GLuint unit;
+};
+
+/**
+ * @brief Samplers set once when programs are linked, never per draw
+*/
+static constexpr const SamplerUnit samplerUnits[] = {
+	{ "_texture",                 Constants::TextureUnits::texture },
+	{ "material.diffuseTexture",  Constants::TextureUnits::diffuseTexture },
+	{ "material.specularTexture", Constants::TextureUnits::specularTexture },
+	{ "albedoMap",                Constants::TextureUnits::albedoMap },
+	{ "normalMap",                Constants::TextureUnits::normalMap },
+	{ "metallicMap",              Constants::TextureUnits::metallicMap },
+	{ "roughnessMap",             Constants::TextureUnits::roughnessMap },
+	{ "aoMap",                    Constants::TextureUnits::aoMap },
+	{ "irradianceMap",            Constants::TextureUnits::irradianceMap },
+	{ "prefilterMap",             Constants::TextureUnits::prefilterMap },
+	{ "brdfLUT",                  Constants::TextureUnits::brdfLUT },
+	{ "shadowMaps",               Constants::TextureUnits::shadowMaps },
+	{ "pointShadowMaps",          Constants::TextureUnits::pointShadowMaps },
+	{ "gAlbedo",                  Constants::TextureUnits::gAlbedo },
+	{ "gNormal",                  Constants::TextureUnits::gNormal },
+	{ "gMaterial",                Constants::TextureUnits::gMaterial },
+	{ "gLight",                   Constants::TextureUnits::gLight },
+	{ "gDepth",                   Constants::TextureUnits::gDepth },
+	{ "sssSceneColor",            Constants::TextureUnits::sssSceneColor },
+	{ "sssSceneDepth",            Constants::TextureUnits::sssSceneDepth },
+	{ "sssSceneStencil",          Constants::TextureUnits::sssSceneStencil },
+	{ "sssColor",                 Constants::TextureUnits::sssColor },
+	{ "sssDepth",                 Constants::TextureUnits::sssDepth }
+};
+
+/**
+ * @brief Header of a cached program binary file, followed by the binary itself
+*/
+struct ProgramBinaryHeader
+{
+	char     magic[4];
+	uint32_t version;
+	uint64_t hash;
+	GLenum   format;
+	GLint    length;
+	float    compileMs;
+};
+
+static constexpr const char programBinaryMagic[4] = { 'O', 'G', 'P', 'B' };
+static constexpr const uint32_t programBinaryVersion = 1;
+
+/**
+ * @brief Returns true if the driver can give back program binaries
+*/
+static bool IsProgramBinarySupported()
+{
+	static const bool supported = []()
+	{
+		GLint formatsCount = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatsCount);
+		return formatsCount > 0;
+	}();
+	return supported;
+}
+
+/**
+ * @brief Binaries are only valid for the driver that produced them
+*/
+static uint64_t DriverHash()
+{
+	static const uint64_t hash = []()
+	{
+		uint64_t h = ShaderPreprocessor::Hash(nullptr, 0);
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+		{
+			const char * str = reinterpret_cast<const char *>(glGetString(name));
+			if (str) h = ShaderPreprocessor::Hash(str, strlen(str), h);
+		}
+		return h;
+	}();
+	return hash;
+}
+
+/**
+ * @brief GL_KHR_parallel_shader_compile (or its ARB version) lets the driver compile
+ * on its own threads and be polled with GL_COMPLETION_STATUS_KHR
+*/
+static bool IsParallelCompileSupported()
+{
+	return GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+}
+
+static void EnableParallelCompile()
+{
+	static bool enabled = false;
+	if (enabled) return;
+	enabled = true;
+
+	// 0xFFFFFFFF = implementation-specific maximum
+	if (GLAD_GL_KHR_parallel_shader_compile)
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	else if (GLAD_GL_ARB_parallel_shader_compile)
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+}
+
+static float ElapsedMs(const std::chrono::high_resolution_clock::time_point & start)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
 
 Shader_Base::Shader_Base(const GLchar * vertexPath, const GLchar * fragmentPath)
 	: __primitiveMode(GL_TRIANGLES)
+	, __program{ 0 }
+	, __entityAttributesSize{ 0 }
+	, __instancing{ false }
 {
-	GLuint vertexID, fragID;
-	if (!CompileShader(vertexPath,   GL_VERTEX_SHADER, &vertexID) ||
-		!CompileShader(fragmentPath, GL_FRAGMENT_SHADER, &fragID))
+	Build({ { vertexPath,   GL_VERTEX_SHADER },
+	        { fragmentPath, GL_FRAGMENT_SHADER } });
+}
+
+Shader_Base::Shader_Base(const GLchar * vertexPath, const GLchar * fragmentPath, const GLchar * tcsPath, const GLchar * tesPath)
+	: __primitiveMode(GL_PATCHES)
+	, __program{ 0 }
+	, __entityAttributesSize{ 0 }
+	, __instancing{ false }
+{
+	Build({ { vertexPath,   GL_VERTEX_SHADER },
+	        { fragmentPath, GL_FRAGMENT_SHADER },
+	        { tcsPath,      GL_TESS_CONTROL_SHADER },
+	        { tesPath,      GL_TESS_EVALUATION_SHADER } });
+}
+
+Shader_Base::Shader_Base(const GLchar * vertexPath, const GLchar * fragmentPath, const GLchar * geometryPath)
+	: __primitiveMode(GL_TRIANGLES)
+	, __program{ 0 }
+	, __entityAttributesSize{ 0 }
+	, __instancing{ false }
+{
+	Build({ { vertexPath,   GL_VERTEX_SHADER },
+	        { fragmentPath, GL_FRAGMENT_SHADER },
+	        { geometryPath, GL_GEOMETRY_SHADER } });
+}
+
+Shader_Base::Shader_Base(const GLchar * computePath)
+	: __primitiveMode(GL_NONE)
+	, __program{ 0 }
+	, __entityAttributesSize{ 0 }
+	, __instancing{ false }
+{
+	Build({ { computePath, GL_COMPUTE_SHADER } });
+}
+
+Shader_Base::Shader_Base(const Shader_Base & base, const ShaderPreprocessor::Defines & defines)
+	: __primitiveMode(base.__primitiveMode)
+	, __program{ 0 }
+	, __entityAttributesSize{ 0 }
+	, __instancing{ false }
+{
+	__build.start = std::chrono::high_resolution_clock::now();
+	__build.stages = base.__build.stages;
+	__build.globalUbos = base.__build.globalUbos;
+	Preprocess(defines);
+}
+
+Shader_Base::~Shader_Base()
+{
+	for (GLuint id : __build.shaderIds) glDeleteShader(id);
+	OpenGL_State::DeleteProgram(__program);
+}
+
+void Shader_Base::Build(std::initializer_list<Stage> stages)
+{
+	__build.state = BuildState::Preprocessing;
+	__build.start = std::chrono::high_resolution_clock::now();
+	for (const Stage & stage : stages)
+		__build.stages.push_back({ stage.path, stage.type });
+	Preprocess({});
+}
+
+void Shader_Base::Preprocess(const ShaderPreprocessor::Defines & defines)
+{
+	__build.state = BuildState::Preprocessing;
+
+	// 1. Retrieve the source codes on a worker, the cache key is computed on the preprocessed sources
+	__build.sources = ThreadPool::Get().Submit([stages = __build.stages, defines]()
 	{
-		throw std::runtime_error("Couldn't create shader.");
+		PreprocessedSources sources;
+		sources.stages.reserve(stages.size());
+		sources.hash = ShaderPreprocessor::Hash(nullptr, 0);
+		for (const auto & stage : stages)
+		{
+			try
+			{
+				sources.stages.push_back(ShaderPreprocessor::Get().Process(stage.first, defines));
+			} catch (const std::exception & e) {
+				LOG_PRINT(stderr, "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ for %s: %s\n", stage.first.c_str(), e.what());
+				throw std::runtime_error("Couldn't create shader.");
+			}
+			sources.hash = ShaderPreprocessor::Hash(&stage.second, sizeof(stage.second), sources.hash);
+			sources.hash = ShaderPreprocessor::Hash(&sources.stages.back().hash, sizeof(uint64_t), sources.hash);
+		}
+		return sources;
+	});
+}
+
+void Shader_Base::SubmitCompilation() const
+{
+	if (__build.state != BuildState::Preprocessing) return;
+
+	EnableParallelCompile();
+	const PreprocessedSources sources = __build.sources.get();
+	for (const auto & stage : sources.stages)
+		__build.files.push_back(stage.files);
+
+	// 2. Try the program binary cache
+	__build.hash = ShaderPreprocessor::Hash(&sources.hash, sizeof(sources.hash), DriverHash());
+	__build.cachePath = std::format("{}{:016x}.bin", Constants::Paths::shaderCache, __build.hash);
+	float recordedCompileMs = 0.0f;
+	if (IsProgramBinarySupported() && LoadProgramBinary(__build.cachePath, __build.hash, &recordedCompileMs))
+	{
+		const float loadMs = ElapsedMs(__build.start);
+		++programCacheStats.hits;
+		programCacheStats.loadMs += loadMs;
+		programCacheStats.savedMs += recordedCompileMs - loadMs;
+		OnReady();
+		return;
+	}
+
+	// 3. Compile & link without querying any status, so that the driver
+	// can work on every submitted program at once
+	for (size_t i = 0; i < __build.stages.size(); ++i)
+	{
+		const GLchar * shaderCode = sources.stages[i].source.c_str();
+		GLuint shaderID = glCreateShader(__build.stages[i].second);
+		glShaderSource(shaderID, 1, &shaderCode, NULL);
+		glCompileShader(shaderID);
+		__build.shaderIds.push_back(shaderID);
 	}
 
 	__program = glCreateProgram();
-	glAttachShader(__program, vertexID);
-	glAttachShader(__program, fragID);
+	for (GLuint id : __build.shaderIds)
+		glAttachShader(__program, id);
+	if (IsProgramBinarySupported())
+		glProgramParameteri(__program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(__program);
 
-	// Print linking errors if any
+	__build.state = BuildState::Compiling;
+}
+
+bool Shader_Base::IsReady() const
+{
+	switch (__build.state)
+	{
+		case BuildState::Preprocessing:
+			if (__build.sources.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				return false;
+			SubmitCompilation();
+			return IsReady();
+		case BuildState::Compiling:
+		{
+			// Without the extension, any status query waits for the driver
+			if (IsParallelCompileSupported())
+			{
+				GLint completed = GL_FALSE;
+				glGetProgramiv(__program, GL_COMPLETION_STATUS_KHR, &completed);
+				if (!completed) return false;
+			}
+			FinishCompilation();
+			return true;
+		}
+		default:
+			return true;
+	}
+}
+
+void Shader_Base::WaitUntilReady() const
+{
+	SubmitCompilation();
+	if (__build.state == BuildState::Compiling)
+		FinishCompilation();
+}
+
+void Shader_Base::FinishCompilation() const
+{
+	// Print compile errors if any
 	GLint success;
 	GLchar infoLog[512];
+	bool compiled = true;
+	for (size_t i = 0; i < __build.shaderIds.size(); ++i)
+	{
+		glGetShaderiv(__build.shaderIds[i], GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			glGetShaderInfoLog(__build.shaderIds[i], 512, NULL, infoLog);
+			LOG_PRINT(stderr, "ERROR::SHADER::COMPILATION_FAILED for %s:\n%s\n", __build.stages[i].first.c_str(),
+				ShaderPreprocessor::MapLog(infoLog, __build.files[i]).c_str());
+			compiled = false;
+		}
+	}
+	if (!compiled)
+		throw std::runtime_error("Couldn't create shader.");
+
+	// Print linking errors if any
 	glGetProgramiv(__program, GL_LINK_STATUS, &success);
 	if (!success)
 	{
 		glGetProgramInfoLog(__program, 512, NULL, infoLog);
-		LOG_PRINT(stderr, "ERROR::SHADER::PROGRAM::LINKING_FAILED for %s: %s\n", vertexPath, infoLog);
+		LOG_PRINT(stderr, "ERROR::SHADER::PROGRAM::LINKING_FAILED for %s: %s\n", __build.stages.front().first.c_str(), infoLog);
 		throw std::runtime_error("ERROR::SHADER::PROGRAM::LINKING_FAILED");
 	}
 
-	glDeleteShader(vertexID);
-	glDeleteShader(fragID);
+	for (GLuint id : __build.shaderIds)
+		glDeleteShader(id);
+	__build.shaderIds.clear();
+
+	// Includes the time the program waited to be polled
+	const float compileMs = ElapsedMs(__build.start);
+	++programCacheStats.misses;
+	programCacheStats.compileMs += compileMs;
+
+	if (IsProgramBinarySupported())
+		SaveProgramBinary(__build.cachePath, __build.hash, compileMs);
+
+	OnReady();
 }
 
-Shader_Base::Shader_Base(const GLchar * vertexPath, const GLchar * fragmentPath, const GLchar * tcsPath, const GLchar * tesPath)
-	: __primitiveMode(GL_PATCHES)
+void Shader_Base::OnReady() const
 {
-	GLuint vertexID, fragID, tcsID, tesID;
-	if (!CompileShader(vertexPath,   GL_VERTEX_SHADER, &vertexID) ||
-		!CompileShader(fragmentPath, GL_FRAGMENT_SHADER, &fragID) ||
-		!CompileShader(tcsPath,      GL_TESS_CONTROL_SHADER, &tcsID) ||
-		!CompileShader(tesPath,      GL_TESS_EVALUATION_SHADER, &tesID))
+	__build.state = BuildState::Ready;
+	ReflectUniforms();
+	// Blocks can be compiled out of some variants
+	for (const auto & ubo : __build.globalUbos)
+	{
+		const GLuint id = glGetUniformBlockIndex(__program, ubo.second.c_str());
+		if (id != GL_INVALID_INDEX) glUniformBlockBinding(__program, id, ubo.first);
+	}
+	const GLuint instanceBlock = glGetProgramResourceIndex(__program, GL_SHADER_STORAGE_BLOCK, Constants::SSBO::Names::instanceData);
+	__instancing = instanceBlock != GL_INVALID_INDEX;
+	if (__instancing) glShaderStorageBlockBinding(__program, instanceBlock, Constants::SSBO::Ids::instanceData);
+}
+
+void Shader_Base::ReflectUniforms() const
+{
+	GLint count = 0, maxNameLength = 0;
+	glGetProgramInterfaceiv(__program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+	glGetProgramInterfaceiv(__program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+	// Arrays are inserted twice, keeping the load factor under 0.5
+	size_t capacity = 16;
+	while (capacity < static_cast<size_t>(count) * 4) capacity <<= 1;
+	__uniforms.assign(capacity, UniformSlot());
+
+	// Members of the per entity block are kept with their offset (see ShaderAttributeManager)
+	const GLuint entityBlock = glGetProgramResourceIndex(__program, GL_UNIFORM_BLOCK, Constants::UBO::Names::entityAttributes);
+	__entityAttributesSize = 0;
+	if (entityBlock != GL_INVALID_INDEX)
 	{
-		throw std::runtime_error("Couldn't create shader.");
+		const GLenum sizeProperty = GL_BUFFER_DATA_SIZE;
+		glGetProgramResourceiv(__program, GL_UNIFORM_BLOCK, entityBlock, 1, &sizeProperty, 1, NULL, &__entityAttributesSize);
 	}
 
+	std::string name(std::max(maxNameLength, 1), '\0');
+	const GLenum properties[] = { GL_BLOCK_INDEX, GL_LOCATION, GL_OFFSET };
+	for (GLint i = 0; i < count; ++i)
+	{
+		GLint values[3] = { -1, -1, -1 };
+		glGetProgramResourceiv(__program, GL_UNIFORM, i, 3, properties, 3, NULL, values);
+		const bool entityMember = entityBlock != GL_INVALID_INDEX && values[0] == static_cast<GLint>(entityBlock);
+		// Members of other UBOs have no location
+		if (!entityMember && (values[0] != -1 || values[1] == -1)) continue;
+
+		GLsizei length = 0;
+		glGetProgramResourceName(__program, GL_UNIFORM, i, maxNameLength, &length, name.data());
+		const std::string_view view(name.data(), length);
+		const GLint offset = entityMember ? values[2] : -1;
+		const uint64_t hash = UniformName::Hash(view);
+		InsertUniform(hash, values[1], offset);
+		for (const SamplerUnit & sampler : samplerUnits)
+			if (sampler.name.hash == hash) glProgramUniform1i(__program, values[1], sampler.unit);
+		// Arrays are named "array[0]", but set as "array"
+		if (view.ends_with("[0]"))
+			InsertUniform(UniformName::Hash(view.substr(0, view.size() - 3)), values[1], offset);
+	}
+}
+
+void Shader_Base::InsertUniform(uint64_t hash, GLint location, GLint offset) const
+{
+	const size_t mask = __uniforms.size() - 1;
+	size_t i = hash & mask;
+	while (__uniforms[i].hash != 0 && __uniforms[i].hash != hash) i = (i + 1) & mask;
+	__uniforms[i] = { hash, location, offset };
+}
+
+bool Shader_Base::LoadProgramBinary(const std::string & cachePath, uint64_t hash, float * compileMs) const
+{
+	std::ifstream file(cachePath, std::ios::binary);
+	if (!file.is_open()) return false;
+
+	ProgramBinaryHeader header;
+	if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))
+		|| memcmp(header.magic, programBinaryMagic, sizeof(programBinaryMagic)) != 0
+		|| header.version != programBinaryVersion
+		|| header.hash != hash
+		|| header.length <= 0)
+	{
+		return false;
+	}
+
+	std::vector<char> binary(header.length);
+	if (!file.read(binary.data(), header.length)) return false;
+
 	__program = glCreateProgram();
-	glAttachShader(__program, vertexID);
-	glAttachShader(__program, fragID);
-	glAttachShader(__program, tcsID);
-	glAttachShader(__program, tesID);
-	glLinkProgram(__program);
+	glProgramBinary(__program, header.format, binary.data(), header.length);
 
-	// Print linking errors if any
+	// Driver refuses binaries it did not produce (e.g. after an update), we then compile from sources
 	GLint success;
-	GLchar infoLog[512];
 	glGetProgramiv(__program, GL_LINK_STATUS, &success);
 	if (!success)
 	{
-		glGetProgramInfoLog(__program, 512, NULL, infoLog);
-		LOG_PRINT(stderr, "ERROR::SHADER::PROGRAM::LINKING_FAILED: %s\n", infoLog);
-		throw std::runtime_error("ERROR::SHADER::PROGRAM::LINKING_FAILED");
+		LOG_PRINT(stderr, "Program binary '%s' rejected by the driver, compiling from sources\n", cachePath.c_str());
+		OpenGL_State::DeleteProgram(__program);
+		__program = 0;
+		return false;
 	}
 
-	glDeleteShader(vertexID);
-	glDeleteShader(fragID);
-	glDeleteShader(tcsID);
-	glDeleteShader(tesID);
+	*compileMs = header.compileMs;
+	return true;
 }
 
-Shader_Base::Shader_Base(const GLchar * vertexPath, const GLchar * fragmentPath, const GLchar * geometryPath)
-	: __primitiveMode(GL_TRIANGLES)
+void Shader_Base::SaveProgramBinary(const std::string & cachePath, uint64_t hash, float compileMs) const
 {
-	GLuint vertexID, fragID, geometryID;
-	if (!CompileShader(vertexPath, GL_VERTEX_SHADER, &vertexID) ||
-		!CompileShader(fragmentPath, GL_FRAGMENT_SHADER, &fragID) ||
-		!CompileShader(geometryPath, GL_GEOMETRY_SHADER, &geometryID))
-	{
-		throw std::runtime_error("Couldn't create shader.");
-	}
+	GLint length = 0;
+	glGetProgramiv(__program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
 
-	__program = glCreateProgram();
-	glAttachShader(__program, vertexID);
-	glAttachShader(__program, fragID);
-	glAttachShader(__program, geometryID);
-	glLinkProgram(__program);
+	ProgramBinaryHeader header;
+	memcpy(header.magic, programBinaryMagic, sizeof(programBinaryMagic));
+	header.version = programBinaryVersion;
+	header.hash = hash;
+	header.compileMs = compileMs;
 
-	// Print linking errors if any
-	GLint success;
-	GLchar infoLog[512];
-	glGetProgramiv(__program, GL_LINK_STATUS, &success);
-	if (!success)
+	std::vector<char> binary(length);
+	glGetProgramBinary(__program, length, &header.length, &header.format, binary.data());
+	if (header.length <= 0) return;
+
+	std::error_code error;
+	std::filesystem::create_directories(Constants::Paths::shaderCache, error);
+
+	std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
 	{
-		glGetProgramInfoLog(__program, 512, NULL, infoLog);
-		LOG_PRINT(stderr, "ERROR::SHADER::PROGRAM::LINKING_FAILED: %s\n", infoLog);
-		throw std::runtime_error("ERROR::SHADER::PROGRAM::LINKING_FAILED");
+		LOG_PRINT(stderr, "Couldn't write program binary '%s'\n", cachePath.c_str());
+		return;
 	}
-
-	glDeleteShader(vertexID);
-	glDeleteShader(fragID);
-	glDeleteShader(geometryID);
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	file.write(binary.data(), header.length);
 }
 
-Shader_Base::~Shader_Base()
+const Shader_Base::ProgramCacheStats & Shader_Base::GetProgramCacheStats()
 {
-	if (__program == programUsed) programUsed = (GLuint)(-1);
-	glDeleteProgram(__program);
+	return programCacheStats;
 }
 
-bool Shader_Base::CompileShader(const GLchar * shaderPath, const GLenum shaderType, GLuint * shaderID)
+void Shader_Base::LogProgramCacheStats()
 {
-	// 1. Retrieve the vertex/fragment source code from filePath
-	std::string code;
-	try
-	{
-		code = ShadInclude::load(shaderPath);
-	} catch (std::ifstream::failure e) {
-		LOG_PRINT(stderr, "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ for %s: Error code: %d\n", shaderPath, e.code().value());
-		return false;
-	}
-	const GLchar * shaderCode = code.c_str();
-	// 2. Compile shaders
-	GLint success;
-	GLchar infoLog[512];
-	// Vertex Shader
-	*shaderID = glCreateShader(shaderType);
-	glShaderSource(*shaderID, 1, &shaderCode, NULL);
-	glCompileShader(*shaderID);
-	// Print compile errors if any
-	glGetShaderiv(*shaderID, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(*shaderID, 512, NULL, infoLog);
-		LOG_PRINT(stderr, "ERROR::SHADER::COMPILATION_FAILED for %s:\n%s\n", shaderPath, infoLog);
-		return false;
-	}
-	return true;
+	const int total = programCacheStats.hits + programCacheStats.misses;
+	LOG_PRINT(stdout, "Program binary cache: %d/%d hits (%.0f%%), %.1f ms loading, %.1f ms compiling, %.1f ms saved\n",
+		programCacheStats.hits, total,
+		total ? 100.0 * programCacheStats.hits / total : 0.0,
+		programCacheStats.loadMs, programCacheStats.compileMs, programCacheStats.savedMs);
 }
 
 GLuint Shader_Base::Program() const
 {
+	if (__build.state != BuildState::Ready) WaitUntilReady();
 	return __program;
 }
 
 void Shader_Base::Use() const
 {
-	if (programUsed != __program)
-	{
-		programUsed = __program;
-		glUseProgram(__program);
-	}
+	if (__build.state != BuildState::Ready) WaitUntilReady();
+	OpenGL_State::UseProgram(__program);
 }
 
 void Shader_Base::AddGlobalUbo(const GLuint bindingPoint, const char * bindingPointName) const
 {
+	// Kept for variants, applied once linked so no need to wait for it
+	const auto it = std::find_if(__build.globalUbos.begin(), __build.globalUbos.end(),
+		[bindingPointName](const auto & ubo) { return ubo.second == bindingPointName; });
+	if (it != __build.globalUbos.end()) it->first = bindingPoint;
+	else __build.globalUbos.push_back({ bindingPoint, bindingPointName });
+
+	if (__build.state != BuildState::Ready) return;
 	GLuint id = glGetUniformBlockIndex(__program, bindingPointName);
-	glUniformBlockBinding(__program, id, bindingPoint);
+	if (id != GL_INVALID_INDEX) glUniformBlockBinding(__program, id, bindingPoint);
 }
 
-void Shader_Base::SetUniformInt(const GLchar * uniformName, const GLint nb)
+void Shader_Base::SetUniformInt(const UniformName uniformName, const GLint nb)
 {
 	glUniform1i(GetUniformId(uniformName), nb);
 }
 
-void Shader_Base::SetUniformInt(const GLchar * uniformName, const std::vector<GLint> & nb)
+void Shader_Base::SetUniformInt(const UniformName uniformName, const std::vector<GLint> & nb)
 {
 	glUniform1iv(GetUniformId(uniformName), nb.size(), nb.data());
 }
 
-void Shader_Base::SetUniformFloat(const GLchar * uniformName, const GLfloat nb)
+void Shader_Base::SetUniformFloat(const UniformName uniformName, const GLfloat nb)
 {
 	glUniform1f(GetUniformId(uniformName), nb);
 }
 
-void Shader_Base::SetUniformFloat(const GLchar * uniformName, const glm::vec2 & nbs)
+void Shader_Base::SetUniformFloat(const UniformName uniformName, const glm::vec2 & nbs)
 {
 	glUniform2fv(GetUniformId(uniformName), 1, glm::value_ptr(nbs));
 }
 
-void Shader_Base::SetUniformFloat(const GLchar * uniformName, const GLfloat nb1, const GLfloat nb2)
+void Shader_Base::SetUniformFloat(const UniformName uniformName, const GLfloat nb1, const GLfloat nb2)
 {
 	glUniform2f(GetUniformId(uniformName), nb1, nb2);
 }
 
-void Shader_Base::SetUniformFloat(const GLchar * uniformName, const glm::vec3 & nbs)
+void Shader_Base::SetUniformFloat(const UniformName uniformName, const glm::vec3 & nbs)
 {
 	glUniform3fv(GetUniformId(uniformName), 1, glm::value_ptr(nbs));
 }
 
-void Shader_Base::SetUniformFloat(const GLchar * uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3)
+void Shader_Base::SetUniformFloat(const UniformName uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3)
 {
 	glUniform3f(GetUniformId(uniformName), nb1, nb2, nb2);
 }
 
-void Shader_Base::SetUniformFloat(const GLchar * uniformName, const glm::vec4 & nbs)
+void Shader_Base::SetUniformFloat(const UniformName uniformName, const glm::vec4 & nbs)
 {
 	glUniform4fv(GetUniformId(uniformName), 1, glm::value_ptr(nbs));
 }
 
-void Shader_Base::SetUniformFloat(const GLchar * uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3, const GLfloat nb4)
+void Shader_Base::SetUniformFloat(const UniformName uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3, const GLfloat nb4)
 {
 	glUniform4f(GetUniformId(uniformName), nb1, nb2, nb2, nb3);
 }
 
-void Shader_Base::SetUniformMatrix4f(const GLchar * uniformName, const glm::mat4 & mat)
+void Shader_Base::SetUniformMatrix4f(const UniformName uniformName, const glm::mat4 & mat)
 {
 	glUniformMatrix4fv(GetUniformId(uniformName), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
-GLuint Shader_Base::GetUniformId(const GLchar * uniformName)
+void Shader_Base::SetUniformMatrix4f(const UniformName uniformName, const glm::mat4 * mats, const GLsizei count)
+{
+	glUniformMatrix4fv(GetUniformId(uniformName), count, GL_FALSE, glm::value_ptr(*mats));
+}
+
+GLint Shader_Base::GetUniformId(const UniformName uniformName)
+{
+	const UniformSlot * slot = FindUniform(uniformName);
+	return slot ? slot->location : -1;
+}
+
+GLint Shader_Base::GetEntityAttributeOffset(const UniformName uniformName)
+{
+	const UniformSlot * slot = FindUniform(uniformName);
+	return slot ? slot->offset : -1;
+}
+
+GLint Shader_Base::GetEntityAttributesSize()
+{
+	if (__build.state != BuildState::Ready) WaitUntilReady();
+	return __entityAttributesSize;
+}
+
+const Shader_Base::UniformSlot * Shader_Base::FindUniform(const UniformName uniformName)
+{
+	if (__build.state != BuildState::Ready) WaitUntilReady();
+	if (__uniforms.empty()) return nullptr;
+
+	const size_t mask = __uniforms.size() - 1;
+	for (size_t i = uniformName.hash & mask; __uniforms[i].hash != 0; i = (i + 1) & mask)
+		if (__uniforms[i].hash == uniformName.hash) return &__uniforms[i];
+	return nullptr;
+}
+
+bool Shader_Base::SupportsInstancing()
 {
-	if (__uniformIds.contains(uniformName))
-		return __uniformIds.at(uniformName);
-	return __uniformIds[uniformName] = glGetUniformLocation(__program, uniformName);
+	if (__build.state != BuildState::Ready) WaitUntilReady();
+	return __instancing;
 }
 
 GLenum Shader_Base::GetPrimitiveMode() const
@@ -9,6 +9,8 @@
 
 // Project includes
 #include "OGL_Implementation\Mesh\Mesh.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "UniformName.hpp"
 
 // GLAD includes
 #include <glad/glad.h>
@@ -18,7 +20,10 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <chrono>
 #include <functional>
+#include <future>
+#include <initializer_list>
 
 /**
  * @brief Contains the real data of the shader to be
@@ -48,13 +53,44 @@ public:
 	 * @param geometryPath
 	*/
 	Shader_Base(const GLchar * vertexPath, const GLchar * fragmentPath, const GLchar * geometryPath);
+	/**
+	 * @brief Constructs and generates a compute shader
+	 * @param computePath
+	*/
+	Shader_Base(const GLchar * computePath);
+	/**
+	 * @brief Constructs and generates a variant of a shader: same stages, primitive mode
+	 * & global UBOs, with macros injected after #version
+	 * @param base
+	 * @param defines
+	*/
+	Shader_Base(const Shader_Base & base, const ShaderPreprocessor::Defines & defines);
 	~Shader_Base();
 
 	/**
-	 * @brief Uses the current shader
+	 * @brief Uses the current shader, waits for it if it is still compiling
 	*/
 	void Use() const;
 
+	/**
+	 * @brief Polls the shader build without blocking: submits the compilation
+	 * once sources are preprocessed, then checks if the driver is done
+	 * (GL_KHR_parallel_shader_compile, without it the check waits for the driver).
+	 * @return true if the shader can be used
+	*/
+	bool IsReady() const;
+
+	/**
+	 * @brief Blocks until the shader is compiled & linked
+	*/
+	void WaitUntilReady() const;
+
+	/**
+	 * @brief Submits compilation & link of the program to the driver without
+	 * waiting for the result (waits for the preprocessing if needed)
+	*/
+	void SubmitCompilation() const;
+
 	/**
 	 * @brief Returns Shader Program
 	 * @return program
@@ -62,30 +98,133 @@ public:
 	GLuint Program() const;
 
 	/**
-	 * @brief Adds a Global Uniform Buffer Object
+	 * @brief Adds a Global Uniform Buffer Object, applied after linking if the program is not ready
 	 * @param bindingPoint (location)
 	 * @param bindingPointName (name)
 	*/
 	void AddGlobalUbo(const GLuint bindingPoint, const char * bindingPointName) const;
 
-	void SetUniformInt(const GLchar * uniformName, const GLint nb);
-	void SetUniformInt(const GLchar * uniformName, const std::vector<GLint> & nb);
+	void SetUniformInt(const UniformName uniformName, const GLint nb);
+	void SetUniformInt(const UniformName uniformName, const std::vector<GLint> & nb);
 
-	void SetUniformFloat(const GLchar * uniformName, const GLfloat nb);
-	void SetUniformFloat(const GLchar * uniformName, const glm::vec2 & nbs);
-	void SetUniformFloat(const GLchar * uniformName, const GLfloat nb1, const GLfloat nb2);
-	void SetUniformFloat(const GLchar * uniformName, const glm::vec3 & nbs);
-	void SetUniformFloat(const GLchar * uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3);
-	void SetUniformFloat(const GLchar * uniformName, const glm::vec4 & nbs);
-	void SetUniformFloat(const GLchar * uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3, const GLfloat nb4);
+	void SetUniformFloat(const UniformName uniformName, const GLfloat nb);
+	void SetUniformFloat(const UniformName uniformName, const glm::vec2 & nbs);
+	void SetUniformFloat(const UniformName uniformName, const GLfloat nb1, const GLfloat nb2);
+	void SetUniformFloat(const UniformName uniformName, const glm::vec3 & nbs);
+	void SetUniformFloat(const UniformName uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3);
+	void SetUniformFloat(const UniformName uniformName, const glm::vec4 & nbs);
+	void SetUniformFloat(const UniformName uniformName, const GLfloat nb1, const GLfloat nb2, const GLfloat nb3, const GLfloat nb4);
 
-	void SetUniformMatrix4f(const GLchar * uniformName, const glm::mat4 & mat);
+	void SetUniformMatrix4f(const UniformName uniformName, const glm::mat4 & mat);
+	void SetUniformMatrix4f(const UniformName uniformName, const glm::mat4 * mats, const GLsizei count);
 
-	GLuint GetUniformId(const GLchar * uniformName);
+	/**
+	 * @brief Returns uniform location from the table reflected at link time,
+	 * waits for the shader if it is still compiling
+	 * @param uniformName
+	 * @return location, -1 if the uniform isn't active (ignored by glUniform*)
+	*/
+	GLint GetUniformId(const UniformName uniformName);
+	/**
+	 * @brief Returns offset of a member of the EntityAttributes block (std140)
+	 * @param uniformName
+	 * @return offset in bytes, -1 if the block doesn't have this member
+	*/
+	GLint GetEntityAttributeOffset(const UniformName uniformName);
+	/**
+	 * @brief Returns size of the EntityAttributes block
+	 * @return size in bytes, 0 if the shader doesn't declare the block
+	*/
+	GLint GetEntityAttributesSize();
+	/**
+	 * @brief Returns true if the program reads model matrices from the InstanceData buffer
+	 * (INSTANCED variants of shaders supporting it)
+	 * @return instancing support
+	*/
+	bool SupportsInstancing();
 	GLenum GetPrimitiveMode() const;
 
+	/**
+	 * @brief Statistics of the program binary cache since launch
+	*/
+	struct ProgramCacheStats
+	{
+		int hits = 0;
+		int misses = 0;
+		/**
+		 * @brief Time spent loading binaries (hits)
+		*/
+		double loadMs = 0.0;
+		/**
+		 * @brief Time spent compiling & linking from sources (misses)
+		*/
+		double compileMs = 0.0;
+		/**
+		 * @brief Compile times recorded in the loaded binaries minus their loading times
+		*/
+		double savedMs = 0.0;
+	};
+
+	/**
+	 * @brief Returns program binary cache statistics
+	 * @return stats
+	*/
+	static const ProgramCacheStats & GetProgramCacheStats();
+	/**
+	 * @brief Prints program binary cache hit rate and time saved in the log
+	*/
+	static void LogProgramCacheStats();
+
 private:
-	bool CompileShader(const GLchar * shaderPath, const GLenum shaderType, GLuint * shaderID);
+	/**
+	 * @brief Source file & type of one shader stage
+	*/
+	struct Stage
+	{
+		const GLchar * path;
+		GLenum type;
+	};
+
+	/**
+	 * @brief Starts preprocessing stages on a worker thread,
+	 * compilation is submitted by SubmitCompilation.
+	 * @param stages
+	*/
+	void Build(std::initializer_list<Stage> stages);
+	/**
+	 * @brief Starts preprocessing __build.stages on a worker thread
+	 * @param defines
+	*/
+	void Preprocess(const ShaderPreprocessor::Defines & defines);
+	/**
+	 * @brief Checks compile & link status, then stores the program in the binary cache
+	*/
+	void FinishCompilation() const;
+	/**
+	 * @brief Applies what was waiting for the program to be linked
+	*/
+	void OnReady() const;
+	/**
+	 * @brief Fills the uniform table with the active uniforms of the default block,
+	 * samplers with a reserved texture unit (Constants::TextureUnits) are set at the same time
+	*/
+	void ReflectUniforms() const;
+	void InsertUniform(uint64_t hash, GLint location, GLint offset) const;
+	/**
+	 * @brief Tries to create the program from a cached binary
+	 * @param cachePath
+	 * @param hash key of the program
+	 * @param compileMs [out] compile time recorded when the binary was stored
+	 * @return true if the driver accepted the binary
+	*/
+	bool LoadProgramBinary(const std::string & cachePath, uint64_t hash, float * compileMs) const;
+	/**
+	 * @brief Stores linked program in the binary cache
+	 * @param cachePath
+	 * @param hash key of the program
+	 * @param compileMs compile & link time of the program
+	*/
+	void SaveProgramBinary(const std::string & cachePath, uint64_t hash, float compileMs) const;
 
 private:
 	/**
@@ -95,9 +234,70 @@ private:
 	/**
 	 * @brief Shader program id
 	*/
-	GLuint __program;
+	mutable GLuint __program;
+
+	enum class BuildState
+	{
+		Preprocessing,
+		Compiling,
+		Ready
+	};
+
+	/**
+	 * @brief Preprocessed sources of every stage & their hash
+	*/
+	struct PreprocessedSources
+	{
+		std::vector<ShaderPreprocessor::Result> stages;
+		uint64_t hash;
+	};
+
+	/**
+	 * @brief State of a program being built
+	*/
+	struct BuildInfo
+	{
+		BuildState state = BuildState::Preprocessing;
+		std::vector<std::pair<std::string, GLenum>> stages;
+		std::future<PreprocessedSources> sources;
+		std::vector<GLuint> shaderIds;
+		/**
+		 * @brief Files of each stage, to map compile errors
+		*/
+		std::vector<std::vector<std::string>> files;
+		std::chrono::high_resolution_clock::time_point start;
+		uint64_t hash = 0;
+		std::string cachePath;
+		/**
+		 * @brief Global UBOs of the program, kept so that variants inherit them
+		*/
+		std::vector<std::pair<GLuint, std::string>> globalUbos;
+	};
+	mutable BuildInfo __build;
+
+	struct UniformSlot
+	{
+		/**
+		 * @brief UniformName hash, 0 if the slot is empty
+		*/
+		uint64_t hash = 0;
+		GLint location = -1;
+		/**
+		 * @brief Offset in the EntityAttributes block, -1 if not a member
+		*/
+		GLint offset = -1;
+	};
+	/**
+	 * @brief Uniform locations (open addressing, power of 2 size)
+	*/
+	mutable std::vector<UniformSlot> __uniforms;
+	mutable GLint __entityAttributesSize;
+	mutable bool __instancing;
+
 	/**
-	 * @brief Contains uniform ids
+	 * @brief Returns uniform slot, waits for the shader if it is still compiling
+	 * @param uniformName
+	 * @return slot or nullptr
 	*/
-	std::unordered_map<std::string, GLuint> __uniformIds;
+	const UniformSlot * FindUniform(const UniformName uniformName);
 };
\ No newline at end of file
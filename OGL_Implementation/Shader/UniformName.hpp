@@ -0,0 +1,60 @@
+/*****************************************************************//**
+ * \file   UniformName.hpp
+ * \brief  Hashed uniform names
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 06 2022
+ *********************************************************************/
+#pragma once
+
+// C++ includes
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief Uniform name reduced to its hash (FNV-1a 64 bits).
+ * String literals are hashed at compile time, so that setting a uniform
+ * never builds nor hashes a string at runtime.
+ * Runtime names have to be hashed explicitly, ideally once (see ShaderAttribute).
+*/
+class UniformName
+{
+public:
+    /**
+     * @brief Hashes a string literal at compile time
+     * @param name
+    */
+    template<size_t N>
+    consteval UniformName(const char (&name)[N])
+        : hash{ Hash(std::string_view(name, N - 1)) }
+    {
+    }
+
+    /**
+     * @brief Hashes a runtime name
+     * @param name
+    */
+    explicit constexpr UniformName(std::string_view name)
+        : hash{ Hash(name) }
+    {
+    }
+
+    /**
+     * @brief FNV-1a 64 bits, never returns 0 (empty slot of reflected uniform tables)
+     * @param name
+     * @return hash
+    */
+    static constexpr uint64_t Hash(std::string_view name)
+    {
+        uint64_t h = 14695981039346656037ull;
+        for (const char c : name)
+        {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ull;
+        }
+        return h ? h : 1;
+    }
+
+public:
+    uint64_t hash;
+};
@@ -17,9 +17,9 @@ Font::Font(const GLuint fontId)
 {
 }
 
-const std::unordered_map<GLchar, std::unique_ptr<Character>> & Font::GetCharacters() const
+const Character * Font::GetCharacter(char32_t codepoint) const
 {
-    return fontDB[__fontId]->GetCharacters();
+    return fontDB[__fontId]->GetCharacter(codepoint);
 }
 
 GLuint Font::GetFontDatabaseID() const
@@ -32,8 +32,28 @@ FT_UInt Font::GetFontSize() const
     return fontDB[__fontId]->GetFontSize();
 }
 
+GLuint Font::GetAtlasTexture() const
+{
+    return fontDB[__fontId]->GetAtlasTexture();
+}
+
 Font GenerateFont(const char * fontPath)
 {
     fontDB.emplace_back(new Font_Base(fontPath));
     return Font(fontDB.size() - 1);
 }
+
+void UpdateFonts()
+{
+    for (auto & font : fontDB)
+        font->Update();
+}
+
+Font_Base::Stats GetFontStats()
+{
+    Font_Base::Stats stats;
+    for (const auto & font : fontDB)
+        font->AddStats(stats);
+    return stats;
+}
+
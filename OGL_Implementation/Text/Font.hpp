@@ -24,10 +24,11 @@ public:
 
 public:
     /**
-     * @brief Gets characters data (not mutable)
-     * @return characters
+     * @brief Gets a glyph, rasterized on first use (see Font_Base::GetCharacter)
+     * @param codepoint
+     * @return character, nullptr if not ready yet
     */
-    const std::unordered_map<GLchar, std::unique_ptr<Character>> & GetCharacters() const;
+    const Character * GetCharacter(char32_t codepoint) const;
 
     /**
      * @brief Returns Font ID
@@ -41,6 +42,12 @@ public:
     */
     FT_UInt GetFontSize() const;
 
+    /**
+     * @brief Gets the texture where every glyph is packed
+     * @return atlas texture
+    */
+    GLuint GetAtlasTexture() const;
+
 public:
     GLuint __fontId;
 };
@@ -49,4 +56,15 @@ public:
  * @brief Generates font from ttf file
  * @param Font Path
 */
-Font GenerateFont(const char * fontPath);
\ No newline at end of file
+Font GenerateFont(const char * fontPath);
+
+/*
+ * @brief Uploads the glyphs rasterized since last frame, to call once per frame
+*/
+void UpdateFonts();
+
+/*
+ * @brief Sums the statistics of every font
+ * @return stats
+*/
+Font_Base::Stats GetFontStats();
@@ -9,18 +9,70 @@
 
 // Project includes
 #include "OGL_Implementation\DebugInfo\Log.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
+#include "OGL_Implementation\Shader\ShaderPreprocessor.hpp"
+#include "OGL_Implementation\Tools\ThreadPool.hpp"
+#include "Constants.hpp"
+
+// C++ includes
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
 
 static bool FreeTypeInitialized = false;
 static FT_Library ft;
+/**
+ * @brief FreeType is released with the last face
+*/
+static int openFaces = 0;
+/**
+ * @brief Creating & destroying faces isn't thread safe, workers of other fonts may be loading glyphs
+*/
+static std::mutex freeTypeMutex;
 
-Character::Character(const wchar_t character, FT_Face & face, bool & error)
-    : __texture{ 0 }
-    , __error{ true }
+static constexpr const char glyphCacheMagic[4] = { 'O', 'G', 'G', 'C' };
+static constexpr const uint32_t glyphCacheVersion = 1;
+
+/**
+ * @brief Header of a font cache file, followed by the glyphs (entry & bitmap, rows tightly packed)
+*/
+struct GlyphCacheHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint64_t hash;
+    uint32_t count;
+};
+
+struct GlyphCacheEntry
+{
+    uint32_t codepoint;
+    int32_t  width, height;
+    int32_t  bearingX, bearingY;
+    uint32_t advance;
+};
+
+static std::string GlyphCachePath(uint64_t hash)
+{
+    return std::format("{}{:016x}.bin", Constants::Paths::fontCache, hash);
+}
+
+Font_Base::Settings Font_Base::settings;
+
+Character::Character(const char32_t character, FT_Face & face, bool & error)
+    : __atlasRect{ 0.0f }
+    , __size{ 0 }
+    , __bearing{ 0 }
+    , __advance{ 0 }
 {
     error = true;
     if (FT_Load_Char(face, character, FT_LOAD_RENDER))
     {
-        __error = error = false;
+        error = false;
         return;
     }
 
@@ -30,85 +82,81 @@ Character::Character(const wchar_t character, FT_Face & face, bool & error)
     __bearing.y = face->glyph->bitmap_top;
     __advance = face->glyph->advance.x;
 
-    glGenTextures(1, &__texture);
-    glBindTexture(GL_TEXTURE_2D, __texture);
-    glTexImage2D(
-        GL_TEXTURE_2D,
-        0,
-        GL_RED,
-        face->glyph->bitmap.width,
-        face->glyph->bitmap.rows,
-        0,
-        GL_RED,
-        GL_UNSIGNED_BYTE,
-        face->glyph->bitmap.buffer
-    );
-    // Set the texture wrapping parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    // Set texture filtering parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Rows tightly packed, FreeType may pad them (pitch)
+    const FT_Bitmap & bitmap = face->glyph->bitmap;
+    __pixels.resize(static_cast<size_t>(__size.x) * __size.y);
+    for (int row = 0; row < __size.y; ++row)
+        std::copy_n(bitmap.buffer + row * bitmap.pitch, __size.x, __pixels.data() + row * __size.x);
 }
 
-Character::~Character()
+Character::Character(const glm::ivec2 & size, const glm::ivec2 & bearing, GLuint advance, std::vector<unsigned char> && pixels)
+    : __atlasRect{ 0.0f }
+    , __size{ size }
+    , __bearing{ bearing }
+    , __advance{ advance }
+    , __pixels{ std::move(pixels) }
 {
-    if (__error) glDeleteTextures(1, &__texture);
 }
 
-GLuint Character::GetTextureID() const { return __texture; }
+const glm::vec4 & Character::GetAtlasRect() const { return __atlasRect; }
+void Character::SetAtlasRect(const glm::vec4 & rect) { __atlasRect = rect; }
 const glm::ivec2 & Character::GetSize() const { return __size; }
 const glm::ivec2 & Character::GetBearing() const { return __bearing; }
 GLuint Character::GetAdvance() const { return __advance; }
+const std::vector<unsigned char> & Character::GetPixels() const { return __pixels; }
 
 Font_Base::Font_Base(const char * fontPath, const FT_UInt fontSize)
-    : __face{ nullptr }
+    : __fontPath{ fontPath }
+    , __face{ nullptr }
     , __fontSize{ fontSize }
+    , __hash{ 0 }
+    , __maxAtlasSize{ 0 }
+    , __frame{ 0 }
+    , __rasterized{ 0 }
+    , __evictions{ 0 }
+    , __dirty{ false }
 {
-    if (!InitFreeType()) throw std::exception("FreeType not initialized.");
-
-    if (FT_New_Face(ft, fontPath, 0, &__face))
+    // The cache is keyed by the content, an edited font file gets a new one
+    std::ifstream file(fontPath, std::ios::binary);
+    if (!file.is_open())
     {
-        LOG_PRINT(stderr, "FreeType couldn't load '%s'.\n", fontPath);
+        LOG_PRINT(stderr, "Couldn't read font '%s'.\n", fontPath);
         throw std::exception("Couldn't load font.");
     }
-    if (FT_Set_Pixel_Sizes(__face, 0, fontSize))
-    {
-        LOG_PRINT(stderr, "FreeType couldn't change font size: '%s'.\n", fontPath);
-        throw std::exception("Couldn't change font size.");
-    }
+    const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    __hash = ShaderPreprocessor::Hash(data.data(), data.size(), ShaderPreprocessor::Hash(&fontSize, sizeof(fontSize)));
 
-    // Disable byte-alignment restriction
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLint maxSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    __maxAtlasSize = std::min(settings.maxAtlasSize, static_cast<int>(maxSize));
+    __atlas.Resize(std::min(settings.atlasSize, __maxAtlasSize));
 
-    // Load first 128 characters of ASCII set
-    __characters.reserve(128);
-    for (GLubyte c = 0; c < 128; c++)
-    {
-        bool error;
-        Character * newChar = new Character(c, __face, error);
-        if (!error)
-        {
-            LOG_PRINT(stderr, "Couldn't load '%c' character from '%s' font.\n", c, fontPath);
-            delete newChar;
-            continue;
-        }   
-        __characters.insert({c, std::unique_ptr<Character>(newChar)});
-    }
-    FT_Done_Face(__face);
+    // Without cache, FreeType checks the font right away
+    if (!LoadCache() && !OpenFace())
+        throw std::exception("Couldn't load font.");
 }
 
 Font_Base::~Font_Base()
 {
-    if (FreeTypeInitialized)
+    // Workers use the face
+    for (auto & job : __jobs) job.wait();
+    if (__saveJob.valid()) __saveJob.wait();
+
+    if (__face)
     {
-        FT_Done_FreeType(ft);
-        FreeTypeInitialized = false;
+        std::lock_guard<std::mutex> lock(freeTypeMutex);
+        FT_Done_Face(__face);
+        if (--openFaces == 0 && FreeTypeInitialized)
+        {
+            FT_Done_FreeType(ft);
+            FreeTypeInitialized = false;
+        }
     }
 }
 
 bool Font_Base::InitFreeType()
 {
+    std::lock_guard<std::mutex> lock(freeTypeMutex);
     if (FreeTypeInitialized) return true;
 
     if (FT_Init_FreeType(&ft))
@@ -120,12 +168,301 @@ bool Font_Base::InitFreeType()
     return true;
 }
 
+bool Font_Base::OpenFace()
+{
+    if (__face) return true;
+    if (!InitFreeType()) return false;
+
+    std::lock_guard<std::mutex> lock(freeTypeMutex);
+    if (FT_New_Face(ft, __fontPath.c_str(), 0, &__face))
+    {
+        LOG_PRINT(stderr, "FreeType couldn't load '%s'.\n", __fontPath.c_str());
+        __face = nullptr;
+        return false;
+    }
+    if (FT_Set_Pixel_Sizes(__face, 0, __fontSize))
+    {
+        LOG_PRINT(stderr, "FreeType couldn't change font size: '%s'.\n", __fontPath.c_str());
+        FT_Done_Face(__face);
+        __face = nullptr;
+        return false;
+    }
+    ++openFaces;
+    return true;
+}
+
+const Character * Font_Base::GetCharacter(char32_t codepoint)
+{
+    const auto it = __glyphs.find(codepoint);
+    if (it == __glyphs.end())
+    {
+        if (__requested.insert(codepoint).second)
+            __misses.push_back(codepoint);
+        return nullptr;
+    }
+
+    Glyph & glyph = it->second;
+    glyph.lastUsed = __frame;
+    if (glyph.resident) return &glyph.character;
+    // Glyphs that didn't fit wait for the next repack
+    if (glyph.queued || glyph.dropped) return nullptr;
+    // Free room is used right away, rectangles laid out this frame only move when Update repacks
+    if (Place(glyph)) return &glyph.character;
+    glyph.queued = true;
+    __uploads.push_back(codepoint);
+    return nullptr;
+}
+
+void Font_Base::Update()
+{
+    ++__frame;
+
+    // Rasterized glyphs wait for a rectangle like evicted ones
+    for (auto job = __jobs.begin(); job != __jobs.end();)
+    {
+        if (job->wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++job;
+            continue;
+        }
+        for (auto & [codepoint, character] : job->get())
+        {
+            Glyph & glyph = __glyphs.emplace(codepoint, Glyph{ std::move(character) }).first->second;
+            glyph.lastUsed = __frame;
+            glyph.queued = true;
+            __uploads.push_back(codepoint);
+            __requested.erase(codepoint);
+            ++__rasterized;
+        }
+        __dirty = true;
+        job = __jobs.erase(job);
+    }
+
+    // Codepoints missed last frame are rendered by a worker, the face is used by one job at a time
+    if (!__misses.empty())
+    {
+        if (OpenFace())
+        {
+            __jobs.push_back(ThreadPool::Get().Submit([this, codepoints = std::move(__misses)]()
+            {
+                std::lock_guard<std::mutex> lock(__faceMutex);
+                Rasterized rasterized;
+                rasterized.reserve(codepoints.size());
+                for (char32_t codepoint : codepoints)
+                {
+                    bool error;
+                    rasterized.emplace_back(codepoint, Character(codepoint, __face, error));
+                    if (!error)
+                        LOG_PRINT(stderr, "Couldn't load U+%04X character from '%s' font.\n", static_cast<unsigned>(codepoint), __fontPath.c_str());
+                }
+                return rasterized;
+            }));
+        }
+        else
+        {
+            // Empty glyphs, not requested again every frame
+            for (char32_t codepoint : __misses)
+            {
+                __glyphs.emplace(codepoint, Glyph{ Character(glm::ivec2(0), glm::ivec2(0), 0, {}) });
+                __requested.erase(codepoint);
+            }
+        }
+        __misses.clear();
+    }
+
+    if (!__uploads.empty())
+    {
+        std::vector<char32_t> uploads;
+        uploads.swap(__uploads);
+        for (char32_t codepoint : uploads)
+        {
+            Glyph & glyph = __glyphs.at(codepoint);
+            if (glyph.resident || Place(glyph))
+                glyph.queued = false;
+            else
+                __uploads.push_back(codepoint);
+        }
+        if (!__uploads.empty()) Repack();
+    }
+
+    // Written once nothing is pending, so that the next launches skip FreeType
+    if (__dirty && __jobs.empty() && (!__saveJob.valid() || __saveJob.wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+    {
+        SaveCache();
+        __dirty = false;
+    }
+}
+
+bool Font_Base::Place(Glyph & glyph)
+{
+    const Character & character = glyph.character;
+    // Spaces & such don't need a rectangle
+    if (character.GetSize().x > 0 && character.GetSize().y > 0)
+    {
+        glm::ivec2 position;
+        if (!__atlas.Allocate(character.GetSize(), position)) return false;
+        __atlas.Upload(position, character.GetSize(), character.GetPixels().data());
+        glyph.character.SetAtlasRect(__atlas.GetRect(position, character.GetSize()));
+    }
+    glyph.resident = true;
+    return true;
+}
+
+void Font_Base::Repack()
+{
+    struct Entry
+    {
+        Glyph * glyph;
+        bool wasResident;
+    };
+    std::vector<Entry> entries;
+    for (auto & [codepoint, glyph] : __glyphs)
+    {
+        if (!glyph.resident && !glyph.queued && !glyph.dropped) continue;
+        entries.push_back({ &glyph, glyph.resident });
+        glyph.queued = false;
+        glyph.dropped = false;
+    }
+    __uploads.clear();
+
+    // Most recently used first, then tallest first to pack the skyline tighter
+    std::sort(entries.begin(), entries.end(), [](const Entry & a, const Entry & b) {
+        if (a.glyph->lastUsed != b.glyph->lastUsed) return a.glyph->lastUsed > b.glyph->lastUsed;
+        return a.glyph->character.GetSize().y > b.glyph->character.GetSize().y;
+    });
+
+    for (bool packed = false; !packed;)
+    {
+        packed = true;
+        __atlas.Clear();
+        for (Entry & entry : entries)
+        {
+            entry.glyph->resident = false;
+            if (Place(*entry.glyph)) continue;
+
+            // Glyphs of the last frame have to fit, the atlas grows for them, older ones are evicted
+            if (entry.glyph->lastUsed + 1 >= __frame && __atlas.GetSize() * 2 <= __maxAtlasSize)
+            {
+                __atlas.Resize(__atlas.GetSize() * 2);
+                packed = false;
+                break;
+            }
+        }
+    }
+    __evictions += static_cast<int>(std::count_if(entries.begin(), entries.end(), [](const Entry & entry) {
+        return entry.wasResident && !entry.glyph->resident;
+    }));
+
+    // Glyphs of the last frame left out at the maximum size are not queued again every frame
+    for (Entry & entry : entries)
+    {
+        if (!entry.glyph->resident && entry.glyph->lastUsed + 1 >= __frame)
+            entry.glyph->dropped = true;
+    }
+}
+
+bool Font_Base::LoadCache()
+{
+    const std::string cachePath = GlyphCachePath(__hash);
+    std::ifstream file(cachePath, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    GlyphCacheHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))
+        || memcmp(header.magic, glyphCacheMagic, sizeof(glyphCacheMagic)) != 0
+        || header.version != glyphCacheVersion
+        || header.hash != __hash)
+    {
+        return false;
+    }
+
+    const auto corrupted = [&cachePath]() {
+        LOG_PRINT(stderr, "Font cache '%s' is corrupted, rasterizing again\n", cachePath.c_str());
+        return false;
+    };
+
+    // Counts & sizes read from the file are checked against what is left of it before allocating
+    file.seekg(0, std::ios::end);
+    uint64_t remaining = static_cast<uint64_t>(file.tellg()) - sizeof(header);
+    file.seekg(sizeof(header));
+    if (header.count > remaining / sizeof(GlyphCacheEntry)) return corrupted();
+
+    // Glyphs are uploaded when first used, a truncated file is ignored entirely
+    std::unordered_map<char32_t, Glyph> glyphs;
+    glyphs.reserve(header.count);
+    for (uint32_t i = 0; i < header.count; ++i)
+    {
+        GlyphCacheEntry entry;
+        if (!file.read(reinterpret_cast<char *>(&entry), sizeof(entry))
+            || entry.width < 0 || entry.height < 0 || entry.width > __maxAtlasSize || entry.height > __maxAtlasSize)
+        {
+            return corrupted();
+        }
+        remaining -= sizeof(entry);
+        const uint64_t pixelsSize = static_cast<uint64_t>(entry.width) * entry.height;
+        if (pixelsSize > remaining) return corrupted();
+        remaining -= pixelsSize;
+
+        std::vector<unsigned char> pixels(static_cast<size_t>(pixelsSize));
+        if (!file.read(reinterpret_cast<char *>(pixels.data()), pixels.size())) return corrupted();
+        glyphs.emplace(static_cast<char32_t>(entry.codepoint), Glyph{ Character(glm::ivec2(entry.width, entry.height),
+            glm::ivec2(entry.bearingX, entry.bearingY), entry.advance, std::move(pixels)) });
+    }
+    __glyphs = std::move(glyphs);
+    return true;
+}
+
+void Font_Base::SaveCache()
+{
+    GlyphCacheHeader header;
+    memcpy(header.magic, glyphCacheMagic, sizeof(glyphCacheMagic));
+    header.version = glyphCacheVersion;
+    header.hash = __hash;
+    header.count = static_cast<uint32_t>(__glyphs.size());
+
+    const char * bytes = reinterpret_cast<const char *>(&header);
+    std::vector<char> data(bytes, bytes + sizeof(header));
+    for (const auto & [codepoint, glyph] : __glyphs)
+    {
+        const Character & character = glyph.character;
+        const GlyphCacheEntry entry = { static_cast<uint32_t>(codepoint), character.GetSize().x, character.GetSize().y,
+            character.GetBearing().x, character.GetBearing().y, character.GetAdvance() };
+        bytes = reinterpret_cast<const char *>(&entry);
+        data.insert(data.end(), bytes, bytes + sizeof(entry));
+        data.insert(data.end(), character.GetPixels().begin(), character.GetPixels().end());
+    }
+
+    // The frame doesn't wait for the disk
+    __saveJob = ThreadPool::Get().Submit([cachePath = GlyphCachePath(__hash), data = std::move(data)]()
+    {
+        std::error_code error;
+        std::filesystem::create_directories(Constants::Paths::fontCache, error);
+
+        std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            LOG_PRINT(stderr, "Couldn't write font cache '%s'\n", cachePath.c_str());
+            return;
+        }
+        file.write(data.data(), data.size());
+    });
+}
+
 FT_UInt Font_Base::GetFontSize() const
 {
     return __fontSize;
 }
 
-const std::unordered_map<GLchar, std::unique_ptr<Character>> & Font_Base::GetCharacters() const
+GLuint Font_Base::GetAtlasTexture() const
+{
+    return __atlas.GetTexture();
+}
+
+void Font_Base::AddStats(Stats & stats) const
 {
-    return __characters;
-}
\ No newline at end of file
+    stats.glyphs += static_cast<int>(__glyphs.size());
+    for (const auto & [codepoint, glyph] : __glyphs)
+        stats.resident += glyph.resident;
+    stats.rasterized += __rasterized;
+    stats.evictions += __evictions;
+}
@@ -7,6 +7,9 @@
  *********************************************************************/
 #pragma once
 
+// Project includes
+#include "GlyphAtlas.hpp"
+
 // GLM includes
 #include <glm\glm.hpp>
 
@@ -19,7 +22,13 @@
 
 // C++ includes
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
+#include <vector>
+#include <string>
+#include <future>
+#include <mutex>
+#include <cstdint>
 
 /**
  * @brief Contains every information about Rendering Characters.
@@ -27,28 +36,75 @@
 class Character
 {
 public:
-    Character(const wchar_t character, FT_Face & face, bool & error);
-    ~Character();
+    /**
+     * @brief Rasterizes the glyph, metrics & bitmap (rows tightly packed) are copied from face->glyph
+     * @param character codepoint
+     * @param face
+     * @param error false if FreeType failed, the character is then empty
+    */
+    Character(const char32_t character, FT_Face & face, bool & error);
+    /**
+     * @brief Glyph read back from the font cache
+    */
+    Character(const glm::ivec2 & size, const glm::ivec2 & bearing, GLuint advance, std::vector<unsigned char> && pixels);
 
-    GLuint GetTextureID() const;
+    /**
+     * @brief UV offset (xy) & scale (zw) of the glyph in the atlas of its font
+    */
+    const glm::vec4 & GetAtlasRect() const;
+    void SetAtlasRect(const glm::vec4 & rect);
     const glm::ivec2 & GetSize() const;
     const glm::ivec2 & GetBearing() const;
     GLuint GetAdvance() const;
+    /**
+     * @brief One byte per texel, kept to upload the glyph again once evicted from the atlas
+    */
+    const std::vector<unsigned char> & GetPixels() const;
 
 private:
-    GLuint __texture;
+    glm::vec4  __atlasRect;
     glm::ivec2 __size;    // Size of character
     glm::ivec2 __bearing; // Offset from baseline to left/top of character
     GLuint     __advance; // Horizontal offset to next character
-    bool __error;
+    std::vector<unsigned char> __pixels;
 };
 
 /**
  * @brief Contains the real data of the font to be
  * stored in a static database.
+ * Glyphs are rasterized on demand: the first GetCharacter of a codepoint queues it, FreeType
+ * renders the queued ones on the ThreadPool & they are uploaded to the atlas by Update.
+ * Glyphs are kept in memory, only their atlas rectangles are evicted (least recently used first)
+ * when the atlas is full. Every rasterized glyph is written to a cache file keyed by the hash of
+ * the font file & its size, fonts found in the cache don't open FreeType until a new glyph is needed.
 */
 class Font_Base
 {
+public:
+    struct Settings
+    {
+        /**
+         * @brief Size of new atlases, in texels
+        */
+        int atlasSize = 1024;
+        /**
+         * @brief Atlases grow up to this size (clamped to GL_MAX_TEXTURE_SIZE) for glyphs
+         * of the last frame, older glyphs are evicted instead
+        */
+        int maxAtlasSize = 4096;
+    };
+
+    /**
+     * @brief Statistics of the glyph caches
+    */
+    struct Stats
+    {
+        int glyphs = 0;
+        int resident = 0;
+        int rasterized = 0;
+        int evictions = 0;
+    };
+
 public:
     Font_Base(const char * fontPath, const FT_UInt fontSize = 260);
     ~Font_Base();
@@ -60,10 +116,18 @@ public:
     static bool InitFreeType();
 
     /**
-     * @brief Gets characters data (not mutable)
-     * @return characters
+     * @brief Returns the glyph of a codepoint if it is in the atlas, else queues it
+     * (rasterization or upload) for the next Update. Its rectangle stays valid until then.
+     * @param codepoint
+     * @return character, nullptr if not ready yet
+    */
+    const Character * GetCharacter(char32_t codepoint);
+
+    /**
+     * @brief Collects rasterized glyphs, submits the queued codepoints to the workers
+     * & packs the waiting glyphs in the atlas, to call once per frame before text is laid out
     */
-    const std::unordered_map<GLchar, std::unique_ptr<Character>> & GetCharacters() const;
+    void Update();
 
     /**
      * @brief Gets Font size
@@ -71,8 +135,88 @@ public:
     */
     FT_UInt GetFontSize() const;
 
+    /**
+     * @brief Gets the texture where every glyph is packed
+     * @return atlas texture
+    */
+    GLuint GetAtlasTexture() const;
+
+    /**
+     * @brief Adds the statistics of this font
+     * @param stats
+    */
+    void AddStats(Stats & stats) const;
+
+    static Settings settings;
+
 private:
+    /**
+     * @brief Glyph & its state in the atlas
+    */
+    struct Glyph
+    {
+        Character character;
+        uint64_t lastUsed = 0;
+        bool resident = false;
+        bool queued = false;
+        /**
+         * @brief Didn't fit in the atlas at its maximum size, retried by the next repack only
+        */
+        bool dropped = false;
+    };
+    using Rasterized = std::vector<std::pair<char32_t, Character>>;
+
+    /**
+     * @brief Opens the FreeType face, on first rasterization
+     * @return false if FreeType can't load the font
+    */
+    bool OpenFace();
+    /**
+     * @brief Allocates & uploads the rectangle of a glyph
+     * @return false if the atlas is full
+    */
+    bool Place(Glyph & glyph);
+    /**
+     * @brief Clears the atlas & places the resident & queued glyphs again, most recently used first,
+     * the ones that don't fit anymore are evicted (dropped if used last frame)
+    */
+    void Repack();
+
+    bool LoadCache();
+    /**
+     * @brief Serializes every glyph, the file is written by a worker
+    */
+    void SaveCache();
+
+private:
+    std::string __fontPath;
     FT_Face __face;
     FT_UInt __fontSize;
-    std::unordered_map<GLchar, std::unique_ptr<Character>> __characters;
+    /**
+     * @brief Hash of the font file & size, names the cache file
+    */
+    uint64_t __hash;
+    std::unordered_map<char32_t, Glyph> __glyphs;
+    GlyphAtlas __atlas;
+    int __maxAtlasSize;
+
+    /**
+     * @brief Codepoints to rasterize, codepoints submitted & not collected yet
+    */
+    std::vector<char32_t> __misses;
+    std::unordered_set<char32_t> __requested;
+    std::vector<std::future<Rasterized>> __jobs;
+    /**
+     * @brief FreeType faces can only be used by one thread at a time
+    */
+    std::mutex __faceMutex;
+    /**
+     * @brief Glyphs waiting for a rectangle
+    */
+    std::vector<char32_t> __uploads;
+    std::future<void> __saveJob;
+
+    uint64_t __frame;
+    int __rasterized, __evictions;
+    bool __dirty;
 };
@@ -0,0 +1,137 @@
+/*****************************************************************//**
+ * \file   GlyphAtlas.cpp
+ * \brief  GlyphAtlas source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 15 2022
+ *********************************************************************/
+#include "GlyphAtlas.hpp"
+
+// Project includes
+#include "OGL_Implementation\OpenGL_State.hpp"
+
+// C++ includes
+#include <algorithm>
+
+/**
+ * @brief Empty texels between rectangles
+*/
+static constexpr const int padding = 1;
+
+GlyphAtlas::GlyphAtlas()
+    : __texture{ 0 }
+    , __size{ 0 }
+{
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+    OpenGL_State::DeleteTextures(1, &__texture);
+}
+
+void GlyphAtlas::Resize(int size)
+{
+    OpenGL_State::DeleteTextures(1, &__texture);
+    __size = size;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &__texture);
+    glTextureStorage2D(__texture, 1, GL_R8, size, size);
+    glTextureParameteri(__texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(__texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(__texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(__texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    Clear();
+}
+
+void GlyphAtlas::Clear()
+{
+    // Padding texels stay empty
+    constexpr const GLubyte zero = 0;
+    glClearTexImage(__texture, 0, GL_RED, GL_UNSIGNED_BYTE, &zero);
+
+    __skyline.assign(1, { 0, 0, __size });
+}
+
+int GlyphAtlas::Fit(size_t segment, const glm::ivec2 & size) const
+{
+    if (__skyline[segment].x + size.x > __size) return -1;
+
+    // Rests on the highest segment it spans
+    int y = 0;
+    for (int widthLeft = size.x; widthLeft > 0; widthLeft -= __skyline[segment++].width)
+    {
+        y = std::max(y, __skyline[segment].y);
+        if (y + size.y > __size) return -1;
+    }
+    return y;
+}
+
+bool GlyphAtlas::Allocate(const glm::ivec2 & size, glm::ivec2 & position)
+{
+    const glm::ivec2 padded = size + padding;
+
+    // Lowest top, then narrowest segment
+    size_t best = __skyline.size();
+    int bestTop = __size + 1, bestWidth = __size + 1;
+    for (size_t i = 0; i < __skyline.size(); ++i)
+    {
+        const int y = Fit(i, padded);
+        if (y < 0) continue;
+        if (y + padded.y < bestTop || (y + padded.y == bestTop && __skyline[i].width < bestWidth))
+        {
+            best = i;
+            bestTop = y + padded.y;
+            bestWidth = __skyline[i].width;
+            position = glm::ivec2(__skyline[i].x, y);
+        }
+    }
+    if (best == __skyline.size()) return false;
+
+    // New segment over the rectangle, the ones it covers are shortened or removed
+    __skyline.insert(__skyline.begin() + best, { position.x, bestTop, padded.x });
+    const int right = position.x + padded.x;
+    for (size_t i = best + 1; i < __skyline.size();)
+    {
+        Segment & segment = __skyline[i];
+        if (segment.x >= right) break;
+        const int covered = std::min(right - segment.x, segment.width);
+        segment.x += covered;
+        segment.width -= covered;
+        if (segment.width > 0) break;
+        __skyline.erase(__skyline.begin() + i);
+    }
+    // Neighbours at the same height become one segment
+    for (size_t i = 1; i < __skyline.size();)
+    {
+        if (__skyline[i - 1].y == __skyline[i].y)
+        {
+            __skyline[i - 1].width += __skyline[i].width;
+            __skyline.erase(__skyline.begin() + i);
+        }
+        else
+            ++i;
+    }
+    return true;
+}
+
+void GlyphAtlas::Upload(const glm::ivec2 & position, const glm::ivec2 & size, const void * pixels) const
+{
+    if (size.x == 0 || size.y == 0) return;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTextureSubImage2D(__texture, 0, position.x, position.y, size.x, size.y, GL_RED, GL_UNSIGNED_BYTE, pixels);
+}
+
+glm::vec4 GlyphAtlas::GetRect(const glm::ivec2 & position, const glm::ivec2 & size) const
+{
+    return glm::vec4(glm::vec2(position), glm::vec2(size)) / static_cast<float>(__size);
+}
+
+GLuint GlyphAtlas::GetTexture() const
+{
+    return __texture;
+}
+
+int GlyphAtlas::GetSize() const
+{
+    return __size;
+}
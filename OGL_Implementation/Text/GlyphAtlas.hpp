@@ -0,0 +1,89 @@
+/*****************************************************************//**
+ * \file   GlyphAtlas.hpp
+ * \brief  Glyphs of a font packed in one texture
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 15 2022
+ *********************************************************************/
+#pragma once
+
+// GLAD includes
+#include <glad\glad.h>
+
+// GLM includes
+#include <glm\glm.hpp>
+
+// C++ includes
+#include <vector>
+
+/**
+ * @brief Square single channel texture where glyph bitmaps are packed by a skyline
+ * (bottom-left heuristic): the top edge of the packed rectangles is kept as a list of
+ * horizontal segments, each rectangle goes where its top ends the lowest. Rectangles are
+ * separated by a texel, so that linear filtering doesn't bleed between glyphs.
+*/
+class GlyphAtlas
+{
+public:
+    GlyphAtlas();
+    ~GlyphAtlas();
+
+    /**
+     * @brief Recreates the texture (cleared), every rectangle is freed
+     * @param size in texels
+    */
+    void Resize(int size);
+    /**
+     * @brief Clears the texture & frees every rectangle, keeping the size
+    */
+    void Clear();
+
+    /**
+     * @brief Finds room for a rectangle, padding included
+     * @param size in texels
+     * @param position of the rectangle in the atlas
+     * @return false if no segment of the skyline can fit it
+    */
+    bool Allocate(const glm::ivec2 & size, glm::ivec2 & position);
+
+    /**
+     * @brief Copies a bitmap to an allocated rectangle
+     * @param position
+     * @param size
+     * @param pixels one byte per texel, rows tightly packed
+    */
+    void Upload(const glm::ivec2 & position, const glm::ivec2 & size, const void * pixels) const;
+
+    /**
+     * @brief UV offset (xy) & scale (zw) of a rectangle of the atlas
+     * @param position
+     * @param size
+     * @return rect
+    */
+    glm::vec4 GetRect(const glm::ivec2 & position, const glm::ivec2 & size) const;
+
+    GLuint GetTexture() const;
+    int GetSize() const;
+
+private:
+    /**
+     * @brief Segment of the skyline: top of the rectangles packed over [x, x + width)
+    */
+    struct Segment
+    {
+        int x, y, width;
+    };
+
+    /**
+     * @brief Returns the lowest y at which a rectangle starting at the segment fits
+     * @param segment index
+     * @param size padded
+     * @return y, -1 if the rectangle overflows the atlas
+    */
+    int Fit(size_t segment, const glm::ivec2 & size) const;
+
+private:
+    GLuint __texture;
+    int __size;
+    std::vector<Segment> __skyline;
+};
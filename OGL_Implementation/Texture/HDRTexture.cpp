@@ -7,21 +7,26 @@
  *********************************************************************/
 #include "HDRTexture.hpp"
 
+// Project includes
+#include "OGL_Implementation\OpenGL_State.hpp"
+
 // STBI includes
 #include <stb_image.h>
 
 HDRTexture::HDRTexture()
     : __width{ 0 }
     , __height{ 0 }
+    , __channels{ 0 }
+    , __textureId{ 0 }
 {
 }
 
 HDRTexture::~HDRTexture()
 {
-    glDeleteTextures(1, &__textureId);
+    OpenGL_State::DeleteTextures(1, &__textureId);
 }
 
-bool HDRTexture::GenerateTexture(const std::string & filePath, int forceChannels)
+bool HDRTexture::GenerateTexture(const std::string & filePath, int forceChannels, bool keepPixels)
 {
     int nrComponents;
     stbi_set_flip_vertically_on_load(true);
@@ -29,8 +34,14 @@ bool HDRTexture::GenerateTexture(const std::string & filePath, int forceChannels
     stbi_set_flip_vertically_on_load(false);
     if (image)
     {
+        __channels = forceChannels != 0 ? forceChannels : nrComponents;
+        if (keepPixels)
+            __pixels.assign(image, image + static_cast<size_t>(__width) * __height * __channels);
+        else
+            __pixels.clear();
+
         glGenTextures(1, &__textureId);
-        glBindTexture(GL_TEXTURE_2D, __textureId);
+        OpenGL_State::BindTexture(GL_TEXTURE_2D, __textureId);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, __width, __height, 0, GL_RGB, GL_FLOAT, image); // note how we specify the texture's data value to be float
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -64,7 +75,17 @@ GLuint HDRTexture::GetTexture() const
     return __textureId;
 }
 
-bool GenerateHDRTexture(const std::string & filePath, HDRTexture & texture)
+const std::vector<float> & HDRTexture::GetPixels() const
+{
+    return __pixels;
+}
+
+int HDRTexture::GetChannels() const
+{
+    return __channels;
+}
+
+bool GenerateHDRTexture(const std::string & filePath, HDRTexture & texture, bool keepPixels)
 {
-    return texture.GenerateTexture(filePath);
+    return texture.GenerateTexture(filePath, 0, keepPixels);
 }
@@ -15,6 +15,7 @@
 
 // C++ includes
 #include <string>
+#include <vector>
 
 /**
  * @brief Contains and manages every information about textures
@@ -28,9 +29,11 @@ public:
     /**
      * @brief Generates texture from texture file path
      * @param filePath 
+     * @param forceChannels
+     * @param keepPixels keeps a CPU copy of the float pixels (see GetPixels)
      * @return true if no errors else false
     */
-    bool GenerateTexture(const std::string & filePath, int forceChannels = 0);
+    bool GenerateTexture(const std::string & filePath, int forceChannels = 0, bool keepPixels = false);
     
     /**
      * @brief Returns texture width
@@ -52,16 +55,28 @@ public:
      * @return texture id
     */
     GLuint GetTexture() const;
+    /**
+     * @brief Returns CPU copy of the pixels (empty if not kept on generation)
+     * @return float pixels, rows flipped like the uploaded texture
+    */
+    const std::vector<float> & GetPixels() const;
+    /**
+     * @brief Returns number of channels of the loaded file
+     * @return channels
+    */
+    int GetChannels() const;
 
 private:
-    int __width, __height;
+    int __width, __height, __channels;
     GLuint __textureId;
+    std::vector<float> __pixels;
 };
 
 /**
  * @brief Generates texture from filepath and ref to a Texture & object
  * @param filePath
  * @param texture ref
+ * @param keepPixels keeps a CPU copy of the pixels
  * @return true if no errors else flase
  */
-bool GenerateHDRTexture(const std::string & filePath, HDRTexture & texture);
\ No newline at end of file
+bool GenerateHDRTexture(const std::string & filePath, HDRTexture & texture, bool keepPixels = false);
\ No newline at end of file
@@ -7,6 +7,9 @@
  *********************************************************************/
 #include "Texture.hpp"
 
+// Project includes
+#include "OGL_Implementation\OpenGL_State.hpp"
+
 Texture::Texture()
     : __width{ 0 }
     , __height{ 0 }
@@ -15,7 +18,7 @@ Texture::Texture()
 
 Texture::~Texture()
 {
-    glDeleteTextures(1, &__textureId);
+    OpenGL_State::DeleteTextures(1, &__textureId);
 }
 
 bool Texture::GenerateTexture(const std::string & filePath, int forceChannels)
@@ -34,7 +37,7 @@ bool Texture::GenerateTexture(const std::string & filePath, int forceChannels)
 
         // Load and create a texture
         glGenTextures(1, &__textureId);
-        glBindTexture(GL_TEXTURE_2D, __textureId); // All upcoming GL_TEXTURE_2D operations now have effect on this texture object
+        OpenGL_State::BindTexture(GL_TEXTURE_2D, __textureId); // All upcoming GL_TEXTURE_2D operations now have effect on this texture object
         // Load image, create texture and generate mipmaps
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, __width, __height, 0, format, GL_UNSIGNED_BYTE, image);
         glGenerateMipmap(GL_TEXTURE_2D);
@@ -45,7 +48,7 @@ bool Texture::GenerateTexture(const std::string & filePath, int forceChannels)
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         // Unbind texture when done, so we won't accidentily mess up our texture.
-        glBindTexture(GL_TEXTURE_2D, 0);
+        OpenGL_State::BindTexture(GL_TEXTURE_2D, 0);
         stbi_image_free(image);
         return true;
     }
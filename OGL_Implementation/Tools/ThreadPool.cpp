@@ -0,0 +1,97 @@
+/*****************************************************************//**
+ * \file   ThreadPool.cpp
+ * \brief  ThreadPool source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 02 2022
+ *********************************************************************/
+#include "ThreadPool.hpp"
+
+// C++ includes
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t workerCount)
+    : __stop{ false }
+{
+    __workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i)
+        __workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lk(__jobsMutex);
+        __stop = true;
+    }
+    __jobsCV.notify_all();
+    for (auto & worker : __workers)
+        worker.join();
+}
+
+ThreadPool & ThreadPool::Get()
+{
+    // Keeping one core for the main (rendering) thread
+    static ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+size_t ThreadPool::GetWorkerCount() const
+{
+    return __workers.size();
+}
+
+size_t ThreadPool::GetMaxChunkCount() const
+{
+    return __workers.size() + 1;
+}
+
+void ThreadPool::ParallelFor(size_t count, const RangeJob & job, size_t minChunkSize)
+{
+    if (count == 0) return;
+
+    minChunkSize = std::max<size_t>(minChunkSize, 1);
+    const size_t chunkCount = std::min(GetMaxChunkCount(), (count + minChunkSize - 1) / minChunkSize);
+    const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(chunkCount);
+    for (size_t chunk = 1; chunk < chunkCount; ++chunk)
+    {
+        const size_t begin = chunk * chunkSize;
+        const size_t end = std::min(count, begin + chunkSize);
+        if (begin >= end) break;
+        futures.push_back(Submit([&job, begin, end, chunk]() { job(begin, end, chunk); }));
+    }
+
+    // Calling thread takes the first chunk instead of sleeping
+    job(0, std::min(count, chunkSize), 0);
+
+    for (auto & future : futures)
+        future.get();
+}
+
+void ThreadPool::Push(std::function<void()> && job)
+{
+    {
+        std::unique_lock<std::mutex> lk(__jobsMutex);
+        __jobs.push_back(std::move(job));
+    }
+    __jobsCV.notify_one();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lk(__jobsMutex);
+            __jobsCV.wait(lk, [this] { return __stop || !__jobs.empty(); });
+            if (__stop && __jobs.empty()) return;
+            job = std::move(__jobs.front());
+            __jobs.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,87 @@
+/*****************************************************************//**
+ * \file   ThreadPool.hpp
+ * \brief  Generic worker thread pool
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 02 2022
+ *********************************************************************/
+#pragma once
+
+// C++ includes
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <deque>
+#include <future>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+
+/**
+ * @brief Pool of worker threads shared by every CPU side job of the engine
+ * (not tied to meshes like Mesh_ThreadPool).
+ * Workers are spawned on first use and joined when the program exits.
+*/
+class ThreadPool
+{
+public:
+    /**
+     * @brief Job executed by ParallelFor on the range [begin, end[,
+     * chunkId is in [0, GetWorkerCount()] and can be used to index per-thread data.
+    */
+    using RangeJob = std::function<void(size_t begin, size_t end, size_t chunkId)>;
+
+private:
+    ThreadPool(size_t workerCount);
+
+public:
+    ~ThreadPool();
+
+    /**
+     * @brief Returns the pool, creating it if needed
+     * @return pool
+    */
+    static ThreadPool & Get();
+
+    /**
+     * @brief Returns number of worker threads (not counting the calling thread)
+     * @return worker count
+    */
+    size_t GetWorkerCount() const;
+
+    /**
+     * @brief Returns the maximum number of chunks ParallelFor can split a range into
+     * @return worker count + 1
+    */
+    size_t GetMaxChunkCount() const;
+
+    /**
+     * @brief Pushes a job on the queue
+     * @param job
+     * @return future holding the job's result
+    */
+    template<typename Func>
+    auto Submit(Func && job) -> std::future<decltype(job())>;
+
+    /**
+     * @brief Splits [0, count[ into contiguous chunks and runs them on the workers
+     * and on the calling thread, then waits for all of them.
+     * @param count
+     * @param job
+     * @param minChunkSize minimum amount of items per chunk
+    */
+    void ParallelFor(size_t count, const RangeJob & job, size_t minChunkSize = 1);
+
+private:
+    void Push(std::function<void()> && job);
+    void WorkerLoop();
+
+private:
+    std::vector<std::thread> __workers;
+    std::deque<std::function<void()>> __jobs;
+    std::mutex __jobsMutex;
+    std::condition_variable __jobsCV;
+    bool __stop;
+};
+
+#include "ThreadPool.inl"
@@ -0,0 +1,20 @@
+/*****************************************************************//**
+ * \file   ThreadPool.inl
+ * \brief  ThreadPool template source code
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 02 2022
+ *********************************************************************/
+#include "ThreadPool.hpp"
+
+template<typename Func>
+inline auto ThreadPool::Submit(Func && job) -> std::future<decltype(job())>
+{
+    using ReturnType = decltype(job());
+
+    // std::function needs a copyable target, packaged_task is move only
+    auto task = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<Func>(job));
+    std::future<ReturnType> future = task->get_future();
+    Push([task]() { (*task)(); });
+    return future;
+}
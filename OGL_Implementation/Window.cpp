@@ -9,6 +9,7 @@
 
 // Project includes
 #include "OGL_Implementation\DebugInfo\Log.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
 #include <stb_image.h>
 
 // C++ includes
@@ -52,6 +53,9 @@ bool Window::Initialize(const char * windowName, const char * iconPath)
 #endif
 	// Anti Aliasing
 	glfwWindowHint(GLFW_SAMPLES, 4);
+	// Depth/stencil format copied by SubsurfaceScattering (GL_DEPTH24_STENCIL8)
+	glfwWindowHint(GLFW_DEPTH_BITS, 24);
+	glfwWindowHint(GLFW_STENCIL_BITS, 8);
 
 	// Create a GLFWwindow object that we can use for GLFW's functions
 	if ((window = glfwCreateWindow(WIDTH, HEIGHT, windowName, nullptr, nullptr)) == nullptr)
@@ -76,7 +80,7 @@ bool Window::Initialize(const char * windowName, const char * iconPath)
 	glfwSetFramebufferSizeCallback(window, [](GLFWwindow * window, int width, int height) {
 		WIDTH = width;
 		HEIGHT = height;
-		glViewport(0, 0, width, height);
+		OpenGL_State::Viewport(0, 0, width, height);
 		windowDimensionsChanged_ = true;
 	});
 
@@ -98,16 +102,16 @@ bool Window::Initialize(const char * windowName, const char * iconPath)
 	};
 
 	// Setup OpenGL options
-	glEnable(GL_DEPTH_TEST); // Depth
-	glDepthFunc(GL_LEQUAL);
-	glEnable(GL_CULL_FACE); // Face Culling
-	glEnable(GL_BLEND); // Blending
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Blending options
+	OpenGL_State::SetCapability(GL_DEPTH_TEST, true); // Depth
+	OpenGL_State::DepthFunc(GL_LEQUAL);
+	OpenGL_State::SetCapability(GL_CULL_FACE, true); // Face Culling
+	OpenGL_State::SetCapability(GL_BLEND, true); // Blending
+	OpenGL_State::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Blending options
 
-	glEnable(GL_MULTISAMPLE);
+	OpenGL_State::SetCapability(GL_MULTISAMPLE, true);
 
 	// enable seamless cubemap sampling for lower mip levels in the pre-filter map.
-	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+	OpenGL_State::SetCapability(GL_TEXTURE_CUBE_MAP_SEAMLESS, true);
 	return true;
 }
 
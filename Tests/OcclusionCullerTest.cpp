@@ -0,0 +1,82 @@
+/*****************************************************************//**
+ * \file   OcclusionCullerTest.cpp
+ * \brief  Checks of the CPU occlusion culler, without GPU
+ * 
+ * \author Kevin Pruvost (pruvostkevin0@gmail.com)
+ * \date   June, 16 2022
+ *********************************************************************/
+
+// Project includes
+#include "OGL_Implementation\Rendering\OcclusionCuller.hpp"
+
+// C++ includes
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { if (!(condition)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); ++failures; } } while (false)
+
+/**
+ * @brief Identity view projection: world = NDC, the quad covers [-0.5, 0.5] on xy at depth 0
+*/
+static void QuadOccluder()
+{
+    const std::vector<VertexPos> vertices = {
+        { -0.5f, -0.5f, 0.0f }, { 0.5f, -0.5f, 0.0f }, { 0.5f, 0.5f, 0.0f }, { -0.5f, 0.5f, 0.0f }
+    };
+    const std::vector<Face> faces = { Face({ 0, 1, 2 }), Face({ 0, 2, 3 }) };
+    std::vector<glm::vec3> triangles;
+    OcclusionCuller::AssembleTriangles(vertices, faces, triangles);
+    CHECK(triangles.size() == 6);
+
+    OcclusionCuller culler(64, 64);
+    culler.Begin(glm::mat4(1.0f));
+    culler.AddOccluder(triangles, glm::mat4(1.0f));
+    culler.Rasterize();
+    CHECK(culler.GetTrianglesCount() == 2);
+
+    // Covered pixel at the quad depth, uncovered one at the far plane
+    const std::vector<float> & depth = culler.GetDepthBuffer();
+    CHECK(std::abs(depth[32 * 64 + 32]) < 1e-5f);
+    CHECK(depth[4 * 64 + 4] == 1.0f);
+
+    // Behind the quad, inside its silhouette
+    CHECK(!culler.IsVisible(BoundingBox(glm::vec3(-0.2f, -0.2f, 0.5f), glm::vec3(0.2f, 0.2f, 0.6f))));
+    // In front of the quad
+    CHECK(culler.IsVisible(BoundingBox(glm::vec3(-0.2f, -0.2f, -0.6f), glm::vec3(0.2f, 0.2f, -0.5f))));
+    // Behind the quad, crossing its edge
+    CHECK(culler.IsVisible(BoundingBox(glm::vec3(0.3f, -0.2f, 0.5f), glm::vec3(0.7f, 0.2f, 0.6f))));
+    // Beside the quad
+    CHECK(culler.IsVisible(BoundingBox(glm::vec3(0.6f, 0.6f, 0.5f), glm::vec3(0.8f, 0.8f, 0.6f))));
+
+    // A new view forgets the occluders of the previous one
+    culler.Begin(glm::mat4(1.0f));
+    culler.Rasterize();
+    CHECK(culler.GetTrianglesCount() == 0);
+    CHECK(culler.IsVisible(BoundingBox(glm::vec3(-0.2f, -0.2f, 0.5f), glm::vec3(0.2f, 0.2f, 0.6f))));
+}
+
+/**
+ * @brief Faces with indices out of the vertices are skipped, polygons are split in fans
+*/
+static void AssembleTriangles()
+{
+    const std::vector<VertexPos> vertices = {
+        { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }
+    };
+    std::vector<glm::vec3> triangles;
+    OcclusionCuller::AssembleTriangles(vertices, { Face({ 0, 1, 2, 3 }), Face({ 0, 1, 7 }) }, triangles);
+    CHECK(triangles.size() == 6);
+    CHECK(triangles[3] == vertices[0] && triangles[4] == vertices[2] && triangles[5] == vertices[3]);
+}
+
+int main()
+{
+    QuadOccluder();
+    AssembleTriangles();
+    if (failures == 0) std::printf("OcclusionCuller: all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -22,11 +22,15 @@
 #include "OGL_Implementation\Obj.hpp"
 #include "OGL_Implementation\Camera.hpp"
 #include "OGL_Implementation\Mesh\Mesh.hpp"
+#include "OGL_Implementation\Mesh\GeometryArena.hpp"
 #include "OGL_Implementation\GUI.hpp"
 #include "OGL_Implementation\Entity\Entity.hpp"
 #include "OGL_Implementation\OpenGL_Timer.hpp"
+#include "OGL_Implementation\OpenGL_State.hpp"
 #include "OGL_Implementation\DebugInfo\FpsCounter.hpp"
 #include "OGL_Implementation\Rendering\Rendering.hpp"
+#include "OGL_Implementation\Rendering\RenderQueue.hpp"
+#include "OGL_Implementation\Rendering\LightBenchmark.hpp"
 #include "OGL_Implementation\Text\Text.hpp"
 #include "OGL_Implementation\Light\Light.hpp"
 
@@ -36,6 +40,7 @@
 #include "OGL_Implementation\DebugInfo\AxisDisplayer.hpp"
 
 #include "OGL_Implementation\Cubemap\Brdf_Cubemap.hpp"
+#include "OGL_Implementation\Cubemap\ReflectionProbe.hpp"
 
 #include "Constants.hpp"
 
@@ -124,11 +129,8 @@ int main()
 	Material & entityMaterial = entity1.AddMaterial();
 	Material & entity2Material = entity2.AddMaterial();
 	Material & entity3Material = entity3.AddMaterial();
-	entity1.SetShaderAttribute("isNormalFlat", 0);
-	entity2.SetShaderAttribute("isNormalFlat", 1);
-	entity3.SetShaderAttribute("isNormalFlat", 1);
-	humanHead.SetShaderAttribute("isNormalFlat", 0);
-	plane.SetShaderAttribute("isNormalFlat", 0);
+	entity2.shaderFeatures |= NormalFlatFeature;
+	entity3.shaderFeatures |= NormalFlatFeature;
 	entityMaterial.diffuseColor = entity2Material.diffuseColor = entity3Material.diffuseColor = glm::vec3(1.0f);
 	entityMaterial.specularColor = entity2Material.specularColor = entity3Material.specularColor = glm::vec3(0.0f);
 
@@ -147,10 +149,8 @@ int main()
 		Constants::Paths::Textures::HumanHead::roughness,
 		Constants::Paths::Textures::HumanHead::ao
 	);
-	humanHead.SetShaderAttribute("useShadow", 1);
 	humanHead.SetShaderAttribute("translucency", 0.85f);
 	humanHead.SetShaderAttribute("sssWidth", 0.0155f);
-	humanHead.SetShaderAttribute("ssssEnabled", 0);
 
 	Mesh sphereMesh = GenerateMeshSphere();
 	PointLight sun(sphereMesh);
@@ -166,7 +166,6 @@ int main()
 		Rendering::Shaders(Constants::Paths::pointShaderVertex),
 		Rendering::Shaders(Constants::Paths::wireframeShaderVertex),
 		Rendering::Shaders(Constants::Paths::pbrVertex));
-	goldBall.SetShaderAttribute("isNormalFlat", 0);
 	goldBall.AddPbrMaterial(
 		Constants::Paths::Textures::Gold::albedo,
 		Constants::Paths::Textures::Gold::normal,
@@ -182,6 +181,9 @@ int main()
 		Constants::Paths::Textures::Gold::ao
 	);
 	goldBall.scale = glm::vec3(2.5f);
+	// Boxes, their own mesh is an exact occluder
+	plane.occluder = meshCube;
+	entity2.occluder = mesh2;
 	goldBall.pos = glm::vec3(-9.0f, 1.5f, -1.0f);
 
 	Camera camera(window->windowWidth(), window->windowHeight(), -2.0f, 4.0f, 5.0f);
@@ -196,7 +198,6 @@ int main()
 		Rendering::Shaders(Constants::Paths::wireframeShaderVertex),
 		Rendering::Shaders(Constants::Paths::pbrVertex));
 	humanHead2.name = "HumanFace2";
-	humanHead2.SetShaderAttribute("isNormalFlat", 0);
 	humanHead2.scale = glm::vec3(12.0f);
 	humanHead2.pos = glm::vec3(-6.0f, 3.0f, -8.0f);
 	humanHead2.AddPbrMaterial(
@@ -208,28 +209,69 @@ int main()
 	);
 	humanHead2.SetShaderAttribute("translucency", 0.85f);
 	humanHead2.SetShaderAttribute("sssWidth", 0.0155f);
-	humanHead2.SetShaderAttribute("ssssEnabled", 0);
+
+	// Local reflections, captured progressively by Rendering::Refresh
+	ReflectionProbe goldBallProbe(goldBall.pos, 8.0f);
+	ReflectionProbe facesProbe(glm::vec3(-3.0f, 1.0f, -8.0f), 8.0f);
+
+	// Clustered shading benchmark, lights orbiting above the ground
+	LightBenchmark lightBenchmark(sphereMesh, glm::vec3(-4.0f, 0.0f, -6.0f), 12.0f);
 
 	bool cameraLock = false;
+	// Entities draws, sorted by state then submitted each frame
+	RenderQueue renderQueue;
 	// GUI
 	GUI gui(window->window);
 	// Creating Second Window
 	bool enableGui = true;
 	bool autoRotation = false;
 	bool verticalSync = true;
+	bool occlusionCulling = renderQueue.IsOcclusionCullingEnabled();
+	bool depthPrePass = renderQueue.IsDepthPrePassEnabled();
 	gui.AddCallback([&]() {
 		const float width = 320.0f;
-		const float height = 475.0f;
-		ImGui::SetNextWindowSize({ width, height }, ImGuiCond_::ImGuiCond_Always);
+		// Height fits the content, up to the display
+		ImGui::SetNextWindowSizeConstraints({ width, 0.0f }, { width, ImGui::GetIO().DisplaySize.y - 40.0f });
 		ImGui::SetNextWindowPos(
 			{ImGui::GetIO().DisplaySize.x - 20.0f - width, 20.0f},
 			ImGuiCond_::ImGuiCond_Always);
-		ImGui::Begin("Settings:");
+		ImGui::Begin("Settings:", nullptr, ImGuiWindowFlags_::ImGuiWindowFlags_AlwaysAutoResize);
 
 		ImGui::Checkbox("Enable/Disable GUI (Press T)", &enableGui);
 		if (ImGui::TreeNodeEx("General", ImGuiTreeNodeFlags_::ImGuiTreeNodeFlags_DefaultOpen))
 		{
 			ImGui::Text(std::format("FPS: {}", GetFpsCount(window->DeltaTimeNoMultiplier(), 0.5f)).c_str());
+			ImGui::Text(std::format("GL state calls: {} issued / {} elided", OpenGL_State::GetLastFrameStats().issued, OpenGL_State::GetLastFrameStats().elided).c_str());
+			{
+				const RenderQueue::Stats & queueStats = renderQueue.GetLastStats();
+				ImGui::Text(std::format("Entities: {} ({} culled, {} occluded), shadow casters drawn: {} ({} shadow maps updated)",
+					queueStats.entities, queueStats.culled, queueStats.occluded, LightRendering::Get().GetShadowDrawsCount(),
+					LightRendering::Get().GetShadowUpdatesCount()).c_str());
+				const ShadowAtlas & shadowAtlas = LightRendering::Get().GetShadowAtlas();
+				ImGui::Text(std::format("Shadow atlas: {}x{}, {:.1f}% used", shadowAtlas.GetSize(), shadowAtlas.GetSize(),
+					100.0 * shadowAtlas.GetUsedArea() / (static_cast<double>(shadowAtlas.GetSize()) * shadowAtlas.GetSize())).c_str());
+				ImGui::Text(std::format("Draw packets: {} ({} entities in the G-buffer)", queueStats.packets, queueStats.deferred).c_str());
+				ImGui::Text(std::format("Program/Material/Mesh changes: {}/{}/{} unsorted, {}/{}/{} sorted",
+					queueStats.unsorted.programs, queueStats.unsorted.materials, queueStats.unsorted.meshes,
+					queueStats.sorted.programs, queueStats.sorted.materials, queueStats.sorted.meshes).c_str());
+				ImGui::Text(std::format("Draw calls: {} ({} batched, drawing {} entities)",
+					queueStats.drawCalls, queueStats.batchedDraws, queueStats.batchedEntities).c_str());
+				const RenderQueue::GpuTimings & gpuTimings = renderQueue.GetGpuTimings();
+				ImGui::Text(std::format("Opaque faces GPU: {:.3f} ms + {:.3f} ms pre-pass ({} entities), {:.3f} ms without",
+					gpuTimings.prePassShadingMs, gpuTimings.prePassMs, queueStats.prePassed, gpuTimings.shadingMs).c_str());
+				const GeometryArena::Stats arenaStats = GeometryArena::GetStats();
+				ImGui::Text(std::format("Geometry arena: {} meshes, {}/{} vertices, {}/{} indices", arenaStats.allocations,
+					arenaStats.verticesUsed, arenaStats.vertexCapacity, arenaStats.indicesUsed, arenaStats.indexCapacity).c_str());
+				const Font_Base::Stats fontStats = GetFontStats();
+				ImGui::Text(std::format("Glyphs: {} cached, {} in atlases, {} rasterized this run, {} evicted",
+					fontStats.glyphs, fontStats.resident, fontStats.rasterized, fontStats.evictions).c_str());
+				if (GpuCuller::settings.validate)
+				{
+					const GpuCuller::ValidationStats & validation = GpuCuller::GetLastValidationStats();
+					ImGui::Text(std::format("GPU culling: {} instances, {} visible on GPU / {} on CPU, {} mismatches",
+						validation.instances, validation.visibleGpu, validation.visibleCpu, validation.mismatches).c_str());
+				}
+			}
 			ImGui::SliderInt("FPS cap", (int *)&window->fpsCap, 0, 60);
 			ImGui::SliderFloat("Time Multiplier", const_cast<float *>(&window->GetTimeMultiplier()), 0.0f, 5.0f);
 			if (ImGui::Button("Screenshot Depth Map"))
@@ -242,9 +284,26 @@ int main()
 				glfwSwapInterval(verticalSync); // Disables V-Sync
 			}
 
-			if (ImGui::Checkbox("SSSS Enabled", (bool *)humanHead.GetShaderAttribute<int>("ssssEnabled")))
+			if (ImGui::Checkbox("Occlusion Culling", &occlusionCulling))
+			{
+				renderQueue.SetOcclusionCulling(occlusionCulling);
+			}
+			if (ImGui::Checkbox("Depth Pre-Pass", &depthPrePass))
+			{
+				renderQueue.SetDepthPrePass(depthPrePass);
+			}
+			if (depthPrePass && GpuCuller::settings.enabled && GpuCuller::settings.occlusion)
+				ImGui::TextDisabled("Depth Pre-Pass is skipped while GPU Occlusion is enabled");
+			ImGui::Checkbox("Deferred Shading", &DeferredRendering::settings.enabled);
+			ImGui::Checkbox("GPU Culling", &GpuCuller::settings.enabled);
+			ImGui::Checkbox("GPU Occlusion", &GpuCuller::settings.occlusion);
+			ImGui::Checkbox("Validate GPU Culling", &GpuCuller::settings.validate);
+			ImGui::Checkbox("Cache Shadow Maps", &LightRendering::settings.cache);
+			ImGui::SliderInt("Shadow Map Updates per Frame", &LightRendering::settings.maxUpdatesPerFrame, 0, 16);
+
+			if (ImGui::CheckboxFlags("SSSS Enabled", &humanHead.shaderFeatures, SsssFeature))
 			{
-				*humanHead2.GetShaderAttribute<int>("ssssEnabled") = *humanHead.GetShaderAttribute<int>("ssssEnabled");
+				humanHead2.shaderFeatures = (humanHead2.shaderFeatures & ~SsssFeature) | (humanHead.shaderFeatures & SsssFeature);
 			}
 			if (ImGui::SliderFloat("SSS Width", humanHead.GetShaderAttribute<float>("sssWidth"), 0.0f, 0.025f))
 			{
@@ -254,6 +313,13 @@ int main()
 			{
 				*humanHead2.GetShaderAttribute<float>("translucency") = *humanHead.GetShaderAttribute<float>("translucency");
 			}
+			ImGui::Checkbox("SSS Blur (Half Resolution)", &SubsurfaceScattering::settings.enabled);
+			{
+				const SubsurfaceScattering::Stats & sssStats = SubsurfaceScattering::GetLastStats();
+				ImGui::Text(std::format("SSS blur: {} entities, {}x{} pixels ({:.1f}% of the window)", sssStats.tagged,
+					sssStats.region.x, sssStats.region.y,
+					100.0 * sssStats.region.x * sssStats.region.y / (static_cast<double>(window->windowWidth()) * window->windowHeight())).c_str());
+			}
 			int displayMode = DisplayMode;
 			bool verticesDisplay   = (displayMode) & RenderingMode::VerticesMode;
 			bool wireframesDisplay = (displayMode) & RenderingMode::WireframeMode;
@@ -267,6 +333,40 @@ int main()
 			ImGui::TreePop();
 		}
 
+		if (ImGui::TreeNodeEx("Clustered Lighting"))
+		{
+			// Toggled by the benchmark while it runs
+			if (!lightBenchmark.IsRunning())
+				ImGui::Checkbox("Clustered Shading", &LightClusters::settings.enabled);
+			const LightClusters::Stats & clusterStats = LightClusters::GetLastStats();
+			ImGui::Text(std::format("{} lights, {} indices ({:.2f} per cluster, max {}), binning: {:.3f} ms",
+				clusterStats.lights, clusterStats.indices, static_cast<double>(clusterStats.indices) / LightClusters::clustersCount,
+				clusterStats.maxLightsPerCluster, clusterStats.binningMs).c_str());
+			if (lightBenchmark.IsRunning())
+			{
+				ImGui::Text(std::format("Benchmark: step {}/{}", lightBenchmark.GetStep() + 1, lightBenchmark.GetStepsCount()).c_str());
+				if (ImGui::Button("Stop Benchmark")) lightBenchmark.Stop();
+			}
+			else if (ImGui::Button("Run Benchmark"))
+				lightBenchmark.Start();
+			for (const LightBenchmark::Result & result : lightBenchmark.GetResults())
+			{
+				ImGui::Text(std::format("{:>3} lights, {:<10}: {:.3f} ms GPU, {:.3f} ms binning", result.lights,
+					result.clustered ? "clustered" : "all lights", result.gpuMs, result.binningMs).c_str());
+			}
+			ImGui::TreePop();
+		}
+
+		if (ImGui::TreeNodeEx("Reflection Probes"))
+		{
+			ImGui::Checkbox("Update Probes", &ReflectionProbe::settings.enabled);
+			ImGui::SliderInt("Max Steps per Frame", &ReflectionProbe::settings.maxStepsPerFrame, 1, 36);
+			ImGui::SliderFloat("GPU Budget (ms)", &ReflectionProbe::settings.budgetMs, 0.05f, 4.0f);
+			ImGui::Text(std::format("Step cost: {:.3f} ms", ReflectionProbe::GetEstimatedStepMs()).c_str());
+			ImGui::Text(std::format("Steps last frame: {}", ReflectionProbe::GetLastFrameSteps()).c_str());
+			ImGui::TreePop();
+		}
+
 		auto entities = Entity::GetAllEntities();
 		if (ImGui::TreeNodeEx("Entities", ImGuiTreeNodeFlags_::ImGuiTreeNodeFlags_DefaultOpen))
 		{
@@ -306,6 +406,7 @@ int main()
 				}
 				ImGui::EndCombo();
 			}
+			ImGui::Checkbox("Omnidirectional Shadows", &sun.omnidirectionalShadows);
 			ImGui::SliderFloat("Constant", &sun.__constant, 0.0f, 1.0f);
 			ImGui::SliderFloat("Linear", &sun.__linear, 0.01f, 1.0f, "%.8f");
 			ImGui::SliderFloat("Quadratic", &sun.__quadratic, 0.001f, 1.0f, "%.10f");
@@ -334,7 +435,7 @@ int main()
 		// Render
 		// Clear the colorbuffer
 		glClearColor(backgroundColor[0], backgroundColor[1], backgroundColor[2], backgroundColor[3]);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
 		// Switch mesh mode
 		if (window->key(GLFW_KEY_C) == InputKey::JustPressed)
@@ -422,18 +523,24 @@ int main()
 			humanHead.quat.RotateY(30.0f * window->DeltaTime());
 		}
 
+		lightBenchmark.Update(static_cast<float>(glfwGetTime()));
 		Rendering::Refresh();
 
 		// display mode & activate shader
 		Rendering::DrawBrdfCubemap(cubemap);
-		Rendering::DrawEntity(entity1);
-		Rendering::DrawEntity(entity2);
-		Rendering::DrawEntity(entity3);
-		Rendering::DrawEntity(plane);
-		Rendering::DrawEntity(humanHead);
-		Rendering::DrawEntity(humanHead2);
-		Rendering::DrawEntity(goldBall);
-		Rendering::DrawEntity(sun);
+		renderQueue.Add(entity1);
+		renderQueue.Add(entity2);
+		renderQueue.Add(entity3);
+		renderQueue.Add(plane);
+		renderQueue.Add(humanHead);
+		renderQueue.Add(humanHead2);
+		renderQueue.Add(goldBall);
+		renderQueue.Add(sun);
+		lightBenchmark.BeginFrame();
+		renderQueue.Submit();
+		lightBenchmark.EndFrame();
+		// Texts laid out this frame, one draw call per font
+		Rendering::DrawTextBatches();
 
 		if (enableGui)
 		{
@@ -445,5 +552,7 @@ int main()
 		return true;
 	});
 
+	// Static OpenGL objects, the context is destroyed with the window
+	ReflectionProbe::ReleaseResources();
 	return EXIT_SUCCESS;
 }
\ No newline at end of file
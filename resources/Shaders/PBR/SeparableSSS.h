@@ -308,9 +308,10 @@ float3 SSSSTransmittance(
         float3 light,
 
         /**
-         * Linear 0..1 shadow map.
+         * Linear 0..1 shadow atlas & tile of the light (UV offset & scale).
          */
-        SSSSTexture2D shadowMap,
+        SSSSTexture2D shadowMaps,
+        float4 shadowRect,
 
         /**
          * Regular world to light space matrix.
@@ -343,13 +344,15 @@ float3 SSSSTransmittance(
 
     int samples = 17;
     int offset = (samples - 1) / 2;
-    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+    if (shadowRect.z == 0.0) return finalColor;
+    vec2 texelSize = 1.0 / (vec2(textureSize(shadowMaps, 0)) * shadowRect.zw);
     float d2 = shadowPosition.z * lightFarPlane;
     for (int x = -offset; x <= offset; ++x)
     {
         for (int y = -offset; y <= offset; ++y)
         {
-            float d1 = SSSSSample(shadowMap, shadowPosition.xy + vec2(x, y) * texelSize).r; // 'd1' has a range of 0..1
+            float2 tileCoords = clamp(shadowPosition.xy + vec2(x, y) * texelSize, texelSize * 0.5, 1.0 - texelSize * 0.5);
+            float d1 = SSSSSample(shadowMaps, shadowRect.xy + tileCoords * shadowRect.zw).r; // 'd1' has a range of 0..1
             d1 *= lightFarPlane; // So we scale 'd1' accordingly:
             if (d1 == d2) continue;
             float d = scale * abs(d1 - d2);
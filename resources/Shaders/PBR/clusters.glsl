@@ -0,0 +1,29 @@
+// Clustered shading (LightClusters): lights whose range intersects the cluster of a fragment
+
+layout (std430, binding = 5) readonly buffer LightGrid
+{
+    uvec4 clusterDims; // grid size (xyz), 0 in w to loop over every light
+    vec4 clusterParams; // tile size in pixels (xy), depth slice scale (z) & bias (w)
+    uvec2 clusterLights[]; // offset in lightIndices & lights count per cluster
+};
+
+layout (std430, binding = 6) readonly buffer LightIndices
+{
+    uint lightIndices[];
+};
+
+// Offset & count of the lights of the fragment, every light when not clustered
+uvec2 GetClusterLights(vec2 fragCoord, float viewDepth, int lightsCount)
+{
+    if (clusterDims.w == 0u)
+        return uvec2(0u, uint(lightsCount));
+    float slice = max(log(max(viewDepth, 1e-6)) * clusterParams.z + clusterParams.w, 0.0);
+    uvec3 cluster = min(uvec3(uvec2(fragCoord / clusterParams.xy), uint(slice)), clusterDims.xyz - 1u);
+    return clusterLights[cluster.x + clusterDims.x * (cluster.y + clusterDims.y * cluster.z)];
+}
+
+// Index in pointLights of the i-th light of the cluster
+int GetClusterLight(uvec2 lights, uint i)
+{
+    return clusterDims.w == 0u ? int(i) : int(lightIndices[lights.x + i]);
+}
@@ -0,0 +1,73 @@
+#version 460 core
+// Lighting pass of the deferred path (DeferredRendering): point lights shaded once per pixel
+// of the G-buffer, added to the ambient radiance written by the geometry pass (pbr.frag, DEFERRED)
+
+out vec4 FragColor;
+
+// G-buffer, same layout as the outputs of pbr.frag
+uniform sampler2D gAlbedo; // albedo (rgb, gamma encoded), shadows received (a)
+uniform sampler2D gNormal; // world normal (xyz)
+uniform sampler2D gMaterial; // metallic (r), roughness (g)
+uniform sampler2D gLight; // ambient radiance (rgb)
+uniform sampler2D gDepth;
+
+// Window depth to world space
+uniform mat4 inverseViewProj;
+
+#include "lighting.glsl"
+
+layout (std140) uniform CameraProps
+{
+    vec4 viewPos;
+    mat4 viewProj;
+    mat4 view;
+	mat4 projection;
+};
+
+#include "clusters.glsl"
+
+void main()
+{
+    const ivec2 texel = ivec2(gl_FragCoord.xy);
+    const float depth = texelFetch(gDepth, texel, 0).r;
+    // Background, left to what was drawn before
+    if (depth == 1.0)
+        discard;
+    // Forward draws are depth tested against the G-buffer
+    gl_FragDepth = depth;
+
+    const vec2 uv = gl_FragCoord.xy / vec2(textureSize(gDepth, 0));
+    const vec4 clipPos = inverseViewProj * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    const vec3 worldPos = clipPos.xyz / clipPos.w;
+
+    const vec4 albedoShadow = texelFetch(gAlbedo, texel, 0);
+    const vec3 albedo = pow(albedoShadow.rgb, vec3(2.2));
+    const vec3 N = normalize(texelFetch(gNormal, texel, 0).xyz);
+    const vec2 metallicRoughness = texelFetch(gMaterial, texel, 0).rg;
+    const float metallic = metallicRoughness.r;
+    const float roughness = metallicRoughness.g;
+    const vec3 V = normalize(viewPos.xyz - worldPos);
+
+    vec3 F0 = vec3(0.04);
+    F0 = mix(F0, albedo, metallic);
+
+    vec3 Lo = vec3(0.0);
+    // only lights reaching the cluster of the pixel
+    uvec2 clusterLights = GetClusterLights(gl_FragCoord.xy, -(view * vec4(worldPos, 1.0)).z, pointLightsCount);
+    for(uint l = 0u; l < clusterLights.y; ++l)
+    {
+        int i = GetClusterLight(clusterLights, l);
+        // the shading normal stands in for the geometric one in the shadow bias
+        float shadow = albedoShadow.a > 0.5 ? PointLightShadow(i, worldPos, N) : 0.0;
+        Lo += (1.0 - shadow) * PointLightRadiance(i, worldPos, N, V, F0, albedo, metallic, roughness);
+    }
+
+    vec3 color = texelFetch(gLight, texel, 0).rgb + Lo;
+
+    // HDR tonemapping
+    color = color / (color + vec3(1.0));
+    // gamma correct
+    color = pow(color, vec3(1.0/2.2));
+
+    FragColor = vec4(color, 1.0);
+}
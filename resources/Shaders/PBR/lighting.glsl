@@ -0,0 +1,210 @@
+// Point lights of the PBR shaders (forward pbr.frag & deferred lighting pass): Lights block,
+// shadow maps & Cook-Torrance BRDF
+
+#define NR_POINT_LIGHTS 128
+
+// Shadow atlas, one tile per point light (PointLight::shadowRect)
+uniform sampler2D shadowMaps;
+// Omnidirectional shadows, one cube per point light (PointLight::cubeShadow), compared by the sampler
+uniform samplerCubeArrayShadow pointShadowMaps;
+
+// lights
+struct PointLight // 64 bytes
+{
+	vec3 position;
+    float constant;
+
+    vec3 ambient;
+    float linear;
+
+    vec3 diffuse;
+    float quadratic;
+
+    vec3 specular;
+    float farPlane;
+
+    mat4 spaceMatrix;
+
+    vec4 shadowRect; // atlas UV offset (xy) & scale (zw), zero without shadow map
+
+    vec4 cubeShadow; // cube shadow map position (xyz) & layer (w), -1 without
+};
+
+struct DirectionLight
+{
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct SpotLight
+{
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+layout (std140) uniform Lights
+{
+	PointLight pointLights[NR_POINT_LIGHTS];
+//    DirectionLight directionLight;
+//    SpotLight spotLight;
+    int pointLightsCount;
+};
+
+const float PI = 3.14159265359;
+// ----------------------------------------------------------------------------
+float DistributionGGX(vec3 N, vec3 H, float roughness)
+{
+    float a = roughness*roughness;
+    float a2 = a*a;
+    float NdotH = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH*NdotH;
+
+    float nom   = a2;
+    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+    denom = PI * denom * denom;
+
+    return nom / denom;
+}
+// ----------------------------------------------------------------------------
+float GeometrySchlickGGX(float NdotV, float roughness)
+{
+    float r = (roughness + 1.0);
+    float k = (r*r) / 8.0;
+
+    float nom   = NdotV;
+    float denom = NdotV * (1.0 - k) + k;
+
+    return nom / denom;
+}
+// ----------------------------------------------------------------------------
+float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
+{
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+    float ggx2 = GeometrySchlickGGX(NdotV, roughness);
+    float ggx1 = GeometrySchlickGGX(NdotL, roughness);
+
+    return ggx1 * ggx2;
+}
+// ----------------------------------------------------------------------------
+vec3 fresnelSchlick(float cosTheta, vec3 F0)
+{
+    return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+// ----------------------------------------------------------------------------
+float ShadowCalculation(vec4 fragPosLightSpace, vec4 shadowRect, vec3 lightPos, vec3 fragPos, vec3 normal)
+{
+    // perform perspective divide
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    // transform to [0,1] range
+    projCoords = projCoords * 0.5 + 0.5;
+    // outside of the tile of the light (no shadow map or outside of its frustum)
+    if (shadowRect.z == 0.0 || any(lessThan(projCoords.xy, vec2(0.0))) || any(greaterThan(projCoords.xy, vec2(1.0))))
+        return 0.0;
+    // get depth of current fragment from light's perspective
+    float currentDepth = projCoords.z;
+    // calculate bias (based on depth map resolution and slope)
+    vec3 lightDir = normalize(lightPos - fragPos);
+    float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);
+    // check whether current frag pos is in shadow
+    // float shadow = currentDepth - bias > closestDepth  ? 1.0 : 0.0;
+    // PCF
+    int samples = 5;
+    int offset = (samples - 1) / 2;
+    float shadow = 0.0;
+    // PCF samples are clamped to texels of the tile, neighbours belong to other lights
+    vec2 texelSize = 1.0 / (vec2(textureSize(shadowMaps, 0)) * shadowRect.zw);
+    for(int x = -offset; x <= offset; ++x)
+    {
+        for(int y = -offset; y <= offset; ++y)
+        {
+            vec2 tileCoords = clamp(projCoords.xy + vec2(x, y) * texelSize, texelSize * 0.5, 1.0 - texelSize * 0.5);
+            float pcfDepth = texture(shadowMaps, shadowRect.xy + tileCoords * shadowRect.zw).r;
+            shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;
+        }
+    }
+    shadow /= samples * samples;
+
+    // keep the shadow at 0.0 when outside the far_plane region of the light's frustum.
+    if(projCoords.z > 1.0)
+        shadow = 0.0;
+
+    return shadow;
+}
+
+// ----------------------------------------------------------------------------
+float PointShadowCalculation(vec3 fragPos, vec4 cubeShadow, float farPlane)
+{
+    // depths are distances to the light divided by the far plane
+    vec3 lightToFrag = fragPos - cubeShadow.xyz;
+    float currentDepth = length(lightToFrag) / farPlane;
+    if (currentDepth > 1.0)
+        return 0.0;
+    float bias = 0.05 / farPlane;
+    // 4 taps around the direction, each filtered over 2x2 texels by the comparison sampler
+    const vec3 offsets[4] = vec3[](vec3(1, 1, 1), vec3(1, -1, -1), vec3(-1, 1, -1), vec3(-1, -1, 1));
+    float radius = 0.005 * length(lightToFrag);
+    float lit = 0.0;
+    for(int i = 0; i < 4; ++i)
+        lit += texture(pointShadowMaps, vec4(lightToFrag + offsets[i] * radius, cubeShadow.w), currentDepth - bias);
+    return 1.0 - lit / 4.0;
+}
+
+// ----------------------------------------------------------------------------
+// Shadow of a point light on a surface, from its cube shadow map or its atlas tile
+float PointLightShadow(int i, vec3 fragPos, vec3 normal)
+{
+    return pointLights[i].cubeShadow.w >= 0.0
+        ? PointShadowCalculation(fragPos, pointLights[i].cubeShadow, pointLights[i].farPlane)
+        : ShadowCalculation(pointLights[i].spaceMatrix * vec4(fragPos, 1.0), pointLights[i].shadowRect, pointLights[i].position, fragPos, normal);
+}
+
+// ----------------------------------------------------------------------------
+// Radiance reflected towards V from a point light, shadows excluded
+vec3 PointLightRadiance(int i, vec3 fragPos, vec3 N, vec3 V, vec3 F0, vec3 albedo, float metallic, float roughness)
+{
+    // calculate per-light radiance
+    vec3 L = normalize(pointLights[i].position - fragPos);
+    vec3 H = normalize(V + L);
+    float distance = length(pointLights[i].position - fragPos);
+    float attenuation = 1.0 / (distance * distance);
+    vec3 radiance = pointLights[i].diffuse * attenuation;
+
+    // Cook-Torrance BRDF
+    float NDF = DistributionGGX(N, H, roughness);
+    float G   = GeometrySmith(N, V, L, roughness);
+    vec3 F    = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+    vec3 numerator    = NDF * G * F;
+    float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001; // + 0.0001 to prevent divide by zero
+    vec3 specular = numerator / denominator;
+
+     // kS is equal to Fresnel
+    vec3 kS = F;
+    // for energy conservation, the diffuse and specular light can't
+    // be above 1.0 (unless the surface emits light); to preserve this
+    // relationship the diffuse component (kD) should equal 1.0 - kS.
+    vec3 kD = vec3(1.0) - kS;
+    // multiply kD by the inverse metalness such that only non-metals
+    // have diffuse lighting, or a linear blend if partly metal (pure metals
+    // have no diffuse light).
+    kD *= 1.0 - metallic;
+
+    // scale light by NdotL
+    float NdotL = max(dot(N, L), 0.0);
+
+    return (kD * albedo / PI + specular) * radiance * NdotL; // note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
+}
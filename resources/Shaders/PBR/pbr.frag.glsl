@@ -1,15 +1,31 @@
 #version 460 core
 
+// Variants (ShaderFeature): SHADOW, SSSS, IRRADIANCE_SH, DEFERRED
+
+#ifdef SSSS
 #ifndef SSSS_GLSL_3
 #define SSSS_GLSL_3 1
 #endif
 
 #include "SeparableSSS.h"
 
-uniform float sssWidth;
-uniform bool ssssEnabled;
+// Per entity attributes (ShaderAttributeManager)
+layout (std140) uniform EntityAttributes
+{
+    float translucency;
+    float sssWidth;
+};
+#endif
 
+#ifdef DEFERRED
+// G-buffer of the deferred path (DeferredRendering), point lights are added by its lighting pass
+layout (location = 0) out vec4 gAlbedo; // albedo (rgb, gamma encoded), shadows received (a)
+layout (location = 1) out vec4 gNormal; // world normal (xyz)
+layout (location = 2) out vec4 gMaterial; // metallic (r), roughness (g)
+layout (location = 3) out vec4 gLight; // ambient radiance (rgb)
+#else
 out vec4 FragColor;
+#endif
 in vec2 TexCoords;
 in vec3 WorldPos;
 in vec3 Normal;
@@ -26,61 +42,15 @@ uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLUT;
 
-#define NR_POINT_LIGHTS 128
-
-uniform sampler2D shadowMapsPerPointLight[NR_POINT_LIGHTS];
-uniform float translucency;
-
-// lights
-struct PointLight // 64 bytes
-{
-	vec3 position;
-    float constant;
-    
-    vec3 ambient;
-    float linear;
-
-    vec3 diffuse;
-    float quadratic; 
-
-    vec3 specular;
-    float farPlane;
-
-    mat4 spaceMatrix;
-};
-
-struct DirectionLight
+#ifdef IRRADIANCE_SH
+// Irradiance projected on spherical harmonics (already convolved with the cosine lobe)
+layout (std140) uniform SphericalHarmonics
 {
-    vec3 direction;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
+    vec4 shCoefficients[9];
 };
+#endif
 
-struct SpotLight
-{
-    vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-  
-    float constant;
-    float linear;
-    float quadratic;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;       
-};
-
-layout (std140) uniform Lights
-{
-	PointLight pointLights[NR_POINT_LIGHTS];
-//    DirectionLight directionLight;
-//    SpotLight spotLight;
-    int pointLightsCount;
-};
+#include "lighting.glsl"
 
 layout (std140) uniform CameraProps
 {
@@ -90,8 +60,8 @@ layout (std140) uniform CameraProps
 	mat4 projection;
 };
 
-const float PI = 3.14159265359;
-uniform bool useShadow = true;
+#include "clusters.glsl"
+
 // ----------------------------------------------------------------------------
 // Easy trick to get tangent-normals to world-space to keep PBR code simplified.
 // Don't worry if you don't get what's going on; you generally want to do normal 
@@ -114,94 +84,35 @@ vec3 getNormalFromMap()
     return normalize(TBN * tangentNormal);
 }
 // ----------------------------------------------------------------------------
-float DistributionGGX(vec3 N, vec3 H, float roughness)
-{
-    float a = roughness*roughness;
-    float a2 = a*a;
-    float NdotH = max(dot(N, H), 0.0);
-    float NdotH2 = NdotH*NdotH;
-
-    float nom   = a2;
-    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
-    denom = PI * denom * denom;
-
-    return nom / denom;
-}
-// ----------------------------------------------------------------------------
-float GeometrySchlickGGX(float NdotV, float roughness)
-{
-    float r = (roughness + 1.0);
-    float k = (r*r) / 8.0;
-
-    float nom   = NdotV;
-    float denom = NdotV * (1.0 - k) + k;
-
-    return nom / denom;
-}
-// ----------------------------------------------------------------------------
-float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
-{
-    float NdotV = max(dot(N, V), 0.0);
-    float NdotL = max(dot(N, L), 0.0);
-    float ggx2 = GeometrySchlickGGX(NdotV, roughness);
-    float ggx1 = GeometrySchlickGGX(NdotL, roughness);
-
-    return ggx1 * ggx2;
-}
-// ----------------------------------------------------------------------------
-vec3 fresnelSchlick(float cosTheta, vec3 F0)
-{
-    return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
-}
-// ----------------------------------------------------------------------------
 vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
 {
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }   
-// ----------------------------------------------------------------------------
-float ShadowCalculation(vec4 fragPosLightSpace, sampler2D shadowMap, vec3 lightPos)
+
+#ifdef SSSS
+vec3 CalculateTransmittance(float translucency, float sssWidth, float3 worldPosition, float3 worldNormal, float3 light, float4 shadowRect, float4x4 lightViewProjection, float lightFarPlane)
 {
-    // perform perspective divide
-    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
-    // transform to [0,1] range
-    projCoords = projCoords * 0.5 + 0.5;
-    // get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-    float closestDepth = texture(shadowMap, projCoords.xy).r; 
-    // get depth of current fragment from light's perspective
-    float currentDepth = projCoords.z;
-    // calculate bias (based on depth map resolution and slope)
-    vec3 normal = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - WorldPos);
-    float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);
-    // check whether current frag pos is in shadow
-    // float shadow = currentDepth - bias > closestDepth  ? 1.0 : 0.0;
-    // PCF
-    int samples = 5;
-    int offset = (samples - 1) / 2;
-    float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
-    for(int x = -offset; x <= offset; ++x)
-    {
-        for(int y = -offset; y <= offset; ++y)
-        {
-            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
-            shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;        
-        }    
-    }
-    shadow /= samples * samples;
-    
-    // keep the shadow at 0.0 when outside the far_plane region of the light's frustum.
-    if(projCoords.z > 1.0)
-        shadow = 0.0;
-        
-    return shadow;
+    vec3 t = SSSSTransmittance(translucency, sssWidth, worldPosition, worldNormal, light, shadowMaps, shadowRect, lightViewProjection, lightFarPlane);
+    return t;
 }
+#endif
 
-vec3 CalculateTransmittance(float translucency, float sssWidth, float3 worldPosition, float3 worldNormal, float3 light, SSSSTexture2D shadowMap, float4x4 lightViewProjection, float lightFarPlane)
+#ifdef IRRADIANCE_SH
+// ----------------------------------------------------------------------------
+vec3 IrradianceSH(vec3 n)
 {
-    vec3 t = SSSSTransmittance(translucency, sssWidth, worldPosition, worldNormal, light, shadowMap, lightViewProjection, lightFarPlane);
-    return t;
+    // Same basis order as SphericalHarmonics::Project
+    return shCoefficients[0].rgb
+         + shCoefficients[1].rgb * n.y
+         + shCoefficients[2].rgb * n.z
+         + shCoefficients[3].rgb * n.x
+         + shCoefficients[4].rgb * (n.x * n.y)
+         + shCoefficients[5].rgb * (n.y * n.z)
+         + shCoefficients[6].rgb * (3.0 * n.z * n.z - 1.0)
+         + shCoefficients[7].rgb * (n.x * n.z)
+         + shCoefficients[8].rgb * (n.x * n.x - n.y * n.y);
 }
+#endif
 
 // ----------------------------------------------------------------------------
 void main()
@@ -223,54 +134,6 @@ void main()
     vec3 F0 = vec3(0.04); 
     F0 = mix(F0, albedo, metallic);
 
-    // reflectance equation
-    vec3 Lo = vec3(0.0);
-    for(int i = 0; i < pointLightsCount; ++i) 
-    {
-        // calculate per-light radiance
-        vec3 L = normalize(pointLights[i].position - WorldPos);
-        vec3 H = normalize(V + L);
-        float distance = length(pointLights[i].position - WorldPos);
-        float attenuation = 1.0 / (distance * distance);
-        vec3 radiance = pointLights[i].diffuse * attenuation;
-
-        // Cook-Torrance BRDF
-        float NDF = DistributionGGX(N, H, roughness);   
-        float G   = GeometrySmith(N, V, L, roughness);    
-        vec3 F    = fresnelSchlick(max(dot(H, V), 0.0), F0);        
-        
-        vec3 numerator    = NDF * G * F;
-        float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001; // + 0.0001 to prevent divide by zero
-        vec3 specular = numerator / denominator;
-        
-         // kS is equal to Fresnel
-        vec3 kS = F;
-        // for energy conservation, the diffuse and specular light can't
-        // be above 1.0 (unless the surface emits light); to preserve this
-        // relationship the diffuse component (kD) should equal 1.0 - kS.
-        vec3 kD = vec3(1.0) - kS;
-        // multiply kD by the inverse metalness such that only non-metals 
-        // have diffuse lighting, or a linear blend if partly metal (pure metals
-        // have no diffuse light).
-        kD *= 1.0 - metallic;	                
-            
-        // scale light by NdotL
-        float NdotL = max(dot(N, L), 0.0);   
-
-        // add to outgoing radiance Lo
-        float shadow = ShadowCalculation(pointLights[i].spaceMatrix * vec4(WorldPos, 1.0), shadowMapsPerPointLight[i], pointLights[i].position);
-        if (!useShadow) shadow = 0.0f;
-        Lo += (1.0 - shadow) * (kD * albedo / PI + specular) * radiance * NdotL; // note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
-        if (ssssEnabled)
-        { 
-            vec3 light = pointLights[i].position - WorldPos;
-            light = light / length(light);
-            //Lo += texture(shadowMapsPerPointLight[i], TexCoords).r;
-            vec3 transmittance = CalculateTransmittance(translucency, sssWidth, WorldPos, normalize(Normal), light, shadowMapsPerPointLight[i], pointLights[i].spaceMatrix, pointLights[i].farPlane);
-            Lo += albedo * radiance * transmittance;
-        }
-    }
-    
     // ambient lighting (we now use IBL as the ambient term)
     vec3 F = fresnelSchlickRoughness(max(dot(N, V), 0.0), F0, roughness);
     
@@ -278,7 +141,11 @@ void main()
     vec3 kD = 1.0 - kS;
     kD *= 1.0 - metallic;	  
     
+#ifdef IRRADIANCE_SH
+    vec3 irradiance = max(IrradianceSH(N), vec3(0.0));
+#else
     vec3 irradiance = texture(irradianceMap, N).rgb;
+#endif
     vec3 diffuse      = irradiance * albedo;
     
     // sample both the pre-filter map and the BRDF lut and combine them together as per the Split-Sum approximation to get the IBL specular part.
@@ -288,7 +155,44 @@ void main()
     vec3 specular = prefilteredColor * (F * brdf.x + brdf.y);
 
     vec3 ambient = pointLights[0].ambient * (kD * diffuse + specular) * ao;
-    
+
+#ifdef DEFERRED
+#ifdef SHADOW
+    gAlbedo = vec4(albedoC, 1.0);
+#else
+    gAlbedo = vec4(albedoC, 0.0);
+#endif
+    gNormal = vec4(N, 0.0);
+    gMaterial = vec4(metallic, roughness, 0.0, 0.0);
+    gLight = vec4(ambient, 1.0);
+#else
+    // reflectance equation
+    vec3 Lo = vec3(0.0);
+    // only lights reaching the cluster of the fragment
+    uvec2 clusterLights = GetClusterLights(gl_FragCoord.xy, -(view * vec4(WorldPos, 1.0)).z, pointLightsCount);
+    for(uint l = 0u; l < clusterLights.y; ++l) 
+    {
+        int i = GetClusterLight(clusterLights, l);
+#ifdef SHADOW
+        float shadow = PointLightShadow(i, WorldPos, normalize(Normal));
+#else
+        float shadow = 0.0;
+#endif
+        // add to outgoing radiance Lo
+        Lo += (1.0 - shadow) * PointLightRadiance(i, WorldPos, N, V, F0, albedo, metallic, roughness);
+#ifdef SSSS
+        { 
+            // thickness is read from the shadow atlas, lights with cube shadow maps have no tile (shadowRect is zero)
+            vec3 light = pointLights[i].position - WorldPos;
+            float distance = length(light);
+            light = light / distance;
+            vec3 radiance = pointLights[i].diffuse / (distance * distance);
+            vec3 transmittance = CalculateTransmittance(translucency, sssWidth, WorldPos, normalize(Normal), light, pointLights[i].shadowRect, pointLights[i].spaceMatrix, pointLights[i].farPlane);
+            Lo += albedo * radiance * transmittance;
+        }
+#endif
+    }
+
     vec3 color = ambient + Lo;
 
     // HDR tonemapping
@@ -297,4 +201,5 @@ void main()
     color = pow(color, vec3(1.0/2.2)); 
 
     FragColor = vec4(color , 1.0);
+#endif
 }
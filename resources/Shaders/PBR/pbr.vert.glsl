@@ -1,4 +1,4 @@
-#version 330 core
+#version 460 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
@@ -7,6 +7,9 @@ out vec2 TexCoords;
 out vec3 WorldPos;
 out vec3 Normal;
 
+// Depth equal to the depth pre-pass (shadow_mapping_depth.vert)
+invariant gl_Position;
+
 layout (std140) uniform CameraProps
 {
     vec4 viewPos;
@@ -14,13 +17,24 @@ layout (std140) uniform CameraProps
     mat4 view;
 	mat4 projection;
 };
+#ifdef INSTANCED
+// Model matrices of batched draws, at gl_BaseInstance + gl_InstanceID (see Rendering::DrawFacesBatch)
+layout (std430) readonly buffer InstanceData
+{
+    mat4 models[];
+};
+#else
 uniform mat4 model;
+#endif
 
 void main()
 {
+#ifdef INSTANCED
+    const mat4 model = models[gl_BaseInstance + gl_InstanceID];
+#endif
     TexCoords = aTexCoords;
     WorldPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(model) * aNormal;   
 
-    gl_Position =  projection * view * vec4(WorldPos, 1.0);
+    gl_Position = viewProj * model * vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+// Shared by the passes of the separable SSS post-process (SubsurfaceScattering),
+// needs the CameraProps block declared first
+
+// Window depth to linear view depth
+float LinearDepth(float depth)
+{
+    return projection[3][2] / ((depth * 2.0 - 1.0) + projection[2][2]);
+}
+
+// Inverse of the tonemapping & gamma correction of pbr.frag, the blur has to work in linear space
+vec3 ToLinear(vec3 color)
+{
+    vec3 mapped = min(pow(color, vec3(2.2)), vec3(0.999));
+    return mapped / (1.0 - mapped);
+}
+
+// HDR tonemapping & gamma correction, as pbr.frag
+vec3 ToDisplay(vec3 color)
+{
+    color = color / (color + vec3(1.0));
+    return pow(color, vec3(1.0/2.2));
+}
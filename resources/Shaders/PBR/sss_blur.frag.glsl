@@ -0,0 +1,32 @@
+#version 460 core
+// Separable SSS blur (SubsurfaceScattering) at half resolution, one direction per pass
+
+out vec4 FragColor;
+
+uniform sampler2D sssColor; // linear HDR color (rgb), SSS strength (a)
+uniform sampler2D sssDepth; // linear view depth
+// Width of the strength 1, in world units
+uniform float sssWidth;
+uniform vec2 direction;
+// Vertical field of view of the camera, in degrees
+uniform float fovy;
+
+#define SSSS_GLSL_3 1
+#define SSSS_FOVY fovy
+// Samples on other surfaces (depth discontinuities) don't bleed into the skin
+#define SSSS_FOLLOW_SURFACE 1
+
+#include "SeparableSSS.h"
+
+void main()
+{
+    const vec4 color = texelFetch(sssColor, ivec2(gl_FragCoord.xy), 0);
+    // Untagged texels are copied, the kernel only runs over the skin
+    if (color.a == 0.0)
+    {
+        FragColor = color;
+        return;
+    }
+    const vec2 uv = gl_FragCoord.xy / vec2(textureSize(sssColor, 0));
+    FragColor = SSSSBlurPS(uv, sssColor, sssDepth, sssWidth, direction, false);
+}
@@ -0,0 +1,58 @@
+#version 460 core
+// Half resolution input of the separable SSS blur (SubsurfaceScattering): linear HDR color,
+// SSS strength from the stencil values written by the tagged entities & linear view depth
+
+layout (location = 0) out vec4 FragColor; // linear HDR color (rgb), SSS strength (a)
+layout (location = 1) out float FragDepth; // linear view depth
+
+// Copy of the window
+uniform sampler2D sssSceneColor;
+uniform sampler2D sssSceneDepth;
+uniform usampler2D sssSceneStencil;
+
+layout (std140) uniform CameraProps
+{
+    vec4 viewPos;
+    mat4 viewProj;
+    mat4 view;
+	mat4 projection;
+};
+
+#include "sss.glsl"
+
+void main()
+{
+    // 2x2 pixels under the texel, only the tagged ones if there are any
+    const ivec2 texel = ivec2(gl_FragCoord.xy) * 2;
+    const ivec2 maxTexel = textureSize(sssSceneColor, 0) - 1;
+    vec3 color = vec3(0.0), taggedColor = vec3(0.0);
+    float depth = 0.0, taggedDepth = 0.0, strength = 0.0;
+    int tagged = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        const ivec2 pixel = min(texel + ivec2(i & 1, i >> 1), maxTexel);
+        const vec3 pixelColor = ToLinear(texelFetch(sssSceneColor, pixel, 0).rgb);
+        const float pixelDepth = LinearDepth(texelFetch(sssSceneDepth, pixel, 0).r);
+        const uint stencil = texelFetch(sssSceneStencil, pixel, 0).r;
+        color += pixelColor;
+        depth += pixelDepth;
+        if (stencil != 0u)
+        {
+            taggedColor += pixelColor;
+            taggedDepth += pixelDepth;
+            strength += float(stencil) / 255.0;
+            ++tagged;
+        }
+    }
+
+    if (tagged > 0)
+    {
+        FragColor = vec4(taggedColor, strength) / float(tagged);
+        FragDepth = taggedDepth / float(tagged);
+    }
+    else
+    {
+        FragColor = vec4(color / 4.0, 0.0);
+        FragDepth = depth / 4.0;
+    }
+}
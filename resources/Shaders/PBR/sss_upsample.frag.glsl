@@ -0,0 +1,50 @@
+#version 460 core
+// Composite of the SSS blur (SubsurfaceScattering) over the tagged pixels of the window (stencil test):
+// bilinear upsample of the half resolution blur, texels on other surfaces rejected by their depth
+
+out vec4 FragColor;
+
+uniform sampler2D sssColor; // blurred linear HDR color (rgb), SSS strength (a)
+uniform sampler2D sssDepth; // linear view depth
+uniform sampler2D sssSceneDepth;
+
+layout (std140) uniform CameraProps
+{
+    vec4 viewPos;
+    mat4 viewProj;
+    mat4 view;
+	mat4 projection;
+};
+
+#include "sss.glsl"
+
+void main()
+{
+    const float depth = LinearDepth(texelFetch(sssSceneDepth, ivec2(gl_FragCoord.xy), 0).r);
+
+    // 4 closest half resolution texels, bilinear weights divided by their relative depth difference
+    const vec2 halfPosition = gl_FragCoord.xy * 0.5 - 0.5;
+    const ivec2 base = ivec2(floor(halfPosition));
+    const vec2 fraction = halfPosition - vec2(base);
+    const ivec2 maxTexel = textureSize(sssColor, 0) - 1;
+    vec3 color = vec3(0.0);
+    float totalWeight = 0.0;
+    for (int i = 0; i < 4; ++i)
+    {
+        const ivec2 offset = ivec2(i & 1, i >> 1);
+        const ivec2 texel = clamp(base + offset, ivec2(0), maxTexel);
+        const vec4 texelColor = texelFetch(sssColor, texel, 0);
+        // Untagged texels weren't blurred
+        if (texelColor.a == 0.0)
+            continue;
+        const vec2 bilinear = mix(1.0 - fraction, fraction, vec2(offset));
+        const float weight = bilinear.x * bilinear.y / (1.0e-3 + abs(texelFetch(sssDepth, texel, 0).r - depth) / depth);
+        color += texelColor.rgb * weight;
+        totalWeight += weight;
+    }
+    // Nothing blurred around, the pixel stays as drawn
+    if (totalWeight <= 0.0)
+        discard;
+
+    FragColor = vec4(ToDisplay(color / totalWeight), 1.0);
+}
@@ -0,0 +1,100 @@
+#version 460 core
+// Tests instances against the frustum & the depth pyramid of the previous frame,
+// then appends the model matrices of visible ones after their command
+// (CPU reference: GpuCuller::IsVisible)
+layout (local_size_x = 64) in;
+
+#include "cull_common.glsl"
+
+struct Instance
+{
+    vec4 center;  // world bounding box
+    vec4 extents;
+    uint command;
+    uint model;   // index in Models
+    uint padding0;
+    uint padding1;
+};
+
+layout (std430, binding = 1) readonly buffer Instances
+{
+    Instance instances[];
+};
+layout (std430, binding = 3) readonly buffer Models
+{
+    mat4 models[];
+};
+// Read by the INSTANCED variants at gl_BaseInstance + gl_InstanceID
+layout (std430, binding = 0) writeonly buffer InstanceData
+{
+    mat4 visibleModels[];
+};
+
+layout (binding = 0) uniform sampler2D depthPyramid;
+
+uniform int instancesCount;
+uniform mat4 viewProjection;
+// Depth pyramid & the view projection it was rendered with
+uniform bool useDepthPyramid;
+uniform mat4 previousViewProjection;
+
+bool IsInFrustum(const vec3 center, const vec3 extents)
+{
+    // Gribb & Hartmann, as Frustum
+    const mat4 m = transpose(viewProjection);
+    const vec4 planes[6] = vec4[6](m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] + m[2], m[3] - m[2]);
+    for (int i = 0; i < 6; ++i)
+    {
+        const vec4 plane = planes[i] / length(planes[i].xyz);
+        if (dot(plane.xyz, center) + plane.w + dot(abs(plane.xyz), extents) < 0.0)
+            return false;
+    }
+    return true;
+}
+
+bool IsOccluded(const vec3 center, const vec3 extents)
+{
+    vec2 minScreen = vec2(1.0), maxScreen = vec2(0.0);
+    float minDepth = 1.0;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        const vec3 side = vec3((corner & 1) != 0 ? 1.0 : -1.0, (corner & 2) != 0 ? 1.0 : -1.0, (corner & 4) != 0 ? 1.0 : -1.0);
+        const vec4 clip = previousViewProjection * vec4(center + side * extents, 1.0);
+        // Crossing the near plane
+        if (clip.w <= 1e-6 || clip.z < -clip.w) return false;
+
+        const vec3 ndc = clip.xyz / clip.w;
+        minScreen = min(minScreen, ndc.xy * 0.5 + 0.5);
+        maxScreen = max(maxScreen, ndc.xy * 0.5 + 0.5);
+        minDepth = min(minDepth, ndc.z * 0.5 + 0.5);
+    }
+    if (any(lessThan(maxScreen, vec2(0.0))) || any(greaterThan(minScreen, vec2(1.0)))) return false;
+    minScreen = clamp(minScreen, 0.0, 1.0);
+    maxScreen = clamp(maxScreen, 0.0, 1.0);
+
+    // Level where the rectangle spans about 2x2 texels
+    const vec2 size = (maxScreen - minScreen) * vec2(textureSize(depthPyramid, 0));
+    const int level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0)))), 0, textureQueryLevels(depthPyramid) - 1);
+    const ivec2 levelSize = textureSize(depthPyramid, level);
+    const ivec2 p0 = clamp(ivec2(minScreen * vec2(levelSize)), ivec2(0), levelSize - 1);
+    const ivec2 p1 = clamp(ivec2(maxScreen * vec2(levelSize)), ivec2(0), levelSize - 1);
+
+    float maxDepth = 0.0;
+    for (int y = p0.y; y <= p1.y; ++y)
+        for (int x = p0.x; x <= p1.x; ++x)
+            maxDepth = max(maxDepth, texelFetch(depthPyramid, ivec2(x, y), level).r);
+    return minDepth > maxDepth;
+}
+
+void main()
+{
+    const uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(instancesCount)) return;
+
+    const Instance instance = instances[i];
+    if (!IsInFrustum(instance.center.xyz, instance.extents.xyz)) return;
+    if (useDepthPyramid && IsOccluded(instance.center.xyz, instance.extents.xyz)) return;
+
+    const uint slot = atomicAdd(commands[instance.command].instanceCount, 1u);
+    visibleModels[commands[instance.command].baseInstance + slot] = models[instance.model];
+}
@@ -0,0 +1,18 @@
+// Shared by the GPU culling passes (see GpuCuller)
+
+// glMultiDrawElementsIndirect layout
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int  baseVertex;
+    uint baseInstance;
+};
+
+// Commands of the batch: instanceCount counts visible instances,
+// baseInstance is the first slot of the command in the visible models
+layout (std430, binding = 2) buffer Commands
+{
+    DrawCommand commands[];
+};
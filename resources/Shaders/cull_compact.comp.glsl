@@ -0,0 +1,22 @@
+#version 460 core
+// Moves commands with visible instances to the front of the draws buffer,
+// their count is the parameter of glMultiDrawElementsIndirectCount
+layout (local_size_x = 64) in;
+
+#include "cull_common.glsl"
+
+layout (std430, binding = 4) buffer Draws
+{
+    uint drawCount;
+    DrawCommand draws[];
+};
+
+uniform int commandsCount;
+
+void main()
+{
+    const uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(commandsCount) || commands[i].instanceCount == 0u) return;
+
+    draws[atomicAdd(drawCount, 1u)] = commands[i];
+}
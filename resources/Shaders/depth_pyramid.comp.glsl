@@ -0,0 +1,27 @@
+#version 460 core
+// One level of the depth pyramid: farthest depth of the source texels it covers
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// Depth texture for the first level, previous level of the pyramid then
+layout (binding = 0) uniform sampler2D source;
+layout (r32f, binding = 0) uniform writeonly image2D destination;
+
+uniform int sourceLevel;
+
+void main()
+{
+    const ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    const ivec2 destinationSize = imageSize(destination);
+    if (any(greaterThanEqual(p, destinationSize))) return;
+
+    // Odd sizes make texels cover up to 3x3 source texels
+    const ivec2 sourceSize = textureSize(source, sourceLevel);
+    const ivec2 begin = p * sourceSize / destinationSize;
+    const ivec2 end = min(((p + 1) * sourceSize + destinationSize - 1) / destinationSize, sourceSize);
+
+    float depth = 0.0;
+    for (int y = begin.y; y < end.y; ++y)
+        for (int x = begin.x; x < end.x; ++x)
+            depth = max(depth, texelFetch(source, ivec2(x, y), sourceLevel).r);
+    imageStore(destination, p, vec4(depth));
+}
@@ -3,6 +3,9 @@
  */
 
 #version 330 core
+#extension GL_ARB_texture_cube_map_array : enable
+
+// Variants (ShaderFeature): SHADOW, NORMAL_FLAT, DIFFUSE_COLOR, SPECULAR_COLOR
 
 in vec2 TexCoords;
 in vec3 FragPos;
@@ -11,8 +14,6 @@ flat in vec3 flatNormal;
 
 struct Material
 {
-    bool diffuseUseColor;
-    bool specularUseColor;
     vec3 diffuseColor;
     vec3 specularColor;
     sampler2D diffuseTexture;
@@ -35,6 +36,10 @@ struct PointLight // 64 bytes
     float farPlane;
 
     mat4 spaceMatrix;
+
+    vec4 shadowRect; // atlas UV offset (xy) & scale (zw), zero without shadow map
+
+    vec4 cubeShadow; // cube shadow map position (xyz) & layer (w), -1 without
 };
 
 struct DirectionLight
@@ -64,7 +69,10 @@ struct SpotLight
 
 #define NR_POINT_LIGHTS 128
 
-uniform sampler2D shadowMapsPerPointLight[NR_POINT_LIGHTS];
+// Shadow atlas, one tile per point light (PointLight::shadowRect)
+uniform sampler2D shadowMaps;
+// Omnidirectional shadows, one cube per point light (PointLight::cubeShadow), compared by the sampler
+uniform samplerCubeArrayShadow pointShadowMaps;
 
 layout (std140) uniform Lights
 {
@@ -83,38 +91,40 @@ layout (std140) uniform CameraProps
 };
 
 vec3 CalcDirLight(DirectionLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, sampler2D shadowMap, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 
 out vec4 color;
 uniform Material material;
-uniform bool isNormalFlat = false;
 uniform bool useLight = true;
 
 vec3 GetDiffuseMaterial(Material mat)
 {
-    if (mat.diffuseUseColor)
-        return mat.diffuseColor;
-    else
-        return vec3(texture(mat.diffuseTexture, TexCoords));
+#ifdef DIFFUSE_COLOR
+    return mat.diffuseColor;
+#else
+    return vec3(texture(mat.diffuseTexture, TexCoords));
+#endif
 }
 
 vec3 GetSpecularMaterial(Material mat)
 {
-    if (mat.specularUseColor)
-        return mat.specularColor;
-    else
-        return vec3(texture(mat.specularTexture, TexCoords));
+#ifdef SPECULAR_COLOR
+    return mat.specularColor;
+#else
+    return vec3(texture(mat.specularTexture, TexCoords));
+#endif
 }
 
 // ----------------------------------------------------------------------------
-float ShadowCalculation(vec4 fragPosLightSpace, sampler2D shadowMap, vec3 lightPos)
+float ShadowCalculation(vec4 fragPosLightSpace, vec4 shadowRect, vec3 lightPos)
 {
     // perform perspective divide
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     // transform to [0,1] range
     projCoords = projCoords * 0.5 + 0.5;
-    // get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-    float closestDepth = texture(shadowMap, projCoords.xy).r; 
+    // outside of the tile of the light (no shadow map or outside of its frustum)
+    if (shadowRect.z == 0.0 || any(lessThan(projCoords.xy, vec2(0.0))) || any(greaterThan(projCoords.xy, vec2(1.0))))
+        return 0.0;
     // get depth of current fragment from light's perspective
     float currentDepth = projCoords.z;
     // calculate bias (based on depth map resolution and slope)
@@ -125,12 +135,14 @@ float ShadowCalculation(vec4 fragPosLightSpace, sampler2D shadowMap, vec3 lightP
     // float shadow = currentDepth - bias > closestDepth  ? 1.0 : 0.0;
     // PCF
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+    // PCF samples are clamped to texels of the tile, neighbours belong to other lights
+    vec2 texelSize = 1.0 / (vec2(textureSize(shadowMaps, 0)) * shadowRect.zw);
     for(int x = -1; x <= 1; ++x)
     {
         for(int y = -1; y <= 1; ++y)
         {
-            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
+            vec2 tileCoords = clamp(projCoords.xy + vec2(x, y) * texelSize, texelSize * 0.5, 1.0 - texelSize * 0.5);
+            float pcfDepth = texture(shadowMaps, shadowRect.xy + tileCoords * shadowRect.zw).r; 
             shadow += currentDepth - bias > pcfDepth  ? 1.0 : 0.0;        
         }    
     }
@@ -143,17 +155,39 @@ float ShadowCalculation(vec4 fragPosLightSpace, sampler2D shadowMap, vec3 lightP
     return shadow;
 }
 
+// ----------------------------------------------------------------------------
+float PointShadowCalculation(vec3 fragPos, vec4 cubeShadow, float farPlane)
+{
+    // depths are distances to the light divided by the far plane
+    vec3 lightToFrag = fragPos - cubeShadow.xyz;
+    float currentDepth = length(lightToFrag) / farPlane;
+    if (currentDepth > 1.0)
+        return 0.0;
+    float bias = 0.05 / farPlane;
+    // 4 taps around the direction, each filtered over 2x2 texels by the comparison sampler
+    const vec3 offsets[4] = vec3[](vec3(1, 1, 1), vec3(1, -1, -1), vec3(-1, 1, -1), vec3(-1, -1, 1));
+    float radius = 0.005 * length(lightToFrag);
+    float lit = 0.0;
+    for(int i = 0; i < 4; ++i)
+        lit += texture(pointShadowMaps, vec4(lightToFrag + offsets[i] * radius, cubeShadow.w), currentDepth - bias);
+    return 1.0 - lit / 4.0;
+}
+
 void main()
 {
     if (useLight)
     {
         // Props
-        vec3 norm = normalize(isNormalFlat ? flatNormal : Normal);
+#ifdef NORMAL_FLAT
+        vec3 norm = normalize(flatNormal);
+#else
+        vec3 norm = normalize(Normal);
+#endif
         vec3 viewDir = normalize(viewPos.xyz - FragPos);
         
         vec3 result = vec3(0.0);
         for(int i = 0; i < pointLightsCount; i++)
-            result += CalcPointLight(pointLights[i], shadowMapsPerPointLight[i], norm, FragPos, viewDir);
+            result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
         color = vec4(result, 1.0);
     }
     else
@@ -179,7 +213,7 @@ vec3 CalcDirLight(DirectionLight light, vec3 normal, vec3 viewDir)
 }
 
 // calculates the color when using a point light.
-vec3 CalcPointLight(PointLight light, sampler2D shadowMap, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
     vec3 lightDir = normalize(light.position - fragPos);
     // diffuse shading
@@ -197,6 +231,11 @@ vec3 CalcPointLight(PointLight light, sampler2D shadowMap, vec3 normal, vec3 fra
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
-    float shadow = ShadowCalculation(light.spaceMatrix * vec4(FragPos, 1.0), shadowMap, light.position);
+#ifdef SHADOW
+    float shadow = light.cubeShadow.w >= 0.0 ? PointShadowCalculation(FragPos, light.cubeShadow, light.farPlane)
+        : ShadowCalculation(light.spaceMatrix * vec4(FragPos, 1.0), light.shadowRect, light.position);
+#else
+    float shadow = 0.0;
+#endif
     return (ambient + (1.0 - shadow) * (diffuse + specular));
 }
\ No newline at end of file
@@ -1,15 +1,23 @@
 /*
- * GLSL Vertex Shader code for OpenGL version 3.3
+ * GLSL Vertex Shader code for OpenGL version 4.6
  */
 
-#version 330 core
+#version 460 core
 
 // input vertex attributes
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+#ifdef INSTANCED
+// Model matrices of batched draws, at gl_BaseInstance + gl_InstanceID (see Rendering::DrawFacesBatch)
+layout (std430) readonly buffer InstanceData
+{
+    mat4 models[];
+};
+#else
 uniform mat4 model;
+#endif
 layout (std140) uniform CameraProps
 {
     vec4 viewPos;
@@ -18,6 +26,9 @@ layout (std140) uniform CameraProps
 	mat4 projection;
 };
 
+// Depth equal to the depth pre-pass (shadow_mapping_depth.vert)
+invariant gl_Position;
+
 out vec2 TexCoords;
 out vec3 FragPos;
 out vec3 Normal;
@@ -25,6 +36,9 @@ flat out vec3 flatNormal;
 
 void main()
 {
+#ifdef INSTANCED
+	const mat4 model = models[gl_BaseInstance + gl_InstanceID];
+#endif
 	gl_Position = viewProj * model * vec4(aPos, 1.0f);
 	TexCoords = aTexCoords;
 	FragPos = vec3(model * vec4(aPos, 1.0));
@@ -18,6 +18,9 @@ layout (std140) uniform CameraProps
 	mat4 projection;
 };
 
+// Depth equal to the depth pre-pass (shadow_mapping_depth.vert)
+invariant gl_Position;
+
 out vec2 TexCoords;
 
 void main()
@@ -3,6 +3,8 @@ layout (triangles) in;
 layout (triangle_strip, max_vertices=18) out;
 
 uniform mat4 shadowMatrices[6];
+uniform int faceMask; // faces the caster intersects (bit per face)
+uniform int cubeLayer; // layer of the light in the cube map array
 
 out vec4 FragPos; // FragPos from GS (output per emitvertex)
 
@@ -10,13 +12,27 @@ void main()
 {
     for(int face = 0; face < 6; ++face)
     {
-        gl_Layer = face; // built-in variable that specifies to which face we render.
+        if ((faceMask & (1 << face)) == 0) continue;
+
+        vec4 clip[3];
+        for(int i = 0; i < 3; ++i)
+            clip[i] = shadowMatrices[face] * gl_in[i].gl_Position;
+        // Triangles fully outside one of the planes of the face are not emitted
+        bool outside = false;
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            outside = outside || (clip[0][axis] > clip[0].w && clip[1][axis] > clip[1].w && clip[2][axis] > clip[2].w);
+            outside = outside || (clip[0][axis] < -clip[0].w && clip[1][axis] < -clip[1].w && clip[2][axis] < -clip[2].w);
+        }
+        if (outside) continue;
+
+        gl_Layer = cubeLayer * 6 + face; // layer-face of the cube map array we render to.
         for(int i = 0; i < 3; ++i) // for each triangle's vertices
         {
             FragPos = gl_in[i].gl_Position;
-            gl_Position = shadowMatrices[face] * FragPos;
+            gl_Position = clip[i];
             EmitVertex();
-        }    
+        }
         EndPrimitive();
     }
-} 
\ No newline at end of file
+}
@@ -4,6 +4,10 @@ layout (location = 0) in vec3 aPos;
 uniform mat4 lightSpaceMatrix;
 uniform mat4 model;
 
+// Depth pre-pass of the camera (RenderQueue): same expression as the faces shaders,
+// which are then depth tested with GL_EQUAL
+invariant gl_Position;
+
 void main()
 {
     vec4 pos = lightSpaceMatrix * model * vec4(aPos, 1.0);
@@ -5,7 +5,9 @@
 #version 330 core
 
 // input vertex attributes
-layout (location = 0) in vec4 vertex;
+layout (location = 0) in vec4 vertex; // position relative to the anchor (xy), atlas UV (zw)
+layout (location = 1) in vec3 anchor; // 3D: world position of the billboard
+layout (location = 2) in vec3 color;
 
 layout (std140) uniform Projection
 {
@@ -13,9 +15,11 @@ layout (std140) uniform Projection
 };
 
 out vec2 TexCoords;
+out vec3 TextColor;
 
 void main()
 {
 	gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
-	TexCoords = vec2(vertex.z, 1.0f - vertex.w);
+	TexCoords = vertex.zw;
+	TextColor = color;
 }
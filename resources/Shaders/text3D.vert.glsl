@@ -5,7 +5,9 @@
 #version 330 core
 
 // input vertex attributes
-layout (location = 0) in vec4 vertex;
+layout (location = 0) in vec4 vertex; // position relative to the anchor (xy), atlas UV (zw)
+layout (location = 1) in vec3 anchor; // 3D: world position of the billboard
+layout (location = 2) in vec3 color;
 
 layout (std140) uniform CameraProps
 {
@@ -14,15 +16,16 @@ layout (std140) uniform CameraProps
     mat4 view;
 	mat4 projection;
 };
-uniform mat4 model;
 
 out vec2 TexCoords;
+out vec3 TextColor;
 
 // See https://geeks3d.developpez.com/billboarding-vertex-shader/ for billboarding
 
 void main()
 {
-	mat4 modelView = view * model;
+	// Texts are batched, the model is the translation to their anchor
+	mat4 modelView = view * mat4(vec4(1.0, 0.0, 0.0, 0.0), vec4(0.0, 1.0, 0.0, 0.0), vec4(0.0, 0.0, 1.0, 0.0), vec4(anchor, 1.0));
 
 	// 1st column
 	modelView[0][0] = 1.0; 
@@ -39,5 +42,6 @@ void main()
 	modelView[2][1] = 0.0;
 	modelView[2][2] = 1.0;
 	gl_Position = projection * modelView * vec4(vertex.xy, 0.0f, 1.0f);
-	TexCoords = vec2(vertex.z, 1.0f - vertex.w);
+	TexCoords = vertex.zw;
+	TextColor = color;
 }